@@ -0,0 +1,30 @@
+#version 150
+
+in vec3 position;
+in vec3 color;
+
+// Per instance, advanced once per cube rather than once per vertex
+in vec3 instancePosition;
+in vec3 instanceScale;
+in vec4 instanceOrientation;	// Unit quaternion stored x, y, z, w
+
+out vec4 Color;
+
+uniform mat4 view;
+uniform mat4 proj;
+
+uniform vec3 overrideColor;
+uniform float Alpha;
+
+// Rotates v by the unit quaternion q
+vec3 rotate(vec4 q, vec3 v)
+{
+	return v + 2.0 * cross(q.xyz, cross(q.xyz, v) + q.w * v);
+}
+
+void main()
+{
+	Color = vec4(color, Alpha);
+	vec3 world = instancePosition + rotate(instanceOrientation, position * instanceScale);
+	gl_Position = proj * view * vec4(world, 1.0);
+}
\ No newline at end of file
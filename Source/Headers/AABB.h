@@ -0,0 +1,68 @@
+/*
+	Name:			AABB.h
+	Project:		OpenGL
+	Description:	Axis aligned bounding box types and the pairwise overlap test
+	Doc Version:	1.0
+	Author:			Jonathan Simon Jones
+	Date(D/M/Y):	16-10-2026
+	To do:			
+*/
+
+#ifndef AABB_H
+#define AABB_H
+
+#include <glm/glm.hpp>						// Math library
+#include "Simd.h"
+
+// Box stored as a center and a half width along each axis
+struct AABB
+{
+	glm::vec3 center_position;
+	glm::vec3 radius;
+};
+
+struct extremes
+{
+	extremes(): minX(0.0f)
+	, maxX(0.0f)
+	, minY(0.0f)
+	, maxY(0.0f)
+	, minZ(0.0f)
+	, maxZ(0.0f)
+	{}
+
+	float minX;
+	float maxX;
+	float minY;
+	float maxY;
+	float minZ;
+	float maxZ;
+};
+
+// Pair of overlapping boxes by index, a is always less than b when both come from the same set
+struct BroadphasePair
+{
+	unsigned int a;
+	unsigned int b;
+};
+
+// Returns true if the boxes overlap, touching boxes count as overlapping
+bool testAABBAABB(const AABB &a, const AABB &b);
+
+// Slab test of a moving by motion against b standing still. Returns true if they touch
+// somewhere along the motion and writes the fraction of it at which they first do, 0
+// when they already overlap.
+bool sweepAABBAABB(const AABB &a, const glm::vec3 &motion, const AABB &b, float &time);
+
+// Tight world box around a box of the given half widths centered on the model origin,
+// the extent on each axis is |R| * halfExtents where R is the upper 3x3 of model
+AABB computeWorldAABB(const glm::mat4 &model, const glm::vec3 &halfExtents);
+
+// Same as above for an array of models, does not allocate
+void computeWorldAABBs(const glm::mat4 models[], const glm::vec3 &halfExtents, unsigned int count, AABB out[]);
+
+// World extremes of the unit cube under transformMat and the 8 corners of that box
+// written as position + color (48 floats) for drawing
+void calculateBoxExtremes(const glm::mat4 &transformMat, float newBoxCoords[], extremes &boxExtremes);
+
+#endif // AABB_H
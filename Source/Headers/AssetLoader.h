@@ -0,0 +1,124 @@
+/*
+	Name:			AssetLoader.h
+	Project:		OpenGL
+	Description:	Memory mapped files and a background thread pool that maps them
+	Doc Version:	1.0
+	Author:			Jonathan Simon Jones
+	Date(D/M/Y):	16-10-2026
+	To do:
+*/
+
+#ifndef ASSETLOADER_H
+#define ASSETLOADER_H
+
+// STL includes
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+// Read only view of a whole file, the OS pages it in straight from its cache so
+// nothing is copied. Empty files open with a size of 0.
+class MappedFile
+{
+public:
+	MappedFile();
+	~MappedFile();
+
+	// Closes whatever was open first, returns false if path could not be mapped
+	bool open(const std::string &path);
+	void close();
+
+	bool isOpen() const { return m_data != 0; }
+	const char* getData() const { return m_data; }
+	size_t getSize() const { return m_size; }
+
+	// Reads one byte per page so later reads do not fault, returns the bytes read
+	unsigned int touchPages() const;
+
+private:
+	MappedFile(const MappedFile &);
+	MappedFile& operator=(const MappedFile &);
+
+	const char *m_data;
+	size_t m_size;
+	bool m_mapped;						// False for empty files, which have nothing to unmap
+#ifdef _WIN32
+	void *m_file;
+	void *m_mapping;
+#endif
+};
+
+enum AssetState
+{
+	AssetLoading,						// Queued or being mapped on a loader thread
+	AssetReady,
+	AssetFailed,
+	AssetReleased
+};
+
+// Files are opened, mapped and paged in on loader threads. The thread that owns the
+// loader sees the result only after update() or wait(), so an asset never changes
+// state partway through a frame.
+class AssetLoader
+{
+public:
+	explicit AssetLoader(unsigned int threadCount = 2);
+	~AssetLoader();
+
+	// Queues path and returns a handle to it straight away
+	unsigned int request(const std::string &path);
+
+	// Picks up every asset that finished since the last call, call once a frame.
+	// Returns how many changed state.
+	unsigned int update();
+
+	// Blocks until handle has finished and picks it up, for code that cannot go on
+	// without it. Returns true if it is ready.
+	bool wait(unsigned int handle);
+
+	AssetState getState(unsigned int handle) const { return m_assets[handle]->state; }
+	const std::string& getPath(unsigned int handle) const { return m_assets[handle]->path; }
+
+	// Only valid once the asset is ready
+	const MappedFile& getFile(unsigned int handle) const { return m_assets[handle]->file; }
+
+	// Unmaps the file, the handle is not reused
+	void release(unsigned int handle);
+
+	unsigned int getThreadCount() const { return (unsigned int)m_workers.size(); }
+
+private:
+	AssetLoader(const AssetLoader &);
+	AssetLoader& operator=(const AssetLoader &);
+
+	struct Asset
+	{
+		std::string path;
+		MappedFile file;				// Written by the loader thread until finished is set
+		AssetState state;				// Only touched by the owning thread
+		bool finished;					// Guarded by m_mutex
+	};
+
+	void workerLoop();
+	void pickUp(Asset &asset);
+
+	// Assets are held by pointer so loader threads can keep using one while the array grows
+	std::vector<std::unique_ptr<Asset> > m_assets;
+	std::vector<std::thread> m_workers;
+
+	// Shared with the loader threads
+	std::mutex m_mutex;
+	std::condition_variable m_wake;
+	std::condition_variable m_done;
+	std::deque<std::pair<unsigned int, Asset*> > m_queue;
+	std::vector<unsigned int> m_finished;
+	bool m_quit;
+};
+
+#endif // ASSETLOADER_H
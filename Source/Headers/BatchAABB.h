@@ -0,0 +1,78 @@
+/*
+	Name:			BatchAABB.h
+	Project:		OpenGL
+	Description:	Structure of arrays box storage and batch overlap tests against it
+	Doc Version:	1.0
+	Author:			Jonathan Simon Jones
+	Date(D/M/Y):	16-10-2026
+	To do:
+*/
+
+#ifndef BATCHAABB_H
+#define BATCHAABB_H
+
+#include "AABB.h"
+#include "Simd.h"
+
+// STL includes
+#include <vector>
+
+// Boxes split into one array per component so a SIMD register holds the same
+// component of several boxes
+struct AABBSoA
+{
+	std::vector<float> cx;
+	std::vector<float> cy;
+	std::vector<float> cz;
+	std::vector<float> rx;
+	std::vector<float> ry;
+	std::vector<float> rz;
+
+	void resize(unsigned int count);
+	void clear();
+	void push_back(const AABB &box);
+	void set(unsigned int index, const AABB &box);
+	AABB get(unsigned int index) const;
+	unsigned int size() const { return (unsigned int)cx.size(); }
+};
+
+// Number of 32 bit words a mask over count boxes needs
+inline unsigned int batchMaskWords(unsigned int count) { return (count + 31) / 32; }
+
+// Sets bit i of mask when query overlaps box i, same result as testAABBAABB
+void testAABBBatchMask(const AABB &query, const AABBSoA &boxes, unsigned int mask[]);
+
+// Writes the index of every box that overlaps query, returns how many were written.
+// indices needs room for boxes.size() entries.
+unsigned int testAABBBatchIndices(const AABB &query, const AABBSoA &boxes, unsigned int indices[]);
+
+// Every overlapping (i from a, j from b) pair is appended to pairs
+void testAABBBatchPairs(const AABBSoA &a, const AABBSoA &b, std::vector<BroadphasePair> &pairs);
+
+// Oriented boxes as structure of arrays, orientation is a unit quaternion
+struct OrientedBoxSoA
+{
+	const float *px;
+	const float *py;
+	const float *pz;
+	const float *qw;
+	const float *qx;
+	const float *qy;
+	const float *qz;
+	const float *hx;
+	const float *hy;
+	const float *hz;
+	unsigned int count;
+};
+
+// Tight world boxes for every oriented box, |R| * halfExtents with R built straight
+// from the quaternion. out is resized to boxes.count, which only allocates when it grows.
+void computeWorldAABBsSoA(const OrientedBoxSoA &boxes, AABBSoA &out);
+// Refits only boxes [begin, end), out must already hold boxes.count
+void computeWorldAABBsSoA(const OrientedBoxSoA &boxes, unsigned int begin, unsigned int end, AABBSoA &out);
+
+// Kernels use the best level the CPU has unless forced lower, used to compare paths
+void setBatchAABBSimdLevel(SimdLevel level);
+SimdLevel getBatchAABBSimdLevel();
+
+#endif // BATCHAABB_H
@@ -0,0 +1,62 @@
+/*
+	Name:			BatchTransform.h
+	Project:		OpenGL
+	Description:	Model and model view projection matrices built in batches straight from quaternions
+	Doc Version:	1.0
+	Author:			Jonathan Simon Jones
+	Date(D/M/Y):	16-10-2026
+	To do:
+*/
+
+#ifndef BATCHTRANSFORM_H
+#define BATCHTRANSFORM_H
+
+#include "BatchAABB.h"
+#include "Simd.h"
+
+// Math includes
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+// Floats each matrix takes in an output buffer, column major as glm and OpenGL keep them
+const unsigned int transformMatrixFloats = 16;
+
+// Positions, unit quaternions and per axis scales as structure of arrays
+struct TransformSoA
+{
+	const float *px;
+	const float *py;
+	const float *pz;
+	const float *qw;
+	const float *qx;
+	const float *qy;
+	const float *qz;
+	const float *sx;
+	const float *sy;
+	const float *sz;
+	float scale;							// Every scale is multiplied by this
+	unsigned int count;
+};
+
+// Oriented boxes as the unit cube mesh scaled to their full widths
+TransformSoA getCubeTransforms(const OrientedBoxSoA &boxes);
+
+// Writes translate * rotate * scale for the transforms listed in indices, or the first count
+// when indices is null, one matrix after another into out. out needs room for count *
+// transformMatrixFloats and can be a mapped buffer, the matrices are ready to upload as
+// they are. The rotation is built from the quaternion's components, several transforms at
+// a time, where glm::rotate(glm::angle(q), glm::axis(q)) goes through acos, sqrt, sin and
+// cos to get back to the same matrix.
+void composeModelMatrices(const TransformSoA &transforms, const unsigned int indices[], unsigned int count, float out[]);
+
+// The same with viewProj in front of each, for a vertex shader that takes the product
+void composeModelViewProjMatrices(const TransformSoA &transforms, const unsigned int indices[], unsigned int count, const glm::mat4 &viewProj, float out[]);
+
+// One transform on its own, through the scalar path so it matches the batches exactly
+glm::mat4 composeModelMatrix(const glm::vec3 &position, const glm::fquat &orientation, const glm::vec3 &scale);
+
+// Kernels use the best level the CPU has unless forced lower, used to compare paths
+void setBatchTransformSimdLevel(SimdLevel level);
+SimdLevel getBatchTransformSimdLevel();
+
+#endif // BATCHTRANSFORM_H
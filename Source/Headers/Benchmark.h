@@ -0,0 +1,92 @@
+/*
+	Name:			Benchmark.h
+	Project:		OpenGL
+	Description:	Headless benchmarks run from the command line with -benchmark <name>
+	Doc Version:	1.0
+	Author:			Jonathan Simon Jones
+	Date(D/M/Y):	16-10-2026
+	To do:
+*/
+
+#ifndef BENCHMARK_H
+#define BENCHMARK_H
+
+// STL includes
+#include <string>
+
+// Runs the named benchmark, returns the process exit code
+int runBenchmark(const std::string &name);
+
+// Sweep and prune against the brute force testAABBAABB loop at 1k, 10k and 100k bodies
+int runBroadphaseBenchmark();
+
+// SSE2/AVX2 batch overlap kernels checked against and timed against testAABBAABB
+int runBatchAABBBenchmark();
+
+// calculateBoxExtremes before and after the rewrite and the batched world AABB refits
+int runBoxExtremesBenchmark();
+
+// Dynamic AABB tree refit, self pair and query cost next to sweep and prune
+int runBVHBenchmark();
+
+// Fixed step rigid body integration of 100k bodies across 1 to n threads
+int runIntegrateBenchmark();
+
+// Render queue sort cost and order, and the state changes a backend issues with and without it
+int runRenderQueueBenchmark();
+
+// The old ifstream and stringstream file reads against mapped loads on loader threads, cold and warm
+int runAssetBenchmark();
+
+// Parsing a large OBJ against mapping its converted .mesh file, and what each costs in memory
+int runMeshBenchmark();
+
+// Weld, vertex cache, overdraw and vertex fetch passes on a sphere in exporter and shuffled order
+int runMeshOptimizerBenchmark();
+
+// Frustum culling 100k boxes one at a time, in SIMD batches and through the BVH, then with occlusion
+int runCullingBenchmark();
+
+// Separating axis tests on the broadphase's pairs, and how many AABB pairs they reject
+int runNarrowphaseBenchmark();
+
+// Columns of boxes settling on a floor at 200 Hz with each solver SIMD level, without warm starting and on fewer threads
+int runSolverBenchmark();
+
+// The same columns kept awake, left to fall asleep, with one column knocked awake again
+// and asleep once more, reporting awake and sleeping bodies and the cost of a step
+int runSleepingBenchmark();
+
+// Job and parallelFor overhead, dependency and coverage checks, and the scene update and
+// solver stacks on 1 to 32 threads, checking every thread count ends up with the same bodies
+int runJobsBenchmark();
+
+// What a zone costs with profiling off and on, and a trace of zones from every thread of a pool
+int runProfilerBenchmark();
+
+// Edge, depth and clipping checks of the software rasterizer, then a field of boxes drawn at
+// 800x600 on 1 to 8 threads and each SIMD level, checking they all draw the same image
+int runRasterBenchmark();
+
+// Fast boxes fired at a thin wall and floor, stepped discretely at rising rates and with
+// continuous collision, counting those that pass through and what each costs a frame
+int runCcdBenchmark();
+
+// Triple buffer hand over checks, then the scene stepped on its own thread against a slow
+// renderer, a slow simulation and both at their own rates, checking neither holds the other up
+int runDecoupledBenchmark();
+
+// Model and model view projection matrices for 100k transforms through glm's angle and axis
+// rotate, glm's mat4_cast and the batched path at each SIMD level, checking they all agree
+int runTransformBenchmark();
+
+// A scene graph of 100k nodes updated whole and with 1% of its nodes moved each frame,
+// against the same nodes walked through pointers, and spread over 1 to 8 threads
+int runSceneGraphBenchmark();
+
+// Frame arena, double arena and pool checks, allocation costs against malloc and new, map
+// nodes from the heap and from a pool, then the frame loop in step and with the simulation
+// on its own thread, on 1 and 4 threads, checking it makes no heap calls once warmed up
+int runMemoryBenchmark();
+
+#endif // BENCHMARK_H
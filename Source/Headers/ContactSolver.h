@@ -0,0 +1,155 @@
+/*
+	Name:			ContactSolver.h
+	Project:		OpenGL
+	Description:	Sequential impulse contact solver, graph colored so batches run on every thread
+	Doc Version:	1.0
+	Author:			Jonathan Simon Jones
+	Date(D/M/Y):	16-10-2026
+	To do:
+*/
+
+#ifndef CONTACTSOLVER_H
+#define CONTACTSOLVER_H
+
+#include "Narrowphase.h"
+#include "PhysicsWorld.h"
+#include "Simd.h"
+
+// STL includes
+#include <vector>
+
+class ThreadPool;
+
+// Manifolds solved side by side, one per lane of an AVX2 register
+const unsigned int solverLanes = 8;
+
+// A color is a set of manifolds no two of which move the same body, so its batches can
+// be solved at once without locks. Manifolds the colors run out for are solved alone,
+// after the rest, which only happens to a body touching more than this many others.
+const unsigned int maxSolverColors = 32;
+
+// One of the three directions a contact point pushes along, for every lane of a batch.
+// Bodies a and b get -impulse and +impulse along it.
+struct SolverDirection
+{
+	float x[solverLanes], y[solverLanes], z[solverLanes];			// Unit direction
+	float rAx[solverLanes], rAy[solverLanes], rAz[solverLanes];		// Lever arm on a crossed with the direction
+	float rBx[solverLanes], rBy[solverLanes], rBz[solverLanes];
+	float iAx[solverLanes], iAy[solverLanes], iAz[solverLanes];		// a's world inverse inertia times the above
+	float iBx[solverLanes], iBy[solverLanes], iBz[solverLanes];
+	float mass[solverLanes];										// Inverse of the effective mass, 0 for empty lanes
+	float impulse[solverLanes];										// Accumulated, applied again at the start of the next step
+};
+
+// Contact point number k of every manifold in a batch
+struct SolverRow
+{
+	SolverDirection normal;
+	SolverDirection tangent1;
+	SolverDirection tangent2;
+	float penetration[solverLanes];		// Depth past the allowed slop pushed out a fraction a step, negative for a gap
+};
+
+// Up to solverLanes manifolds of one color and their rows
+struct SolverBatch
+{
+	unsigned int bodyA[solverLanes];
+	unsigned int bodyB[solverLanes];
+	float inverseMassA[solverLanes];	// 0 for static, kinematic and sleeping bodies, which are never written
+	float inverseMassB[solverLanes];
+	unsigned int manifold[solverLanes];	// Index into the manifolds given to setContacts, or noSolverManifold
+	unsigned int firstRow;
+	unsigned int rowCount;
+};
+
+const unsigned int noSolverManifold = 0xffffffff;
+
+// Totals of the last setContacts and solve
+struct SolverStats
+{
+	unsigned int manifolds;
+	unsigned int points;
+	unsigned int warmStarted;			// Points starting with an impulse carried over from the last contacts
+	unsigned int colors;
+	unsigned int batches;
+	unsigned int lanesUsed;				// Out of batches * solverLanes
+	unsigned int serialManifolds;		// Left without a color
+
+	SolverStats(): manifolds(0), points(0), warmStarted(0), colors(0), batches(0), lanesUsed(0), serialManifolds(0) {}
+};
+
+// Pushes touching boxes apart and applies friction between them. Contacts are given once
+// per frame and used by every fixed step the frame takes, PhysicsWorld calls solve
+// between adding gravity to the velocities and moving the bodies.
+class ContactSolver
+{
+public:
+	// pool may be null, in which case every color is solved on the calling thread
+	explicit ContactSolver(ThreadPool *pool = 0);
+
+	// Colors and batches the manifolds and works out their effective masses from the bodies
+	// as they are now. Impulses of points close to last time's are carried over.
+	void setContacts(const BodySoA &bodies, const ContactManifold manifolds[], unsigned int count);
+
+	// Iterations over every color, changes only the velocities
+	void solve(BodySoA &bodies, float dt);
+
+	void setIterations(unsigned int iterations) { m_iterations = iterations; }
+	unsigned int getIterations() const { return m_iterations; }
+	void setWarmStarting(bool enabled) { m_warmStarting = enabled; }
+	void setFriction(float friction) { m_friction = friction; }
+	// Never goes above what the CPU can run
+	void setSimdLevel(SimdLevel level);
+	SimdLevel getSimdLevel() const { return m_simdLevel; }
+
+	const SolverStats& getStats() const { return m_stats; }
+
+private:
+	ContactSolver(const ContactSolver &);
+	ContactSolver& operator=(const ContactSolver &);
+
+	// Impulses a pair's points ended last step with, sorted by key to be found again
+	struct WarmStart
+	{
+		unsigned long long key;
+		glm::vec3 points[maxManifoldPoints];
+		float normal[maxManifoldPoints];
+		float tangent1[maxManifoldPoints];
+		float tangent2[maxManifoldPoints];
+		unsigned int pointCount;
+
+		bool operator<(const WarmStart &other) const { return key < other.key; }
+	};
+
+	void saveImpulses();
+	void colorManifolds(const BodySoA &bodies);
+	void prepareBatch(const BodySoA &bodies, unsigned int batch);
+	// With warmStart the batch's accumulated impulses are applied instead of solved,
+	// backwards solves its rows last to first
+	void solveColor(BodySoA &bodies, unsigned int color, float biasFactor, bool warmStart, bool backwards);
+	void solveBatch(BodySoA &bodies, unsigned int batch, float biasFactor, bool warmStart, bool backwards);
+
+	ThreadPool *m_pool;
+
+	std::vector<ContactManifold> m_manifolds;
+	std::vector<WarmStart> m_warmStarts;
+
+	// Batches of color c are [m_colorStarts[c], m_colorStarts[c + 1]), color
+	// maxSolverColors holds the manifolds that did not get one, a batch each
+	std::vector<SolverBatch> m_batches;
+	std::vector<SolverRow> m_rows;
+	std::vector<unsigned int> m_colorStarts;
+
+	// Scratch kept between frames so coloring does not allocate once warmed up
+	std::vector<unsigned int> m_bodyColors;			// Bit per color the body is already in
+	std::vector<unsigned int> m_manifoldColors;
+	std::vector<unsigned int> m_colorCounts;
+
+	SolverStats m_stats;
+	unsigned int m_iterations;
+	float m_friction;
+	bool m_warmStarting;
+	SimdLevel m_simdLevel;
+};
+
+#endif // CONTACTSOLVER_H
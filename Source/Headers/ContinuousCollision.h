@@ -0,0 +1,91 @@
+/*
+	Name:			ContinuousCollision.h
+	Project:		OpenGL
+	Description:	Swept boxes and time of impact sub-stepping for bodies fast enough to pass through others in a step
+	Doc Version:	1.0
+	Author:			Jonathan Simon Jones
+	Date(D/M/Y):	16-10-2026
+	To do:
+*/
+
+#ifndef CONTINUOUSCOLLISION_H
+#define CONTINUOUSCOLLISION_H
+
+#include "AABB.h"
+#include "PhysicsWorld.h"
+
+// STL includes
+#include <vector>
+
+// A body is fast once a step moves it further than this fraction of its smallest half
+// width. A pair's sub-steps are cut so it closes by no more than this fraction of the
+// two smallest half widths added, far too little to pass one through the other.
+const float ccdMotionThreshold = 0.5f;
+
+// Most sub-steps a pair is split into, anything faster takes longer ones
+const unsigned int ccdMaxSubsteps = 64;
+
+// True if body moves far enough in dt at its current velocity to need sweeping
+bool isFastBody(const BodySoA &bodies, unsigned int body, float dt);
+
+// Box around everywhere body can be over the next time seconds at its current velocity,
+// however it turns on the way. What the broadphase is given for a fast body.
+AABB sweepBodyAABB(const BodySoA &bodies, unsigned int body, float time);
+
+// Totals since the last setPairs
+struct CcdStats
+{
+	unsigned int pairs;					// Given to setPairs with a fast body in them
+	unsigned int sweptPairs;			// Moving fast enough against each other in a step to be swept
+	unsigned int impacts;				// Swept boxes that met, and so were sub-stepped
+	unsigned int substeps;
+	unsigned int contacts;				// Pairs stopped short of passing into each other
+
+	CcdStats(): pairs(0), sweptPairs(0), impacts(0), substeps(0), contacts(0) {}
+};
+
+// Catches what a fixed step moves too far for the discrete narrowphase to see. The
+// broadphase is given swept boxes for fast bodies, so the pairs they could reach over the
+// frame are found with the rest. After each step has moved the bodies, every such pair
+// whose swept boxes meet is stepped again on its own from the slab test's time of impact,
+// in sub-steps short enough that the boxes cannot pass through each other unseen. At the
+// first overlap the pair goes back to its last sub-step apart and loses the velocity
+// that closes it, then carries on with what is left. Everything else keeps its one step.
+//
+// Orientations are taken as they are at the end of the step, only the linear motion is
+// swept. A body gets at most one impact a step and pairs already touching at the start
+// of the step are left to the contact solver.
+class ContinuousCollision
+{
+public:
+	ContinuousCollision();
+
+	// Call once per frame with the broadphase's pairs, keeps those with a fast body
+	void setPairs(const BodySoA &bodies, const BroadphasePair pairs[], unsigned int count, float dt);
+
+	// PhysicsWorld calls this once each step has moved the bodies by dt. Runs on the
+	// calling thread, only the few pairs with a fast body get here.
+	void resolve(BodySoA &bodies, float dt);
+
+	// Off keeps no pairs, for measuring against the discrete steps alone
+	void setEnabled(bool enabled) { m_enabled = enabled; }
+	bool isEnabled() const { return m_enabled; }
+
+	const std::vector<BroadphasePair>& getPairs() const { return m_pairs; }
+	const CcdStats& getStats() const { return m_stats; }
+
+private:
+	ContinuousCollision(const ContinuousCollision &);
+	ContinuousCollision& operator=(const ContinuousCollision &);
+
+	// Returns true if the pair touched and had its velocity changed
+	bool resolvePair(BodySoA &bodies, unsigned int a, unsigned int b, float dt);
+
+	std::vector<BroadphasePair> m_pairs;
+	std::vector<unsigned long long> m_stepsResolved;	// Step count an impact last moved a body in, indexed by body
+	unsigned long long m_step;
+	CcdStats m_stats;
+	bool m_enabled;
+};
+
+#endif // CONTINUOUSCOLLISION_H
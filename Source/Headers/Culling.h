@@ -0,0 +1,125 @@
+/*
+	Name:			Culling.h
+	Project:		OpenGL
+	Description:	Frustum and occlusion culling of world boxes before anything is submitted to draw
+	Doc Version:	1.0
+	Author:			Jonathan Simon Jones
+	Date(D/M/Y):	16-10-2026
+	To do:
+*/
+
+#ifndef CULLING_H
+#define CULLING_H
+
+#include "AABB.h"
+#include "BatchAABB.h"
+#include "Memory.h"
+
+// Math includes
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+// STL includes
+#include <vector>
+
+// Left, right, bottom, top, near and far planes pointing inwards, a point p is inside
+// a plane when dot(plane.xyz, p) + plane.w >= 0. Normals are unit length.
+struct Frustum
+{
+	glm::vec4 planes[6];
+};
+
+// Planes of the volume proj * view maps into clip space, in world space
+Frustum extractFrustum(const glm::mat4 &viewProj);
+
+// False only when the box lies wholly outside one of the planes. Boxes near a corner
+// of the frustum can pass without touching it, which only costs a wasted draw.
+bool testFrustumAABB(const Frustum &frustum, const AABB &box);
+
+// Writes the index of every box testFrustumAABB passes, returns how many were written.
+// indices needs room for boxes.size() entries. Runs at getBatchAABBSimdLevel.
+unsigned int cullAABBBatch(const Frustum &frustum, const AABBSoA &boxes, unsigned int indices[]);
+
+// Small CPU depth buffer that the nearest solid boxes are drawn into, other boxes are
+// then tested against it. Occluders only cover pixels they cover completely and store
+// the farthest depth they reach inside them, so a box is never hidden wrongly.
+class OcclusionBuffer
+{
+public:
+	OcclusionBuffer(unsigned int width = 128, unsigned int height = 64);
+
+	// Starts a frame seen through viewProj with every pixel at the far plane
+	void clear(const glm::mat4 &viewProj);
+
+	// Rasterizes the box as an occluder, returns false if it was left out because
+	// it crosses the near plane
+	bool drawOccluder(const glm::vec3 &center, const glm::fquat &orientation, const glm::vec3 &halfExtents);
+
+	// False when every pixel under the box's screen rectangle is nearer than the box
+	bool testAABB(const AABB &box) const;
+
+	unsigned int getWidth() const { return m_width; }
+	unsigned int getHeight() const { return m_height; }
+	// Depth in [0, 1] per pixel, rows from the bottom of the screen
+	const std::vector<float>& getDepth() const { return m_depth; }
+
+private:
+	// One box face in screen space, corners in order around it
+	void drawFace(const glm::vec3 corners[4]);
+
+	glm::mat4 m_viewProj;
+	std::vector<float> m_depth;
+	unsigned int m_width;
+	unsigned int m_height;
+};
+
+// Totals of the last cull
+struct CullStats
+{
+	unsigned int tested;
+	unsigned int frustumCulled;
+	unsigned int occluded;
+	unsigned int occluders;				// Drawn into the occlusion buffer, always visible
+	unsigned int visible;
+
+	CullStats(): tested(0), frustumCulled(0), occluded(0), occluders(0), visible(0) {}
+};
+
+// The whole stage: a SIMD frustum pass over every box, then the nearest survivors are
+// drawn as occluders and the rest tested against them
+class SceneCuller
+{
+public:
+	explicit SceneCuller(unsigned int maxOccluders = 32);
+
+	// boxes are world boxes and shapes the solid boxes inside them, indexed alike.
+	// Returns the indices of the visible ones, occluders first nearest to farthest,
+	// valid until the next call.
+	const std::vector<unsigned int>& cull(const glm::mat4 &viewProj, const glm::vec3 &eye, const AABBSoA &boxes, const OrientedBoxSoA &shapes);
+
+	// One more box against the frustum and occlusion buffer of the last cull
+	bool isVisible(const AABB &box) const;
+
+	void setOcclusion(bool enabled) { m_occlusionEnabled = enabled; }
+	bool getOcclusion() const { return m_occlusionEnabled; }
+
+	const CullStats& getStats() const { return m_stats; }
+	const OcclusionBuffer& getOcclusionBuffer() const { return m_occlusion; }
+
+private:
+	SceneCuller(const SceneCuller &);
+	SceneCuller& operator=(const SceneCuller &);
+
+	Frustum m_frustum;
+	OcclusionBuffer m_occlusion;
+	// Kept between frames and sized for every box, so culling does not allocate once warmed up
+	std::vector<unsigned int> m_inFrustum;
+	std::vector<unsigned int> m_visible;
+	// Survivors by distance, only needed during a cull
+	FrameArena m_scratch;
+	CullStats m_stats;
+	unsigned int m_maxOccluders;
+	bool m_occlusionEnabled;
+};
+
+#endif // CULLING_H
@@ -0,0 +1,102 @@
+/*
+	Name:			DynamicAABBTree.h
+	Project:		OpenGL
+	Description:	Dynamic bounding volume hierarchy over AABB leaves
+	Doc Version:	1.0
+	Author:			Jonathan Simon Jones
+	Date(D/M/Y):	16-10-2026
+	To do:
+*/
+
+#ifndef DYNAMICAABBTREE_H
+#define DYNAMICAABBTREE_H
+
+#include "AABB.h"
+
+// STL includes
+#include <utility>
+#include <vector>
+
+struct Frustum;
+
+// Leaves store a fattened copy of the body's box so a body can move a little
+// without the tree changing. Nodes live in one array and link by index.
+class DynamicAABBTree
+{
+public:
+	static const int nullNode = -1;
+
+	// margin is added to every side of a leaf box when it is (re)inserted
+	explicit DynamicAABBTree(float margin = 0.1f);
+
+	// Returns a proxy id used to move or remove the box, userData is handed back by queries
+	int insert(const AABB &box, unsigned int userData);
+	void remove(int proxy);
+
+	// Returns true if the leaf had to be reinserted because box left its fat box.
+	// displacement stretches the fat box in the direction of travel.
+	bool move(int proxy, const AABB &box, const glm::vec3 &displacement);
+
+	// Every leaf whose fat box overlaps box
+	void query(const AABB &box, std::vector<unsigned int> &results) const;
+
+	// Leaves hit by the segment start + t * direction for t in [0, maxT], nearest
+	// fat box entry first is not guaranteed. Returns the number of hits.
+	unsigned int rayCast(const glm::vec3 &start, const glm::vec3 &direction, float maxT, std::vector<unsigned int> &results) const;
+
+	// Leaves whose fat box testFrustumAABB would pass. Subtrees wholly inside a plane stop
+	// testing it and wholly inside subtrees are taken without any more tests. Returns the
+	// number of nodes tested.
+	unsigned int queryFrustum(const Frustum &frustum, std::vector<unsigned int> &results) const;
+
+	// Every pair of leaves whose fat boxes overlap, userData values with a < b
+	void queryAllPairs(std::vector<BroadphasePair> &pairs) const;
+
+	unsigned int getUserData(int proxy) const { return m_nodes[proxy].userData; }
+	AABB getFatAABB(int proxy) const;
+
+	int getHeight() const;
+	unsigned int getLeafCount() const { return m_leafCount; }
+	// Sum of internal node surface areas over the root's, lower is a better tree
+	float getAreaRatio() const;
+	unsigned int getRotationCount() const { return m_rotationCount; }
+
+private:
+	struct Node
+	{
+		glm::vec3 lower;
+		glm::vec3 upper;
+
+		// Free nodes reuse parent as the next free link
+		int parent;
+		int child1;
+		int child2;
+		int height;
+
+		unsigned int userData;
+
+		bool isLeaf() const { return child1 == nullNode; }
+	};
+
+	int allocateNode();
+	void freeNode(int node);
+
+	void insertLeaf(int leaf);
+	void removeLeaf(int leaf);
+	int findBestSibling(const glm::vec3 &lower, const glm::vec3 &upper) const;
+	void refitAncestors(int node);
+	// Surface area reducing swap of a child and grandchild, node keeps its place
+	void rotate(int node);
+
+	std::vector<Node> m_nodes;
+	// Traversal scratch, kept to avoid reallocating on every query
+	mutable std::vector<int> m_stack;
+	mutable std::vector<std::pair<int, int> > m_pairStack;
+	int m_root;
+	int m_freeList;
+	unsigned int m_leafCount;
+	unsigned int m_rotationCount;
+	float m_margin;
+};
+
+#endif // DYNAMICAABBTREE_H
@@ -0,0 +1,44 @@
+/*
+	Name:			GLRenderBackend.h
+	Project:		OpenGL
+	Description:	Render backend that issues the queue's commands through OpenGL
+	Doc Version:	1.0
+	Author:			Jonathan Simon Jones
+	Date(D/M/Y):	16-10-2026
+	To do:
+*/
+
+#ifndef GLRENDERBACKEND_H
+#define GLRENDERBACKEND_H
+
+#include "RenderBackend.h"
+
+// OpenGL includes
+#include <GL/glew.h>
+
+class ShaderCache;
+
+// Programs are expected to have "model" and "Alpha" uniforms, either may be missing.
+// Their locations come from the shader cache, which forgets them when a program is rebuilt.
+class GLRenderBackend : public RenderBackend
+{
+public:
+	explicit GLRenderBackend(ShaderCache &shaders);
+
+protected:
+	virtual void applyProgram(unsigned int program);
+	virtual void applyVertexArray(unsigned int vertexArray);
+	virtual void applyBlend(bool blend);
+	virtual void applyModel(const float model[16]);
+	virtual void applyAlpha(float alpha);
+	virtual void draw(const RenderCommand &command);
+
+private:
+	ShaderCache &m_shaders;
+
+	// Locations in the bound program
+	GLint m_model;
+	GLint m_alpha;
+};
+
+#endif // GLRENDERBACKEND_H
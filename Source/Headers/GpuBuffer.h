@@ -0,0 +1,63 @@
+/*
+	Name:			GpuBuffer.h
+	Project:		OpenGL
+	Description:	Buffer objects for geometry uploaded once and for data rewritten every frame
+	Doc Version:	1.0
+	Author:			Jonathan Simon Jones
+	Date(D/M/Y):	16-10-2026
+	To do:
+*/
+
+#ifndef GPUBUFFER_H
+#define GPUBUFFER_H
+
+// OpenGL includes
+#include <GL/glew.h>
+
+// STL includes
+#include <vector>
+
+// Creates a buffer, fills it with size bytes of data and leaves it bound to target.
+// Meant for geometry that never changes, it is the only upload the data gets.
+GLuint createStaticBuffer(GLenum target, GLsizeiptr size, const void *data);
+
+// One buffer split into regionCount regions, each frame writes into the next region
+// so the CPU never overwrites data the GPU may still be drawing from.
+// With ARB_buffer_storage the buffer is mapped once and each region is fenced,
+// otherwise the storage is orphaned whenever the ring wraps round.
+class StreamingBuffer
+{
+public:
+	// regionSize is the most that can be written in one frame
+	StreamingBuffer(GLenum target, GLsizeiptr regionSize, unsigned int regionCount = 2);
+	~StreamingBuffer();
+
+	// Moves on to the next region, waiting on its fence if the GPU still has it
+	void beginFrame();
+
+	// Copies size bytes into this frame's region and returns the offset in the buffer to
+	// draw from, or -1 if the region is full. Leaves the buffer bound to its target.
+	GLintptr write(const void *data, GLsizeiptr size);
+
+	// Fences this frame's region, call once the draws reading it have been issued
+	void endFrame();
+
+	GLuint getBuffer() const { return m_buffer; }
+	bool isPersistent() const { return m_mapped != 0; }
+
+private:
+	StreamingBuffer(const StreamingBuffer &);
+	StreamingBuffer& operator=(const StreamingBuffer &);
+
+	GLenum m_target;
+	GLuint m_buffer;
+	GLsizeiptr m_regionSize;
+	unsigned int m_regionCount;
+	unsigned int m_region;
+	GLsizeiptr m_used;					// Bytes written to the current region
+
+	char *m_mapped;						// Persistent mapping, null when orphaning
+	std::vector<GLsync> m_fences;		// One per region, 0 when the region is free
+};
+
+#endif // GPUBUFFER_H
@@ -0,0 +1,91 @@
+/*
+	Name:			GpuProfiler.h
+	Project:		OpenGL
+	Description:	GPU spans measured with timestamp queries and handed to the profiler
+	Doc Version:	1.0
+	Author:			Jonathan Simon Jones
+	Date(D/M/Y):	16-10-2026
+	To do:
+*/
+
+#ifndef GPUPROFILER_H
+#define GPUPROFILER_H
+
+#include "Profiler.h"
+
+// OpenGL includes
+#include <GL/glew.h>
+
+// STL includes
+#include <vector>
+
+#ifndef PROFILER_DISABLED
+// Times the GL commands issued in the rest of the enclosing scope
+#define PROFILE_GPU_ZONE(profiler, name) GpuProfileZone PROFILER_JOIN(gpuProfileZone, __LINE__)(profiler, name)
+#else
+#define PROFILE_GPU_ZONE(profiler, name)
+#endif
+
+// A timestamp is written before and after each zone's commands. The results are read
+// frameLatency frames later, when the GPU has long finished with them, so nothing waits.
+// Does nothing without ARB_timer_query or while profiling is off.
+class GpuProfiler
+{
+public:
+	GpuProfiler();
+	~GpuProfiler();
+
+	bool isAvailable() const { return m_available; }
+
+	// Zones nest, each endZone closes the last beginZone
+	void beginZone(const char *name);
+	void endZone();
+
+	// After the frame's last zone, reads back the oldest frame and starts the next
+	void endFrame();
+
+private:
+	GpuProfiler(const GpuProfiler &);
+	GpuProfiler& operator=(const GpuProfiler &);
+
+	static const unsigned int frameLatency = 4;
+	static const unsigned int noZone = 0xffffffff;
+
+	struct Zone
+	{
+		const char *name;
+		GLuint begin;
+		GLuint end;
+	};
+
+	GLuint takeQuery();
+
+	std::vector<Zone> m_frames[frameLatency];
+	std::vector<unsigned int> m_open;		// This frame's zones not yet ended, noZone for skipped ones
+	std::vector<GLuint> m_freeQueries;
+	std::vector<GLuint> m_allQueries;
+	unsigned int m_frame;
+	bool m_available;
+};
+
+class GpuProfileZone
+{
+public:
+	GpuProfileZone(GpuProfiler &profiler, const char *name): m_profiler(profiler)
+	{
+		m_profiler.beginZone(name);
+	}
+
+	~GpuProfileZone()
+	{
+		m_profiler.endZone();
+	}
+
+private:
+	GpuProfileZone(const GpuProfileZone &);
+	GpuProfileZone& operator=(const GpuProfileZone &);
+
+	GpuProfiler &m_profiler;
+};
+
+#endif // GPUPROFILER_H
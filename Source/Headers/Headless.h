@@ -0,0 +1,24 @@
+/*
+	Name:			Headless.h
+	Project:		OpenGL
+	Description:	Runs the per frame scene update without a window or GL context
+	Doc Version:	1.0
+	Author:			Jonathan Simon Jones
+	Date(D/M/Y):	16-10-2026
+	To do:
+*/
+
+#ifndef HEADLESS_H
+#define HEADLESS_H
+
+// Runs frames updates as fast as possible with extraBodies spinning boxes added to
+// the scene, prints frame time percentiles and steps per second. Given tracePath the
+// run is profiled and written there as a Chrome trace. Returns the exit code.
+int runHeadless(unsigned int frames, unsigned int extraBodies, const char *tracePath = 0);
+
+// The same frames drawn by SoftwareRenderBackend at 800x600, the clutter as one instanced
+// draw. Prints simulation and render times and triangles per second, the last frame is
+// written to imagePath as a PNG when given. Returns the exit code.
+int runHeadlessRender(unsigned int frames, unsigned int extraBodies, const char *imagePath = 0);
+
+#endif // HEADLESS_H
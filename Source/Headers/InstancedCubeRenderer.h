@@ -0,0 +1,67 @@
+/*
+	Name:			InstancedCubeRenderer.h
+	Project:		OpenGL
+	Description:	Draws every cube in a list of bodies with a single instanced draw call
+	Doc Version:	1.0
+	Author:			Jonathan Simon Jones
+	Date(D/M/Y):	16-10-2026
+	To do:
+*/
+
+#ifndef INSTANCEDCUBERENDERER_H
+#define INSTANCEDCUBERENDERER_H
+
+#include "GpuBuffer.h"
+#include "RenderQueue.h"
+
+// OpenGL includes
+#include <GL/glew.h>
+
+// STL includes
+#include <memory>
+#include <vector>
+
+struct OrientedBoxSoA;
+
+class InstancedCubeRenderer
+{
+public:
+	// cubeBuffer holds a unit cube as position + color and cubeIndices its indexCount
+	// triangle indices. Attribute locations come from shaderProgram, linked from
+	// color3DInstanced.vert.
+	InstancedCubeRenderer(GLuint cubeBuffer, GLuint cubeIndices, GLsizei indexCount, GLuint shaderProgram);
+	~InstancedCubeRenderer();
+
+	// Replaces the instance list with one cube per body, sized by its half extents
+	void setInstances(const OrientedBoxSoA &boxes, const std::vector<unsigned int> &bodies);
+
+	// Streams the instances to the graphics card and points the instance attributes at them.
+	// Leaves no vertex array object bound.
+	void upload();
+
+	// One instanced draw of every cube with program, valid once upload has been called
+	RenderCommand getCommand(GLuint program) const;
+
+	// Call after the command has been executed so the stream can fence this frame's region
+	void endFrame();
+
+	unsigned int getInstanceCount() const { return (unsigned int)m_instances.size(); }
+
+private:
+	InstancedCubeRenderer(const InstancedCubeRenderer &);
+	InstancedCubeRenderer& operator=(const InstancedCubeRenderer &);
+
+	GLuint m_vao;
+	GLsizei m_indexCount;
+	GLint m_instancePosition;
+	GLint m_instanceScale;
+	GLint m_instanceOrientation;
+
+	std::vector<CubeInstance> m_instances;
+	// Recreated larger when the instances outgrow it
+	std::unique_ptr<StreamingBuffer> m_stream;
+	unsigned int m_capacity;
+	bool m_uploaded;					// A region has been written this frame and needs fencing
+};
+
+#endif // INSTANCEDCUBERENDERER_H
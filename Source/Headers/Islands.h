@@ -0,0 +1,74 @@
+/*
+	Name:			Islands.h
+	Project:		OpenGL
+	Description:	Groups touching bodies into islands and puts islands that have come to rest to sleep
+	Doc Version:	1.0
+	Author:			Jonathan Simon Jones
+	Date(D/M/Y):	16-10-2026
+	To do:
+*/
+
+#ifndef ISLANDS_H
+#define ISLANDS_H
+
+#include "Narrowphase.h"
+#include "PhysicsWorld.h"
+
+// STL includes
+#include <vector>
+
+// Counts from the last update, bodies gravity does not move are left out
+struct IslandStats
+{
+	unsigned int awakeBodies;
+	unsigned int sleepingBodies;
+	unsigned int islands;				// Awake ones, a body touching nothing is an island on its own
+	unsigned int fellAsleep;			// Bodies this update put to sleep
+	unsigned int woken;					// Bodies this update woke
+
+	IslandStats(): awakeBodies(0), sleepingBodies(0), islands(0), fellAsleep(0), woken(0) {}
+};
+
+// Bodies that touch, directly or through others, form an island. Static and kinematic
+// bodies join nothing, so boxes standing on the same floor are islands of their own.
+// An island sleeps once all of its bodies have been slower than the thresholds for
+// sleepDelay seconds, and wakes as soon as an awake body touches it or a setter moves
+// one of its bodies.
+class IslandManager
+{
+public:
+	IslandManager();
+
+	// Call once per frame after the narrowphase, with its contacts and the time the world
+	// was stepped by since the last call. Bodies are woken and put to sleep through world.
+	void update(PhysicsWorld &world, const ContactManifold manifolds[], unsigned int count, float elapsed);
+
+	// Off wakes every island and keeps them awake, used to measure what sleeping saves
+	void setEnabled(bool enabled) { m_enabled = enabled; }
+	bool isEnabled() const { return m_enabled; }
+
+	const IslandStats& getStats() const { return m_stats; }
+
+private:
+	IslandManager(const IslandManager &);
+	IslandManager& operator=(const IslandManager &);
+
+	unsigned int findRoot(unsigned int body);
+	void join(unsigned int a, unsigned int b);
+	void wakeIsland(PhysicsWorld &world, unsigned int body);
+
+	// Union-find forest over the awake bodies, rebuilt every update
+	std::vector<unsigned int> m_parent;
+	// Seconds each body has been under the thresholds, and the least of them in each
+	// island indexed by its root
+	std::vector<float> m_stillTime;
+	std::vector<float> m_islandStillTime;
+	// Every sleeping island is a ring of its bodies, noIslandBody for the rest
+	std::vector<unsigned int> m_nextSleeping;
+	unsigned int m_sleepingCount;
+
+	IslandStats m_stats;
+	bool m_enabled;
+};
+
+#endif // ISLANDS_H
@@ -0,0 +1,283 @@
+/*
+	Name:			Memory.h
+	Project:		OpenGL
+	Description:	Per frame arenas, fixed size pools, STL allocators over them and heap counters
+	Doc Version:	1.0
+	Author:			Jonathan Simon Jones
+	Date(D/M/Y):	16-10-2026
+	To do:
+*/
+
+#ifndef MEMORY_H
+#define MEMORY_H
+
+// STL includes
+#include <cstddef>
+#include <new>
+#include <type_traits>
+#include <vector>
+
+// Calls made through operator new and delete since the program started. Defining
+// MEMORY_COUNTERS_ENABLED makes Memory.cpp replace the global operators to count them, one
+// relaxed add a call. Without it the standard ones stay in place and these stay 0. malloc
+// called directly, as the C libraries do, is not seen.
+struct HeapStats
+{
+	unsigned long long allocations;
+	unsigned long long frees;
+	unsigned long long bytes;				// Asked for by allocations
+
+	HeapStats(): allocations(0), frees(0), bytes(0) {}
+};
+
+HeapStats getHeapStats();
+
+#ifdef MEMORY_COUNTERS_ENABLED
+const bool heapCountersEnabled = true;
+#else
+const bool heapCountersEnabled = false;
+#endif
+
+// Alignment allocations get unless they ask for more, enough for SSE loads
+const size_t frameArenaAlignment = 16;
+
+// Totals since the arena was made, used is reset every frame
+struct FrameArenaStats
+{
+	size_t used;							// This frame, overflow blocks included
+	size_t highWater;						// Most any frame has used
+	size_t capacity;						// Of the main block
+	unsigned int overflows;					// Allocations that did not fit and went to the heap
+	unsigned int grows;						// Times reset made the main block larger
+
+	FrameArenaStats(): used(0), highWater(0), capacity(0), overflows(0), grows(0) {}
+};
+
+// Hands out memory by moving a pointer along one block, and takes all of it back at once
+// on reset. Nothing is freed on its own and no destructors run, so only plain data goes in.
+// An allocation that does not fit gets a block of its own from the heap, and the next reset
+// grows the main block to the most a frame has used, so once frames stop growing the
+// arena never goes to the heap. Not thread safe.
+class FrameArena
+{
+public:
+	explicit FrameArena(size_t capacity = 0);
+	~FrameArena();
+
+	// Never null, alignment has to be a power of two
+	void* allocate(size_t bytes, size_t alignment = frameArenaAlignment);
+
+	template<class T>
+	T* allocateArray(size_t count)
+	{
+		const size_t alignment = std::alignment_of<T>::value;
+		return static_cast<T*>(allocate(count * sizeof(T), alignment > frameArenaAlignment ? alignment : frameArenaAlignment));
+	}
+
+	// Everything allocated since the last reset is gone
+	void reset();
+
+	const FrameArenaStats& getStats() const { return m_stats; }
+
+private:
+	FrameArena(const FrameArena &);
+	FrameArena& operator=(const FrameArena &);
+
+	char *m_block;
+	size_t m_used;
+	std::vector<char*> m_overflow;
+	FrameArenaStats m_stats;
+};
+
+// Two arenas used a frame each in turn. What a frame allocated stays good through the
+// frame after it, so it can be handed to whoever works a frame behind, the renderer
+// drawing what the simulation put together the frame before.
+class DoubleFrameArena
+{
+public:
+	// Each arena starts at capacity
+	explicit DoubleFrameArena(size_t capacity = 0);
+
+	// Swaps arenas and resets the one now current, which the frame before last used
+	void beginFrame();
+
+	FrameArena& getCurrent() { return *m_current; }
+	FrameArena& getPrevious() { return *m_previous; }
+
+	void* allocate(size_t bytes, size_t alignment = frameArenaAlignment) { return m_current->allocate(bytes, alignment); }
+
+	template<class T>
+	T* allocateArray(size_t count) { return m_current->allocateArray<T>(count); }
+
+private:
+	DoubleFrameArena(const DoubleFrameArena &);
+	DoubleFrameArena& operator=(const DoubleFrameArena &);
+
+	FrameArena m_first;
+	FrameArena m_second;
+	FrameArena *m_current;
+	FrameArena *m_previous;
+};
+
+// Blocks of one size handed out and taken back in any order. They are cut from chunks that
+// are only given back when the pool goes, and a free block holds the link to the next, so
+// taking and giving back a block is a couple of pointer moves. Not thread safe.
+class FixedPool
+{
+public:
+	// blockSize is rounded up to hold a pointer and to a multiple of alignment
+	FixedPool(size_t blockSize, size_t alignment, unsigned int blocksPerChunk = 64);
+	~FixedPool();
+
+	// Never null
+	void* allocate();
+	// block has to have come from this pool
+	void deallocate(void *block);
+
+	// Makes sure at least blocks more can be taken without going to the heap
+	void reserve(unsigned int blocks);
+
+	size_t getBlockSize() const { return m_blockSize; }
+	size_t getAlignment() const { return m_alignment; }
+	unsigned int getUsedCount() const { return m_used; }
+	unsigned int getCapacity() const { return m_capacity; }
+
+private:
+	FixedPool(const FixedPool &);
+	FixedPool& operator=(const FixedPool &);
+
+	struct FreeBlock
+	{
+		FreeBlock *next;
+	};
+
+	void addChunk(unsigned int blocks);
+
+	size_t m_blockSize;
+	size_t m_alignment;
+	unsigned int m_blocksPerChunk;
+	std::vector<char*> m_chunks;
+	FreeBlock *m_free;
+	unsigned int m_used;
+	unsigned int m_capacity;
+};
+
+// Puts a container's memory in a frame arena, std::vector<T, ArenaAllocator<T> >. Giving
+// memory back does nothing, so a vector that grows leaves its old storage behind until the
+// reset; reserve what it will need first. The container has to be gone or cleared before
+// the arena is reset.
+template<class T>
+class ArenaAllocator
+{
+public:
+	typedef T value_type;
+	typedef T* pointer;
+	typedef const T* const_pointer;
+	typedef T& reference;
+	typedef const T& const_reference;
+	typedef size_t size_type;
+	typedef ptrdiff_t difference_type;
+
+	template<class U>
+	struct rebind
+	{
+		typedef ArenaAllocator<U> other;
+	};
+
+	explicit ArenaAllocator(FrameArena &arena): m_arena(&arena) {}
+
+	template<class U>
+	ArenaAllocator(const ArenaAllocator<U> &other): m_arena(other.getArena()) {}
+
+	T* allocate(size_t count, const void * = 0) { return m_arena->allocateArray<T>(count); }
+	void deallocate(T *, size_t) {}
+
+	void construct(T *p, const T &value) { new(p) T(value); }
+	void destroy(T *p) { p->~T(); }
+	size_t max_size() const { return (size_t)-1 / sizeof(T); }
+
+	FrameArena* getArena() const { return m_arena; }
+
+private:
+	FrameArena *m_arena;
+};
+
+template<class T, class U>
+bool operator==(const ArenaAllocator<T> &a, const ArenaAllocator<U> &b) { return a.getArena() == b.getArena(); }
+
+template<class T, class U>
+bool operator!=(const ArenaAllocator<T> &a, const ArenaAllocator<U> &b) { return a.getArena() != b.getArena(); }
+
+// Room a list, set or map node takes beyond the value it holds, for sizing a pool's blocks
+const size_t containerNodeOverhead = 4 * sizeof(void*);
+
+// Puts the nodes of a list, set or map in a fixed pool, one block each, so inserting and
+// erasing stop going to the heap once the pool has grown. Anything that does not fit a
+// block, like arrays a container asks for, goes to the heap as usual. The pool has to
+// outlive the container.
+template<class T>
+class PoolAllocator
+{
+public:
+	typedef T value_type;
+	typedef T* pointer;
+	typedef const T* const_pointer;
+	typedef T& reference;
+	typedef const T& const_reference;
+	typedef size_t size_type;
+	typedef ptrdiff_t difference_type;
+
+	template<class U>
+	struct rebind
+	{
+		typedef PoolAllocator<U> other;
+	};
+
+	explicit PoolAllocator(FixedPool &pool): m_pool(&pool) {}
+
+	template<class U>
+	PoolAllocator(const PoolAllocator<U> &other): m_pool(other.getPool()) {}
+
+	T* allocate(size_t count, const void * = 0)
+	{
+		if(fitsBlock(count))
+		{
+			return static_cast<T*>(m_pool->allocate());
+		}
+		return static_cast<T*>(::operator new(count * sizeof(T)));
+	}
+
+	void deallocate(T *p, size_t count)
+	{
+		if(fitsBlock(count))
+		{
+			m_pool->deallocate(p);
+		}
+		else
+		{
+			::operator delete(p);
+		}
+	}
+
+	void construct(T *p, const T &value) { new(p) T(value); }
+	void destroy(T *p) { p->~T(); }
+	size_t max_size() const { return (size_t)-1 / sizeof(T); }
+
+	FixedPool* getPool() const { return m_pool; }
+
+private:
+	bool fitsBlock(size_t count) const
+	{
+		return count == 1 && sizeof(T) <= m_pool->getBlockSize() && std::alignment_of<T>::value <= m_pool->getAlignment();
+	}
+
+	FixedPool *m_pool;
+};
+
+template<class T, class U>
+bool operator==(const PoolAllocator<T> &a, const PoolAllocator<U> &b) { return a.getPool() == b.getPool(); }
+
+template<class T, class U>
+bool operator!=(const PoolAllocator<T> &a, const PoolAllocator<U> &b) { return a.getPool() != b.getPool(); }
+
+#endif // MEMORY_H
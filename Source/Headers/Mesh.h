@@ -0,0 +1,80 @@
+/*
+	Name:			Mesh.h
+	Project:		OpenGL
+	Description:	Binary mesh files that upload straight from a memory map, and the OBJ converter that writes them
+	Doc Version:	1.0
+	Author:			Jonathan Simon Jones
+	Date(D/M/Y):	16-10-2026
+	To do:
+*/
+
+#ifndef MESH_H
+#define MESH_H
+
+// STL includes
+#include <cstddef>
+#include <string>
+#include <vector>
+
+class MappedFile;
+
+// Floats per vertex, position then color, the layout every shader here reads
+const unsigned int meshVertexFloats = 6;
+const unsigned int meshFileVersion = 1;
+
+// A .mesh file is this header, the interleaved vertices and then unsigned int indices,
+// three per triangle. Both blocks start on a 16 byte boundary so they can be handed
+// from the mapping to glBufferData as they are.
+struct MeshHeader
+{
+	char magic[4];						// "MESH"
+	unsigned int version;
+	unsigned int vertexCount;
+	unsigned int vertexStride;			// Bytes per vertex
+	unsigned int indexCount;
+	unsigned int vertexOffset;			// Bytes from the start of the file
+	unsigned int indexOffset;
+	unsigned int reserved;
+	float boundsMin[3];
+	float boundsMax[3];
+	unsigned int padding[2];
+};
+
+// Indexed geometry built in memory, what the converter writes out
+struct MeshData
+{
+	std::vector<float> vertices;
+	std::vector<unsigned int> indices;
+
+	unsigned int getVertexCount() const { return (unsigned int)(vertices.size() / meshVertexFloats); }
+};
+
+// Pointers into a mapped .mesh file, valid while the file stays mapped
+struct MeshView
+{
+	const MeshHeader *header;
+	const float *vertices;
+	const unsigned int *indices;
+
+	size_t getVertexBytes() const { return (size_t)header->vertexCount * header->vertexStride; }
+	size_t getIndexBytes() const { return (size_t)header->indexCount * sizeof(unsigned int); }
+};
+
+// Checks the header and that both blocks lie inside the file, nothing is copied
+bool openMeshView(const MappedFile &file, MeshView &view);
+
+// Reads the v, vn and f lines of an OBJ file, polygons are split into fans. Colors come
+// from "v x y z r g b" when present, otherwise from the normal, otherwise grey.
+// Corners with the same position and color are welded into one vertex.
+bool loadObj(const std::string &path, MeshData &mesh);
+
+// The unit cube of Meshes/cube.obj, welded as loadObj leaves it, for when there are no
+// files to load it from
+void createUnitCube(MeshData &mesh);
+
+bool writeMeshFile(const std::string &path, const MeshData &mesh);
+
+// Offline conversion run with -convert <in.obj> <out.mesh>, returns the process exit code
+int convertObjToMesh(const std::string &objPath, const std::string &meshPath);
+
+#endif // MESH_H
@@ -0,0 +1,55 @@
+/*
+	Name:			MeshOptimizer.h
+	Project:		OpenGL
+	Description:	CPU passes that weld, reorder and analyse indexed triangle lists before upload
+	Doc Version:	1.0
+	Author:			Jonathan Simon Jones
+	Date(D/M/Y):	16-10-2026
+	To do:
+*/
+
+#ifndef MESHOPTIMIZER_H
+#define MESHOPTIMIZER_H
+
+// STL includes
+#include <cstddef>
+
+struct MeshData;
+
+// Size of the post transform cache the statistics model, a FIFO like most hardware
+const unsigned int defaultVertexCacheSize = 16;
+
+struct MeshCacheStats
+{
+	float acmr;							// Vertices transformed per triangle, 3 is no reuse at all
+	float atvr;							// Vertices transformed per vertex used, 1 is perfect
+	float overfetch;					// Vertex bytes read through a small cache over the bytes in use, 1 is perfect
+
+	MeshCacheStats(): acmr(0.0f), atvr(0.0f), overfetch(0.0f) {}
+};
+
+// Simulates the post transform cache and a 16 KB vertex fetch cache over the triangle list
+MeshCacheStats analyzeMesh(const unsigned int *indices, size_t indexCount, unsigned int vertexCount, unsigned int vertexBytes, unsigned int cacheSize = defaultVertexCacheSize);
+
+// Merges vertices that are equal bit for bit, generating indices first if the mesh has
+// none, and drops triangles that end up using a vertex twice. Returns the vertices removed.
+unsigned int weldVertices(MeshData &mesh);
+
+// Reorders triangles so each one reuses vertices still in the cache, Forsyth's
+// linear-speed vertex cache optimisation
+void optimizeVertexCache(unsigned int *indices, size_t indexCount, unsigned int vertexCount);
+
+// Splits a cache optimised list into the runs where the cache starts over and sorts the
+// runs so outward facing ones draw first, which hides more of what follows. Keeps the
+// old order if the ACMR would get worse by more than threshold.
+void optimizeOverdraw(unsigned int *indices, size_t indexCount, const float *vertices, unsigned int vertexCount, unsigned int vertexFloats, float threshold = 1.05f);
+
+// Drops vertices no triangle uses and renumbers the rest in the order the triangles first
+// use them, so fetches walk the vertex buffer forwards. The order they were in is kept
+// instead when the fetch cache model reads fewer lines for it.
+void optimizeVertexFetch(MeshData &mesh);
+
+// Every pass above in order. before and after may be null.
+void optimizeMesh(MeshData &mesh, MeshCacheStats *before, MeshCacheStats *after);
+
+#endif // MESHOPTIMIZER_H
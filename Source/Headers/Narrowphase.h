@@ -0,0 +1,116 @@
+/*
+	Name:			Narrowphase.h
+	Project:		OpenGL
+	Description:	Separating axis tests between oriented boxes and the contact manifolds they produce
+	Doc Version:	1.0
+	Author:			Jonathan Simon Jones
+	Date(D/M/Y):	16-10-2026
+	To do:
+*/
+
+#ifndef NARROWPHASE_H
+#define NARROWPHASE_H
+
+#include "AABB.h"
+#include "BatchAABB.h"
+
+// Math includes
+#include <glm/glm.hpp>
+
+// STL includes
+#include <vector>
+
+class ThreadPool;
+
+// A box face clipped against another gives up to 8 points, they are cut down to the 4
+// that keep the deepest point and the largest area
+const unsigned int maxManifoldPoints = 4;
+
+// Clipped points up to this far off the reference face are kept with a negative depth,
+// so a box resting on a face does not lose a corner to rounding and tip over the rest
+const float contactMargin = 0.02f;
+
+// Axes are numbered 0-2 for a's faces, 3-5 for b's faces and 6 + 3i + j for a's edge i
+// crossed with b's edge j
+const int satAxisCount = 15;
+const int noSeparatingAxis = -1;
+
+struct OrientedBox
+{
+	glm::vec3 center;
+	glm::vec3 axes[3];					// Unit length, the columns of the rotation
+	glm::vec3 halfExtents;
+};
+
+// Box index from the structure of arrays, the rotation is built from the quaternion
+OrientedBox getOrientedBox(const OrientedBoxSoA &boxes, unsigned int index);
+
+struct ContactManifold
+{
+	unsigned int a;
+	unsigned int b;
+	glm::vec3 normal;					// Unit length, pointing from a to b
+	glm::vec3 points[maxManifoldPoints];	// World space, halfway between the two surfaces
+	float depths[maxManifoldPoints];	// How far the surfaces overlap at each point, down to -contactMargin
+	unsigned int pointCount;
+	int axis;							// Axis the normal came from, see satAxisCount
+};
+
+// Unit axis number axis for the pair, not signed towards b
+glm::vec3 getSatAxis(const OrientedBox &a, const OrientedBox &b, int axis);
+
+// Returns true if the boxes overlap and writes their contacts to manifold, which may be
+// null when only the answer is wanted. On entry axis is the axis that separated the
+// pair last time or noSeparatingAxis, it is tried first. On exit it is the axis that
+// separated them or the one the contact normal came from.
+bool collideOBBOBB(const OrientedBox &a, const OrientedBox &b, int &axis, ContactManifold *manifold);
+
+// Totals of the last collide call
+struct NarrowphaseStats
+{
+	unsigned int pairsTested;
+	unsigned int separated;
+	unsigned int manifolds;
+	unsigned int points;
+
+	NarrowphaseStats(): pairsTested(0), separated(0), manifolds(0), points(0) {}
+};
+
+// Runs the pairs the broadphase found through collideOBBOBB, in batches of pairs on every
+// thread of the pool.
+class Narrowphase
+{
+public:
+	// pool may be null, in which case every batch is tested on the calling thread. Room for
+	// manifoldCapacity manifolds is allocated up front, more only if a frame needs it.
+	explicit Narrowphase(ThreadPool *pool = 0, unsigned int manifoldCapacity = 1024);
+
+	// pairs index boxes, returns the number of manifolds written
+	unsigned int collide(const OrientedBoxSoA &boxes, const BroadphasePair pairs[], unsigned int pairCount);
+
+	const ContactManifold* getManifolds() const { return m_manifolds.empty() ? 0 : &m_manifolds[0]; }
+	unsigned int getManifoldCount() const { return m_manifoldCount; }
+	// Manifold for the pair a, b in that order, null if they did not touch
+	const ContactManifold* findManifold(unsigned int a, unsigned int b) const;
+
+	const NarrowphaseStats& getStats() const { return m_stats; }
+
+private:
+	Narrowphase(const Narrowphase &);
+	Narrowphase& operator=(const Narrowphase &);
+
+	void collideBatch(const OrientedBoxSoA &boxes, const BroadphasePair pairs[], unsigned int pairCount, unsigned int batch);
+
+	ThreadPool *m_pool;
+
+	std::vector<ContactManifold> m_manifolds;
+	unsigned int m_manifoldCount;
+
+	// Each batch writes its manifolds from its own first pair's index on and they are packed
+	// together once every batch is done
+	std::vector<unsigned int> m_batchManifolds;
+	std::vector<NarrowphaseStats> m_batchStats;
+	NarrowphaseStats m_stats;
+};
+
+#endif // NARROWPHASE_H
@@ -0,0 +1,132 @@
+/*
+	Name:			PhysicsWorld.h
+	Project:		OpenGL
+	Description:	Rigid body store kept as structure of arrays and a fixed timestep integrator
+	Doc Version:	1.0
+	Author:			Jonathan Simon Jones
+	Date(D/M/Y):	16-10-2026
+	To do:
+*/
+
+#ifndef PHYSICSWORLD_H
+#define PHYSICSWORLD_H
+
+#include "BatchAABB.h"
+
+// Math includes
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+// STL includes
+#include <vector>
+
+class ContactSolver;
+class ContinuousCollision;
+class ThreadPool;
+
+// Rate of change of orientation for a body spinning at angularVelocity (radians per second)
+inline glm::fquat AngularVelocityToSpin(glm::fquat orientation, glm::vec3 angularVelocity)
+{
+	const float x = angularVelocity.x;
+	const float y = angularVelocity.y;
+	const float z = angularVelocity.z;
+
+	return 0.5f * glm::fquat(0, x, y, z) * orientation;
+}
+
+// Every body property lives in its own array so the integrator can load four or
+// eight bodies into a register at a time
+struct BodySoA
+{
+	std::vector<float> px, py, pz;			// Position
+	std::vector<float> vx, vy, vz;			// Linear velocity
+	std::vector<float> qw, qx, qy, qz;		// Orientation
+	std::vector<float> wx, wy, wz;			// Angular velocity
+	std::vector<float> hx, hy, hz;			// Half widths of the box
+	std::vector<float> inverseMass;			// 0 for bodies gravity does not move
+	std::vector<unsigned char> awake;		// 0 while asleep, nothing integrates, refits or pushes the body
+
+	unsigned int size() const { return (unsigned int)px.size(); }
+};
+
+// Bodies [begin, end)
+struct BodyRange
+{
+	unsigned int begin;
+	unsigned int end;
+};
+
+class PhysicsWorld
+{
+public:
+	// pool may be null, in which case everything runs on the calling thread
+	explicit PhysicsWorld(float fixedDt = 1.0f / 200.0f, ThreadPool *pool = 0);
+
+	unsigned int addBody(const glm::vec3 &position, const glm::fquat &orientation, const glm::vec3 &halfExtents, float inverseMass);
+
+	// Advances by as many fixed steps as fit in the accumulated time, at most maxSteps
+	// so a long stall does not snowball. Returns the number of steps taken.
+	unsigned int step(float frameTime, unsigned int maxSteps = 8);
+
+	// One semi-implicit Euler step of dt for every awake body, contacts are solved between
+	// gravity changing the velocities and the velocities moving the bodies. Fast bodies
+	// are then swept from where they started.
+	void integrate(float dt);
+
+	// Solver run by every step, may be null for bodies that pass through each other
+	void setContactSolver(ContactSolver *solver) { m_solver = solver; }
+	// Run once every step has moved the bodies, may be null to leave fast bodies to the solver
+	void setContinuousCollision(ContinuousCollision *ccd) { m_ccd = ccd; }
+
+	glm::vec3 getPosition(unsigned int body) const;
+	glm::fquat getOrientation(unsigned int body) const;
+	glm::vec3 getVelocity(unsigned int body) const;
+	glm::vec3 getAngularVelocity(unsigned int body) const;
+	glm::vec3 getHalfExtents(unsigned int body) const;
+
+	void setPosition(unsigned int body, const glm::vec3 &position);
+	void setOrientation(unsigned int body, const glm::fquat &orientation);
+	void setVelocity(unsigned int body, const glm::vec3 &velocity);
+	void setAngularVelocity(unsigned int body, const glm::vec3 &angularVelocity);
+
+	// A sleeping body is skipped by integrate until woken. Putting a body to sleep zeroes
+	// its velocities, any setter that changes the body wakes it.
+	void setAwake(unsigned int body, bool awake);
+	bool isAwake(unsigned int body) const { return m_bodies.awake[body] != 0; }
+	unsigned int getAwakeCount() const { return m_awakeCount; }
+	// Runs of consecutive awake bodies, cut so no run is more than a thread's share of work
+	const std::vector<BodyRange>& getAwakeRanges() const;
+
+	void setGravity(const glm::vec3 &gravity) { m_gravity = gravity; }
+	const glm::vec3& getGravity() const { return m_gravity; }
+
+	float getFixedDt() const { return m_fixedDt; }
+	// How far the accumulator is into the next step, for interpolating between states
+	float getInterpolationAlpha() const { return m_accumulator / m_fixedDt; }
+	unsigned int getBodyCount() const { return m_bodies.size(); }
+	unsigned long long getStepCount() const { return m_stepCount; }
+
+	const BodySoA& getBodies() const { return m_bodies; }
+
+	// View of every body as an oriented box, valid until a body is added
+	OrientedBoxSoA getOrientedBoxes() const;
+
+private:
+	void applyGravityRange(unsigned int begin, unsigned int end, float dt);
+	void integrateRange(unsigned int begin, unsigned int end, float dt);
+
+	BodySoA m_bodies;
+	glm::vec3 m_gravity;
+	float m_fixedDt;
+	float m_accumulator;
+	unsigned long long m_stepCount;
+	ThreadPool *m_pool;
+	ContactSolver *m_solver;
+	ContinuousCollision *m_ccd;
+
+	unsigned int m_awakeCount;
+	mutable std::vector<BodyRange> m_awakeRanges;	// Rebuilt when next asked for after a body sleeps or wakes
+	mutable bool m_awakeRangesDirty;
+};
+
+#endif // PHYSICSWORLD_H
@@ -0,0 +1,114 @@
+/*
+	Name:			Profiler.h
+	Project:		OpenGL
+	Description:	Scoped CPU zones, GPU spans and per frame counters, written out as a Chrome trace
+	Doc Version:	1.0
+	Author:			Jonathan Simon Jones
+	Date(D/M/Y):	16-10-2026
+	To do:
+*/
+
+#ifndef PROFILER_H
+#define PROFILER_H
+
+// STL includes
+#include <atomic>
+
+// Zones and counters stay compiled in and cost one relaxed load and a branch while
+// profiling is off. Defining PROFILER_DISABLED takes them out altogether.
+#ifndef PROFILER_DISABLED
+#define PROFILER_JOIN2(a, b) a##b
+#define PROFILER_JOIN(a, b) PROFILER_JOIN2(a, b)
+// Times the rest of the enclosing scope, name has to outlive the capture so use a literal
+#define PROFILE_ZONE(name) ProfileZone PROFILER_JOIN(profileZone, __LINE__)(name)
+#define PROFILE_COUNTER(name, value) profileCounter(name, value)
+#else
+#define PROFILE_ZONE(name)
+#define PROFILE_COUNTER(name, value)
+#endif
+
+// Set by startProfiling and stopProfiling, read by every zone
+extern std::atomic<bool> profilingEnabled;
+
+inline bool isProfiling()
+{
+	return profilingEnabled.load(std::memory_order_relaxed);
+}
+
+// Nanoseconds since the profiler's clock started, the time every event is written out in
+unsigned long long profilerNow();
+
+// What zones are timed with, the CPU's time stamp counter where there is one as it costs a
+// fraction of reading the system clock. Turned into nanoseconds when collected.
+unsigned long long profilerTicks();
+
+// Events are recorded from here on. Any that were collected but not written are dropped.
+void startProfiling();
+// Stops recording, what was collected stays until it is written or profiling starts again
+void stopProfiling();
+
+// Shown as the track's name in the trace, copied. Threads not named are numbered.
+void setProfilerThreadName(const char *name);
+
+// Adds a finished zone timed in profilerTicks to the calling thread's ring buffer, the
+// name is kept as a pointer
+void recordProfileZone(const char *name, unsigned long long start, unsigned long long end);
+// A span the GPU took, put on its own track, with times already moved onto profilerNow's clock
+void recordGpuZone(const char *name, unsigned long long start, unsigned long long end);
+// A value drawn as a graph over time, usually set once a frame
+void recordProfileCounter(const char *name, double value);
+
+inline void profileCounter(const char *name, double value)
+{
+	if(isProfiling())
+	{
+		recordProfileCounter(name, value);
+	}
+}
+
+// Moves what every thread has recorded into the capture. Call once a frame from one thread,
+// a ring buffer that fills up before it is collected drops events and counts them.
+void collectProfile();
+
+// Collects, then writes the capture as Chrome trace JSON, loadable in chrome://tracing or
+// ui.perfetto.dev, and empties it. Returns false if the file could not be written.
+bool writeChromeTrace(const char *path);
+
+// Totals of the capture so far
+struct ProfilerStats
+{
+	unsigned long long zones;
+	unsigned long long gpuZones;
+	unsigned long long counters;
+	unsigned long long dropped;			// Lost to full ring buffers
+
+	ProfilerStats(): zones(0), gpuZones(0), counters(0), dropped(0) {}
+};
+
+ProfilerStats getProfilerStats();
+
+class ProfileZone
+{
+public:
+	explicit ProfileZone(const char *name): m_name(isProfiling() ? name : 0)
+	, m_start(m_name ? profilerTicks() : 0)
+	{
+	}
+
+	~ProfileZone()
+	{
+		if(m_name)
+		{
+			recordProfileZone(m_name, m_start, profilerTicks());
+		}
+	}
+
+private:
+	ProfileZone(const ProfileZone &);
+	ProfileZone& operator=(const ProfileZone &);
+
+	const char *m_name;					// Null when profiling was off as the zone opened
+	unsigned long long m_start;
+};
+
+#endif // PROFILER_H
@@ -0,0 +1,46 @@
+/*
+	Name:			RenderBackend.h
+	Project:		OpenGL
+	Description:	Walks a sorted render queue and only changes state that differs from the last draw
+	Doc Version:	1.0
+	Author:			Jonathan Simon Jones
+	Date(D/M/Y):	16-10-2026
+	To do:
+*/
+
+#ifndef RENDERBACKEND_H
+#define RENDERBACKEND_H
+
+#include "RenderQueue.h"
+
+// Tracks what is bound and calls the apply functions only on a change. Derived classes
+// do the actual work, GLRenderBackend talks to OpenGL.
+class RenderBackend
+{
+public:
+	RenderBackend();
+	virtual ~RenderBackend() {}
+
+	// Issues every command in queue order. Bound state is treated as unknown at the
+	// start, so anything else may touch state between calls.
+	void execute(const RenderQueue &queue);
+
+protected:
+	virtual void applyProgram(unsigned int program) = 0;
+	virtual void applyVertexArray(unsigned int vertexArray) = 0;
+	virtual void applyBlend(bool blend) = 0;
+	virtual void applyModel(const float model[16]) = 0;
+	virtual void applyAlpha(float alpha) = 0;
+	virtual void draw(const RenderCommand &command) = 0;
+	// After the last command, a backend that only records draws does them here
+	virtual void flush() {}
+
+private:
+	unsigned int m_program;
+	unsigned int m_vertexArray;
+	bool m_blend;
+	float m_model[16];
+	float m_alpha;
+};
+
+#endif // RENDERBACKEND_H
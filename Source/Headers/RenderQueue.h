@@ -0,0 +1,105 @@
+/*
+	Name:			RenderQueue.h
+	Project:		OpenGL
+	Description:	Draw submissions recorded as commands and sorted by a 64 bit key
+	Doc Version:	1.0
+	Author:			Jonathan Simon Jones
+	Date(D/M/Y):	16-10-2026
+	To do:
+*/
+
+#ifndef RENDERQUEUE_H
+#define RENDERQUEUE_H
+
+// STL includes
+#include <vector>
+
+struct OrientedBoxSoA;
+
+// How a command's vertices are fetched
+enum DrawType
+{
+	DrawArrays,
+	DrawElements,						// Unsigned int indices from the vertex array's index buffer
+	DrawArraysInstanced,
+	DrawElementsInstanced
+};
+
+// Everything one draw needs. GL names and enums are kept as plain integers so the
+// queue can be built and sorted without a GL context.
+struct RenderCommand
+{
+	unsigned int program;
+	unsigned int vertexArray;
+	bool blend;							// Alpha blended, drawn after everything opaque
+
+	DrawType drawType;
+	unsigned int primitive;				// GL_TRIANGLES etc
+	unsigned int first;					// First vertex, or first index for DrawElements
+	unsigned int count;
+	unsigned int instanceCount;
+
+	// Per draw uniforms
+	float model[16];
+	float alpha;
+
+	RenderCommand();
+	void setModel(const float matrix[16]);
+};
+
+// Layout of one instance of an instanced cube draw, matches color3DInstanced.vert
+struct CubeInstance
+{
+	float position[3];
+	float scale[3];
+	float orientation[4];				// Unit quaternion as x, y, z, w
+};
+
+// One instance per body, the cube geometry being a unit cube each is scaled by the full width
+void makeCubeInstances(const OrientedBoxSoA &boxes, const std::vector<unsigned int> &bodies, std::vector<CubeInstance> &instances);
+
+// Sort key layout, most significant bit first.
+// Opaque:      0 | program 10 | vertex array 10 | depth 24 | unused 19
+// Translucent: 1 | inverted depth 24 | program 10 | vertex array 10 | unused 19
+// Opaque commands are grouped by state and go front to back within a group, translucent
+// commands go back to front regardless of state so blending stays correct.
+// depth is 0 at the camera and 1 at the far plane.
+unsigned long long makeSortKey(bool translucent, unsigned int program, unsigned int vertexArray, float depth);
+
+class RenderQueue
+{
+public:
+	void clear();
+	// Room for count commands in all, submitting up to that many then never allocates
+	void reserve(unsigned int count);
+
+	// Copies the command in, depth is its distance from the camera over the far plane distance
+	void submit(const RenderCommand &command, float depth);
+
+	// Orders the commands by key, equal keys keep submission order
+	void sort();
+
+	unsigned int size() const { return (unsigned int)m_entries.size(); }
+
+	// In sorted order once sort has been called, submission order before
+	const RenderCommand& getCommand(unsigned int index) const { return m_commands[m_entries[index].command]; }
+	unsigned long long getKey(unsigned int index) const { return m_entries[index].key; }
+
+private:
+	// Only these small entries are moved by the sort, commands stay where they were submitted
+	struct SortEntry
+	{
+		unsigned long long key;
+		unsigned int command;
+
+		bool operator<(const SortEntry &other) const
+		{
+			return key < other.key || (key == other.key && command < other.command);
+		}
+	};
+
+	std::vector<RenderCommand> m_commands;
+	std::vector<SortEntry> m_entries;
+};
+
+#endif // RENDERQUEUE_H
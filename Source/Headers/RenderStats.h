@@ -0,0 +1,47 @@
+/*
+	Name:			RenderStats.h
+	Project:		OpenGL
+	Description:	Per frame counters for the work handed to the graphics card
+	Doc Version:	1.0
+	Author:			Jonathan Simon Jones
+	Date(D/M/Y):	16-10-2026
+	To do:
+*/
+
+#ifndef RENDERSTATS_H
+#define RENDERSTATS_H
+
+struct RenderStats
+{
+	unsigned long long bytesUploaded;	// Everything copied into buffer objects
+	unsigned int uploads;				// Number of copies making up bytesUploaded
+	unsigned int fenceWaits;			// Times the CPU had to wait for the GPU to finish with a buffer
+	unsigned int drawCalls;
+	unsigned long long instances;		// Objects drawn, an instanced draw counts each instance
+	unsigned int stateChanges;			// Binds and uniform sets actually issued
+	unsigned int stateChangesSkipped;	// Ones left out because the value was already set
+
+	RenderStats(): bytesUploaded(0), uploads(0), fenceWaits(0), drawCalls(0), instances(0), stateChanges(0), stateChangesSkipped(0) {}
+	void reset() { *this = RenderStats(); }
+};
+
+// Counters for the frame being built, the render loop resets them once a frame
+RenderStats& getRenderStats();
+
+// Adds size bytes to this frame's upload total
+inline void countUpload(unsigned long long size)
+{
+	RenderStats &stats = getRenderStats();
+	stats.bytesUploaded += size;
+	++stats.uploads;
+}
+
+// Adds one draw call of instanceCount objects to this frame's totals
+inline void countDraw(unsigned int instanceCount = 1)
+{
+	RenderStats &stats = getRenderStats();
+	++stats.drawCalls;
+	stats.instances += instanceCount;
+}
+
+#endif // RENDERSTATS_H
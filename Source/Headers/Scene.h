@@ -0,0 +1,192 @@
+/*
+	Name:			Scene.h
+	Project:		OpenGL
+	Description:	Simulation state for the demo scene and the per frame update shared by
+					the windowed and headless builds
+	Doc Version:	1.0
+	Author:			Jonathan Simon Jones
+	Date(D/M/Y):	16-10-2026
+	To do:
+*/
+
+#ifndef SCENE_H
+#define SCENE_H
+
+#include "AABB.h"
+#include "BatchAABB.h"
+#include "ContactSolver.h"
+#include "ContinuousCollision.h"
+#include "Culling.h"
+#include "Islands.h"
+#include "Memory.h"
+#include "Narrowphase.h"
+#include "PhysicsWorld.h"
+#include "RenderQueue.h"
+#include "SceneGraph.h"
+#include "SweepAndPrune.h"
+
+// Math includes
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+// STL includes
+#include <vector>
+
+class ThreadPool;
+
+struct Scene
+{
+	// pool may be null, otherwise integration, refits, the narrowphase and the solver
+	// are spread over its threads
+	explicit Scene(ThreadPool *pool);
+
+	ThreadPool *pool;
+	PhysicsWorld world;
+	SweepAndPrune broadphase;
+
+	// Box 1 spins in the physics world
+	unsigned int box1Body;
+	glm::mat4 box1Model;
+	AABB BBB1;
+	extremes box1Extremes;
+	float boundingBoxCoords[48];			// Corners of box 1's AABB as position + color
+
+	// Box 2 is moved by the arrow keys, its body is put at box2Pos every frame
+	unsigned int box2Body;
+	glm::vec3 box2Pos;
+	AABB BBB2;
+
+	unsigned int box1Proxy;
+	unsigned int box2Proxy;
+	std::vector<unsigned int> proxyBodies;	// Body of every broadphase proxy
+	std::vector<unsigned int> bodyProxies;	// And the other way round
+
+	// Extra falling, spinning bodies used to load the headless runs
+	std::vector<unsigned int> clutterBodies;
+	std::vector<unsigned int> clutterProxies;
+	AABBSoA clutterBoxes;					// World boxes of every body, indexed by body
+
+	// The broadphase pairs as bodies, less those with nothing awake, then the ones whose
+	// boxes really touch, which the solver pushes apart during the next frame's steps.
+	// Fast bodies are given the broadphase as swept boxes and their pairs are swept
+	// through each step. Bodies that have come to rest sleep until something touches them.
+	std::vector<BroadphasePair> bodyPairs;
+	Narrowphase narrowphase;
+	ContactSolver solver;
+	ContinuousCollision ccd;
+	IslandManager islands;
+
+	bool colliding;							// Box 1 and box 2 touch
+	bool boxesOverlapAABB;					// Their AABBs overlap, which colliding needs but is not enough for
+	ContactManifold boxContact;				// Valid while colliding, normal from box 1 to box 2
+	unsigned int pairCount;
+};
+
+// Everything drawing the scene reads, copied out after a step so the simulation can go on
+// while it is drawn, possibly on another thread
+struct SceneSnapshot
+{
+	// Every body, indexed as in the world. Half widths never change but travel along so a
+	// snapshot can be drawn on its own.
+	std::vector<float> px, py, pz;
+	std::vector<float> qw, qx, qy, qz;
+	std::vector<float> hx, hy, hz;
+	unsigned int box1Body;
+	unsigned int box2Body;
+
+	glm::mat4 box1Model;
+	float boundingBoxCoords[48];
+	AABB BBB1;
+
+	// How the step went, never blended
+	bool colliding;
+	bool boxesOverlapAABB;
+	ContactManifold boxContact;
+	unsigned int pairCount;
+	unsigned int pairsTested;
+	unsigned int manifolds;
+	unsigned int awakeBodies;
+
+	double time;							// Seconds simulated up to the step
+	unsigned long long steps;
+	unsigned long long published;			// profilerNow as it was handed to the renderer, 0 if never
+
+	SceneSnapshot();
+
+	unsigned int getBodyCount() const { return (unsigned int)px.size(); }
+	// View of every body as an oriented box, valid until the snapshot is next written
+	OrientedBoxSoA getOrientedBoxes() const;
+};
+
+// What cullScene found worth drawing, kept by whoever draws
+struct SceneVisibility
+{
+	SceneCuller culler;
+	AABBSoA boxes;							// World boxes of every body, refit from the snapshot culled
+	std::vector<unsigned int> visibleClutter;	// Clutter bodies, occluders first
+	bool box1Visible;
+	bool box2Visible;
+
+	// What submitSceneDraws puts together each frame, the last frame's stays good while the
+	// next is put together
+	DoubleFrameArena frameMemory;
+	const float *clutterModels;				// Model matrices of visibleClutter, in frameMemory
+
+	SceneVisibility(): box1Visible(true), box2Visible(true), clutterModels(0) {}
+};
+
+// Transforms of what is placed rather than simulated, kept by whoever draws. The floor
+// hangs off the ground so moving the ground moves everything on it. The floor is the cube
+// mesh flattened, its top level with the bottom of box 2.
+struct SceneProps
+{
+	// pool may be null, otherwise large graph updates are spread over its threads
+	explicit SceneProps(ThreadPool *pool);
+
+	SceneGraph graph;
+	unsigned int groundNode;
+	unsigned int floorNode;
+};
+
+// Triangles over the eight corners calculateBoxExtremes writes, in the order it writes them
+extern const unsigned int boundingBoxIndices[36];
+
+// What the scene's draws are made with, GL names or a software backend's ids
+struct SceneDrawSetup
+{
+	unsigned int colorProgram;				// color3D.vert
+	unsigned int cubeVertexArray;			// The unit cube, indexed
+	unsigned int cubeIndexCount;
+	unsigned int boundingBoxVertexArray;	// boundingBoxCoords over boundingBoxIndices
+};
+
+// Adds count randomly placed spinning boxes around the origin
+void addSceneClutter(Scene &scene, unsigned int count);
+
+// Steps the simulation by frameTime, refits the AABBs of the awake bodies, runs the broadphase
+// and narrowphase, sleeps and wakes islands and hands the contacts to the solver and the
+// fast bodies' pairs to continuous collision
+void updateScene(Scene &scene, float frameTime);
+
+// Copies what drawing needs out of the scene as updateScene left it, stamped as step
+// number steps at time seconds
+void takeSceneSnapshot(const Scene &scene, double time, unsigned long long steps, SceneSnapshot &snapshot);
+
+// Positions blended and orientations normalised-blended alpha of the way from from to to,
+// box 1's model and bounding box worked out again. The rest is to's. Bodies to has that
+// from does not are copied from to.
+void interpolateSceneSnapshots(const SceneSnapshot &from, const SceneSnapshot &to, float alpha, SceneSnapshot &out);
+
+// Frustum and occlusion culls every body of snapshot as seen through viewProj from eye
+void cullScene(const SceneSnapshot &snapshot, const glm::mat4 &viewProj, const glm::vec3 &eye, SceneVisibility &visibility);
+// Marks every body visible, for drawing with culling off
+void showWholeScene(const SceneSnapshot &snapshot, SceneVisibility &visibility);
+
+// Submits box 1, box 2, box 1's bounding box and the floor as seen from eye, and with
+// perObjectClutter a draw per visible clutter body, their model matrices built in one batch
+// in visibility's frame memory. Otherwise the clutter is left to an instanced draw. The
+// props' graph is updated first, so whatever was moved since the last call is drawn where
+// it was put.
+void submitSceneDraws(const SceneSnapshot &snapshot, SceneVisibility &visibility, SceneProps &props, const SceneDrawSetup &setup, const glm::vec3 &eye, float farPlane, bool perObjectClutter, RenderQueue &queue);
+
+#endif // SCENE_H
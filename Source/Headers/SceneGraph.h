@@ -0,0 +1,123 @@
+/*
+	Name:			SceneGraph.h
+	Project:		OpenGL
+	Description:	Parent and child transforms kept in flat arrays, only what moved is worked out again
+	Doc Version:	1.0
+	Author:			Jonathan Simon Jones
+	Date(D/M/Y):	16-10-2026
+	To do:
+*/
+
+#ifndef SCENEGRAPH_H
+#define SCENEGRAPH_H
+
+// Math includes
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+// STL includes
+#include <vector>
+
+class ThreadPool;
+
+// Parent of a node with none, a root
+const unsigned int noParentNode = 0xffffffff;
+
+// Fewest nodes worth a job of their own when updating in parallel
+const unsigned int sceneGraphGrain = 1024;
+
+// Totals for the last update
+struct SceneGraphStats
+{
+	unsigned int nodes;
+	unsigned int marked;					// Nodes changed since the update before
+	unsigned int updated;					// Nodes whose world transform was worked out again
+	unsigned int ranges;					// Changed subtrees, each one run of the arrays
+	unsigned int chunks;					// Jobs the ranges were handed out in
+	bool reordered;							// Nodes were added out of order and the arrays sorted again
+
+	SceneGraphStats(): nodes(0), marked(0), updated(0), ranges(0), chunks(0), reordered(false) {}
+};
+
+// Every node has a local translation, rotation and scale and a world transform, its
+// parent's world transform times its local one. The arrays hold nodes in depth first order,
+// so a parent comes before its children and a node's whole subtree is the run of nodes
+// after it, as long as its subtree size. Changing a node only marks it. update walks the
+// marked nodes in order and works out each one's run again, those inside a run already
+// done are skipped, and nothing else is touched. Runs share no nodes and only read
+// parents outside them that are already up to date, so they go to the pool as they are.
+// A large run does its root first and splits into its children's runs.
+//
+// Nodes keep the index addNode returned, their place in the arrays is looked up through it.
+// A node added under a parent whose subtree is not the last in the arrays sorts them
+// again on the next update, which then does every node.
+class SceneGraph
+{
+public:
+	// With a pool, updates with enough to do are spread over its threads
+	explicit SceneGraph(ThreadPool *pool = 0);
+
+	// parent is noParentNode or a node added before this one
+	unsigned int addNode(unsigned int parent, const glm::vec3 &position, const glm::fquat &orientation, const glm::vec3 &scale);
+
+	void setLocalPosition(unsigned int node, const glm::vec3 &position);
+	void setLocalOrientation(unsigned int node, const glm::fquat &orientation);
+	void setLocalScale(unsigned int node, const glm::vec3 &scale);
+	void setLocalTransform(unsigned int node, const glm::vec3 &position, const glm::fquat &orientation);
+
+	glm::vec3 getLocalPosition(unsigned int node) const;
+	glm::fquat getLocalOrientation(unsigned int node) const;
+	glm::vec3 getLocalScale(unsigned int node) const;
+	unsigned int getParent(unsigned int node) const { return m_parents[node]; }
+	unsigned int getNodeCount() const { return (unsigned int)m_parents.size(); }
+
+	// Works out the world transform of every node changed since the last update and of
+	// everything below them
+	void update();
+
+	// As of the last update
+	const glm::mat4& getWorld(unsigned int node) const { return m_world[m_slots[node]]; }
+
+	const SceneGraphStats& getStats() const { return m_stats; }
+
+private:
+	SceneGraph(const SceneGraph &);
+	SceneGraph& operator=(const SceneGraph &);
+
+	struct Range
+	{
+		unsigned int begin;
+		unsigned int end;
+	};
+
+	void markDirty(unsigned int slot);
+	// Sorts the arrays depth first again after an out of order addNode
+	void reorder();
+	// Hands out [begin, end) whole, or does its root here and hands out its children's runs
+	void addRange(unsigned int begin, unsigned int end, unsigned int grain);
+	void updateRange(unsigned int begin, unsigned int end);
+
+	ThreadPool *m_pool;
+
+	// Indexed by node
+	std::vector<unsigned int> m_parents;
+	std::vector<unsigned int> m_slots;
+
+	// Indexed by place in the arrays, depth first
+	std::vector<unsigned int> m_nodes;
+	std::vector<unsigned int> m_parentSlots;
+	std::vector<unsigned int> m_subtreeSizes;	// The node itself included
+	std::vector<float> m_px, m_py, m_pz;
+	std::vector<float> m_qw, m_qx, m_qy, m_qz;
+	std::vector<float> m_sx, m_sy, m_sz;
+	std::vector<unsigned char> m_dirty;
+	std::vector<glm::mat4> m_world;
+
+	std::vector<unsigned int> m_dirtySlots;
+	std::vector<Range> m_ranges;
+	std::vector<Range> m_chunks;			// Runs of m_ranges, indices into it
+	bool m_outOfOrder;
+	SceneGraphStats m_stats;
+};
+
+#endif // SCENEGRAPH_H
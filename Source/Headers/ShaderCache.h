@@ -0,0 +1,131 @@
+/*
+	Name:			ShaderCache.h
+	Project:		OpenGL
+	Description:	Builds shader programs once, keeps linked binaries on disk and reloads edited shaders
+	Doc Version:	1.0
+	Author:			Jonathan Simon Jones
+	Date(D/M/Y):	16-10-2026
+	To do:
+*/
+
+#ifndef SHADERCACHE_H
+#define SHADERCACHE_H
+
+#include "AssetLoader.h"
+
+// OpenGL includes
+#include <GL/glew.h>
+
+// STL includes
+#include <condition_variable>
+#include <ctime>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+struct ShaderCacheStats
+{
+	unsigned int compiles;				// Shader stages compiled from source
+	unsigned int links;
+	unsigned int binaryLoads;			// Programs restored from the disk cache without compiling
+	unsigned int binarySaves;
+	unsigned int reloads;				// Programs rebuilt because one of their files changed
+	double seconds;						// Spent waiting on files, compiling, linking and loading binaries
+
+	ShaderCacheStats(): compiles(0), links(0), binaryLoads(0), binarySaves(0), reloads(0), seconds(0.0) {}
+};
+
+// Attributes are bound to fixed locations before linking so vertex array objects stay
+// valid when a program is rebuilt: position 0, color 1, instancePosition 2,
+// instanceScale 3, instanceOrientation 4. Fragment output outColor goes to buffer 0.
+class ShaderCache
+{
+public:
+	// Shader files are read through assets. Linked binaries are kept in cacheDirectory,
+	// keyed by a hash of the sources and the driver, pass "" to always compile. Shader
+	// files are checked for changes on a background thread every pollMilliseconds.
+	ShaderCache(AssetLoader &assets, const std::string &cacheDirectory, unsigned int pollMilliseconds = 250);
+	~ShaderCache();
+
+	// Returns a handle to the program built from the two files, asking for the same pair
+	// again returns the same handle. Both files load in parallel but this waits for them.
+	// getProgram gives 0 if it failed to build.
+	unsigned int load(const std::string &vertexFile, const std::string &fragmentFile);
+
+	GLuint getProgram(unsigned int handle) const { return m_programs[handle].name; }
+
+	// Locations are looked up once per program and remembered until it is rebuilt
+	GLint getUniformLocation(unsigned int handle, const std::string &name);
+	GLint getAttribLocation(unsigned int handle, const std::string &name);
+
+	// Same as getUniformLocation for code that only has the GL program name, -1 for programs
+	// this cache did not build
+	GLint getProgramUniformLocation(GLuint program, const std::string &name);
+
+	// Asks for the files of programs that changed since they were built and rebuilds the
+	// ones whose files have arrived, so a frame never waits on the disk. Call once a frame
+	// after AssetLoader::update on the thread that owns the GL context. A program that
+	// fails to build keeps its old version. Returns true if any program name changed,
+	// their uniforms need setting again.
+	bool update();
+
+	const ShaderCacheStats& getStats() const { return m_stats; }
+
+private:
+	ShaderCache(const ShaderCache &);
+	ShaderCache& operator=(const ShaderCache &);
+
+	struct Program
+	{
+		std::string vertexFile;
+		std::string fragmentFile;
+		GLuint name;
+		unsigned long long hash;		// Of both sources, 0 if they could not be read
+		bool reloading;					// Waiting on the two assets below
+		unsigned int vertexAsset;
+		unsigned int fragmentAsset;
+		std::map<std::string, GLint> uniforms;
+		std::map<std::string, GLint> attributes;
+	};
+
+	struct WatchedFile
+	{
+		std::string path;
+		unsigned int handle;
+		time_t modified;
+	};
+
+	unsigned long long hashSources(const MappedFile &vertexSource, const MappedFile &fragmentSource) const;
+
+	// Builds a program from the sources, from the disk cache when it has a binary for hash. The
+	// file names are only for the compile log
+	GLuint build(const std::string &vertexFile, const MappedFile &vertexSource, const std::string &fragmentFile, const MappedFile &fragmentSource, unsigned long long hash);
+	// Rebuilds from the program's two loaded assets and releases them, true if its name changed
+	bool rebuild(unsigned int handle);
+	GLuint loadBinary(unsigned long long hash);
+	void saveBinary(GLuint program, unsigned long long hash);
+	std::string binaryPath(unsigned long long hash) const;
+
+	void watchLoop();
+
+	AssetLoader &m_assets;
+	std::vector<Program> m_programs;
+	std::map<GLuint, unsigned int> m_handleByName;
+	std::string m_cacheDirectory;
+	std::string m_driver;				// Renderer and version, binaries only load on the driver that made them
+	bool m_binariesSupported;
+	ShaderCacheStats m_stats;
+
+	// Shared with the watcher thread
+	std::mutex m_mutex;
+	std::condition_variable m_wake;
+	std::vector<WatchedFile> m_watched;
+	std::vector<unsigned int> m_changed;	// Handles with a file that changed, may repeat
+	unsigned int m_pollMilliseconds;
+	bool m_quit;
+	std::thread m_watcher;
+};
+
+#endif // SHADERCACHE_H
@@ -0,0 +1,59 @@
+/*
+	Name:			Simd.h
+	Project:		OpenGL
+	Description:	SIMD instruction set detection and bit helpers shared by the batch kernels
+	Doc Version:	1.0
+	Author:			Jonathan Simon Jones
+	Date(D/M/Y):	16-10-2026
+	To do:
+*/
+
+#ifndef SIMD_H
+#define SIMD_H
+
+// SSE2 is always there on x86-64, on 32 bit only when the compiler was told to use it
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+	#define SIMD_HAS_SSE2 1
+	#include <immintrin.h>
+#else
+	#define SIMD_HAS_SSE2 0
+#endif
+
+// AVX2 kernels are compiled per function and only called when the CPU reports support
+#if SIMD_HAS_SSE2
+	#if defined(_MSC_VER)
+		#define SIMD_TARGET_AVX2
+	#else
+		#define SIMD_TARGET_AVX2 __attribute__((target("avx2")))
+	#endif
+#endif
+
+#if defined(_MSC_VER)
+	#include <intrin.h>
+#endif
+
+enum SimdLevel
+{
+	SimdScalar = 0,
+	SimdSSE2,
+	SimdAVX2
+};
+
+// Best level this CPU and build support, worked out once
+SimdLevel getSimdLevel();
+
+const char* getSimdLevelName(SimdLevel level);
+
+// Index of the lowest set bit, value must not be zero
+inline unsigned int countTrailingZeros(unsigned int value)
+{
+#if defined(_MSC_VER)
+	unsigned long index;
+	_BitScanForward(&index, value);
+	return (unsigned int)index;
+#else
+	return (unsigned int)__builtin_ctz(value);
+#endif
+}
+
+#endif // SIMD_H
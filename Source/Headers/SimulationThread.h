@@ -0,0 +1,111 @@
+/*
+	Name:			SimulationThread.h
+	Project:		OpenGL
+	Description:	Steps the scene at its fixed rate on a thread of its own and hands snapshots to the renderer
+	Doc Version:	1.0
+	Author:			Jonathan Simon Jones
+	Date(D/M/Y):	16-10-2026
+	To do:
+*/
+
+#ifndef SIMULATIONTHREAD_H
+#define SIMULATIONTHREAD_H
+
+#include "Scene.h"
+#include "TripleBuffer.h"
+
+// Math includes
+#include <glm/glm.hpp>
+
+// STL includes
+#include <atomic>
+#include <thread>
+
+// Steps the simulation can fall behind before the time is dropped rather than caught up
+const unsigned int maxCatchUpSteps = 8;
+
+// Totals since start, times in nanoseconds
+struct SimulationThreadStats
+{
+	// Simulation side
+	unsigned long long steps;
+	unsigned long long lateSteps;			// Started over a step after they were due
+	unsigned long long droppedSteps;		// Given up on after falling maxCatchUpSteps behind
+	unsigned long long unreadSnapshots;		// Written over before the renderer took them
+	unsigned long long longestStepGap;		// Between the starts of two steps
+
+	// Render side
+	unsigned long long frames;
+	unsigned long long staleFrames;			// Found nothing newer than the frame before
+	unsigned long long snapshotsTaken;
+	unsigned long long totalLatency;		// From a snapshot being published to the renderer taking it
+	unsigned long long maxLatency;
+	unsigned long long longestInterpolate;	// Taking and blending, the renderer never waits in it
+
+	SimulationThreadStats(): steps(0), lateSteps(0), droppedSteps(0), unreadSnapshots(0), longestStepGap(0)
+	, frames(0), staleFrames(0), snapshotsTaken(0), totalLatency(0), maxLatency(0), longestInterpolate(0) {}
+};
+
+// Runs updateScene once every fixed step of the scene's world on its own thread, which
+// owns the scene from start until stop. After every step the transforms are copied into
+// a triple buffer, so the renderer takes the latest whenever it likes and neither side
+// ever waits for the other. The renderer blends the two latest snapshots by how far it
+// is into the step after the newer one was published, which shows the simulation one
+// step late but moving smoothly at any refresh rate.
+class SimulationThread
+{
+public:
+	explicit SimulationThread(Scene &scene);
+	// Stops the thread if it is still running
+	~SimulationThread();
+
+	// Publishes the scene as it is now, so there is something to draw straight away,
+	// and starts stepping
+	void start();
+	// Returns once the step under way has finished, the scene is the caller's again
+	void stop();
+	bool isRunning() const { return m_thread.joinable(); }
+
+	// Render thread only. Takes the latest snapshot if there is a newer one and writes
+	// the two latest blended for the time now to out.
+	void interpolate(SceneSnapshot &out);
+
+	// Render thread only. Where the keys have put box 2, picked up by the next step.
+	void setBox2Position(const glm::vec3 &position);
+
+	// Sleeps this long in every step, standing in for a slow simulation when measuring
+	void setStepDelay(unsigned int microseconds) { m_stepDelay.store(microseconds, std::memory_order_relaxed); }
+
+	// Render thread only
+	SimulationThreadStats getStats() const;
+
+private:
+	SimulationThread(const SimulationThread &);
+	SimulationThread& operator=(const SimulationThread &);
+
+	void run();
+
+	Scene &m_scene;
+	float m_dt;								// The world's fixed step, kept so the renderer never reads the scene
+	std::thread m_thread;
+	std::atomic<bool> m_running;
+	std::atomic<unsigned int> m_stepDelay;
+
+	TripleBuffer<SceneSnapshot> m_snapshots;
+	TripleBuffer<glm::vec3> m_box2Positions;
+
+	// The snapshot before the read buffer's, the renderer's own
+	SceneSnapshot m_previous;
+
+	// Written by the simulation thread, read by the renderer
+	std::atomic<unsigned long long> m_steps;
+	std::atomic<unsigned long long> m_lateSteps;
+	std::atomic<unsigned long long> m_droppedSteps;
+	std::atomic<unsigned long long> m_unreadSnapshots;
+	std::atomic<unsigned long long> m_longestStepGap;
+
+	// The renderer's own
+	SimulationThreadStats m_renderStats;
+};
+
+#endif // SIMULATIONTHREAD_H
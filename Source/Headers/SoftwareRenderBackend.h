@@ -0,0 +1,222 @@
+/*
+	Name:			SoftwareRenderBackend.h
+	Project:		OpenGL
+	Description:	Render backend that draws the queue's commands on the CPU into tiles of a framebuffer
+	Doc Version:	1.0
+	Author:			Jonathan Simon Jones
+	Date(D/M/Y):	16-10-2026
+	To do:
+*/
+
+#ifndef SOFTWARERENDERBACKEND_H
+#define SOFTWARERENDERBACKEND_H
+
+#include "Mesh.h"
+#include "RenderBackend.h"
+#include "Simd.h"
+
+// Math includes
+#include <glm/glm.hpp>
+
+// STL includes
+#include <vector>
+
+class ThreadPool;
+
+// The vertex shaders the scene draws with, run on the CPU. Both feed inputColor.frag.
+enum SoftwareProgram
+{
+	SoftwareColor3D,					// color3D.vert, proj * view * model * position
+	SoftwareColor3DInstanced			// color3DInstanced.vert, one CubeInstance per instance
+};
+
+// Side of the square tiles the framebuffer is split into, a tile is only ever drawn by one thread
+const unsigned int softwareTileSize = 64;
+
+// Colors as 8 bit RGBA, top row first, and depth as NDC z. Rows are padded out to whole tiles.
+class Framebuffer
+{
+public:
+	Framebuffer(unsigned int width, unsigned int height);
+
+	unsigned int getWidth() const { return m_width; }
+	unsigned int getHeight() const { return m_height; }
+	// Pixels from one row to the next
+	unsigned int getStride() const { return m_stride; }
+
+	// R in the lowest byte, as the bytes lie in memory on a little endian CPU
+	unsigned int getPixel(unsigned int x, unsigned int y) const { return m_color[y * m_stride + x]; }
+	float getDepth(unsigned int x, unsigned int y) const { return m_depth[y * m_stride + x]; }
+
+	unsigned int* getColorRow(unsigned int y) { return &m_color[y * m_stride]; }
+	float* getDepthRow(unsigned int y) { return &m_depth[y * m_stride]; }
+
+	// FNV-1a over the visible pixels, equal images give equal hashes
+	unsigned long long hash() const;
+
+	// Writes the visible pixels as an RGBA PNG for comparing against golden images. The
+	// image data is stored uncompressed so nothing outside the STL is needed.
+	bool writePng(const char *path) const;
+
+private:
+	unsigned int m_width;
+	unsigned int m_height;
+	unsigned int m_stride;
+	std::vector<unsigned int> m_color;
+	std::vector<float> m_depth;
+};
+
+// Totals of the last execute
+struct SoftwareRenderStats
+{
+	unsigned int draws;
+	unsigned int vertices;				// Run through the vertex stage, per instance
+	unsigned int triangles;				// Assembled from the draws
+	unsigned int clipped;				// Crossing a frustum plane and cut down to what is inside
+	unsigned int culled;				// Wholly outside the frustum, with no area or covering no pixel centre
+	unsigned int binned;				// Triangle and tile pairs
+	unsigned long long fragments;		// Pixels that passed the depth test and were written
+
+	SoftwareRenderStats(): draws(0), vertices(0), triangles(0), clipped(0), culled(0), binned(0), fragments(0) {}
+};
+
+// Draws are only recorded as they are issued. Once the queue has been walked their
+// vertices are transformed four at a time and their triangles clipped, set up and binned
+// into every tile they touch, spread over the pool in batches. Each tile is then cleared
+// and rasterized by one thread, its triangles in issue order so blending and equal depths
+// come out as they would on the GPU. Only GL_TRIANGLES are drawn.
+//
+// Depth testing is GL_LESS with depth writes on, blending is what GLRenderBackend sets,
+// GL_SRC_COLOR and GL_ONE_MINUS_SRC_COLOR. Pixel centres on a shared edge go to one
+// triangle only. Width and height are at most 2048 so edge functions fit in 32 bits.
+class SoftwareRenderBackend : public RenderBackend
+{
+public:
+	// pool may be null, in which case everything runs on the calling thread
+	SoftwareRenderBackend(unsigned int width, unsigned int height, ThreadPool *pool = 0);
+
+	// What commands use as program and vertexArray, ids start at 1
+	unsigned int createProgram(SoftwareProgram program);
+	// Vertices are position + color, meshVertexFloats each, indices may be null. Both are copied.
+	unsigned int createVertexArray(const float *vertices, unsigned int vertexCount, const unsigned int *indices, unsigned int indexCount);
+	// For geometry that changes every frame, copied
+	void setVertices(unsigned int vertexArray, const float *vertices, unsigned int vertexCount);
+	// What instanced draws of vertexArray read, copied
+	void setInstances(unsigned int vertexArray, const CubeInstance *instances, unsigned int count);
+
+	// The uniforms every program shares, as setSharedUniforms sets them for GL
+	void setViewProj(const glm::mat4 &view, const glm::mat4 &proj);
+	// Each execute starts from a framebuffer cleared to this and the far plane
+	void setClearColor(float r, float g, float b, float a);
+
+	// Never goes above what the CPU can run, AVX2 runs the SSE2 kernels
+	void setSimdLevel(SimdLevel level);
+	SimdLevel getSimdLevel() const { return m_simdLevel; }
+
+	const Framebuffer& getFramebuffer() const { return m_framebuffer; }
+	const SoftwareRenderStats& getStats() const { return m_stats; }
+
+protected:
+	virtual void applyProgram(unsigned int program);
+	virtual void applyVertexArray(unsigned int vertexArray);
+	virtual void applyBlend(bool blend);
+	virtual void applyModel(const float model[16]);
+	virtual void applyAlpha(float alpha);
+	virtual void draw(const RenderCommand &command);
+	virtual void flush();
+
+private:
+	SoftwareRenderBackend(const SoftwareRenderBackend &);
+	SoftwareRenderBackend& operator=(const SoftwareRenderBackend &);
+
+	struct VertexArray
+	{
+		std::vector<float> vertices;
+		std::vector<unsigned int> indices;
+		std::vector<CubeInstance> instances;
+
+		unsigned int getVertexCount() const { return (unsigned int)(vertices.size() / meshVertexFloats); }
+	};
+
+	// A command as it was issued, with the state bound at the time
+	struct Draw
+	{
+		SoftwareProgram program;
+		unsigned int vertexArray;
+		bool blend;
+		glm::mat4 model;
+		float alpha;
+		DrawType drawType;
+		unsigned int first;
+		unsigned int count;
+		unsigned int instanceCount;
+	};
+
+	// Triangles [first, first + count) of instances [instanceBegin, instanceEnd) of a draw,
+	// what one job of the vertex stage takes
+	struct Batch
+	{
+		unsigned int draw;
+		unsigned int first;
+		unsigned int count;
+		unsigned int instanceBegin;
+		unsigned int instanceEnd;
+	};
+
+	// Ready to rasterize, wound so the area is positive
+	struct Triangle
+	{
+		int x[3], y[3];					// Screen position, 28.4 fixed point with y down
+		// Attributes as their value at the first corner and their change per unit of the
+		// edge functions weighting the second and third
+		float depth[3];					// NDC z
+		float invW[3];
+		float color[4][3];				// Divided by w so they interpolate perspective correct
+		int minX, minY, maxX, maxY;		// Pixels that can be covered, inside the framebuffer
+		bool blend;
+	};
+
+	// Everything one batch made, kept between frames so they stop allocating
+	struct BatchOutput
+	{
+		std::vector<Triangle> triangles;
+		std::vector<float> clip;		// Transformed vertices, a run of x then of y, z and w
+		SoftwareRenderStats stats;
+	};
+
+	void runBatch(unsigned int batch);
+	void binTriangles();
+	void rasterizeTile(unsigned int tile);
+
+	ThreadPool *m_pool;
+	Framebuffer m_framebuffer;
+	unsigned int m_tilesX;
+	unsigned int m_tilesY;
+
+	std::vector<SoftwareProgram> m_programs;
+	std::vector<VertexArray> m_vertexArrays;
+	glm::mat4 m_viewProj;
+	float m_clearColor[4];
+	SimdLevel m_simdLevel;
+
+	// Bound state
+	SoftwareProgram m_program;
+	unsigned int m_vertexArray;
+	bool m_blend;
+	glm::mat4 m_model;
+	float m_alpha;
+
+	std::vector<Draw> m_draws;
+	std::vector<Batch> m_batches;
+	std::vector<BatchOutput> m_outputs;
+
+	// Triangles of tile t are m_binned[m_binStarts[t], m_binStarts[t + 1])
+	std::vector<const Triangle*> m_binned;
+	std::vector<unsigned int> m_binStarts;
+	std::vector<unsigned int> m_binFill;
+	std::vector<unsigned long long> m_tileFragments;
+
+	SoftwareRenderStats m_stats;
+};
+
+#endif // SOFTWARERENDERBACKEND_H
@@ -0,0 +1,72 @@
+/*
+	Name:			SweepAndPrune.h
+	Project:		OpenGL
+	Description:	Incremental sort and sweep broadphase over AABBs
+	Doc Version:	1.0
+	Author:			Jonathan Simon Jones
+	Date(D/M/Y):	16-10-2026
+	To do:
+*/
+
+#ifndef SWEEPANDPRUNE_H
+#define SWEEPANDPRUNE_H
+
+#include "AABB.h"
+
+// STL includes
+#include <vector>
+
+// Keeps the min/max endpoints of every body sorted along one axis between frames.
+// Bodies only move a little each frame so the endpoints are almost sorted already
+// and an insertion sort brings them back in close to linear time.
+class SweepAndPrune
+{
+public:
+	SweepAndPrune();
+
+	// Returns a handle used to update or remove the body
+	unsigned int addBody(const AABB &box);
+	void removeBody(unsigned int body);
+	void updateBody(unsigned int body, const AABB &box);
+
+	// Re-sorts the endpoints and sweeps them, the list stays valid until the next call
+	const std::vector<BroadphasePair>& findOverlappingPairs();
+
+	const std::vector<BroadphasePair>& getPairs() const { return m_pairs; }
+	const AABB& getBox(unsigned int body) const { return m_boxes[body]; }
+	unsigned int getBodyCount() const { return m_bodyCount; }
+	unsigned int getSortAxis() const { return m_axis; }
+
+private:
+	// Body handle in the upper bits, lowest bit set for a max endpoint
+	struct Endpoint
+	{
+		float value;
+		unsigned int data;
+	};
+
+	void chooseSortAxis();
+	void refreshEndpoints();
+	void insertionSort();
+	void fullSort();
+	void sweep();
+
+	static bool endpointLess(const Endpoint &a, const Endpoint &b);
+
+	std::vector<AABB> m_boxes;
+	std::vector<unsigned char> m_alive;
+	std::vector<unsigned int> m_freeBodies;
+	std::vector<Endpoint> m_endpoints;
+	std::vector<BroadphasePair> m_pairs;
+
+	// Scratch used by the sweep, kept to avoid reallocating every frame
+	std::vector<unsigned int> m_open;
+	std::vector<unsigned int> m_openSlot;
+
+	unsigned int m_bodyCount;
+	unsigned int m_axis;
+	unsigned int m_insertedSinceSort;
+	bool m_needsFullSort;
+};
+
+#endif // SWEEPANDPRUNE_H
@@ -0,0 +1,148 @@
+/*
+	Name:			ThreadPool.h
+	Project:		OpenGL
+	Description:	Worker threads that run jobs from their own deques and steal from each other's
+	Doc Version:	1.0
+	Author:			Jonathan Simon Jones
+	Date(D/M/Y):	16-10-2026
+	To do:
+*/
+
+#ifndef THREADPOOL_H
+#define THREADPOOL_H
+
+#include "Memory.h"
+
+// STL includes
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+struct Job;
+
+// Jobs given to run with a counter raise it and lower it again when they finish. It can
+// be waited on, or handed to run as what a job has to wait for. Only reuse a counter
+// once it has been waited on.
+class JobCounter
+{
+public:
+	JobCounter(): m_pending(0), m_waiting(0) {}
+
+	bool isDone() const { return m_pending.load() == 0; }
+
+private:
+	friend class ThreadPool;
+
+	JobCounter(const JobCounter &);
+	JobCounter& operator=(const JobCounter &);
+
+	std::atomic<unsigned int> m_pending;
+	// The last job to finish lowers the count to 0 while holding this, so a waiter that
+	// takes it after seeing 0 knows nothing touches the counter any more
+	std::mutex m_mutex;
+	Job *m_waiting;							// Jobs held back until the count reaches 0
+};
+
+// Totals since the last resetStats
+struct JobStats
+{
+	unsigned long long jobs;
+	unsigned long long stolen;				// Run by a thread other than the one that queued them
+
+	JobStats(): jobs(0), stolen(0) {}
+};
+
+// Every thread, the one that made the pool included, owns a deque of jobs. A thread pushes
+// and pops its own jobs at the bottom without locking and takes from the top of the
+// others' when it runs out. Threads that find nothing anywhere sleep until a job is queued.
+class ThreadPool
+{
+public:
+	typedef std::function<void()> Task;
+
+	// Called with [begin, end) for each chunk of a parallelFor. It only refers to the function
+	// it is made from, which lives until parallelFor returns, so unlike std::function it never
+	// copies a lambda's captures to the heap.
+	class RangeTask
+	{
+	public:
+		template<class Function>
+		RangeTask(const Function &function): m_function(&function)
+		, m_call(&call<Function>)
+		{
+		}
+
+		void operator()(unsigned int begin, unsigned int end) const { m_call(m_function, begin, end); }
+
+	private:
+		template<class Function>
+		static void call(const void *function, unsigned int begin, unsigned int end)
+		{
+			(*static_cast<const Function*>(function))(begin, end);
+		}
+
+		const void *m_function;
+		void (*m_call)(const void *function, unsigned int begin, unsigned int end);
+	};
+
+	// threadCount includes the calling thread, 0 uses every hardware thread
+	explicit ThreadPool(unsigned int threadCount = 0);
+	// Every job has to have been waited on
+	~ThreadPool();
+
+	// Queues task, counter may be null. With after it is held back until after's jobs
+	// have all finished. Threads outside the pool queue on a shared, locked list.
+	void run(const Task &task, JobCounter *counter, JobCounter *after = 0);
+
+	// Runs jobs on the calling thread until counter's have all finished
+	void wait(JobCounter &counter);
+
+	// Splits [0, count) into chunks of grain and returns once all of them are done. The
+	// calling thread halves the range and queues one half until it is down to a chunk,
+	// threads that steal a half do the same. Can be called from inside a job.
+	void parallelFor(unsigned int count, unsigned int grain, const RangeTask &task);
+
+	unsigned int getThreadCount() const { return (unsigned int)m_workers.size(); }
+
+	JobStats getStats() const;
+	void resetStats();
+
+private:
+	ThreadPool(const ThreadPool &);
+	ThreadPool& operator=(const ThreadPool &);
+
+	struct Worker;
+
+	Worker* findWorker() const;
+	Job* allocateJob(Worker *worker);
+	void releaseJob(Worker *worker, Job *job);
+	void queue(Worker *worker, Job *job);
+	Job* findJob(Worker *worker);
+	void execute(Worker *worker, Job *job);
+	void finish(Worker *worker, JobCounter *counter);
+	void workerLoop(unsigned int index);
+
+	// Index 0 is the thread that made the pool, the rest have a std::thread each
+	std::vector<Worker*> m_workers;
+	std::vector<std::thread> m_threads;
+
+	// Jobs queued from outside the pool and the sleeping threads, under m_mutex
+	std::mutex m_mutex;
+	std::condition_variable m_wake;
+	std::vector<Job*> m_foreignJobs;
+	std::atomic<unsigned int> m_queued;		// Jobs in any deque or the foreign list
+	std::atomic<unsigned int> m_sleeping;
+	bool m_quit;
+
+	// Jobs are made in m_jobPool. A worker keeps the ones it finishes and swaps batches with
+	// the spares, so jobs finished by a thief come back round rather than the thread that
+	// queued them going on making more. Both under m_jobMutex.
+	std::mutex m_jobMutex;
+	FixedPool m_jobPool;
+	std::vector<Job*> m_spareJobs;
+};
+
+#endif // THREADPOOL_H
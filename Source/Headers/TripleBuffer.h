@@ -0,0 +1,85 @@
+/*
+	Name:			TripleBuffer.h
+	Project:		OpenGL
+	Description:	Lock free hand over of whole values from one writing thread to one reading thread
+	Doc Version:	1.0
+	Author:			Jonathan Simon Jones
+	Date(D/M/Y):	16-10-2026
+	To do:
+*/
+
+#ifndef TRIPLEBUFFER_H
+#define TRIPLEBUFFER_H
+
+// STL includes
+#include <atomic>
+
+// Three values, one the writer fills, one the reader reads and one in between. Publishing
+// swaps the writer's with the one in between and acquiring swaps the reader's with it, each
+// a single atomic exchange, so neither side ever waits for the other. A reader slower than
+// the writer only sees the latest value, the ones it missed are written over.
+//
+// Each side keeps its value until it swaps it away, so values holding vectors stop
+// allocating once all three have grown to size.
+template<class T>
+class TripleBuffer
+{
+public:
+	TripleBuffer(): m_write(0)
+	, m_read(2)
+	, m_middle(1)
+	{
+	}
+
+	// Only the writing thread, valid until the next publish
+	T& getWriteBuffer() { return m_buffers[m_write]; }
+
+	// Hands the write buffer over and takes another to write into, whose contents are
+	// whatever was last there. Returns false if the value published before this one was
+	// never acquired and has been written over.
+	bool publish()
+	{
+		const unsigned int previous = m_middle.exchange(m_write | freshBit, std::memory_order_acq_rel);
+		m_write = previous & indexMask;
+		return (previous & freshBit) == 0;
+	}
+
+	// True if acquire would take a new value. Only the reading thread, the writer can make
+	// it true at any time but only acquire makes it false again.
+	bool isFresh() const
+	{
+		return (m_middle.load(std::memory_order_relaxed) & freshBit) != 0;
+	}
+
+	// Only the reading thread. Takes the latest published value if there is one newer than
+	// the read buffer's, returns false and leaves the read buffer alone otherwise.
+	bool acquire()
+	{
+		if(!isFresh())
+		{
+			return false;
+		}
+
+		const unsigned int previous = m_middle.exchange(m_read, std::memory_order_acq_rel);
+		m_read = previous & indexMask;
+		return true;
+	}
+
+	// Only the reading thread, valid until the next acquire that returns true
+	T& getReadBuffer() { return m_buffers[m_read]; }
+	const T& getReadBuffer() const { return m_buffers[m_read]; }
+
+private:
+	TripleBuffer(const TripleBuffer &);
+	TripleBuffer& operator=(const TripleBuffer &);
+
+	static const unsigned int indexMask = 3;
+	static const unsigned int freshBit = 4;		// Set on the middle index by publish, cleared by acquire
+
+	T m_buffers[3];
+	unsigned int m_write;					// Writer's own
+	unsigned int m_read;					// Reader's own
+	std::atomic<unsigned int> m_middle;		// Index of the one in between, with freshBit
+};
+
+#endif // TRIPLEBUFFER_H
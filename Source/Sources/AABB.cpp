@@ -0,0 +1,124 @@
+/*
+	Name:			AABB.cpp
+	Project:		OpenGL
+	Description:	Axis aligned bounding box overlap test
+	Doc Version:	1.0
+	Author:			Jonathan Simon Jones
+	Date(D/M/Y):	16-10-2026
+	To do:			
+*/
+
+#include "AABB.h"
+
+// STL includes
+#include <algorithm>
+
+bool testAABBAABB(const AABB &a, const AABB &b)
+{
+	if(glm::abs(a.center_position.x - b.center_position.x) > (a.radius.x + b.radius.x)) return false;
+	if(glm::abs(a.center_position.y - b.center_position.y) > (a.radius.y + b.radius.y))	return false;
+	if(glm::abs(a.center_position.z - b.center_position.z) > (a.radius.z + b.radius.z)) return false;
+				
+	return true;
+}
+
+bool sweepAABBAABB(const AABB &a, const glm::vec3 &motion, const AABB &b, float &time)
+{
+	// b grown by a's half widths against a's centre moving along a ray, the ray is inside
+	// the grown box between the latest entry and the earliest exit over the three slabs
+	float enter = 0.0f;
+	float leave = 1.0f;
+	for(int i = 0; i < 3; ++i)
+	{
+		const float offset = b.center_position[i] - a.center_position[i];
+		const float reach = a.radius[i] + b.radius[i];
+		if(glm::abs(motion[i]) < 1e-12f)
+		{
+			if(glm::abs(offset) > reach) return false;
+			continue;
+		}
+
+		float slabEnter = (offset - reach) / motion[i];
+		float slabLeave = (offset + reach) / motion[i];
+		if(slabEnter > slabLeave)
+		{
+			std::swap(slabEnter, slabLeave);
+		}
+
+		enter = std::max(enter, slabEnter);
+		leave = std::min(leave, slabLeave);
+		if(enter > leave) return false;
+	}
+
+	time = enter;
+	return true;
+}
+
+AABB computeWorldAABB(const glm::mat4 &model, const glm::vec3 &halfExtents)
+{
+	AABB box;
+	computeWorldAABBs(&model, halfExtents, 1, &box);
+	return box;
+}
+
+void computeWorldAABBs(const glm::mat4 models[], const glm::vec3 &halfExtents, unsigned int count, AABB out[])
+{
+#if SIMD_HAS_SSE2
+	const __m128 signMask = _mm_castsi128_ps(_mm_set1_epi32(0x80000000));
+	const __m128 ex = _mm_set1_ps(halfExtents.x);
+	const __m128 ey = _mm_set1_ps(halfExtents.y);
+	const __m128 ez = _mm_set1_ps(halfExtents.z);
+
+	for(unsigned int i = 0; i < count; ++i)
+	{
+		// glm stores columns contiguously, each load is one column of x, y, z, w
+		const float *m = &models[i][0][0];
+		const __m128 c0 = _mm_andnot_ps(signMask, _mm_loadu_ps(m));
+		const __m128 c1 = _mm_andnot_ps(signMask, _mm_loadu_ps(m + 4));
+		const __m128 c2 = _mm_andnot_ps(signMask, _mm_loadu_ps(m + 8));
+		const __m128 extent = _mm_add_ps(_mm_add_ps(_mm_mul_ps(c0, ex), _mm_mul_ps(c1, ey)), _mm_mul_ps(c2, ez));
+
+		float radius[4];
+		_mm_storeu_ps(radius, extent);
+		out[i].center_position = glm::vec3(m[12], m[13], m[14]);
+		out[i].radius = glm::vec3(radius[0], radius[1], radius[2]);
+	}
+#else
+	for(unsigned int i = 0; i < count; ++i)
+	{
+		const glm::mat4 &m = models[i];
+		out[i].center_position = glm::vec3(m[3]);
+		out[i].radius = glm::abs(glm::vec3(m[0])) * halfExtents.x
+			+ glm::abs(glm::vec3(m[1])) * halfExtents.y
+			+ glm::abs(glm::vec3(m[2])) * halfExtents.z;
+	}
+#endif
+}
+
+void calculateBoxExtremes(const glm::mat4 &transformMat, float newBoxCoords[], extremes &boxExtremes)
+{
+	const AABB box = computeWorldAABB(transformMat, glm::vec3(0.5f, 0.5f, 0.5f));
+
+	boxExtremes.minX = box.center_position.x - box.radius.x;
+	boxExtremes.maxX = box.center_position.x + box.radius.x;
+	boxExtremes.minY = box.center_position.y - box.radius.y;
+	boxExtremes.maxY = box.center_position.y + box.radius.y;
+	boxExtremes.minZ = box.center_position.z - box.radius.z;
+	boxExtremes.maxZ = box.center_position.z + box.radius.z;
+
+	// Corners in the order the element buffer expects, bottom face then top face
+	const float xs[4] = { boxExtremes.minX, boxExtremes.maxX, boxExtremes.maxX, boxExtremes.minX };
+	const float ys[4] = { boxExtremes.minY, boxExtremes.minY, boxExtremes.maxY, boxExtremes.maxY };
+	const float zs[2] = { boxExtremes.minZ, boxExtremes.maxZ };
+
+	for(unsigned int corner = 0; corner < 8; ++corner)
+	{
+		float *vertex = &newBoxCoords[corner * 6];
+		vertex[0] = xs[corner & 3];
+		vertex[1] = ys[corner & 3];
+		vertex[2] = zs[corner >> 2];
+		vertex[3] = 0.3f;
+		vertex[4] = 0.3f;
+		vertex[5] = 0.3f;
+	}
+}
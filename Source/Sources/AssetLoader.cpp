@@ -0,0 +1,324 @@
+/*
+	Name:			AssetLoader.cpp
+	Project:		OpenGL
+	Description:	Memory mapped files and a background thread pool that maps them
+	Doc Version:	1.0
+	Author:			Jonathan Simon Jones
+	Date(D/M/Y):	16-10-2026
+	To do:
+*/
+
+#include "AssetLoader.h"
+
+// STL includes
+#include <cstdio>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <Windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace
+{
+	// Smallest page size in use, touching more often than needed is harmless
+	const size_t pageSize = 4096;
+
+	// Empty files point here so getData is never null for an open file
+	const char emptyFile[1] = { 0 };
+}
+
+MappedFile::MappedFile(): m_data(0)
+, m_size(0)
+, m_mapped(false)
+#ifdef _WIN32
+, m_file(INVALID_HANDLE_VALUE)
+, m_mapping(0)
+#endif
+{
+}
+
+MappedFile::~MappedFile()
+{
+	close();
+}
+
+#ifdef _WIN32
+bool MappedFile::open(const std::string &path)
+{
+	close();
+
+	HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+	if(file == INVALID_HANDLE_VALUE)
+	{
+		return false;
+	}
+
+	LARGE_INTEGER size;
+	if(!GetFileSizeEx(file, &size))
+	{
+		CloseHandle(file);
+		return false;
+	}
+
+	if(size.QuadPart == 0)
+	{
+		CloseHandle(file);
+		m_data = emptyFile;
+		return true;
+	}
+
+	HANDLE mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+	const void *view = mapping ? MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0) : NULL;
+	if(!view)
+	{
+		if(mapping)
+		{
+			CloseHandle(mapping);
+		}
+		CloseHandle(file);
+		return false;
+	}
+
+	m_file = file;
+	m_mapping = mapping;
+	m_data = (const char*)view;
+	m_size = (size_t)size.QuadPart;
+	m_mapped = true;
+	return true;
+}
+
+void MappedFile::close()
+{
+	if(m_mapped)
+	{
+		UnmapViewOfFile(m_data);
+		CloseHandle(m_mapping);
+		CloseHandle(m_file);
+	}
+
+	m_file = INVALID_HANDLE_VALUE;
+	m_mapping = 0;
+	m_data = 0;
+	m_size = 0;
+	m_mapped = false;
+}
+#else
+bool MappedFile::open(const std::string &path)
+{
+	close();
+
+	const int file = ::open(path.c_str(), O_RDONLY);
+	if(file < 0)
+	{
+		return false;
+	}
+
+	struct stat info;
+	if(fstat(file, &info) != 0)
+	{
+		::close(file);
+		return false;
+	}
+
+	if(info.st_size == 0)
+	{
+		::close(file);
+		m_data = emptyFile;
+		return true;
+	}
+
+	// The mapping keeps the file alive, the descriptor is not needed after this
+	void *view = mmap(NULL, (size_t)info.st_size, PROT_READ, MAP_PRIVATE, file, 0);
+	::close(file);
+	if(view == MAP_FAILED)
+	{
+		return false;
+	}
+
+	madvise(view, (size_t)info.st_size, MADV_WILLNEED);
+
+	m_data = (const char*)view;
+	m_size = (size_t)info.st_size;
+	m_mapped = true;
+	return true;
+}
+
+void MappedFile::close()
+{
+	if(m_mapped)
+	{
+		munmap((void*)m_data, m_size);
+	}
+
+	m_data = 0;
+	m_size = 0;
+	m_mapped = false;
+}
+#endif
+
+unsigned int MappedFile::touchPages() const
+{
+	// Volatile so the reads are not optimised away
+	const volatile char *data = m_data;
+	unsigned int sum = 0;
+	for(size_t i = 0; i < m_size; i += pageSize)
+	{
+		sum += (unsigned char)data[i];
+	}
+
+	return sum;
+}
+
+AssetLoader::AssetLoader(unsigned int threadCount): m_quit(false)
+{
+	if(threadCount == 0)
+	{
+		threadCount = 1;
+	}
+
+	for(unsigned int i = 0; i < threadCount; ++i)
+	{
+		m_workers.push_back(std::thread(&AssetLoader::workerLoop, this));
+	}
+}
+
+AssetLoader::~AssetLoader()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_quit = true;
+	}
+	m_wake.notify_all();
+
+	for(unsigned int i = 0; i < m_workers.size(); ++i)
+	{
+		m_workers[i].join();
+	}
+}
+
+unsigned int AssetLoader::request(const std::string &path)
+{
+	std::unique_ptr<Asset> asset(new Asset);
+	asset->path = path;
+	asset->state = AssetLoading;
+	asset->finished = false;
+
+	const unsigned int handle = (unsigned int)m_assets.size();
+	Asset *loading = asset.get();
+	m_assets.push_back(std::move(asset));
+
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_queue.push_back(std::make_pair(handle, loading));
+	}
+	m_wake.notify_one();
+
+	return handle;
+}
+
+unsigned int AssetLoader::update()
+{
+	std::vector<unsigned int> finished;
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		finished.swap(m_finished);
+	}
+
+	unsigned int pickedUp = 0;
+	for(unsigned int i = 0; i < finished.size(); ++i)
+	{
+		Asset &asset = *m_assets[finished[i]];
+		if(asset.state == AssetLoading)
+		{
+			pickUp(asset);
+			++pickedUp;
+		}
+	}
+
+	return pickedUp;
+}
+
+bool AssetLoader::wait(unsigned int handle)
+{
+	Asset &asset = *m_assets[handle];
+	if(asset.state == AssetLoading)
+	{
+		{
+			std::unique_lock<std::mutex> lock(m_mutex);
+			while(!asset.finished)
+			{
+				m_done.wait(lock);
+			}
+		}
+
+		// Its handle stays in m_finished, update skips it as it is no longer loading
+		pickUp(asset);
+	}
+
+	return asset.state == AssetReady;
+}
+
+void AssetLoader::release(unsigned int handle)
+{
+	// A loader thread may still be writing to it
+	wait(handle);
+
+	Asset &asset = *m_assets[handle];
+	asset.file.close();
+	asset.state = AssetReleased;
+}
+
+void AssetLoader::pickUp(Asset &asset)
+{
+	if(asset.file.isOpen())
+	{
+		asset.state = AssetReady;
+	}
+	else
+	{
+		asset.state = AssetFailed;
+		printf("Could not open %s\n", asset.path.c_str());
+	}
+}
+
+void AssetLoader::workerLoop()
+{
+	for(;;)
+	{
+		std::pair<unsigned int, Asset*> job;
+		{
+			std::unique_lock<std::mutex> lock(m_mutex);
+			while(!m_quit && m_queue.empty())
+			{
+				m_wake.wait(lock);
+			}
+
+			if(m_quit)
+			{
+				return;
+			}
+
+			job = m_queue.front();
+			m_queue.pop_front();
+		}
+
+		// Map and fault the pages in here so the owning thread never waits on the disk
+		Asset &asset = *job.second;
+		if(asset.file.open(asset.path))
+		{
+			asset.file.touchPages();
+		}
+
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			asset.finished = true;
+			m_finished.push_back(job.first);
+		}
+		m_done.notify_all();
+	}
+}
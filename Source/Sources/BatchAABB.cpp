@@ -0,0 +1,414 @@
+/*
+	Name:			BatchAABB.cpp
+	Project:		OpenGL
+	Description:	Structure of arrays box storage and batch overlap tests against it
+	Doc Version:	1.0
+	Author:			Jonathan Simon Jones
+	Date(D/M/Y):	16-10-2026
+	To do:
+*/
+
+#include "BatchAABB.h"
+
+namespace
+{
+	SimdLevel activeLevel = getSimdLevel();
+
+	// Sinks receive one 32 bit word of results at a time, bit i is box (word << 5) + i
+	struct MaskSink
+	{
+		unsigned int *mask;
+
+		void operator()(unsigned int word, unsigned int bits) { mask[word] = bits; }
+	};
+
+	struct IndexSink
+	{
+		unsigned int *indices;
+		unsigned int found;
+
+		void operator()(unsigned int word, unsigned int bits)
+		{
+			while(bits)
+			{
+				indices[found++] = (word << 5) + countTrailingZeros(bits);
+				bits &= bits - 1;
+			}
+		}
+	};
+
+	struct PairSink
+	{
+		std::vector<BroadphasePair> *pairs;
+		unsigned int query;
+
+		void operator()(unsigned int word, unsigned int bits)
+		{
+			while(bits)
+			{
+				BroadphasePair pair;
+				pair.a = query;
+				pair.b = (word << 5) + countTrailingZeros(bits);
+				pairs->push_back(pair);
+				bits &= bits - 1;
+			}
+		}
+	};
+
+	// Tests boxes [first, boxes.size()) one at a time, first must be a multiple of 32
+	template<class Sink>
+	void testScalar(const AABB &query, const AABBSoA &boxes, unsigned int first, Sink &sink)
+	{
+		const unsigned int count = boxes.size();
+		for(unsigned int i = first; i < count; i += 32)
+		{
+			const unsigned int end = count - i < 32 ? count : i + 32;
+
+			unsigned int word = 0;
+			for(unsigned int j = i; j < end; ++j)
+			{
+				// Same comparisons as testAABBAABB without the early outs
+				const unsigned int overlap =
+					(unsigned int)(glm::abs(boxes.cx[j] - query.center_position.x) <= boxes.rx[j] + query.radius.x) &
+					(unsigned int)(glm::abs(boxes.cy[j] - query.center_position.y) <= boxes.ry[j] + query.radius.y) &
+					(unsigned int)(glm::abs(boxes.cz[j] - query.center_position.z) <= boxes.rz[j] + query.radius.z);
+
+				word |= overlap << (j - i);
+			}
+
+			sink(i >> 5, word);
+		}
+	}
+
+#if SIMD_HAS_SSE2
+	// SIMD kernels only handle whole words and return how many boxes they tested
+	template<class Sink>
+	unsigned int testSSE2(const AABB &query, const AABBSoA &boxes, Sink &sink)
+	{
+		const __m128 signMask = _mm_castsi128_ps(_mm_set1_epi32(0x80000000));
+		const __m128 qx = _mm_set1_ps(query.center_position.x);
+		const __m128 qy = _mm_set1_ps(query.center_position.y);
+		const __m128 qz = _mm_set1_ps(query.center_position.z);
+		const __m128 qrx = _mm_set1_ps(query.radius.x);
+		const __m128 qry = _mm_set1_ps(query.radius.y);
+		const __m128 qrz = _mm_set1_ps(query.radius.z);
+
+		const unsigned int count = boxes.size() & ~31u;
+		for(unsigned int i = 0; i < count; i += 32)
+		{
+			unsigned int word = 0;
+			for(unsigned int lane = 0; lane < 32; lane += 4)
+			{
+				const unsigned int j = i + lane;
+				const __m128 dx = _mm_andnot_ps(signMask, _mm_sub_ps(_mm_loadu_ps(&boxes.cx[j]), qx));
+				const __m128 dy = _mm_andnot_ps(signMask, _mm_sub_ps(_mm_loadu_ps(&boxes.cy[j]), qy));
+				const __m128 dz = _mm_andnot_ps(signMask, _mm_sub_ps(_mm_loadu_ps(&boxes.cz[j]), qz));
+				const __m128 inX = _mm_cmple_ps(dx, _mm_add_ps(_mm_loadu_ps(&boxes.rx[j]), qrx));
+				const __m128 inY = _mm_cmple_ps(dy, _mm_add_ps(_mm_loadu_ps(&boxes.ry[j]), qry));
+				const __m128 inZ = _mm_cmple_ps(dz, _mm_add_ps(_mm_loadu_ps(&boxes.rz[j]), qrz));
+				const __m128 overlap = _mm_and_ps(_mm_and_ps(inX, inY), inZ);
+
+				word |= (unsigned int)_mm_movemask_ps(overlap) << lane;
+			}
+
+			sink(i >> 5, word);
+		}
+
+		return count;
+	}
+
+	template<class Sink>
+	SIMD_TARGET_AVX2 unsigned int testAVX2(const AABB &query, const AABBSoA &boxes, Sink &sink)
+	{
+		const __m256 signMask = _mm256_castsi256_ps(_mm256_set1_epi32(0x80000000));
+		const __m256 qx = _mm256_set1_ps(query.center_position.x);
+		const __m256 qy = _mm256_set1_ps(query.center_position.y);
+		const __m256 qz = _mm256_set1_ps(query.center_position.z);
+		const __m256 qrx = _mm256_set1_ps(query.radius.x);
+		const __m256 qry = _mm256_set1_ps(query.radius.y);
+		const __m256 qrz = _mm256_set1_ps(query.radius.z);
+
+		const unsigned int count = boxes.size() & ~31u;
+		for(unsigned int i = 0; i < count; i += 32)
+		{
+			unsigned int word = 0;
+			for(unsigned int lane = 0; lane < 32; lane += 8)
+			{
+				const unsigned int j = i + lane;
+				const __m256 dx = _mm256_andnot_ps(signMask, _mm256_sub_ps(_mm256_loadu_ps(&boxes.cx[j]), qx));
+				const __m256 dy = _mm256_andnot_ps(signMask, _mm256_sub_ps(_mm256_loadu_ps(&boxes.cy[j]), qy));
+				const __m256 dz = _mm256_andnot_ps(signMask, _mm256_sub_ps(_mm256_loadu_ps(&boxes.cz[j]), qz));
+				const __m256 inX = _mm256_cmp_ps(dx, _mm256_add_ps(_mm256_loadu_ps(&boxes.rx[j]), qrx), _CMP_LE_OQ);
+				const __m256 inY = _mm256_cmp_ps(dy, _mm256_add_ps(_mm256_loadu_ps(&boxes.ry[j]), qry), _CMP_LE_OQ);
+				const __m256 inZ = _mm256_cmp_ps(dz, _mm256_add_ps(_mm256_loadu_ps(&boxes.rz[j]), qrz), _CMP_LE_OQ);
+				const __m256 overlap = _mm256_and_ps(_mm256_and_ps(inX, inY), inZ);
+
+				word |= (unsigned int)_mm256_movemask_ps(overlap) << lane;
+			}
+
+			sink(i >> 5, word);
+		}
+
+		return count;
+	}
+#endif
+
+	// Writes world boxes [first, boxes.count) one at a time
+	void refitScalar(const OrientedBoxSoA &boxes, unsigned int first, unsigned int end, AABBSoA &out)
+	{
+		for(unsigned int i = first; i < end; ++i)
+		{
+			const float w = boxes.qw[i];
+			const float x = boxes.qx[i];
+			const float y = boxes.qy[i];
+			const float z = boxes.qz[i];
+
+			// Rotation matrix rows from the quaternion, no trig needed
+			const float r00 = 1.0f - 2.0f * (y * y + z * z);
+			const float r01 = 2.0f * (x * y - w * z);
+			const float r02 = 2.0f * (x * z + w * y);
+			const float r10 = 2.0f * (x * y + w * z);
+			const float r11 = 1.0f - 2.0f * (x * x + z * z);
+			const float r12 = 2.0f * (y * z - w * x);
+			const float r20 = 2.0f * (x * z - w * y);
+			const float r21 = 2.0f * (y * z + w * x);
+			const float r22 = 1.0f - 2.0f * (x * x + y * y);
+
+			const float hx = boxes.hx[i];
+			const float hy = boxes.hy[i];
+			const float hz = boxes.hz[i];
+
+			out.cx[i] = boxes.px[i];
+			out.cy[i] = boxes.py[i];
+			out.cz[i] = boxes.pz[i];
+			out.rx[i] = glm::abs(r00) * hx + glm::abs(r01) * hy + glm::abs(r02) * hz;
+			out.ry[i] = glm::abs(r10) * hx + glm::abs(r11) * hy + glm::abs(r12) * hz;
+			out.rz[i] = glm::abs(r20) * hx + glm::abs(r21) * hy + glm::abs(r22) * hz;
+		}
+	}
+
+#if SIMD_HAS_SSE2
+	// Four boxes per iteration, returns how many were written
+	unsigned int refitSSE2(const OrientedBoxSoA &boxes, unsigned int begin, unsigned int end, AABBSoA &out)
+	{
+		const __m128 signMask = _mm_castsi128_ps(_mm_set1_epi32(0x80000000));
+		const __m128 one = _mm_set1_ps(1.0f);
+		const __m128 two = _mm_set1_ps(2.0f);
+
+		unsigned int i = begin;
+		for(; i + 4 <= end; i += 4)
+		{
+			const __m128 w = _mm_loadu_ps(&boxes.qw[i]);
+			const __m128 x = _mm_loadu_ps(&boxes.qx[i]);
+			const __m128 y = _mm_loadu_ps(&boxes.qy[i]);
+			const __m128 z = _mm_loadu_ps(&boxes.qz[i]);
+
+			const __m128 xx = _mm_mul_ps(x, x);
+			const __m128 yy = _mm_mul_ps(y, y);
+			const __m128 zz = _mm_mul_ps(z, z);
+			const __m128 xy = _mm_mul_ps(x, y);
+			const __m128 xz = _mm_mul_ps(x, z);
+			const __m128 yz = _mm_mul_ps(y, z);
+			const __m128 wx = _mm_mul_ps(w, x);
+			const __m128 wy = _mm_mul_ps(w, y);
+			const __m128 wz = _mm_mul_ps(w, z);
+
+			// Only the magnitudes are needed so the signs are dropped straight away
+			const __m128 r00 = _mm_andnot_ps(signMask, _mm_sub_ps(one, _mm_mul_ps(two, _mm_add_ps(yy, zz))));
+			const __m128 r01 = _mm_andnot_ps(signMask, _mm_mul_ps(two, _mm_sub_ps(xy, wz)));
+			const __m128 r02 = _mm_andnot_ps(signMask, _mm_mul_ps(two, _mm_add_ps(xz, wy)));
+			const __m128 r10 = _mm_andnot_ps(signMask, _mm_mul_ps(two, _mm_add_ps(xy, wz)));
+			const __m128 r11 = _mm_andnot_ps(signMask, _mm_sub_ps(one, _mm_mul_ps(two, _mm_add_ps(xx, zz))));
+			const __m128 r12 = _mm_andnot_ps(signMask, _mm_mul_ps(two, _mm_sub_ps(yz, wx)));
+			const __m128 r20 = _mm_andnot_ps(signMask, _mm_mul_ps(two, _mm_sub_ps(xz, wy)));
+			const __m128 r21 = _mm_andnot_ps(signMask, _mm_mul_ps(two, _mm_add_ps(yz, wx)));
+			const __m128 r22 = _mm_andnot_ps(signMask, _mm_sub_ps(one, _mm_mul_ps(two, _mm_add_ps(xx, yy))));
+
+			const __m128 hx = _mm_loadu_ps(&boxes.hx[i]);
+			const __m128 hy = _mm_loadu_ps(&boxes.hy[i]);
+			const __m128 hz = _mm_loadu_ps(&boxes.hz[i]);
+
+			_mm_storeu_ps(&out.cx[i], _mm_loadu_ps(&boxes.px[i]));
+			_mm_storeu_ps(&out.cy[i], _mm_loadu_ps(&boxes.py[i]));
+			_mm_storeu_ps(&out.cz[i], _mm_loadu_ps(&boxes.pz[i]));
+			_mm_storeu_ps(&out.rx[i], _mm_add_ps(_mm_add_ps(_mm_mul_ps(r00, hx), _mm_mul_ps(r01, hy)), _mm_mul_ps(r02, hz)));
+			_mm_storeu_ps(&out.ry[i], _mm_add_ps(_mm_add_ps(_mm_mul_ps(r10, hx), _mm_mul_ps(r11, hy)), _mm_mul_ps(r12, hz)));
+			_mm_storeu_ps(&out.rz[i], _mm_add_ps(_mm_add_ps(_mm_mul_ps(r20, hx), _mm_mul_ps(r21, hy)), _mm_mul_ps(r22, hz)));
+		}
+
+		return i;
+	}
+
+	SIMD_TARGET_AVX2 unsigned int refitAVX2(const OrientedBoxSoA &boxes, unsigned int begin, unsigned int end, AABBSoA &out)
+	{
+		const __m256 signMask = _mm256_castsi256_ps(_mm256_set1_epi32(0x80000000));
+		const __m256 one = _mm256_set1_ps(1.0f);
+		const __m256 two = _mm256_set1_ps(2.0f);
+
+		unsigned int i = begin;
+		for(; i + 8 <= end; i += 8)
+		{
+			const __m256 w = _mm256_loadu_ps(&boxes.qw[i]);
+			const __m256 x = _mm256_loadu_ps(&boxes.qx[i]);
+			const __m256 y = _mm256_loadu_ps(&boxes.qy[i]);
+			const __m256 z = _mm256_loadu_ps(&boxes.qz[i]);
+
+			const __m256 xx = _mm256_mul_ps(x, x);
+			const __m256 yy = _mm256_mul_ps(y, y);
+			const __m256 zz = _mm256_mul_ps(z, z);
+			const __m256 xy = _mm256_mul_ps(x, y);
+			const __m256 xz = _mm256_mul_ps(x, z);
+			const __m256 yz = _mm256_mul_ps(y, z);
+			const __m256 wx = _mm256_mul_ps(w, x);
+			const __m256 wy = _mm256_mul_ps(w, y);
+			const __m256 wz = _mm256_mul_ps(w, z);
+
+			const __m256 r00 = _mm256_andnot_ps(signMask, _mm256_sub_ps(one, _mm256_mul_ps(two, _mm256_add_ps(yy, zz))));
+			const __m256 r01 = _mm256_andnot_ps(signMask, _mm256_mul_ps(two, _mm256_sub_ps(xy, wz)));
+			const __m256 r02 = _mm256_andnot_ps(signMask, _mm256_mul_ps(two, _mm256_add_ps(xz, wy)));
+			const __m256 r10 = _mm256_andnot_ps(signMask, _mm256_mul_ps(two, _mm256_add_ps(xy, wz)));
+			const __m256 r11 = _mm256_andnot_ps(signMask, _mm256_sub_ps(one, _mm256_mul_ps(two, _mm256_add_ps(xx, zz))));
+			const __m256 r12 = _mm256_andnot_ps(signMask, _mm256_mul_ps(two, _mm256_sub_ps(yz, wx)));
+			const __m256 r20 = _mm256_andnot_ps(signMask, _mm256_mul_ps(two, _mm256_sub_ps(xz, wy)));
+			const __m256 r21 = _mm256_andnot_ps(signMask, _mm256_mul_ps(two, _mm256_add_ps(yz, wx)));
+			const __m256 r22 = _mm256_andnot_ps(signMask, _mm256_sub_ps(one, _mm256_mul_ps(two, _mm256_add_ps(xx, yy))));
+
+			const __m256 hx = _mm256_loadu_ps(&boxes.hx[i]);
+			const __m256 hy = _mm256_loadu_ps(&boxes.hy[i]);
+			const __m256 hz = _mm256_loadu_ps(&boxes.hz[i]);
+
+			_mm256_storeu_ps(&out.cx[i], _mm256_loadu_ps(&boxes.px[i]));
+			_mm256_storeu_ps(&out.cy[i], _mm256_loadu_ps(&boxes.py[i]));
+			_mm256_storeu_ps(&out.cz[i], _mm256_loadu_ps(&boxes.pz[i]));
+			_mm256_storeu_ps(&out.rx[i], _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(r00, hx), _mm256_mul_ps(r01, hy)), _mm256_mul_ps(r02, hz)));
+			_mm256_storeu_ps(&out.ry[i], _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(r10, hx), _mm256_mul_ps(r11, hy)), _mm256_mul_ps(r12, hz)));
+			_mm256_storeu_ps(&out.rz[i], _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(r20, hx), _mm256_mul_ps(r21, hy)), _mm256_mul_ps(r22, hz)));
+		}
+
+		return i;
+	}
+#endif
+
+	// Picks the kernel for the active level, the scalar loop mops up the last partial word
+	template<class Sink>
+	void testBatch(const AABB &query, const AABBSoA &boxes, Sink &sink)
+	{
+		unsigned int done = 0;
+#if SIMD_HAS_SSE2
+		if(activeLevel == SimdAVX2)
+		{
+			done = testAVX2(query, boxes, sink);
+		}
+		else if(activeLevel == SimdSSE2)
+		{
+			done = testSSE2(query, boxes, sink);
+		}
+#endif
+
+		testScalar(query, boxes, done, sink);
+	}
+}
+
+void AABBSoA::resize(unsigned int count)
+{
+	cx.resize(count);
+	cy.resize(count);
+	cz.resize(count);
+	rx.resize(count);
+	ry.resize(count);
+	rz.resize(count);
+}
+
+void AABBSoA::clear()
+{
+	resize(0);
+}
+
+void AABBSoA::push_back(const AABB &box)
+{
+	cx.push_back(box.center_position.x);
+	cy.push_back(box.center_position.y);
+	cz.push_back(box.center_position.z);
+	rx.push_back(box.radius.x);
+	ry.push_back(box.radius.y);
+	rz.push_back(box.radius.z);
+}
+
+void AABBSoA::set(unsigned int index, const AABB &box)
+{
+	cx[index] = box.center_position.x;
+	cy[index] = box.center_position.y;
+	cz[index] = box.center_position.z;
+	rx[index] = box.radius.x;
+	ry[index] = box.radius.y;
+	rz[index] = box.radius.z;
+}
+
+AABB AABBSoA::get(unsigned int index) const
+{
+	AABB box;
+	box.center_position = glm::vec3(cx[index], cy[index], cz[index]);
+	box.radius = glm::vec3(rx[index], ry[index], rz[index]);
+	return box;
+}
+
+void testAABBBatchMask(const AABB &query, const AABBSoA &boxes, unsigned int mask[])
+{
+	MaskSink sink = { mask };
+	testBatch(query, boxes, sink);
+}
+
+unsigned int testAABBBatchIndices(const AABB &query, const AABBSoA &boxes, unsigned int indices[])
+{
+	IndexSink sink = { indices, 0 };
+	testBatch(query, boxes, sink);
+	return sink.found;
+}
+
+void testAABBBatchPairs(const AABBSoA &a, const AABBSoA &b, std::vector<BroadphasePair> &pairs)
+{
+	PairSink sink = { &pairs, 0 };
+	for(unsigned int i = 0; i < a.size(); ++i)
+	{
+		sink.query = i;
+		testBatch(a.get(i), b, sink);
+	}
+}
+
+void computeWorldAABBsSoA(const OrientedBoxSoA &boxes, AABBSoA &out)
+{
+	if(out.size() != boxes.count)
+	{
+		out.resize(boxes.count);
+	}
+
+	computeWorldAABBsSoA(boxes, 0, boxes.count, out);
+}
+
+void computeWorldAABBsSoA(const OrientedBoxSoA &boxes, unsigned int begin, unsigned int end, AABBSoA &out)
+{
+	unsigned int done = begin;
+#if SIMD_HAS_SSE2
+	if(activeLevel == SimdAVX2)
+	{
+		done = refitAVX2(boxes, begin, end, out);
+	}
+	else if(activeLevel == SimdSSE2)
+	{
+		done = refitSSE2(boxes, begin, end, out);
+	}
+#endif
+
+	refitScalar(boxes, done, end, out);
+}
+
+void setBatchAABBSimdLevel(SimdLevel level)
+{
+	// Never go above what the CPU can run
+	activeLevel = level > getSimdLevel() ? getSimdLevel() : level;
+}
+
+SimdLevel getBatchAABBSimdLevel()
+{
+	return activeLevel;
+}
@@ -0,0 +1,379 @@
+/*
+	Name:			BatchTransform.cpp
+	Project:		OpenGL
+	Description:	Model and model view projection matrices built in batches straight from quaternions
+	Doc Version:	1.0
+	Author:			Jonathan Simon Jones
+	Date(D/M/Y):	16-10-2026
+	To do:
+*/
+
+#include "BatchTransform.h"
+
+// Math includes
+#include <glm/gtc/type_ptr.hpp>
+
+namespace
+{
+	SimdLevel activeLevel = getSimdLevel();
+
+	// Every level works the entries out with the same operations in the same order, so a
+	// transform comes out the same whichever kernel it lands in
+	void composeScalar(const TransformSoA &t, const unsigned int indices[], unsigned int begin, unsigned int count, const float *viewProj, float out[])
+	{
+		for(unsigned int i = begin; i < count; ++i)
+		{
+			const unsigned int n = indices ? indices[i] : i;
+			const float w = t.qw[n];
+			const float x = t.qx[n];
+			const float y = t.qy[n];
+			const float z = t.qz[n];
+
+			const float xx = x * x;
+			const float yy = y * y;
+			const float zz = z * z;
+			const float xy = x * y;
+			const float xz = x * z;
+			const float yz = y * z;
+			const float wx = w * x;
+			const float wy = w * y;
+			const float wz = w * z;
+
+			const float sx = t.sx[n] * t.scale;
+			const float sy = t.sy[n] * t.scale;
+			const float sz = t.sz[n] * t.scale;
+
+			// Columns of the rotation, each scaled by the scale along it
+			float m[3][3];
+			m[0][0] = (1.0f - 2.0f * (yy + zz)) * sx;
+			m[0][1] = 2.0f * (xy + wz) * sx;
+			m[0][2] = 2.0f * (xz - wy) * sx;
+			m[1][0] = 2.0f * (xy - wz) * sy;
+			m[1][1] = (1.0f - 2.0f * (xx + zz)) * sy;
+			m[1][2] = 2.0f * (yz + wx) * sy;
+			m[2][0] = 2.0f * (xz + wy) * sz;
+			m[2][1] = 2.0f * (yz - wx) * sz;
+			m[2][2] = (1.0f - 2.0f * (xx + yy)) * sz;
+			const float p[3] = { t.px[n], t.py[n], t.pz[n] };
+
+			float *matrix = out + i * transformMatrixFloats;
+			if(!viewProj)
+			{
+				for(unsigned int c = 0; c < 3; ++c)
+				{
+					matrix[c * 4 + 0] = m[c][0];
+					matrix[c * 4 + 1] = m[c][1];
+					matrix[c * 4 + 2] = m[c][2];
+					matrix[c * 4 + 3] = 0.0f;
+				}
+				matrix[12] = p[0];
+				matrix[13] = p[1];
+				matrix[14] = p[2];
+				matrix[15] = 1.0f;
+				continue;
+			}
+
+			// The model's bottom row is 0 0 0 1, so only the translation picks up viewProj's last column
+			for(unsigned int r = 0; r < 4; ++r)
+			{
+				for(unsigned int c = 0; c < 3; ++c)
+				{
+					matrix[c * 4 + r] = viewProj[r] * m[c][0] + viewProj[4 + r] * m[c][1] + viewProj[8 + r] * m[c][2];
+				}
+				matrix[12 + r] = viewProj[r] * p[0] + viewProj[4 + r] * p[1] + viewProj[8 + r] * p[2] + viewProj[12 + r];
+			}
+		}
+	}
+
+#if SIMD_HAS_SSE2
+	inline __m128 load4(const float values[], const unsigned int indices[], unsigned int i)
+	{
+		if(!indices)
+		{
+			return _mm_loadu_ps(&values[i]);
+		}
+
+		return _mm_setr_ps(values[indices[i]], values[indices[i + 1]], values[indices[i + 2]], values[indices[i + 3]]);
+	}
+
+	// entries[c][r] holds row r of column c for four transforms, turned into four whole matrices
+	inline void store4(const __m128 entries[4][4], float out[])
+	{
+		for(unsigned int c = 0; c < 4; ++c)
+		{
+			__m128 r0 = entries[c][0];
+			__m128 r1 = entries[c][1];
+			__m128 r2 = entries[c][2];
+			__m128 r3 = entries[c][3];
+			_MM_TRANSPOSE4_PS(r0, r1, r2, r3);
+
+			_mm_storeu_ps(&out[0 * transformMatrixFloats + c * 4], r0);
+			_mm_storeu_ps(&out[1 * transformMatrixFloats + c * 4], r1);
+			_mm_storeu_ps(&out[2 * transformMatrixFloats + c * 4], r2);
+			_mm_storeu_ps(&out[3 * transformMatrixFloats + c * 4], r3);
+		}
+	}
+
+	// Four transforms a lane each, returns how many were done
+	unsigned int composeSSE2(const TransformSoA &t, const unsigned int indices[], unsigned int count, const float *viewProj, float out[])
+	{
+		const __m128 zero = _mm_setzero_ps();
+		const __m128 one = _mm_set1_ps(1.0f);
+		const __m128 two = _mm_set1_ps(2.0f);
+		const __m128 scale = _mm_set1_ps(t.scale);
+
+		unsigned int i = 0;
+		for(; i + 4 <= count; i += 4)
+		{
+			const __m128 w = load4(t.qw, indices, i);
+			const __m128 x = load4(t.qx, indices, i);
+			const __m128 y = load4(t.qy, indices, i);
+			const __m128 z = load4(t.qz, indices, i);
+
+			const __m128 xx = _mm_mul_ps(x, x);
+			const __m128 yy = _mm_mul_ps(y, y);
+			const __m128 zz = _mm_mul_ps(z, z);
+			const __m128 xy = _mm_mul_ps(x, y);
+			const __m128 xz = _mm_mul_ps(x, z);
+			const __m128 yz = _mm_mul_ps(y, z);
+			const __m128 wx = _mm_mul_ps(w, x);
+			const __m128 wy = _mm_mul_ps(w, y);
+			const __m128 wz = _mm_mul_ps(w, z);
+
+			const __m128 sx = _mm_mul_ps(load4(t.sx, indices, i), scale);
+			const __m128 sy = _mm_mul_ps(load4(t.sy, indices, i), scale);
+			const __m128 sz = _mm_mul_ps(load4(t.sz, indices, i), scale);
+
+			__m128 m[4][4];
+			m[0][0] = _mm_mul_ps(_mm_sub_ps(one, _mm_mul_ps(two, _mm_add_ps(yy, zz))), sx);
+			m[0][1] = _mm_mul_ps(_mm_mul_ps(two, _mm_add_ps(xy, wz)), sx);
+			m[0][2] = _mm_mul_ps(_mm_mul_ps(two, _mm_sub_ps(xz, wy)), sx);
+			m[1][0] = _mm_mul_ps(_mm_mul_ps(two, _mm_sub_ps(xy, wz)), sy);
+			m[1][1] = _mm_mul_ps(_mm_sub_ps(one, _mm_mul_ps(two, _mm_add_ps(xx, zz))), sy);
+			m[1][2] = _mm_mul_ps(_mm_mul_ps(two, _mm_add_ps(yz, wx)), sy);
+			m[2][0] = _mm_mul_ps(_mm_mul_ps(two, _mm_add_ps(xz, wy)), sz);
+			m[2][1] = _mm_mul_ps(_mm_mul_ps(two, _mm_sub_ps(yz, wx)), sz);
+			m[2][2] = _mm_mul_ps(_mm_sub_ps(one, _mm_mul_ps(two, _mm_add_ps(xx, yy))), sz);
+			m[0][3] = zero;
+			m[1][3] = zero;
+			m[2][3] = zero;
+			m[3][0] = load4(t.px, indices, i);
+			m[3][1] = load4(t.py, indices, i);
+			m[3][2] = load4(t.pz, indices, i);
+			m[3][3] = one;
+
+			float *matrices = out + i * transformMatrixFloats;
+			if(!viewProj)
+			{
+				store4(m, matrices);
+				continue;
+			}
+
+			__m128 product[4][4];
+			for(unsigned int r = 0; r < 4; ++r)
+			{
+				const __m128 v0 = _mm_set1_ps(viewProj[r]);
+				const __m128 v1 = _mm_set1_ps(viewProj[4 + r]);
+				const __m128 v2 = _mm_set1_ps(viewProj[8 + r]);
+				for(unsigned int c = 0; c < 3; ++c)
+				{
+					product[c][r] = _mm_add_ps(_mm_add_ps(_mm_mul_ps(v0, m[c][0]), _mm_mul_ps(v1, m[c][1])), _mm_mul_ps(v2, m[c][2]));
+				}
+				product[3][r] = _mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(v0, m[3][0]), _mm_mul_ps(v1, m[3][1])), _mm_mul_ps(v2, m[3][2])),
+					_mm_set1_ps(viewProj[12 + r]));
+			}
+			store4(product, matrices);
+		}
+
+		return i;
+	}
+
+	SIMD_TARGET_AVX2 inline __m256 load8(const float values[], const unsigned int indices[], unsigned int i)
+	{
+		if(!indices)
+		{
+			return _mm256_loadu_ps(&values[i]);
+		}
+
+		return _mm256_i32gather_ps(values, _mm256_loadu_si256((const __m256i*)&indices[i]), 4);
+	}
+
+	// As store4, each 128 bit half transposes on its own, the low half into the first four
+	// matrices and the high half into the next four
+	SIMD_TARGET_AVX2 inline void store8(const __m256 entries[4][4], float out[])
+	{
+		for(unsigned int c = 0; c < 4; ++c)
+		{
+			const __m256 t0 = _mm256_unpacklo_ps(entries[c][0], entries[c][1]);
+			const __m256 t1 = _mm256_unpackhi_ps(entries[c][0], entries[c][1]);
+			const __m256 t2 = _mm256_unpacklo_ps(entries[c][2], entries[c][3]);
+			const __m256 t3 = _mm256_unpackhi_ps(entries[c][2], entries[c][3]);
+
+			const __m256 column[4] =
+			{
+				_mm256_shuffle_ps(t0, t2, _MM_SHUFFLE(1, 0, 1, 0)),
+				_mm256_shuffle_ps(t0, t2, _MM_SHUFFLE(3, 2, 3, 2)),
+				_mm256_shuffle_ps(t1, t3, _MM_SHUFFLE(1, 0, 1, 0)),
+				_mm256_shuffle_ps(t1, t3, _MM_SHUFFLE(3, 2, 3, 2))
+			};
+
+			for(unsigned int k = 0; k < 4; ++k)
+			{
+				_mm_storeu_ps(&out[k * transformMatrixFloats + c * 4], _mm256_castps256_ps128(column[k]));
+				_mm_storeu_ps(&out[(k + 4) * transformMatrixFloats + c * 4], _mm256_extractf128_ps(column[k], 1));
+			}
+		}
+	}
+
+	SIMD_TARGET_AVX2 unsigned int composeAVX2(const TransformSoA &t, const unsigned int indices[], unsigned int count, const float *viewProj, float out[])
+	{
+		const __m256 zero = _mm256_setzero_ps();
+		const __m256 one = _mm256_set1_ps(1.0f);
+		const __m256 two = _mm256_set1_ps(2.0f);
+		const __m256 scale = _mm256_set1_ps(t.scale);
+
+		unsigned int i = 0;
+		for(; i + 8 <= count; i += 8)
+		{
+			const __m256 w = load8(t.qw, indices, i);
+			const __m256 x = load8(t.qx, indices, i);
+			const __m256 y = load8(t.qy, indices, i);
+			const __m256 z = load8(t.qz, indices, i);
+
+			const __m256 xx = _mm256_mul_ps(x, x);
+			const __m256 yy = _mm256_mul_ps(y, y);
+			const __m256 zz = _mm256_mul_ps(z, z);
+			const __m256 xy = _mm256_mul_ps(x, y);
+			const __m256 xz = _mm256_mul_ps(x, z);
+			const __m256 yz = _mm256_mul_ps(y, z);
+			const __m256 wx = _mm256_mul_ps(w, x);
+			const __m256 wy = _mm256_mul_ps(w, y);
+			const __m256 wz = _mm256_mul_ps(w, z);
+
+			const __m256 sx = _mm256_mul_ps(load8(t.sx, indices, i), scale);
+			const __m256 sy = _mm256_mul_ps(load8(t.sy, indices, i), scale);
+			const __m256 sz = _mm256_mul_ps(load8(t.sz, indices, i), scale);
+
+			__m256 m[4][4];
+			m[0][0] = _mm256_mul_ps(_mm256_sub_ps(one, _mm256_mul_ps(two, _mm256_add_ps(yy, zz))), sx);
+			m[0][1] = _mm256_mul_ps(_mm256_mul_ps(two, _mm256_add_ps(xy, wz)), sx);
+			m[0][2] = _mm256_mul_ps(_mm256_mul_ps(two, _mm256_sub_ps(xz, wy)), sx);
+			m[1][0] = _mm256_mul_ps(_mm256_mul_ps(two, _mm256_sub_ps(xy, wz)), sy);
+			m[1][1] = _mm256_mul_ps(_mm256_sub_ps(one, _mm256_mul_ps(two, _mm256_add_ps(xx, zz))), sy);
+			m[1][2] = _mm256_mul_ps(_mm256_mul_ps(two, _mm256_add_ps(yz, wx)), sy);
+			m[2][0] = _mm256_mul_ps(_mm256_mul_ps(two, _mm256_add_ps(xz, wy)), sz);
+			m[2][1] = _mm256_mul_ps(_mm256_mul_ps(two, _mm256_sub_ps(yz, wx)), sz);
+			m[2][2] = _mm256_mul_ps(_mm256_sub_ps(one, _mm256_mul_ps(two, _mm256_add_ps(xx, yy))), sz);
+			m[0][3] = zero;
+			m[1][3] = zero;
+			m[2][3] = zero;
+			m[3][0] = load8(t.px, indices, i);
+			m[3][1] = load8(t.py, indices, i);
+			m[3][2] = load8(t.pz, indices, i);
+			m[3][3] = one;
+
+			float *matrices = out + i * transformMatrixFloats;
+			if(!viewProj)
+			{
+				store8(m, matrices);
+				continue;
+			}
+
+			__m256 product[4][4];
+			for(unsigned int r = 0; r < 4; ++r)
+			{
+				const __m256 v0 = _mm256_set1_ps(viewProj[r]);
+				const __m256 v1 = _mm256_set1_ps(viewProj[4 + r]);
+				const __m256 v2 = _mm256_set1_ps(viewProj[8 + r]);
+				for(unsigned int c = 0; c < 3; ++c)
+				{
+					product[c][r] = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(v0, m[c][0]), _mm256_mul_ps(v1, m[c][1])), _mm256_mul_ps(v2, m[c][2]));
+				}
+				product[3][r] = _mm256_add_ps(_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(v0, m[3][0]), _mm256_mul_ps(v1, m[3][1])), _mm256_mul_ps(v2, m[3][2])),
+					_mm256_set1_ps(viewProj[12 + r]));
+			}
+			store8(product, matrices);
+		}
+
+		return i;
+	}
+#endif
+
+	// Picks the kernel for the active level, the scalar loop finishes the last partial batch
+	void compose(const TransformSoA &transforms, const unsigned int indices[], unsigned int count, const float *viewProj, float out[])
+	{
+		unsigned int done = 0;
+#if SIMD_HAS_SSE2
+		if(activeLevel == SimdAVX2)
+		{
+			done = composeAVX2(transforms, indices, count, viewProj, out);
+		}
+		else if(activeLevel == SimdSSE2)
+		{
+			done = composeSSE2(transforms, indices, count, viewProj, out);
+		}
+#endif
+
+		composeScalar(transforms, indices, done, count, viewProj, out);
+	}
+}
+
+TransformSoA getCubeTransforms(const OrientedBoxSoA &boxes)
+{
+	TransformSoA transforms;
+	transforms.px = boxes.px;
+	transforms.py = boxes.py;
+	transforms.pz = boxes.pz;
+	transforms.qw = boxes.qw;
+	transforms.qx = boxes.qx;
+	transforms.qy = boxes.qy;
+	transforms.qz = boxes.qz;
+	transforms.sx = boxes.hx;
+	transforms.sy = boxes.hy;
+	transforms.sz = boxes.hz;
+	transforms.scale = 2.0f;
+	transforms.count = boxes.count;
+	return transforms;
+}
+
+void composeModelMatrices(const TransformSoA &transforms, const unsigned int indices[], unsigned int count, float out[])
+{
+	compose(transforms, indices, count, 0, out);
+}
+
+void composeModelViewProjMatrices(const TransformSoA &transforms, const unsigned int indices[], unsigned int count, const glm::mat4 &viewProj, float out[])
+{
+	compose(transforms, indices, count, glm::value_ptr(viewProj), out);
+}
+
+glm::mat4 composeModelMatrix(const glm::vec3 &position, const glm::fquat &orientation, const glm::vec3 &scale)
+{
+	TransformSoA transform;
+	transform.px = &position.x;
+	transform.py = &position.y;
+	transform.pz = &position.z;
+	transform.qw = &orientation.w;
+	transform.qx = &orientation.x;
+	transform.qy = &orientation.y;
+	transform.qz = &orientation.z;
+	transform.sx = &scale.x;
+	transform.sy = &scale.y;
+	transform.sz = &scale.z;
+	transform.scale = 1.0f;
+	transform.count = 1;
+
+	glm::mat4 model;
+	composeScalar(transform, 0, 0, 1, 0, glm::value_ptr(model));
+	return model;
+}
+
+void setBatchTransformSimdLevel(SimdLevel level)
+{
+	// Never go above what the CPU can run
+	activeLevel = level > getSimdLevel() ? getSimdLevel() : level;
+}
+
+SimdLevel getBatchTransformSimdLevel()
+{
+	return activeLevel;
+}
@@ -0,0 +1,4002 @@
+/*
+	Name:			Benchmark.cpp
+	Project:		OpenGL
+	Description:	Headless benchmarks run from the command line with -benchmark <name>
+	Doc Version:	1.0
+	Author:			Jonathan Simon Jones
+	Date(D/M/Y):	16-10-2026
+	To do:
+*/
+
+#include "Benchmark.h"
+#include "AABB.h"
+#include "AssetLoader.h"
+#include "ContactSolver.h"
+#include "ContinuousCollision.h"
+#include "Mesh.h"
+#include "MeshOptimizer.h"
+#include "Narrowphase.h"
+#include "SweepAndPrune.h"
+#include "BatchAABB.h"
+#include "BatchTransform.h"
+#include "Culling.h"
+#include "DynamicAABBTree.h"
+#include "Islands.h"
+#include "Memory.h"
+#include "PhysicsWorld.h"
+#include "Profiler.h"
+#include "Scene.h"
+#include "SceneGraph.h"
+#include "SimulationThread.h"
+#include "SoftwareRenderBackend.h"
+#include "ThreadPool.h"
+#include "TripleBuffer.h"
+#include "RenderQueue.h"
+#include "RenderBackend.h"
+#include "RenderStats.h"
+
+// STL includes
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <memory>
+#include <random>
+#include <sstream>
+#include <thread>
+#include <vector>
+
+// OS includes
+#ifdef _WIN32
+#include <direct.h>
+#else
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+// Math includes
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/quaternion.hpp>
+#include <glm/gtc/type_ptr.hpp>
+
+namespace
+{
+	typedef std::chrono::high_resolution_clock Clock;
+
+	const float benchmarkDt = 1.0f / 200.0f;
+
+	double secondsSince(Clock::time_point start)
+	{
+		return std::chrono::duration<double>(Clock::now() - start).count();
+	}
+
+	// Unit boxes scattered so the density stays the same whatever the count
+	void createMovingBoxes(unsigned int count, std::vector<AABB> &boxes, std::vector<glm::vec3> &velocities)
+	{
+		std::mt19937 random(1234);
+		const float worldSize = 2.0f * std::pow((float)count, 1.0f / 3.0f);
+		std::uniform_real_distribution<float> position(0.0f, worldSize);
+		std::uniform_real_distribution<float> speed(-1.0f, 1.0f);
+
+		boxes.resize(count);
+		velocities.resize(count);
+		for(unsigned int i = 0; i < count; ++i)
+		{
+			boxes[i].center_position = glm::vec3(position(random), position(random), position(random));
+			boxes[i].radius = glm::vec3(0.5f, 0.5f, 0.5f);
+			velocities[i] = glm::vec3(speed(random), speed(random), speed(random));
+		}
+	}
+
+	void moveBoxes(std::vector<AABB> &boxes, const std::vector<glm::vec3> &velocities)
+	{
+		for(unsigned int i = 0; i < boxes.size(); ++i)
+		{
+			boxes[i].center_position += velocities[i] * benchmarkDt;
+		}
+	}
+
+	// Returns the number of overlapping pairs found by testing rows [0, rows) against every later box
+	unsigned int bruteForcePairs(const std::vector<AABB> &boxes, unsigned int rows)
+	{
+		unsigned int pairs = 0;
+		const unsigned int count = (unsigned int)boxes.size();
+		for(unsigned int i = 0; i < rows; ++i)
+		{
+			for(unsigned int j = i + 1; j < count; ++j)
+			{
+				if(testAABBAABB(boxes[i], boxes[j]))
+				{
+					++pairs;
+				}
+			}
+		}
+
+		return pairs;
+	}
+
+	// calculateBoxExtremes as it was before the rewrite, kept to measure against
+	void legacyCalculateBoxExtremes(glm::mat4 transformMat, extremes &boxExtremes)
+	{
+		std::vector<glm::vec4> v;
+		v.push_back(glm::vec4(-0.5f, -0.5f, -0.5f, 1.0f));
+		v.push_back(glm::vec4(-0.5f,  0.5f, -0.5f, 1.0f));
+		v.push_back(glm::vec4( 0.5f, -0.5f, -0.5f, 1.0f));
+		v.push_back(glm::vec4( 0.5f,  0.5f, -0.5f, 1.0f));
+		v.push_back(glm::vec4(-0.5f, -0.5f,  0.5f, 1.0f));
+		v.push_back(glm::vec4(-0.5f,  0.5f,  0.5f, 1.0f));
+		v.push_back(glm::vec4( 0.5f, -0.5f,  0.5f, 1.0f));
+		v.push_back(glm::vec4( 0.5f,  0.5f,  0.5f, 1.0f));
+
+		std::vector<glm::vec4> updateVerts;
+		for(std::vector<glm::vec4>::iterator it = v.begin(); it != v.end(); it++)
+		{
+			updateVerts.push_back((*it) * transformMat);
+		}
+
+		for(std::vector<glm::vec4>::iterator it = updateVerts.begin(); it != updateVerts.end(); it++)
+		{
+			if((*it).x > boxExtremes.minX) boxExtremes.minX = (*it).x;
+			if((*it).x < boxExtremes.maxX) boxExtremes.maxX = (*it).x;
+			if((*it).y > boxExtremes.minY) boxExtremes.minY = (*it).y;
+			if((*it).y < boxExtremes.maxY) boxExtremes.maxY = (*it).y;
+			if((*it).z > boxExtremes.minZ) boxExtremes.minZ = (*it).z;
+			if((*it).z < boxExtremes.maxZ) boxExtremes.maxZ = (*it).z;
+		}
+	}
+
+	// Corners pushed through the matrix, the reference the fast paths are checked against
+	AABB cornerAABB(const glm::mat4 &model, const glm::vec3 &halfExtents)
+	{
+		glm::vec3 lower(1e30f, 1e30f, 1e30f);
+		glm::vec3 upper(-1e30f, -1e30f, -1e30f);
+		for(unsigned int corner = 0; corner < 8; ++corner)
+		{
+			const glm::vec4 local((corner & 1) ? halfExtents.x : -halfExtents.x,
+				(corner & 2) ? halfExtents.y : -halfExtents.y,
+				(corner & 4) ? halfExtents.z : -halfExtents.z, 1.0f);
+			const glm::vec3 world(model * local);
+			lower = glm::min(lower, world);
+			upper = glm::max(upper, world);
+		}
+
+		AABB box;
+		box.center_position = (lower + upper) * 0.5f;
+		box.radius = (upper - lower) * 0.5f;
+		return box;
+	}
+
+	bool closeTo(const AABB &a, const AABB &b)
+	{
+		const float tolerance = 1e-4f;
+		for(unsigned int axis = 0; axis < 3; ++axis)
+		{
+			if(glm::abs(a.center_position[axis] - b.center_position[axis]) > tolerance) return false;
+			if(glm::abs(a.radius[axis] - b.radius[axis]) > tolerance) return false;
+		}
+
+		return true;
+	}
+
+	// Backend that draws nothing, it remembers what it was told to apply so every draw can be
+	// checked against the state its command asked for
+	class CheckingBackend : public RenderBackend
+	{
+	public:
+		CheckingBackend(): m_program(0), m_vertexArray(0), m_blend(false), m_alpha(0.0f), m_mismatches(0)
+		{
+			memset(m_model, 0, sizeof(m_model));
+		}
+
+		unsigned int getMismatches() const { return m_mismatches; }
+
+	protected:
+		virtual void applyProgram(unsigned int program) { m_program = program; }
+		virtual void applyVertexArray(unsigned int vertexArray) { m_vertexArray = vertexArray; }
+		virtual void applyBlend(bool blend) { m_blend = blend; }
+		virtual void applyModel(const float model[16]) { memcpy(m_model, model, sizeof(m_model)); }
+		virtual void applyAlpha(float alpha) { m_alpha = alpha; }
+
+		virtual void draw(const RenderCommand &command)
+		{
+			if(command.program != m_program || command.vertexArray != m_vertexArray || command.blend != m_blend ||
+				command.alpha != m_alpha || memcmp(command.model, m_model, sizeof(m_model)) != 0)
+			{
+				++m_mismatches;
+			}
+		}
+
+	private:
+		unsigned int m_program;
+		unsigned int m_vertexArray;
+		bool m_blend;
+		float m_model[16];
+		float m_alpha;
+		unsigned int m_mismatches;
+	};
+
+	// How shaders were read before the asset loader, kept to measure against
+	std::string legacyReadTextFromFile(std::string nameOfFile)
+	{
+		std::ifstream vertexShaderSource(nameOfFile);
+		std::stringstream vertexShaderText;
+		vertexShaderText << vertexShaderSource.rdbuf();
+		return vertexShaderText.str();
+	}
+
+	unsigned long long hashBytes(const char *data, size_t size)
+	{
+		unsigned long long hash = 14695981039346656037ull;
+		for(size_t i = 0; i < size; ++i)
+		{
+			hash ^= (unsigned char)data[i];
+			hash *= 1099511628211ull;
+		}
+
+		return hash;
+	}
+
+	// Drops the file from the OS cache so the next read goes to the disk, false where
+	// that is not possible
+	bool evictFromCache(const std::string &path)
+	{
+#if defined(_WIN32) || !defined(POSIX_FADV_DONTNEED)
+		(void)path;
+		return false;
+#else
+		const int file = open(path.c_str(), O_RDONLY);
+		if(file < 0)
+		{
+			return false;
+		}
+
+		// Only clean pages can be dropped
+		fdatasync(file);
+		const bool evicted = posix_fadvise(file, 0, 0, POSIX_FADV_DONTNEED) == 0;
+		close(file);
+		return evicted;
+#endif
+	}
+
+	// Smooth shaded sphere with a ring of duplicate vertices at each pole and along the seam,
+	// the way exporters write them
+	bool writeSphereObj(const std::string &path, unsigned int stacks, unsigned int slices)
+	{
+		FILE *file = fopen(path.c_str(), "w");
+		if(!file)
+		{
+			return false;
+		}
+
+		for(unsigned int stack = 0; stack <= stacks; ++stack)
+		{
+			const float theta = 3.14159265f * stack / stacks;
+			for(unsigned int slice = 0; slice <= slices; ++slice)
+			{
+				// Snap the poles and the seam so the duplicates are bit for bit equal
+				const float phi = slice == slices ? 0.0f : 6.28318531f * slice / slices;
+				const float ring = stack == 0 || stack == stacks ? 0.0f : std::sin(theta);
+				const float x = ring * std::cos(phi);
+				const float y = ring * std::sin(phi);
+				const float z = stack == 0 ? 1.0f : (stack == stacks ? -1.0f : std::cos(theta));
+				fprintf(file, "v %f %f %f\nvn %f %f %f\n", x, y, z, x, y, z);
+			}
+		}
+
+		for(unsigned int stack = 0; stack < stacks; ++stack)
+		{
+			for(unsigned int slice = 0; slice < slices; ++slice)
+			{
+				const unsigned int a = stack * (slices + 1) + slice + 1;
+				const unsigned int b = a + slices + 1;
+				fprintf(file, "f %u//%u %u//%u %u//%u %u//%u\n", a, a, b, b, b + 1, b + 1, a + 1, a + 1);
+			}
+		}
+
+		return fclose(file) == 0;
+	}
+
+	// The same sphere unwelded, one vertex per corner, optionally with its triangles shuffled
+	void createSphereCorners(unsigned int stacks, unsigned int slices, bool shuffle, MeshData &mesh)
+	{
+		std::vector<float> grid;
+		for(unsigned int stack = 0; stack <= stacks; ++stack)
+		{
+			const float theta = 3.14159265f * stack / stacks;
+			for(unsigned int slice = 0; slice <= slices; ++slice)
+			{
+				const float phi = slice == slices ? 0.0f : 6.28318531f * slice / slices;
+				const float ring = stack == 0 || stack == stacks ? 0.0f : std::sin(theta);
+				const float x = ring * std::cos(phi) + 0.0f;
+				const float y = ring * std::sin(phi) + 0.0f;
+				const float z = stack == 0 ? 1.0f : (stack == stacks ? -1.0f : std::cos(theta));
+				const float vertex[6] = { x, y, z, std::fabs(x), std::fabs(y), std::fabs(z) };
+				grid.insert(grid.end(), vertex, vertex + 6);
+			}
+		}
+
+		std::vector<unsigned int> triangles;
+		for(unsigned int stack = 0; stack < stacks; ++stack)
+		{
+			for(unsigned int slice = 0; slice < slices; ++slice)
+			{
+				const unsigned int a = stack * (slices + 1) + slice;
+				const unsigned int b = a + slices + 1;
+				const unsigned int quad[6] = { a, b, b + 1, a, b + 1, a + 1 };
+				triangles.insert(triangles.end(), quad, quad + 6);
+			}
+		}
+
+		std::vector<unsigned int> order(triangles.size() / 3);
+		for(unsigned int i = 0; i < order.size(); ++i)
+		{
+			order[i] = i;
+		}
+		if(shuffle)
+		{
+			std::mt19937 random(5);
+			std::shuffle(order.begin(), order.end(), random);
+		}
+
+		mesh.vertices.clear();
+		mesh.indices.clear();
+		for(unsigned int i = 0; i < order.size(); ++i)
+		{
+			for(unsigned int k = 0; k < 3; ++k)
+			{
+				const float *vertex = &grid[triangles[order[i] * 3 + k] * 6];
+				mesh.vertices.insert(mesh.vertices.end(), vertex, vertex + 6);
+			}
+		}
+	}
+
+	// Each triangle's vertex data rotated so the smallest corner is first, sorted, so two
+	// lists can be compared whatever the triangle, corner start and vertex order
+	std::vector<std::vector<float> > canonicalTriangles(const MeshData &mesh)
+	{
+		std::vector<std::vector<float> > triangles(mesh.indices.size() / 3);
+		for(size_t t = 0; t < triangles.size(); ++t)
+		{
+			const float *corners[3];
+			for(unsigned int k = 0; k < 3; ++k)
+			{
+				corners[k] = &mesh.vertices[mesh.indices[t * 3 + k] * meshVertexFloats];
+			}
+
+			unsigned int first = 0;
+			for(unsigned int k = 1; k < 3; ++k)
+			{
+				if(std::lexicographical_compare(corners[k], corners[k] + meshVertexFloats, corners[first], corners[first] + meshVertexFloats))
+				{
+					first = k;
+				}
+			}
+
+			for(unsigned int k = 0; k < 3; ++k)
+			{
+				const float *vertex = corners[(first + k) % 3];
+				triangles[t].insert(triangles[t].end(), vertex, vertex + meshVertexFloats);
+			}
+		}
+
+		std::sort(triangles.begin(), triangles.end());
+		return triangles;
+	}
+
+	MeshCacheStats printMeshStage(const char *stage, double seconds, const MeshData &mesh)
+	{
+		const MeshCacheStats stats = analyzeMesh(&mesh.indices[0], mesh.indices.size(), mesh.getVertexCount(), meshVertexFloats * sizeof(float));
+		printf("  %-10s %10.2f %10.3f %10.3f %10.3f\n", stage, seconds * 1000.0, stats.acmr, stats.atvr, stats.overfetch);
+		return stats;
+	}
+
+	size_t fileSize(const std::string &path)
+	{
+		MappedFile file;
+		return file.open(path) ? file.getSize() : 0;
+	}
+
+	void makeBenchmarkDirectory(const std::string &path)
+	{
+#ifdef _WIN32
+		_mkdir(path.c_str());
+#else
+		mkdir(path.c_str(), 0755);
+#endif
+	}
+
+	void removeBenchmarkDirectory(const std::string &path)
+	{
+#ifdef _WIN32
+		_rmdir(path.c_str());
+#else
+		rmdir(path.c_str());
+#endif
+	}
+
+	// Unit boxes strewn over a square of ground about one per square unit, like a city seen
+	// from street level, so the near ones hide a lot of the rest
+	void createBoxField(unsigned int count, PhysicsWorld &world)
+	{
+		std::mt19937 random(4242);
+		const float halfSize = 0.5f * std::sqrt((float)count);
+		std::uniform_real_distribution<float> ground(-halfSize, halfSize);
+		std::uniform_real_distribution<float> height(0.0f, 2.0f);
+		std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+
+		for(unsigned int i = 0; i < count; ++i)
+		{
+			world.addBody(glm::vec3(ground(random), ground(random), height(random)),
+				glm::normalize(glm::fquat(unit(random), unit(random), unit(random), unit(random))),
+				glm::vec3(0.5f, 0.5f, 0.5f), 0.0f);
+		}
+	}
+
+	// The windowed build's lens turned a step further round each frame from just above the ground
+	glm::mat4 benchmarkCamera(unsigned int frame, unsigned int frames, glm::vec3 &eye)
+	{
+		const float turn = 6.2831853f * frame / frames;
+		eye = glm::vec3(0.0f, 0.0f, 1.5f);
+		const glm::vec3 target = eye + glm::vec3(std::cos(turn), std::sin(turn), -0.1f);
+		return glm::perspective(45.0f, 800.0f / 600.0f, 1.0f, 15.0f) * glm::lookAt(eye, target, glm::vec3(0.0f, 0.0f, 1.0f));
+	}
+
+	// A vertex at pixel position (x, y) of a width by height target, for drawing with
+	// identity view and projection
+	void addPixelVertex(std::vector<float> &vertices, float x, float y, float z, unsigned int width, unsigned int height, const glm::vec3 &color)
+	{
+		const float vertex[meshVertexFloats] = { 2.0f * x / width - 1.0f, 1.0f - 2.0f * y / height, z, color.x, color.y, color.z };
+		vertices.insert(vertices.end(), vertex, vertex + meshVertexFloats);
+	}
+
+	// An unindexed quad over pixels [x0, x1) by [y0, y1) at depth z in one color
+	void addPixelQuad(std::vector<float> &vertices, float x0, float y0, float x1, float y1, float z, unsigned int width, unsigned int height, const glm::vec3 &color)
+	{
+		const float corners[6][2] = { { x0, y0 }, { x1, y0 }, { x1, y1 }, { x0, y0 }, { x1, y1 }, { x0, y1 } };
+		for(unsigned int i = 0; i < 6; ++i)
+		{
+			addPixelVertex(vertices, corners[i][0], corners[i][1], z, width, height, color);
+		}
+	}
+
+	// Draws the first 6 vertices of each vertex array as a command of its own, in order
+	void drawSoftware(SoftwareRenderBackend &backend, const std::vector<unsigned int> &vertexArrays, unsigned int program, bool blend)
+	{
+		RenderQueue queue;
+		RenderCommand command;
+		command.program = program;
+		command.blend = blend;
+		for(unsigned int i = 0; i < vertexArrays.size(); ++i)
+		{
+			command.vertexArray = vertexArrays[i];
+			command.count = 6;
+			queue.submit(command, 0.0f);
+		}
+		backend.execute(queue);
+	}
+
+	unsigned int countPixels(const Framebuffer &framebuffer, unsigned int color)
+	{
+		unsigned int count = 0;
+		for(unsigned int y = 0; y < framebuffer.getHeight(); ++y)
+		{
+			for(unsigned int x = 0; x < framebuffer.getWidth(); ++x)
+			{
+				count += framebuffer.getPixel(x, y) == color ? 1 : 0;
+			}
+		}
+		return count;
+	}
+
+	// The box field seen from street level by benchmarkCamera, a few big boxes and a lot of
+	// overdraw, or from high above, a lot of boxes a few pixels across
+	glm::mat4 rasterCamera(bool overhead, unsigned int frame, unsigned int frames)
+	{
+		glm::vec3 eye;
+		if(!overhead)
+		{
+			return benchmarkCamera(frame, frames, eye);
+		}
+
+		const float turn = 6.2831853f * frame / frames;
+		return glm::perspective(45.0f, 800.0f / 600.0f, 50.0f, 150.0f) *
+			glm::lookAt(glm::vec3(0.0f, 0.0f, 110.0f), glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3(std::cos(turn), std::sin(turn), 0.0f));
+	}
+
+	// The boxes of the field in view drawn as one instanced draw, vertexArray holding the
+	// unit cube. Returns the hash of the image.
+	unsigned long long renderBoxField(SoftwareRenderBackend &backend, unsigned int program, unsigned int vertexArray, unsigned int indexCount,
+		const PhysicsWorld &world, const glm::mat4 &viewProj, SoftwareRenderStats &stats)
+	{
+		backend.setViewProj(glm::mat4(), viewProj);
+
+		AABBSoA boxes;
+		computeWorldAABBsSoA(world.getOrientedBoxes(), boxes);
+		std::vector<unsigned int> visible(boxes.size());
+		visible.resize(cullAABBBatch(extractFrustum(viewProj), boxes, visible.empty() ? 0 : &visible[0]));
+
+		std::vector<CubeInstance> instances;
+		makeCubeInstances(world.getOrientedBoxes(), visible, instances);
+		RenderQueue queue;
+		if(!instances.empty())
+		{
+			backend.setInstances(vertexArray, &instances[0], (unsigned int)instances.size());
+			RenderCommand command;
+			command.program = program;
+			command.vertexArray = vertexArray;
+			command.drawType = DrawElementsInstanced;
+			command.count = indexCount;
+			command.instanceCount = (unsigned int)instances.size();
+			queue.submit(command, 0.0f);
+		}
+		backend.execute(queue);
+
+		stats = backend.getStats();
+		return backend.getFramebuffer().hash();
+	}
+
+	// Separation of two boxes along axis from their 8 corners each, kept apart from the
+	// narrowphase's own sums so it can check them
+	float projectedGap(const OrientedBox &a, const OrientedBox &b, const glm::vec3 &axis)
+	{
+		float minA = HUGE_VALF, maxA = -HUGE_VALF, minB = HUGE_VALF, maxB = -HUGE_VALF;
+		for(unsigned int i = 0; i < 8; ++i)
+		{
+			const glm::vec3 cornerA = a.center + a.axes[0] * ((i & 1) ? a.halfExtents.x : -a.halfExtents.x) +
+				a.axes[1] * ((i & 2) ? a.halfExtents.y : -a.halfExtents.y) + a.axes[2] * ((i & 4) ? a.halfExtents.z : -a.halfExtents.z);
+			const glm::vec3 cornerB = b.center + b.axes[0] * ((i & 1) ? b.halfExtents.x : -b.halfExtents.x) +
+				b.axes[1] * ((i & 2) ? b.halfExtents.y : -b.halfExtents.y) + b.axes[2] * ((i & 4) ? b.halfExtents.z : -b.halfExtents.z);
+			minA = std::min(minA, glm::dot(cornerA, axis));
+			maxA = std::max(maxA, glm::dot(cornerA, axis));
+			minB = std::min(minB, glm::dot(cornerB, axis));
+			maxB = std::max(maxB, glm::dot(cornerB, axis));
+		}
+
+		return std::max(minB - maxA, minA - maxB);
+	}
+
+	// Largest gap over all 15 axes, positive when the boxes are apart
+	float referenceGap(const OrientedBox &a, const OrientedBox &b)
+	{
+		float gap = -HUGE_VALF;
+		for(int axis = 0; axis < satAxisCount; ++axis)
+		{
+			if(axis >= 6 && glm::length(glm::cross(a.axes[(axis - 6) / 3], b.axes[(axis - 6) % 3])) < 1e-3f)
+			{
+				continue;
+			}
+			gap = std::max(gap, projectedGap(a, b, getSatAxis(a, b, axis)));
+		}
+
+		return gap;
+	}
+
+	// True if p is inside box grown by margin on every side
+	bool insideBox(const OrientedBox &box, const glm::vec3 &p, float margin)
+	{
+		const glm::vec3 offset = p - box.center;
+		for(unsigned int i = 0; i < 3; ++i)
+		{
+			if(std::fabs(glm::dot(offset, box.axes[i])) > box.halfExtents[i] + margin)
+			{
+				return false;
+			}
+		}
+
+		return true;
+	}
+
+	// How a run of the stacking scene ended up
+	struct StackRun
+	{
+		double stepSeconds;
+		double solveSeconds;
+		float meanSpeed;			// Of every box at the end
+		float maxSpeed;
+		float maxDrift;				// Furthest any box slid sideways from where it started
+		float lowestTop;			// Lowest top box of any column, against where it started
+		SolverStats stats;
+	};
+
+	// Columns of unit boxes standing on a static floor, stepped at 200 Hz through the same
+	// broadphase, narrowphase, island and solver stages the scene uses
+	class StackScene
+	{
+	public:
+		StackScene(unsigned int columns, unsigned int height, ThreadPool *pool): m_world(benchmarkDt, pool)
+		, m_solver(pool)
+		, m_narrowphase(pool)
+		, m_height(height)
+		, m_stepSeconds(0.0)
+		, m_solveSeconds(0.0)
+		{
+			m_world.setGravity(glm::vec3(0.0f, 0.0f, -9.81f));
+			m_world.setContactSolver(&m_solver);
+
+			const float spacing = 1.5f;
+			const float floorSize = columns * spacing;
+			m_world.addBody(glm::vec3(0.0f, 0.0f, -0.5f), glm::fquat(1.0f, 0.0f, 0.0f, 0.0f), glm::vec3(floorSize, floorSize, 0.5f), 0.0f);
+
+			for(unsigned int x = 0; x < columns; ++x)
+			{
+				for(unsigned int y = 0; y < columns; ++y)
+				{
+					for(unsigned int z = 0; z < height; ++z)
+					{
+						const glm::vec3 position((x - columns * 0.5f) * spacing, (y - columns * 0.5f) * spacing, 0.5f + z);
+						m_world.addBody(position, glm::fquat(1.0f, 0.0f, 0.0f, 0.0f), glm::vec3(0.5f, 0.5f, 0.5f), 1.0f);
+						m_starts.push_back(position);
+					}
+				}
+			}
+
+			computeWorldAABBsSoA(m_world.getOrientedBoxes(), m_boxes);
+			for(unsigned int i = 0; i < m_world.getBodyCount(); ++i)
+			{
+				m_broadphase.addBody(m_boxes.get(i));
+			}
+		}
+
+		PhysicsWorld& getWorld() { return m_world; }
+		ContactSolver& getSolver() { return m_solver; }
+		IslandManager& getIslands() { return m_islands; }
+
+		// Top box of column, they are numbered in the order they were built
+		unsigned int getTopBody(unsigned int column) const { return 1 + column * m_height + m_height - 1; }
+
+		// One frame of a single step, pairs with nothing awake in them are dropped and only
+		// the awake bodies are refit, the way updateScene does it
+		void step()
+		{
+			const Clock::time_point stepStart = Clock::now();
+
+			const std::vector<BroadphasePair> &pairs = m_broadphase.findOverlappingPairs();
+			m_pairs.clear();
+			for(unsigned int i = 0; i < pairs.size(); ++i)
+			{
+				if(m_world.isAwake(pairs[i].a) || m_world.isAwake(pairs[i].b))
+				{
+					m_pairs.push_back(pairs[i]);
+				}
+			}
+
+			const OrientedBoxSoA oriented = m_world.getOrientedBoxes();
+			m_narrowphase.collide(oriented, m_pairs.empty() ? 0 : &m_pairs[0], (unsigned int)m_pairs.size());
+			m_islands.update(m_world, m_narrowphase.getManifolds(), m_narrowphase.getManifoldCount(), benchmarkDt);
+			m_solver.setContacts(m_world.getBodies(), m_narrowphase.getManifolds(), m_narrowphase.getManifoldCount());
+
+			const Clock::time_point solveStart = Clock::now();
+			m_world.integrate(benchmarkDt);
+			m_solveSeconds += secondsSince(solveStart);
+
+			const std::vector<BodyRange> &awake = m_world.getAwakeRanges();
+			for(unsigned int r = 0; r < awake.size(); ++r)
+			{
+				computeWorldAABBsSoA(oriented, awake[r].begin, awake[r].end, m_boxes);
+				for(unsigned int i = awake[r].begin; i < awake[r].end; ++i)
+				{
+					m_broadphase.updateBody(i, m_boxes.get(i));
+				}
+			}
+
+			m_stepSeconds += secondsSince(stepStart);
+		}
+
+		void resetTimes()
+		{
+			m_stepSeconds = 0.0;
+			m_solveSeconds = 0.0;
+		}
+
+		StackRun getRun() const
+		{
+			StackRun run;
+			run.stepSeconds = m_stepSeconds;
+			run.solveSeconds = m_solveSeconds;
+			run.meanSpeed = 0.0f;
+			run.maxSpeed = 0.0f;
+			run.maxDrift = 0.0f;
+			run.lowestTop = 0.0f;
+
+			const unsigned int count = m_world.getBodyCount();
+			for(unsigned int i = 1; i < count; ++i)
+			{
+				const glm::vec3 offset = m_world.getPosition(i) - m_starts[i - 1];
+				const float speed = glm::length(m_world.getVelocity(i));
+				run.meanSpeed += speed / (count - 1);
+				run.maxSpeed = std::max(run.maxSpeed, speed);
+				run.maxDrift = std::max(run.maxDrift, glm::length(glm::vec2(offset.x, offset.y)));
+				if(i % m_height == 0)
+				{
+					run.lowestTop = std::min(run.lowestTop, offset.z);
+				}
+			}
+			run.stats = m_solver.getStats();
+
+			return run;
+		}
+
+	private:
+		StackScene(const StackScene &);
+		StackScene& operator=(const StackScene &);
+
+		PhysicsWorld m_world;
+		ContactSolver m_solver;
+		IslandManager m_islands;
+		SweepAndPrune m_broadphase;
+		Narrowphase m_narrowphase;
+		AABBSoA m_boxes;
+		std::vector<BroadphasePair> m_pairs;
+		std::vector<glm::vec3> m_starts;
+		unsigned int m_height;
+		double m_stepSeconds;
+		double m_solveSeconds;
+	};
+
+	// Every box is kept awake so the solver is measured on all of them
+	StackRun runStacks(unsigned int columns, unsigned int height, unsigned int steps, ThreadPool *pool, SimdLevel level, bool warmStarting)
+	{
+		StackScene scene(columns, height, pool);
+		scene.getSolver().setSimdLevel(level);
+		scene.getSolver().setWarmStarting(warmStarting);
+		scene.getIslands().setEnabled(false);
+
+		for(unsigned int step = 0; step < steps; ++step)
+		{
+			scene.step();
+		}
+
+		return scene.getRun();
+	}
+
+	// How a run of the bullet scene ended up
+	struct BulletRun
+	{
+		double seconds;
+		unsigned long long steps;
+		unsigned int tunneled;		// Bullets that came out the far side of the wall or floor
+		unsigned int ccdPairs;		// Totals over every step
+		unsigned int impacts;
+		unsigned int substeps;
+		unsigned int contacts;
+	};
+
+	// Small boxes fired at a thin wall and down at a thin floor, next to columns of boxes
+	// resting on the floor, stepped at dt through the frame updateScene runs. With
+	// continuous collision the fast bodies are swept, without it every pair is discrete.
+	class BulletScene
+	{
+	public:
+		BulletScene(unsigned int bullets, float speed, float dt, bool continuous, ThreadPool *pool): m_world(dt, pool)
+		, m_solver(pool)
+		, m_narrowphase(pool)
+		, m_dt(dt)
+		{
+			m_world.setGravity(glm::vec3(0.0f, 0.0f, -9.81f));
+			m_world.setContactSolver(&m_solver);
+			m_world.setContinuousCollision(&m_ccd);
+			m_ccd.setEnabled(continuous);
+
+			const glm::fquat identity(1.0f, 0.0f, 0.0f, 0.0f);
+			const glm::vec3 bulletHalf(0.1f, 0.1f, 0.1f);
+			m_world.addBody(glm::vec3(0.0f, 0.0f, -0.05f), identity, glm::vec3(40.0f, 40.0f, 0.05f), 0.0f);
+			m_world.addBody(glm::vec3(0.0f, 0.0f, 4.0f), identity, glm::vec3(0.05f, 4.0f, 4.0f), 0.0f);
+
+			const unsigned int columns = 16;
+			for(unsigned int x = 0; x < columns; ++x)
+			{
+				for(unsigned int y = 0; y < columns; ++y)
+				{
+					for(unsigned int z = 0; z < 4; ++z)
+					{
+						m_world.addBody(glm::vec3(8.0f + x * 1.5f, (y - columns * 0.5f) * 1.5f, 0.5f + z), identity, glm::vec3(0.5f, 0.5f, 0.5f), 1.0f);
+					}
+				}
+			}
+
+			// Half at the wall from in front of it, half straight down onto the floor
+			const unsigned int side = (unsigned int)std::ceil(std::sqrt(bullets * 0.5f));
+			for(unsigned int i = 0; i < bullets; ++i)
+			{
+				const unsigned int slot = i / 2;
+				const float u = (slot % side + 0.5f) / side;
+				const float v = (slot / side + 0.5f) / side;
+				unsigned int body = 0;
+				if(i % 2 == 0)
+				{
+					body = m_world.addBody(glm::vec3(-6.0f, -3.0f + 6.0f * u, 1.0f + 6.0f * v), identity, bulletHalf, 1.0f);
+					m_world.setVelocity(body, glm::vec3(speed, 0.0f, 0.0f));
+				}
+				else
+				{
+					body = m_world.addBody(glm::vec3(-20.0f + 10.0f * u, -10.0f + 20.0f * v, 6.0f), identity, bulletHalf, 1.0f);
+					m_world.setVelocity(body, glm::vec3(0.0f, 0.0f, -speed));
+				}
+				m_bullets.push_back(body);
+			}
+
+			computeWorldAABBsSoA(m_world.getOrientedBoxes(), m_boxes);
+			for(unsigned int i = 0; i < m_world.getBodyCount(); ++i)
+			{
+				m_broadphase.addBody(getBroadphaseBox(i));
+			}
+
+			m_run.seconds = 0.0;
+			m_run.steps = 0;
+			m_run.tunneled = 0;
+			m_run.ccdPairs = 0;
+			m_run.impacts = 0;
+			m_run.substeps = 0;
+			m_run.contacts = 0;
+		}
+
+		void step()
+		{
+			const Clock::time_point start = Clock::now();
+
+			const std::vector<BroadphasePair> &pairs = m_broadphase.findOverlappingPairs();
+			m_pairs.clear();
+			for(unsigned int i = 0; i < pairs.size(); ++i)
+			{
+				if(m_world.isAwake(pairs[i].a) || m_world.isAwake(pairs[i].b))
+				{
+					m_pairs.push_back(pairs[i]);
+				}
+			}
+
+			const OrientedBoxSoA oriented = m_world.getOrientedBoxes();
+			const BroadphasePair *first = m_pairs.empty() ? 0 : &m_pairs[0];
+			m_narrowphase.collide(oriented, first, (unsigned int)m_pairs.size());
+			m_islands.update(m_world, m_narrowphase.getManifolds(), m_narrowphase.getManifoldCount(), m_dt);
+			m_solver.setContacts(m_world.getBodies(), m_narrowphase.getManifolds(), m_narrowphase.getManifoldCount());
+			m_ccd.setPairs(m_world.getBodies(), first, (unsigned int)m_pairs.size(), m_dt);
+
+			m_world.integrate(m_dt);
+
+			const std::vector<BodyRange> &awake = m_world.getAwakeRanges();
+			for(unsigned int r = 0; r < awake.size(); ++r)
+			{
+				computeWorldAABBsSoA(oriented, awake[r].begin, awake[r].end, m_boxes);
+				for(unsigned int i = awake[r].begin; i < awake[r].end; ++i)
+				{
+					m_broadphase.updateBody(i, getBroadphaseBox(i));
+				}
+			}
+
+			m_run.seconds += secondsSince(start);
+			++m_run.steps;
+			const CcdStats &stats = m_ccd.getStats();
+			m_run.ccdPairs += stats.pairs;
+			m_run.impacts += stats.impacts;
+			m_run.substeps += stats.substeps;
+			m_run.contacts += stats.contacts;
+		}
+
+		BulletRun getRun() const
+		{
+			BulletRun run = m_run;
+			for(unsigned int i = 0; i < m_bullets.size(); ++i)
+			{
+				const glm::vec3 position = m_world.getPosition(m_bullets[i]);
+				const bool passed = i % 2 == 0 ? position.x > 0.05f : position.z < -0.1f;
+				run.tunneled += passed ? 1 : 0;
+			}
+
+			return run;
+		}
+
+	private:
+		BulletScene(const BulletScene &);
+		BulletScene& operator=(const BulletScene &);
+
+		AABB getBroadphaseBox(unsigned int body) const
+		{
+			const BodySoA &bodies = m_world.getBodies();
+			return m_ccd.isEnabled() && isFastBody(bodies, body, m_dt) ? sweepBodyAABB(bodies, body, m_dt) : m_boxes.get(body);
+		}
+
+		PhysicsWorld m_world;
+		ContactSolver m_solver;
+		ContinuousCollision m_ccd;
+		IslandManager m_islands;
+		SweepAndPrune m_broadphase;
+		Narrowphase m_narrowphase;
+		AABBSoA m_boxes;
+		std::vector<BroadphasePair> m_pairs;
+		std::vector<unsigned int> m_bullets;
+		float m_dt;
+		BulletRun m_run;
+	};
+
+	// What the triple buffer stress check hands over, every word the same sequence number so
+	// a value torn between two publishes shows up
+	struct SequenceBlock
+	{
+		unsigned long long words[64];
+	};
+
+	// Box 1 only ever turns about z, this is how far
+	float box1Angle(const SceneSnapshot &snapshot)
+	{
+		const unsigned int body = snapshot.box1Body;
+		return 2.0f * std::atan2(snapshot.qz[body], snapshot.qw[body]);
+	}
+
+	struct DecoupledRun
+	{
+		SimulationThreadStats stats;
+		float dt;					// The scene's fixed step
+		double seconds;
+		double longestFrame;		// Between the starts of two frames, seconds
+		bool angleWentBack;			// Box 1 drawn turned back from where the frame before drew it
+		bool timeWentBack;
+		double drawnRate;			// Simulated seconds drawn per second, fitted over the frames
+		double drawnJitter;			// Furthest a frame's drawn time is off that fit, seconds
+	};
+
+	// The scene with clutter stepped on a simulation thread that sleeps stepDelay every
+	// step, drawn for seconds by frames that each sleep frameSleep and start no more often
+	// than framePeriod. Only interpolation happens on this thread, standing in for the draws.
+	DecoupledRun runDecoupled(unsigned int clutter, double seconds, double framePeriod, double frameSleep, unsigned int stepDelay, ThreadPool *pool)
+	{
+		Scene scene(pool);
+		addSceneClutter(scene, clutter);
+		updateScene(scene, 0.0f);
+
+		SimulationThread simulation(scene);
+		simulation.setStepDelay(stepDelay);
+		SceneSnapshot snapshot;
+
+		DecoupledRun run;
+		run.dt = scene.world.getFixedDt();
+		run.longestFrame = 0.0;
+		run.angleWentBack = false;
+		run.timeWentBack = false;
+		float lastAngle = -1.0f;
+		double lastTime = -1.0;
+		std::vector<double> frameTimes;
+		std::vector<double> drawnTimes;
+
+		simulation.start();
+		const Clock::time_point start = Clock::now();
+		Clock::time_point frameStart = start;
+		while(secondsSince(start) < seconds)
+		{
+			simulation.interpolate(snapshot);
+
+			const float angle = box1Angle(snapshot);
+			run.angleWentBack |= angle < lastAngle;
+			run.timeWentBack |= snapshot.time < lastTime;
+			lastAngle = angle;
+			lastTime = snapshot.time;
+
+			// Once there are two snapshots to blend between
+			if(snapshot.steps > 1)
+			{
+				frameTimes.push_back(secondsSince(start));
+				drawnTimes.push_back(snapshot.time);
+			}
+
+			if(frameSleep > 0.0)
+			{
+				std::this_thread::sleep_for(std::chrono::duration<double>(frameSleep));
+			}
+			std::this_thread::sleep_until(frameStart + std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(framePeriod)));
+
+			const Clock::time_point now = Clock::now();
+			run.longestFrame = std::max(run.longestFrame, std::chrono::duration<double>(now - frameStart).count());
+			frameStart = now;
+		}
+		run.seconds = secondsSince(start);
+		simulation.stop();
+		run.stats = simulation.getStats();
+
+		// Least squares line through drawn time against when the frame was drawn
+		run.drawnRate = 0.0;
+		run.drawnJitter = 0.0;
+		const unsigned int frames = (unsigned int)frameTimes.size();
+		if(frames > 1)
+		{
+			double meanFrame = 0.0;
+			double meanDrawn = 0.0;
+			for(unsigned int i = 0; i < frames; ++i)
+			{
+				meanFrame += frameTimes[i] / frames;
+				meanDrawn += drawnTimes[i] / frames;
+			}
+
+			double covariance = 0.0;
+			double variance = 0.0;
+			for(unsigned int i = 0; i < frames; ++i)
+			{
+				covariance += (frameTimes[i] - meanFrame) * (drawnTimes[i] - meanDrawn);
+				variance += (frameTimes[i] - meanFrame) * (frameTimes[i] - meanFrame);
+			}
+			run.drawnRate = variance > 0.0 ? covariance / variance : 0.0;
+
+			for(unsigned int i = 0; i < frames; ++i)
+			{
+				const double fitted = meanDrawn + run.drawnRate * (frameTimes[i] - meanFrame);
+				run.drawnJitter = std::max(run.drawnJitter, std::abs(drawnTimes[i] - fitted));
+			}
+		}
+
+		return run;
+	}
+
+	// What the scene graph replaces, nodes allocated one at a time and walked through pointers
+	struct PointerNode
+	{
+		PointerNode *parent;
+		std::vector<PointerNode*> children;
+		glm::vec3 position;
+		glm::fquat orientation;
+		glm::vec3 scale;
+		glm::mat4 world;
+	};
+
+	void updatePointerNode(PointerNode *node, const glm::mat4 &parentWorld)
+	{
+		const glm::mat4 local = glm::translate(glm::mat4(), node->position) * glm::mat4_cast(node->orientation);
+		node->world = parentWorld * glm::scale(local, node->scale);
+		for(unsigned int i = 0; i < node->children.size(); ++i)
+		{
+			updatePointerNode(node->children[i], node->world);
+		}
+	}
+
+	// Trees of treeSize nodes, each node under a random earlier one of its tree, so they
+	// are not added in depth first order. The same nodes go into graph and pointerNodes.
+	void buildForest(unsigned int count, unsigned int treeSize, SceneGraph &graph, std::vector<std::unique_ptr<PointerNode> > *pointerNodes)
+	{
+		std::mt19937 random(8080);
+		std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+		std::uniform_real_distribution<float> size(0.8f, 1.2f);
+
+		for(unsigned int node = 0; node < count; ++node)
+		{
+			const unsigned int treeStart = node - node % treeSize;
+			const unsigned int parent = node == treeStart ? noParentNode : treeStart + random() % (node - treeStart);
+			const glm::vec3 position = node == treeStart ? glm::vec3(unit(random), unit(random), unit(random)) * 100.0f
+				: glm::vec3(unit(random), unit(random), unit(random)) * 2.0f;
+			const glm::fquat orientation = glm::normalize(glm::fquat(unit(random), unit(random), unit(random), unit(random)));
+			const glm::vec3 scale(size(random), size(random), size(random));
+			graph.addNode(parent, position, orientation, scale);
+
+			if(pointerNodes)
+			{
+				PointerNode *pointerNode = new PointerNode;
+				pointerNode->parent = parent == noParentNode ? 0 : (*pointerNodes)[parent].get();
+				pointerNode->position = position;
+				pointerNode->orientation = orientation;
+				pointerNode->scale = scale;
+				if(pointerNode->parent)
+				{
+					pointerNode->parent->children.push_back(pointerNode);
+				}
+				pointerNodes->push_back(std::unique_ptr<PointerNode>(pointerNode));
+			}
+		}
+	}
+
+	// The windowed build's frame without the GL calls: a step, a snapshot culled as seen from
+	// its camera, the ground moved in the scene graph and the draws submitted and sorted.
+	// Culling is switched off and on every 50 frames as the C key does. Returns the heap
+	// allocations made after warmUp frames, over frames more.
+	unsigned long long countFrameAllocations(ThreadPool *pool, unsigned int clutter, unsigned int warmUp, unsigned int frames)
+	{
+		Scene scene(pool);
+		addSceneClutter(scene, clutter);
+		const float farPlane = 15.0f;
+		const glm::vec3 cameraPosition(0.0f, -5.0f, 2.0f);
+		const glm::mat4 viewProj = glm::perspective(45.0f, 800.0f / 600.0f, 1.0f, farPlane) *
+			glm::lookAt(cameraPosition, glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3(0.0f, 0.0f, 1.0f));
+		const SceneDrawSetup setup = { 1, 1, 36, 2 };
+
+		SceneSnapshot snapshot;
+		SceneVisibility visibility;
+		RenderQueue queue;
+		SceneProps props(pool);
+
+		HeapStats before = getHeapStats();
+		for(unsigned int frame = 0; frame < warmUp + frames; ++frame)
+		{
+			if(frame == warmUp)
+			{
+				before = getHeapStats();
+			}
+
+			updateScene(scene, scene.world.getFixedDt());
+			takeSceneSnapshot(scene, scene.world.getStepCount() * (double)scene.world.getFixedDt(), scene.world.getStepCount(), snapshot);
+			if(frame / 50 % 2 == 0)
+			{
+				cullScene(snapshot, viewProj, cameraPosition, visibility);
+			}
+			else
+			{
+				showWholeScene(snapshot, visibility);
+			}
+
+			// The ground moved each frame so the graph has work to do in submitSceneDraws
+			props.graph.setLocalPosition(props.groundNode, glm::vec3(0.0f, 0.0f, 0.01f * (frame % 100)));
+
+			queue.clear();
+			submitSceneDraws(snapshot, visibility, props, setup, cameraPosition, farPlane, true, queue);
+			queue.sort();
+		}
+
+		return getHeapStats().allocations - before.allocations;
+	}
+
+	// The same with the simulation on its own thread and this one interpolating the snapshots
+	// it hands over, for about seconds after warmUpSeconds
+	unsigned long long countDecoupledAllocations(ThreadPool *pool, unsigned int clutter, double warmUpSeconds, double seconds, unsigned int &frames)
+	{
+		Scene scene(pool);
+		addSceneClutter(scene, clutter);
+		updateScene(scene, 0.0f);
+		const float farPlane = 15.0f;
+		const glm::vec3 cameraPosition(0.0f, -5.0f, 2.0f);
+		const glm::mat4 viewProj = glm::perspective(45.0f, 800.0f / 600.0f, 1.0f, farPlane) *
+			glm::lookAt(cameraPosition, glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3(0.0f, 0.0f, 1.0f));
+		const SceneDrawSetup setup = { 1, 1, 36, 2 };
+
+		SimulationThread simulation(scene);
+		SceneSnapshot snapshot;
+		SceneVisibility visibility;
+		SceneProps props(pool);
+		RenderQueue queue;
+
+		simulation.start();
+		const Clock::time_point start = Clock::now();
+		bool warm = false;
+		HeapStats before;
+		frames = 0;
+		while(secondsSince(start) < warmUpSeconds + seconds)
+		{
+			if(!warm && secondsSince(start) >= warmUpSeconds)
+			{
+				before = getHeapStats();
+				warm = true;
+			}
+
+			simulation.interpolate(snapshot);
+			cullScene(snapshot, viewProj, cameraPosition, visibility);
+			queue.clear();
+			submitSceneDraws(snapshot, visibility, props, setup, cameraPosition, farPlane, true, queue);
+			queue.sort();
+			frames += warm ? 1 : 0;
+
+			std::this_thread::sleep_for(std::chrono::milliseconds(2));
+		}
+		const HeapStats after = getHeapStats();
+		simulation.stop();
+
+		return after.allocations - before.allocations;
+	}
+}
+
+int runBenchmark(const std::string &name)
+{
+	if(name == "broadphase")
+	{
+		return runBroadphaseBenchmark();
+	}
+
+	if(name == "batchaabb")
+	{
+		return runBatchAABBBenchmark();
+	}
+
+	if(name == "boxextremes")
+	{
+		return runBoxExtremesBenchmark();
+	}
+
+	if(name == "bvh")
+	{
+		return runBVHBenchmark();
+	}
+
+	if(name == "integrate")
+	{
+		return runIntegrateBenchmark();
+	}
+
+	if(name == "renderqueue")
+	{
+		return runRenderQueueBenchmark();
+	}
+
+	if(name == "assets")
+	{
+		return runAssetBenchmark();
+	}
+
+	if(name == "meshes")
+	{
+		return runMeshBenchmark();
+	}
+
+	if(name == "meshopt")
+	{
+		return runMeshOptimizerBenchmark();
+	}
+
+	if(name == "culling")
+	{
+		return runCullingBenchmark();
+	}
+
+	if(name == "narrowphase")
+	{
+		return runNarrowphaseBenchmark();
+	}
+
+	if(name == "solver")
+	{
+		return runSolverBenchmark();
+	}
+
+	if(name == "sleeping")
+	{
+		return runSleepingBenchmark();
+	}
+
+	if(name == "jobs")
+	{
+		return runJobsBenchmark();
+	}
+
+	if(name == "profiler")
+	{
+		return runProfilerBenchmark();
+	}
+
+	if(name == "raster")
+	{
+		return runRasterBenchmark();
+	}
+
+	if(name == "ccd")
+	{
+		return runCcdBenchmark();
+	}
+
+	if(name == "decoupled")
+	{
+		return runDecoupledBenchmark();
+	}
+
+	if(name == "transforms")
+	{
+		return runTransformBenchmark();
+	}
+
+	if(name == "scenegraph")
+	{
+		return runSceneGraphBenchmark();
+	}
+
+	if(name == "memory")
+	{
+		return runMemoryBenchmark();
+	}
+
+	printf("Unknown benchmark: %s\n", name.c_str());
+	return 1;
+}
+
+int runBroadphaseBenchmark()
+{
+	const unsigned int counts[] = { 1000, 10000, 100000 };
+	const unsigned int frames = 20;
+
+	printf("%10s %14s %14s %16s %16s %10s\n", "bodies", "sap ms/frame", "brute ms/frame", "sap pairs/s", "brute pairs/s", "speedup");
+
+	for(unsigned int c = 0; c < sizeof(counts) / sizeof(counts[0]); ++c)
+	{
+		const unsigned int count = counts[c];
+
+		std::vector<AABB> boxes;
+		std::vector<glm::vec3> velocities;
+		createMovingBoxes(count, boxes, velocities);
+
+		SweepAndPrune broadphase;
+		std::vector<unsigned int> handles(count);
+		for(unsigned int i = 0; i < count; ++i)
+		{
+			handles[i] = broadphase.addBody(boxes[i]);
+		}
+
+		// First update pays for the full sort, keep it out of the steady state numbers
+		broadphase.findOverlappingPairs();
+
+		double sapSeconds = 0.0;
+		double pairsFound = 0.0;
+		for(unsigned int frame = 0; frame < frames; ++frame)
+		{
+			moveBoxes(boxes, velocities);
+
+			Clock::time_point start = Clock::now();
+			for(unsigned int i = 0; i < count; ++i)
+			{
+				broadphase.updateBody(handles[i], boxes[i]);
+			}
+			pairsFound += (double)broadphase.findOverlappingPairs().size();
+			sapSeconds += secondsSince(start);
+		}
+
+		// The full n^2 loop takes minutes at 100k, time a slice of rows and scale it up
+		const unsigned int sampleRows = count > 10000 ? 1000 : count;
+		Clock::time_point start = Clock::now();
+		const unsigned int brutePairs = bruteForcePairs(boxes, sampleRows);
+		const double sampleSeconds = secondsSince(start);
+		const double sampledTests = (double)sampleRows * (double)count - (double)sampleRows * (sampleRows + 1) * 0.5;
+		const double totalTests = (double)count * (count - 1) * 0.5;
+		const double bruteSeconds = sampleSeconds * totalTests / sampledTests;
+
+		if(sampleRows == count && brutePairs != broadphase.getPairs().size())
+		{
+			printf("Mismatch: sweep and prune found %u pairs, brute force found %u\n", (unsigned int)broadphase.getPairs().size(), brutePairs);
+			return 1;
+		}
+
+		const double sapFrame = sapSeconds / frames;
+		const double pairsPerFrame = pairsFound / frames;
+		printf("%10u %14.3f %14.3f %16.0f %16.0f %9.1fx%s\n", count,
+			sapFrame * 1000.0, bruteSeconds * 1000.0,
+			pairsPerFrame / sapFrame, pairsPerFrame / bruteSeconds,
+			bruteSeconds / sapFrame, sampleRows == count ? "" : " (brute force estimated)");
+	}
+
+	return 0;
+}
+
+int runBatchAABBBenchmark()
+{
+	// Odd count so every level also goes through the scalar tail
+	const unsigned int count = 100003;
+	const unsigned int queries = 200;
+
+	std::vector<AABB> boxes;
+	std::vector<glm::vec3> velocities;
+	createMovingBoxes(count, boxes, velocities);
+
+	AABBSoA soa;
+	for(unsigned int i = 0; i < count; ++i)
+	{
+		soa.push_back(boxes[i]);
+	}
+
+	// Fatter query boxes so there are plenty of hits to check
+	std::vector<AABB> queryBoxes(queries);
+	for(unsigned int q = 0; q < queries; ++q)
+	{
+		queryBoxes[q] = boxes[(q * 7919) % count];
+		queryBoxes[q].radius = glm::vec3(2.0f, 2.0f, 2.0f);
+	}
+
+	std::vector<unsigned int> mask(batchMaskWords(count));
+	std::vector<unsigned int> indices(count);
+
+	// Every level has to agree with testAABBAABB before its numbers mean anything
+	const SimdLevel best = getSimdLevel();
+	for(int level = SimdScalar; level <= best; ++level)
+	{
+		setBatchAABBSimdLevel((SimdLevel)level);
+		for(unsigned int q = 0; q < queries; ++q)
+		{
+			testAABBBatchMask(queryBoxes[q], soa, &mask[0]);
+			const unsigned int found = testAABBBatchIndices(queryBoxes[q], soa, &indices[0]);
+
+			unsigned int expected = 0;
+			for(unsigned int i = 0; i < count; ++i)
+			{
+				const bool overlap = testAABBAABB(queryBoxes[q], boxes[i]);
+				const bool bit = ((mask[i >> 5] >> (i & 31)) & 1) != 0;
+				if(overlap != bit || (overlap && (expected >= found || indices[expected] != i)))
+				{
+					printf("Mismatch at %s level, query %u box %u\n", getSimdLevelName((SimdLevel)level), q, i);
+					return 1;
+				}
+
+				if(overlap)
+				{
+					++expected;
+				}
+			}
+
+			if(expected != found)
+			{
+				printf("Mismatch at %s level, query %u found %u expected %u\n", getSimdLevelName((SimdLevel)level), q, found, expected);
+				return 1;
+			}
+		}
+	}
+	printf("All levels match testAABBAABB over %u queries x %u boxes\n", queries, count);
+
+	printf("%12s %16s %10s\n", "path", "box tests/s", "speedup");
+
+	// Baseline is the existing function over the array of structures
+	Clock::time_point start = Clock::now();
+	unsigned int hits = 0;
+	for(unsigned int q = 0; q < queries; ++q)
+	{
+		for(unsigned int i = 0; i < count; ++i)
+		{
+			hits += testAABBAABB(queryBoxes[q], boxes[i]) ? 1 : 0;
+		}
+	}
+	const double baseline = (double)queries * count / secondsSince(start);
+	printf("%12s %16.0f %9.1fx (%u hits)\n", "testAABBAABB", baseline, 1.0, hits);
+
+	for(int level = SimdScalar; level <= best; ++level)
+	{
+		setBatchAABBSimdLevel((SimdLevel)level);
+
+		start = Clock::now();
+		hits = 0;
+		for(unsigned int q = 0; q < queries; ++q)
+		{
+			hits += testAABBBatchIndices(queryBoxes[q], soa, &indices[0]);
+		}
+		const double rate = (double)queries * count / secondsSince(start);
+		printf("%12s %16.0f %9.1fx (%u hits)\n", getSimdLevelName((SimdLevel)level), rate, rate / baseline, hits);
+	}
+
+	setBatchAABBSimdLevel(best);
+	return 0;
+}
+
+int runBoxExtremesBenchmark()
+{
+	const unsigned int count = 100003;
+	const unsigned int repeats = 20;
+
+	// Randomly placed and rotated boxes with varied half widths
+	std::mt19937 random(4321);
+	std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+	std::uniform_real_distribution<float> size(0.1f, 2.0f);
+
+	std::vector<float> px(count), py(count), pz(count);
+	std::vector<float> qw(count), qx(count), qy(count), qz(count);
+	std::vector<float> hx(count), hy(count), hz(count);
+	std::vector<glm::mat4> models(count);
+	for(unsigned int i = 0; i < count; ++i)
+	{
+		glm::fquat q = glm::normalize(glm::fquat(unit(random), unit(random), unit(random), unit(random)));
+		px[i] = unit(random) * 50.0f;
+		py[i] = unit(random) * 50.0f;
+		pz[i] = unit(random) * 50.0f;
+		qw[i] = q.w;
+		qx[i] = q.x;
+		qy[i] = q.y;
+		qz[i] = q.z;
+		hx[i] = size(random);
+		hy[i] = size(random);
+		hz[i] = size(random);
+
+		// Unit cube models for the mat4 paths, same translate then rotate as main()
+		models[i] = glm::translate(glm::mat4(), glm::vec3(px[i], py[i], pz[i])) * glm::mat4_cast(q);
+	}
+
+	OrientedBoxSoA oriented = { &px[0], &py[0], &pz[0], &qw[0], &qx[0], &qy[0], &qz[0], &hx[0], &hy[0], &hz[0], count };
+	std::vector<AABB> batch(count);
+	AABBSoA soa;
+	const glm::vec3 unitHalf(0.5f, 0.5f, 0.5f);
+
+	// Every path has to match the transformed corners before it gets timed
+	computeWorldAABBs(&models[0], unitHalf, count, &batch[0]);
+	const SimdLevel best = getSimdLevel();
+	for(int level = SimdScalar; level <= best; ++level)
+	{
+		setBatchAABBSimdLevel((SimdLevel)level);
+		computeWorldAABBsSoA(oriented, soa);
+		for(unsigned int i = 0; i < count; ++i)
+		{
+			const glm::mat4 scaled = glm::scale(models[i], glm::vec3(hx[i], hy[i], hz[i]) * 2.0f);
+			if(!closeTo(soa.get(i), cornerAABB(scaled, unitHalf)) || !closeTo(batch[i], cornerAABB(models[i], unitHalf)))
+			{
+				printf("Mismatch at %s level, box %u\n", getSimdLevelName((SimdLevel)level), i);
+				return 1;
+			}
+		}
+	}
+	printf("All paths match the transformed corners for %u boxes\n", count);
+
+	printf("%28s %16s %10s\n", "path", "boxes/s", "speedup");
+
+	Clock::time_point start = Clock::now();
+	float sink = 0.0f;
+	for(unsigned int r = 0; r < repeats; ++r)
+	{
+		for(unsigned int i = 0; i < count; ++i)
+		{
+			extremes boxExtremes;
+			legacyCalculateBoxExtremes(models[i], boxExtremes);
+			sink += boxExtremes.minX;
+		}
+	}
+	const double baseline = (double)repeats * count / secondsSince(start);
+	printf("%28s %16.0f %9.1fx\n", "old calculateBoxExtremes", baseline, 1.0);
+
+	start = Clock::now();
+	float corners[48];
+	for(unsigned int r = 0; r < repeats; ++r)
+	{
+		for(unsigned int i = 0; i < count; ++i)
+		{
+			extremes boxExtremes;
+			calculateBoxExtremes(models[i], corners, boxExtremes);
+			sink += boxExtremes.minX;
+		}
+	}
+	double rate = (double)repeats * count / secondsSince(start);
+	printf("%28s %16.0f %9.1fx\n", "calculateBoxExtremes", rate, rate / baseline);
+
+	start = Clock::now();
+	for(unsigned int r = 0; r < repeats; ++r)
+	{
+		computeWorldAABBs(&models[0], unitHalf, count, &batch[0]);
+		sink += batch[r].radius.x;
+	}
+	rate = (double)repeats * count / secondsSince(start);
+	printf("%28s %16.0f %9.1fx\n", "computeWorldAABBs (mat4)", rate, rate / baseline);
+
+	for(int level = SimdScalar; level <= best; ++level)
+	{
+		setBatchAABBSimdLevel((SimdLevel)level);
+
+		start = Clock::now();
+		for(unsigned int r = 0; r < repeats; ++r)
+		{
+			computeWorldAABBsSoA(oriented, soa);
+			sink += soa.rx[r];
+		}
+		rate = (double)repeats * count / secondsSince(start);
+
+		const std::string label = std::string("computeWorldAABBsSoA ") + getSimdLevelName((SimdLevel)level);
+		printf("%28s %16.0f %9.1fx\n", label.c_str(), rate, rate / baseline);
+	}
+
+	setBatchAABBSimdLevel(best);
+
+	// Keeps the optimiser from dropping the timed loops
+	return sink == 12345.0f ? 2 : 0;
+}
+
+int runBVHBenchmark()
+{
+	const unsigned int counts[] = { 10000, 100000 };
+	const unsigned int frames = 20;
+	const unsigned int queries = 10000;
+
+	// One in ten bodies moves, the rest are static scenery like the floor
+	const unsigned int movingStride = 10;
+
+	printf("%8s %10s %12s %12s %12s %12s %14s %14s\n", "bodies", "structure", "refit ms", "pairs ms", "pairs", "reinserts", "box queries/s", "ray casts/s");
+
+	for(unsigned int c = 0; c < sizeof(counts) / sizeof(counts[0]); ++c)
+	{
+		const unsigned int count = counts[c];
+
+		std::vector<AABB> boxes;
+		std::vector<glm::vec3> velocities;
+		createMovingBoxes(count, boxes, velocities);
+
+		DynamicAABBTree tree;
+		SweepAndPrune broadphase;
+		std::vector<int> proxies(count);
+		std::vector<unsigned int> handles(count);
+		for(unsigned int i = 0; i < count; ++i)
+		{
+			proxies[i] = tree.insert(boxes[i], i);
+			handles[i] = broadphase.addBody(boxes[i]);
+		}
+		broadphase.findOverlappingPairs();
+
+		double treeRefit = 0.0, treePairs = 0.0, sapRefit = 0.0, sapPairs = 0.0;
+		unsigned int reinserts = 0;
+		std::vector<BroadphasePair> pairs;
+		unsigned int exactPairs = 0;
+		for(unsigned int frame = 0; frame < frames; ++frame)
+		{
+			for(unsigned int i = 0; i < count; i += movingStride)
+			{
+				boxes[i].center_position += velocities[i] * benchmarkDt;
+			}
+
+			Clock::time_point start = Clock::now();
+			for(unsigned int i = 0; i < count; i += movingStride)
+			{
+				reinserts += tree.move(proxies[i], boxes[i], velocities[i] * benchmarkDt) ? 1 : 0;
+			}
+			treeRefit += secondsSince(start);
+
+			start = Clock::now();
+			pairs.clear();
+			tree.queryAllPairs(pairs);
+			treePairs += secondsSince(start);
+
+			start = Clock::now();
+			for(unsigned int i = 0; i < count; i += movingStride)
+			{
+				broadphase.updateBody(handles[i], boxes[i]);
+			}
+			sapRefit += secondsSince(start);
+
+			start = Clock::now();
+			broadphase.findOverlappingPairs();
+			sapPairs += secondsSince(start);
+		}
+
+		// Fat boxes report a superset, the exact overlaps have to match sweep and prune
+		for(unsigned int p = 0; p < pairs.size(); ++p)
+		{
+			exactPairs += testAABBAABB(boxes[pairs[p].a], boxes[pairs[p].b]) ? 1 : 0;
+		}
+		if(exactPairs != broadphase.getPairs().size())
+		{
+			printf("Mismatch: tree found %u exact pairs, sweep and prune found %u\n", exactPairs, (unsigned int)broadphase.getPairs().size());
+			return 1;
+		}
+
+		// Query throughput, small boxes and short rays spread over the scene
+		std::vector<unsigned int> results;
+		Clock::time_point start = Clock::now();
+		for(unsigned int q = 0; q < queries; ++q)
+		{
+			results.clear();
+			tree.query(boxes[(q * 7919) % count], results);
+		}
+		const double boxRate = queries / secondsSince(start);
+
+		start = Clock::now();
+		for(unsigned int q = 0; q < queries; ++q)
+		{
+			results.clear();
+			const AABB &from = boxes[(q * 104729) % count];
+			tree.rayCast(from.center_position, glm::normalize(velocities[q % count]), 5.0f, results);
+		}
+		const double rayRate = queries / secondsSince(start);
+
+		printf("%8u %10s %12.3f %12.3f %12u %12u %14.0f %14.0f\n", count, "bvh",
+			treeRefit * 1000.0 / frames, treePairs * 1000.0 / frames, (unsigned int)pairs.size(), reinserts, boxRate, rayRate);
+		printf("%8u %10s %12.3f %12.3f %12u %12s %14s %14s\n", count, "sap",
+			sapRefit * 1000.0 / frames, sapPairs * 1000.0 / frames, (unsigned int)broadphase.getPairs().size(), "-", "-", "-");
+		printf("%8s height %d, area ratio %.1f, rotations %u\n", "", tree.getHeight(), tree.getAreaRatio(), tree.getRotationCount());
+	}
+
+	return 0;
+}
+
+int runIntegrateBenchmark()
+{
+	const unsigned int count = 100000;
+	const unsigned int steps = 400;
+	const float dt = 1.0f / 200.0f;
+
+	unsigned int maxThreads = std::thread::hardware_concurrency();
+	if(maxThreads == 0)
+	{
+		maxThreads = 1;
+	}
+
+	printf("%u bodies, fixed step %.4f s\n", count, dt);
+	printf("%8s %12s %14s %10s\n", "threads", "ms/step", "steps/s", "200 Hz");
+
+	// Powers of two up to the hardware thread count, then the count itself
+	std::vector<unsigned int> threadCounts;
+	for(unsigned int threads = 1; threads < maxThreads; threads *= 2)
+	{
+		threadCounts.push_back(threads);
+	}
+	threadCounts.push_back(maxThreads);
+
+	for(unsigned int t = 0; t < threadCounts.size(); ++t)
+	{
+		ThreadPool pool(threadCounts[t]);
+		PhysicsWorld world(dt, &pool);
+
+		std::mt19937 random(99);
+		std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+		for(unsigned int i = 0; i < count; ++i)
+		{
+			const unsigned int body = world.addBody(glm::vec3(unit(random), unit(random), unit(random)) * 100.0f,
+				glm::normalize(glm::fquat(unit(random), unit(random), unit(random), unit(random))),
+				glm::vec3(0.5f, 0.5f, 0.5f), 1.0f);
+			world.setVelocity(body, glm::vec3(unit(random), unit(random), unit(random)));
+			world.setAngularVelocity(body, glm::vec3(unit(random), unit(random), unit(random)) * 3.0f);
+		}
+
+		// Feed it frame times as a render loop would, the accumulator decides the step count
+		Clock::time_point start = Clock::now();
+		unsigned int taken = 0;
+		while(taken < steps)
+		{
+			taken += world.step(dt * 2.0f);
+		}
+		const double seconds = secondsSince(start);
+
+		const double msPerStep = seconds * 1000.0 / taken;
+		printf("%8u %12.3f %14.0f %10s\n", pool.getThreadCount(), msPerStep, taken / seconds, msPerStep <= dt * 1000.0 ? "yes" : "no");
+	}
+
+	return 0;
+}
+
+int runRenderQueueBenchmark()
+{
+	const unsigned int count = 10000;
+	const unsigned int programs = 4;
+	const unsigned int vertexArrays = 8;
+	const unsigned int repeats = 50;
+
+	// A scene's worth of draws spread over a few programs and meshes, a fifth of them blended.
+	// first holds the submission index so the sorted order can be checked against depth.
+	std::mt19937 random(7);
+	std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+	std::vector<RenderCommand> commands(count);
+	std::vector<float> depths(count);
+	for(unsigned int i = 0; i < count; ++i)
+	{
+		RenderCommand &command = commands[i];
+		command.program = 1 + random() % programs;
+		command.vertexArray = 1 + random() % vertexArrays;
+		command.blend = unit(random) < 0.2f;
+		command.first = i;
+		command.count = 36;
+		command.alpha = command.blend ? 0.5f : 1.0f;
+		command.model[12] = unit(random);
+		depths[i] = unit(random);
+	}
+
+	RenderQueue queue;
+	double sortSeconds = 0.0;
+	for(unsigned int r = 0; r < repeats; ++r)
+	{
+		queue.clear();
+		for(unsigned int i = 0; i < count; ++i)
+		{
+			queue.submit(commands[i], depths[i]);
+		}
+
+		Clock::time_point start = Clock::now();
+		queue.sort();
+		sortSeconds += secondsSince(start);
+	}
+
+	// Opaque before blended, each opaque state group in one run and front to back inside it,
+	// blended back to front
+	unsigned int orderErrors = 0;
+	std::vector<bool> groupSeen(programs * vertexArrays, false);
+	for(unsigned int i = 0; i < queue.size(); ++i)
+	{
+		const RenderCommand &command = queue.getCommand(i);
+		if(i == 0)
+		{
+			groupSeen[(command.program - 1) * vertexArrays + command.vertexArray - 1] = !command.blend;
+			continue;
+		}
+
+		const RenderCommand &previous = queue.getCommand(i - 1);
+		if(previous.blend && !command.blend)
+		{
+			++orderErrors;
+		}
+		else if(!command.blend)
+		{
+			const bool sameGroup = command.program == previous.program && command.vertexArray == previous.vertexArray;
+			const unsigned int group = (command.program - 1) * vertexArrays + command.vertexArray - 1;
+			if(sameGroup ? depths[command.first] < depths[previous.first] : groupSeen[group])
+			{
+				++orderErrors;
+			}
+			groupSeen[group] = true;
+		}
+		else if(previous.blend && depths[command.first] > depths[previous.first])
+		{
+			++orderErrors;
+		}
+	}
+
+	printf("%u draws, %u programs, %u vertex arrays, 20%% blended\n", count, programs, vertexArrays);
+	printf("Sort: %.3f ms, order errors: %u\n", sortSeconds * 1000.0 / repeats, orderErrors);
+	printf("%-12s %14s %14s %12s\n", "order", "state changes", "skipped", "mismatches");
+
+	// The same draws issued in submission order and in sorted order
+	for(unsigned int pass = 0; pass < 2; ++pass)
+	{
+		queue.clear();
+		for(unsigned int i = 0; i < count; ++i)
+		{
+			queue.submit(commands[i], depths[i]);
+		}
+		if(pass == 1)
+		{
+			queue.sort();
+		}
+
+		CheckingBackend backend;
+		getRenderStats().reset();
+		backend.execute(queue);
+
+		const RenderStats &stats = getRenderStats();
+		printf("%-12s %14u %14u %12u\n", pass == 0 ? "submitted" : "sorted", stats.stateChanges, stats.stateChangesSkipped, backend.getMismatches());
+		if(backend.getMismatches() != 0)
+		{
+			orderErrors += backend.getMismatches();
+		}
+	}
+	getRenderStats().reset();
+
+	return orderErrors == 0 ? 0 : 1;
+}
+
+int runAssetBenchmark()
+{
+	const unsigned int shaderCount = 200;
+	const unsigned int meshCount = 100;
+	const unsigned int loaderThreads = 4;
+	const std::string directory = "AssetBenchmark";
+
+	// Shader sized text files and mesh sized binary ones
+	makeBenchmarkDirectory(directory);
+	std::mt19937 random(11);
+	std::vector<std::string> paths;
+	size_t totalBytes = 0;
+	for(unsigned int i = 0; i < shaderCount + meshCount; ++i)
+	{
+		char name[64];
+		sprintf(name, i < shaderCount ? "/shader%03u.vert" : "/mesh%03u.mesh", i);
+		paths.push_back(directory + name);
+
+		std::string contents;
+		if(i < shaderCount)
+		{
+			while(contents.size() < 1024 + random() % 6144)
+			{
+				contents += "uniform mat4 model;\nin vec3 position;\nvoid main() { gl_Position = model * vec4(position, 1.0); }\n";
+			}
+		}
+		else
+		{
+			contents.resize(65536 + random() % (1024 * 1024));
+			for(unsigned int j = 0; j < contents.size(); ++j)
+			{
+				contents[j] = (char)random();
+			}
+		}
+
+		std::ofstream file(paths[i].c_str(), std::ios::out | std::ios::binary);
+		file.write(contents.data(), contents.size());
+		totalBytes += contents.size();
+	}
+
+	const double megabytes = totalBytes / (1024.0 * 1024.0);
+	printf("%u files, %u shaders and %u meshes, %.1f MB, %u loader threads\n", shaderCount + meshCount, shaderCount, meshCount, megabytes, loaderThreads);
+	printf("%-6s %-8s %10s %10s %10s %12s\n", "pass", "path", "total ms", "main ms", "MB/s", "mismatches");
+
+	// Cold runs drop every file from the OS cache first, warm runs read it straight back
+	std::vector<unsigned long long> expected(paths.size());
+	unsigned int failures = 0;
+	bool evicted = true;
+	for(unsigned int pass = 0; pass < 2; ++pass)
+	{
+		for(unsigned int path = 0; path < 2; ++path)
+		{
+			if(pass == 0)
+			{
+				for(unsigned int i = 0; i < paths.size(); ++i)
+				{
+					evicted = evictFromCache(paths[i]) && evicted;
+				}
+			}
+
+			double totalSeconds = 0.0;
+			double mainSeconds = 0.0;
+			unsigned int mismatches = 0;
+
+			if(path == 0)
+			{
+				// Everything happens on the calling thread
+				std::vector<std::string> texts(paths.size());
+				Clock::time_point start = Clock::now();
+				for(unsigned int i = 0; i < paths.size(); ++i)
+				{
+					texts[i] = legacyReadTextFromFile(paths[i]);
+				}
+				totalSeconds = mainSeconds = secondsSince(start);
+
+				for(unsigned int i = 0; i < paths.size(); ++i)
+				{
+					const unsigned long long hash = hashBytes(texts[i].data(), texts[i].size());
+					if(pass == 0)
+					{
+						expected[i] = hash;
+					}
+					mismatches += hash != expected[i] ? 1 : 0;
+				}
+			}
+			else
+			{
+				// The calling thread only queues requests and picks up results between frames
+				AssetLoader loader(loaderThreads);
+				std::vector<unsigned int> handles(paths.size());
+				Clock::time_point start = Clock::now();
+				for(unsigned int i = 0; i < paths.size(); ++i)
+				{
+					handles[i] = loader.request(paths[i]);
+				}
+				mainSeconds = secondsSince(start);
+
+				unsigned int pickedUp = 0;
+				while(pickedUp < paths.size())
+				{
+					std::this_thread::sleep_for(std::chrono::microseconds(100));
+
+					Clock::time_point frame = Clock::now();
+					pickedUp += loader.update();
+					mainSeconds += secondsSince(frame);
+				}
+				totalSeconds = secondsSince(start);
+
+				for(unsigned int i = 0; i < paths.size(); ++i)
+				{
+					const MappedFile &file = loader.getFile(handles[i]);
+					mismatches += loader.getState(handles[i]) != AssetReady || hashBytes(file.getData(), file.getSize()) != expected[i] ? 1 : 0;
+				}
+			}
+
+			printf("%-6s %-8s %10.2f %10.3f %10.0f %12u\n", pass == 0 ? "cold" : "warm", path == 0 ? "legacy" : "mapped",
+				totalSeconds * 1000.0, mainSeconds * 1000.0, megabytes / totalSeconds, mismatches);
+			failures += mismatches;
+		}
+	}
+
+	if(!evicted)
+	{
+		printf("Files could not be dropped from the OS cache here, the cold runs are warm\n");
+	}
+
+	for(unsigned int i = 0; i < paths.size(); ++i)
+	{
+		std::remove(paths[i].c_str());
+	}
+	removeBenchmarkDirectory(directory);
+
+	return failures == 0 ? 0 : 1;
+}
+
+int runMeshBenchmark()
+{
+	const unsigned int stacks = 400;
+	const unsigned int slices = 800;
+	const unsigned int repeats = 5;
+	const std::string objPath = "MeshBenchmark.obj";
+	const std::string meshPath = "MeshBenchmark.mesh";
+
+	if(!writeSphereObj(objPath, stacks, slices))
+	{
+		printf("Could not write %s\n", objPath.c_str());
+		return 1;
+	}
+
+	// The offline step, parse and weld then write the binary file
+	Clock::time_point start = Clock::now();
+	MeshData mesh;
+	if(!loadObj(objPath, mesh))
+	{
+		return 1;
+	}
+	const double parseSeconds = secondsSince(start);
+	start = Clock::now();
+	if(!writeMeshFile(meshPath, mesh))
+	{
+		return 1;
+	}
+	const double writeSeconds = secondsSince(start);
+
+	const unsigned int corners = (unsigned int)mesh.indices.size();
+	const unsigned int objVertices = (stacks + 1) * (slices + 1);
+	printf("Sphere: %u triangles, %u OBJ vertices welded to %u\n", corners / 3, objVertices, mesh.getVertexCount());
+	printf("Convert: %.1f ms parse and weld, %.1f ms write\n", parseSeconds * 1000.0, writeSeconds * 1000.0);
+
+	// What a frame that wants the mesh pays, parsing the OBJ against mapping the .mesh
+	printf("%-6s %-6s %12s\n", "pass", "file", "load ms");
+	unsigned int failures = 0;
+	for(unsigned int pass = 0; pass < 2; ++pass)
+	{
+		const unsigned int runs = pass == 0 ? 1 : repeats;
+		for(unsigned int format = 0; format < 2; ++format)
+		{
+			double seconds = 0.0;
+			for(unsigned int run = 0; run < runs; ++run)
+			{
+				if(pass == 0)
+				{
+					evictFromCache(objPath);
+					evictFromCache(meshPath);
+				}
+
+				start = Clock::now();
+				if(format == 0)
+				{
+					MeshData parsed;
+					failures += loadObj(objPath, parsed) ? 0 : 1;
+					seconds += secondsSince(start);
+				}
+				else
+				{
+					MappedFile file;
+					MeshView view;
+					if(!file.open(meshPath) || !openMeshView(file, view))
+					{
+						++failures;
+						continue;
+					}
+					file.touchPages();
+					seconds += secondsSince(start);
+
+					// The mapping has to hold exactly what the converter built
+					if(view.header->vertexCount != mesh.getVertexCount() || view.header->indexCount != corners ||
+						memcmp(view.vertices, &mesh.vertices[0], view.getVertexBytes()) != 0 ||
+						memcmp(view.indices, &mesh.indices[0], view.getIndexBytes()) != 0)
+					{
+						++failures;
+					}
+				}
+			}
+
+			printf("%-6s %-6s %12.2f\n", pass == 0 ? "cold" : "warm", format == 0 ? "obj" : "mesh", seconds * 1000.0 / runs);
+		}
+	}
+
+	// Bytes on disk, held on the heap once loaded, and sent to the graphics card
+	const size_t indexedBytes = mesh.vertices.size() * sizeof(float) + corners * sizeof(unsigned int);
+	const size_t unindexedBytes = (size_t)corners * meshVertexFloats * sizeof(float);
+	const size_t parsedHeapBytes = mesh.vertices.capacity() * sizeof(float) + mesh.indices.capacity() * sizeof(unsigned int);
+	printf("%-24s %12s\n", "memory", "KB");
+	printf("%-24s %12.0f\n", "obj file", fileSize(objPath) / 1024.0);
+	printf("%-24s %12.0f\n", "mesh file", fileSize(meshPath) / 1024.0);
+	printf("%-24s %12.0f\n", "obj parsed, peak heap", (parsedHeapBytes + fileSize(objPath)) / 1024.0);
+	printf("%-24s %12.0f\n", "mesh mapped, peak heap", 0.0);
+	printf("%-24s %12.0f\n", "upload indexed", indexedBytes / 1024.0);
+	printf("%-24s %12.0f\n", "upload vertex array", unindexedBytes / 1024.0);
+	printf("Failures: %u\n", failures);
+
+	std::remove(objPath.c_str());
+	std::remove(meshPath.c_str());
+
+	return failures == 0 ? 0 : 1;
+}
+
+int runMeshOptimizerBenchmark()
+{
+	const unsigned int stacks = 200;
+	const unsigned int slices = 400;
+
+	unsigned int failures = 0;
+	for(unsigned int shuffled = 0; shuffled < 2; ++shuffled)
+	{
+		MeshData mesh;
+		createSphereCorners(stacks, slices, shuffled == 1, mesh);
+		const unsigned int corners = mesh.getVertexCount();
+
+		Clock::time_point start = Clock::now();
+		weldVertices(mesh);
+		const double weldSeconds = secondsSince(start);
+
+		printf("Sphere, %s triangle order: %u corners welded to %u vertices, %u triangles\n", shuffled ? "shuffled" : "exporter",
+			corners, mesh.getVertexCount(), (unsigned int)mesh.indices.size() / 3);
+		printf("  %-10s %10s %10s %10s %10s\n", "stage", "ms", "ACMR", "ATVR", "overfetch");
+		printMeshStage("welded", weldSeconds, mesh);
+
+		const std::vector<std::vector<float> > expected = canonicalTriangles(mesh);
+
+		start = Clock::now();
+		optimizeVertexCache(&mesh.indices[0], mesh.indices.size(), mesh.getVertexCount());
+		const double cacheSeconds = secondsSince(start);
+		printMeshStage("cache", cacheSeconds, mesh);
+
+		start = Clock::now();
+		optimizeOverdraw(&mesh.indices[0], mesh.indices.size(), &mesh.vertices[0], mesh.getVertexCount(), meshVertexFloats);
+		const MeshCacheStats overdrawStats = printMeshStage("overdraw", secondsSince(start), mesh);
+
+		start = Clock::now();
+		optimizeVertexFetch(mesh);
+		const MeshCacheStats fetchStats = printMeshStage("fetch", secondsSince(start), mesh);
+
+		printf("  vertex cache pass: %.1f M triangles/s\n", mesh.indices.size() / 3 / cacheSeconds / 1000000.0);
+
+		// The passes may only reorder, every triangle has to come out with the same corners
+		if(canonicalTriangles(mesh) != expected)
+		{
+			printf("  triangles changed\n");
+			++failures;
+		}
+
+		// The fetch pass is only there for overfetch, it must never make it worse
+		if(fetchStats.overfetch > overdrawStats.overfetch)
+		{
+			printf("  overfetch went from %.3f to %.3f in the fetch pass\n", overdrawStats.overfetch, fetchStats.overfetch);
+			++failures;
+		}
+	}
+
+	return failures == 0 ? 0 : 1;
+}
+
+int runCullingBenchmark()
+{
+	// Odd count so every level also goes through the scalar tail
+	const unsigned int count = 100003;
+	const unsigned int frames = 64;
+
+	PhysicsWorld world(benchmarkDt);
+	createBoxField(count, world);
+	const OrientedBoxSoA shapes = world.getOrientedBoxes();
+
+	AABBSoA soa;
+	computeWorldAABBsSoA(shapes, soa);
+	std::vector<AABB> boxes(count);
+	for(unsigned int i = 0; i < count; ++i)
+	{
+		boxes[i] = soa.get(i);
+	}
+
+	// No margin so the tree's leaves are the boxes themselves
+	DynamicAABBTree tree(0.0f);
+	for(unsigned int i = 0; i < count; ++i)
+	{
+		tree.insert(boxes[i], i);
+	}
+
+	std::vector<unsigned int> indices(count);
+	std::vector<unsigned int> results;
+	std::vector<std::vector<unsigned int> > expected(frames);
+	glm::vec3 eye;
+
+	// Every path has to agree with testFrustumAABB before its numbers mean anything
+	for(unsigned int frame = 0; frame < frames; ++frame)
+	{
+		const Frustum frustum = extractFrustum(benchmarkCamera(frame, frames, eye));
+		for(unsigned int i = 0; i < count; ++i)
+		{
+			if(testFrustumAABB(frustum, boxes[i]))
+			{
+				expected[frame].push_back(i);
+			}
+		}
+	}
+
+	const SimdLevel best = getSimdLevel();
+	for(int level = SimdScalar; level <= best; ++level)
+	{
+		setBatchAABBSimdLevel((SimdLevel)level);
+		for(unsigned int frame = 0; frame < frames; ++frame)
+		{
+			const Frustum frustum = extractFrustum(benchmarkCamera(frame, frames, eye));
+			const unsigned int found = cullAABBBatch(frustum, soa, &indices[0]);
+			if(found != expected[frame].size() || !std::equal(expected[frame].begin(), expected[frame].end(), indices.begin()))
+			{
+				printf("Mismatch at %s level, frame %u found %u expected %u\n", getSimdLevelName((SimdLevel)level), frame, found, (unsigned int)expected[frame].size());
+				return 1;
+			}
+		}
+	}
+
+	// The tree tests the same boxes so it must find the same set, in its own order
+	for(unsigned int frame = 0; frame < frames; ++frame)
+	{
+		results.clear();
+		tree.queryFrustum(extractFrustum(benchmarkCamera(frame, frames, eye)), results);
+		std::sort(results.begin(), results.end());
+		if(results != expected[frame])
+		{
+			printf("Mismatch in the tree, frame %u found %u expected %u\n", frame, (unsigned int)results.size(), (unsigned int)expected[frame].size());
+			return 1;
+		}
+	}
+
+	// Occlusion at 128x64 may only hide what a finer buffer with the same occluders hides too
+	SceneCuller culler;
+	OcclusionBuffer fine(1024, 512);
+	unsigned int occludedChecked = 0;
+	for(unsigned int frame = 0; frame < frames; ++frame)
+	{
+		const glm::mat4 viewProj = benchmarkCamera(frame, frames, eye);
+		const std::vector<unsigned int> &visible = culler.cull(viewProj, eye, soa, shapes);
+		const unsigned int occluders = std::min((unsigned int)visible.size(), 32u);
+
+		fine.clear(viewProj);
+		for(unsigned int i = 0; i < occluders; ++i)
+		{
+			const unsigned int index = visible[i];
+			fine.drawOccluder(glm::vec3(shapes.px[index], shapes.py[index], shapes.pz[index]),
+				glm::fquat(shapes.qw[index], shapes.qx[index], shapes.qy[index], shapes.qz[index]),
+				glm::vec3(shapes.hx[index], shapes.hy[index], shapes.hz[index]));
+		}
+
+		std::vector<bool> drawn(count, false);
+		for(unsigned int i = 0; i < visible.size(); ++i)
+		{
+			drawn[visible[i]] = true;
+		}
+		for(unsigned int i = 0; i < expected[frame].size(); ++i)
+		{
+			const unsigned int index = expected[frame][i];
+			if(!drawn[index])
+			{
+				++occludedChecked;
+				if(fine.testAABB(boxes[index]))
+				{
+					printf("Box %u occluded at 128x64 but not at 1024x512, frame %u\n", index, frame);
+					return 1;
+				}
+			}
+		}
+	}
+	printf("All paths match testFrustumAABB over %u views x %u boxes, %u occluded boxes confirmed at 1024x512\n", frames, count, occludedChecked);
+
+	printf("%22s %12s %16s %10s %10s\n", "path", "ms/frame", "boxes/s", "speedup", "visible");
+
+	// Baseline is the single box test over the array of structures
+	Clock::time_point start = Clock::now();
+	unsigned long long visible = 0;
+	for(unsigned int frame = 0; frame < frames; ++frame)
+	{
+		const Frustum frustum = extractFrustum(benchmarkCamera(frame, frames, eye));
+		for(unsigned int i = 0; i < count; ++i)
+		{
+			visible += testFrustumAABB(frustum, boxes[i]) ? 1 : 0;
+		}
+	}
+	const double baseline = secondsSince(start) / frames;
+	printf("%22s %12.3f %16.0f %9.1fx %10.1f\n", "testFrustumAABB", baseline * 1000.0, count / baseline, 1.0, (double)visible / frames);
+
+	for(int level = SimdScalar; level <= best; ++level)
+	{
+		setBatchAABBSimdLevel((SimdLevel)level);
+
+		start = Clock::now();
+		visible = 0;
+		for(unsigned int frame = 0; frame < frames; ++frame)
+		{
+			visible += cullAABBBatch(extractFrustum(benchmarkCamera(frame, frames, eye)), soa, &indices[0]);
+		}
+		const double seconds = secondsSince(start) / frames;
+		printf("%22s %12.3f %16.0f %9.1fx %10.1f\n", getSimdLevelName((SimdLevel)level), seconds * 1000.0, count / seconds, baseline / seconds, (double)visible / frames);
+	}
+	setBatchAABBSimdLevel(best);
+
+	start = Clock::now();
+	visible = 0;
+	unsigned long long nodesTested = 0;
+	for(unsigned int frame = 0; frame < frames; ++frame)
+	{
+		results.clear();
+		nodesTested += tree.queryFrustum(extractFrustum(benchmarkCamera(frame, frames, eye)), results);
+		visible += results.size();
+	}
+	double seconds = secondsSince(start) / frames;
+	printf("%22s %12.3f %16.0f %9.1fx %10.1f (%.0f nodes tested)\n", "bvh", seconds * 1000.0, count / seconds, baseline / seconds, (double)visible / frames, (double)nodesTested / frames);
+
+	// The whole stage, the frustum pass at the best level and then occlusion
+	start = Clock::now();
+	visible = 0;
+	unsigned long long occluded = 0;
+	for(unsigned int frame = 0; frame < frames; ++frame)
+	{
+		const glm::mat4 viewProj = benchmarkCamera(frame, frames, eye);
+		visible += culler.cull(viewProj, eye, soa, shapes).size();
+		occluded += culler.getStats().occluded;
+	}
+	seconds = secondsSince(start) / frames;
+	printf("%22s %12.3f %16.0f %9.1fx %10.1f (%.1f occluded)\n", "frustum + occlusion", seconds * 1000.0, count / seconds, baseline / seconds, (double)visible / frames, (double)occluded / frames);
+
+	return 0;
+}
+
+int runNarrowphaseBenchmark()
+{
+	const unsigned int count = 20000;
+	const unsigned int frames = 60;
+
+	// Long thin spinning boxes, their AABBs are loose whenever they are turned
+	std::mt19937 random(777);
+	const float worldSize = 1.6f * std::pow((float)count, 1.0f / 3.0f);
+	std::uniform_real_distribution<float> position(0.0f, worldSize);
+	std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+	std::uniform_real_distribution<float> extent(0.1f, 0.8f);
+
+	PhysicsWorld world(benchmarkDt);
+	world.setGravity(glm::vec3(0.0f, 0.0f, 0.0f));
+	for(unsigned int i = 0; i < count; ++i)
+	{
+		const unsigned int body = world.addBody(glm::vec3(position(random), position(random), position(random)),
+			glm::normalize(glm::fquat(unit(random), unit(random), unit(random), unit(random))),
+			glm::vec3(extent(random), extent(random), extent(random)), 1.0f);
+		world.setVelocity(body, glm::vec3(unit(random), unit(random), unit(random)));
+		world.setAngularVelocity(body, glm::vec3(unit(random), unit(random), unit(random)) * 2.0f);
+	}
+
+	// Bodies and broadphase handles are added in the same order so they share indices
+	AABBSoA boxes;
+	computeWorldAABBsSoA(world.getOrientedBoxes(), boxes);
+	SweepAndPrune broadphase;
+	for(unsigned int i = 0; i < count; ++i)
+	{
+		broadphase.addBody(boxes.get(i));
+	}
+
+	Narrowphase narrowphase;
+
+	double seconds = 0.0;
+	unsigned long long pairs = 0, touching = 0, points = 0;
+	unsigned int checkedPairs = 0, badPoints = 0;
+	for(unsigned int frame = 0; frame < frames; ++frame)
+	{
+		world.integrate(benchmarkDt);
+		const OrientedBoxSoA shapes = world.getOrientedBoxes();
+		computeWorldAABBsSoA(shapes, boxes);
+		for(unsigned int i = 0; i < count; ++i)
+		{
+			broadphase.updateBody(i, boxes.get(i));
+		}
+		const std::vector<BroadphasePair> &candidates = broadphase.findOverlappingPairs();
+		const unsigned int pairCount = (unsigned int)candidates.size();
+		pairs += pairCount;
+
+		const Clock::time_point start = Clock::now();
+		narrowphase.collide(shapes, &candidates[0], pairCount);
+		seconds += secondsSince(start);
+
+		touching += narrowphase.getStats().manifolds;
+		points += narrowphase.getStats().points;
+
+		// Every few frames each answer is checked by projecting corners on all 15 axes,
+		// near misses either way are left to rounding
+		if(frame % 10 == 0)
+		{
+			unsigned int manifold = 0;
+			for(unsigned int p = 0; p < pairCount; ++p)
+			{
+				const OrientedBox a = getOrientedBox(shapes, candidates[p].a);
+				const OrientedBox b = getOrientedBox(shapes, candidates[p].b);
+				const float gap = referenceGap(a, b);
+				const ContactManifold *found = manifold < narrowphase.getManifoldCount() && narrowphase.getManifolds()[manifold].a == candidates[p].a &&
+					narrowphase.getManifolds()[manifold].b == candidates[p].b ? &narrowphase.getManifolds()[manifold] : 0;
+				manifold += found ? 1 : 0;
+
+				if((found != 0) != (gap <= 0.0f) && std::fabs(gap) > 1e-4f)
+				{
+					printf("Mismatch: pair %u-%u %s, corner projections give a gap of %f\n", candidates[p].a, candidates[p].b, found ? "touching" : "apart", gap);
+					return 1;
+				}
+
+				// Contacts lie in both boxes give or take their depth, or the gap for points
+				// kept within the contact margin
+				for(unsigned int i = 0; found && i < found->pointCount; ++i)
+				{
+					const float margin = std::fabs(found->depths[i]) + 1e-3f;
+					badPoints += insideBox(a, found->points[i], margin) && insideBox(b, found->points[i], margin) ? 0 : 1;
+				}
+				++checkedPairs;
+			}
+		}
+	}
+
+	if(badPoints > 0)
+	{
+		printf("%u contact points lie outside their boxes\n", badPoints);
+		return 1;
+	}
+	printf("Touching pairs match corner projections on all 15 axes over %u pairs\n", checkedPairs);
+
+	printf("%u spinning boxes, %u frames\n", count, frames);
+	printf("  AABB pairs per frame      %10.1f\n", (double)pairs / frames);
+	printf("  OBB touching per frame    %10.1f (%.1f%% of AABB pairs were false positives)\n", (double)touching / frames, 100.0 * (pairs - touching) / pairs);
+	printf("  contact points per pair   %10.2f\n", (double)points / touching);
+	printf("  pairs/s                   %10.0f\n", pairs / seconds);
+
+	return 0;
+}
+
+int runSolverBenchmark()
+{
+	const unsigned int columns = 16;
+	const unsigned int height = 10;
+	const unsigned int steps = 1000;
+
+	unsigned int maxThreads = std::thread::hardware_concurrency();
+	if(maxThreads == 0)
+	{
+		maxThreads = 1;
+	}
+
+	printf("%u columns of %u boxes, %u steps at %.0f Hz\n", columns * columns, height, steps, 1.0f / benchmarkDt);
+	printf("%24s %9s %9s %10s %10s %10s %10s %8s\n", "", "ms/step", "ms/solve", "mean speed", "max speed", "max drift", "top sank", "settled");
+
+	// Columns at rest, nothing sliding off and no column sinking into the one below. The odd
+	// tall column can keep a slight sway at 10 iterations so the fastest box is only reported.
+	bool failed = false;
+	struct Config
+	{
+		const char *name;
+		unsigned int threads;
+		SimdLevel level;
+		bool warmStarting;
+	};
+
+	std::vector<Config> configs;
+	const Config scalar = { "scalar", maxThreads, SimdScalar, true };
+	configs.push_back(scalar);
+	if(getSimdLevel() >= SimdSSE2)
+	{
+		const Config sse2 = { "SSE2", maxThreads, SimdSSE2, true };
+		configs.push_back(sse2);
+	}
+	if(getSimdLevel() >= SimdAVX2)
+	{
+		const Config avx2 = { "AVX2", maxThreads, SimdAVX2, true };
+		configs.push_back(avx2);
+	}
+	const Config cold = { "no warm starting", maxThreads, getSimdLevel(), false };
+	configs.push_back(cold);
+	for(unsigned int threads = 1; threads < maxThreads; threads *= 2)
+	{
+		const Config fewer = { "threads", threads, getSimdLevel(), true };
+		configs.push_back(fewer);
+	}
+
+	SolverStats stats;
+	for(unsigned int i = 0; i < configs.size(); ++i)
+	{
+		const Config &config = configs[i];
+		ThreadPool pool(config.threads);
+		const StackRun run = runStacks(columns, height, steps, &pool, config.level, config.warmStarting);
+		// Every contact in a column may sink by up to the solver's slop
+		const bool settled = run.meanSpeed < 0.01f && run.maxDrift < 0.1f && run.lowestTop > -0.02f * height;
+		failed |= config.warmStarting && !settled;
+		stats = config.warmStarting ? run.stats : stats;
+
+		char label[64];
+		snprintf(label, sizeof(label), "%s, %u thread%s", config.name, pool.getThreadCount(), pool.getThreadCount() == 1 ? "" : "s");
+		printf("%24s %9.3f %9.3f %10.4f %10.4f %10.4f %10.4f %8s\n", label, run.stepSeconds * 1000.0 / steps, run.solveSeconds * 1000.0 / steps,
+			run.meanSpeed, run.maxSpeed, run.maxDrift, -run.lowestTop, settled ? "yes" : "no");
+	}
+
+	printf("%u manifolds, %u points (%u warm started), %u colors in %u batches of %u lanes (%.0f%% filled), %u solved alone\n",
+		stats.manifolds, stats.points, stats.warmStarted, stats.colors, stats.batches, solverLanes,
+		100.0 * stats.lanesUsed / (stats.batches * solverLanes), stats.serialManifolds);
+
+	if(failed)
+	{
+		printf("Warm started stacks did not settle\n");
+		return 1;
+	}
+
+	return 0;
+}
+
+int runSleepingBenchmark()
+{
+	const unsigned int columns = 16;
+	const unsigned int height = 10;
+	const unsigned int settleSteps = 600;
+	// A knocked column sways for a while without last frame's impulses to hold it
+	const unsigned int resettleSteps = 2000;
+	const unsigned int steps = 100;
+	ThreadPool pool;
+
+	printf("%u columns of %u boxes at %.0f Hz, %u threads\n", columns * columns, height, 1.0f / benchmarkDt, pool.getThreadCount());
+	printf("%28s %8s %8s %8s %10s %10s\n", "", "awake", "asleep", "islands", "ms/step", "ms/solve");
+
+	bool failed = false;
+	StackScene awake(columns, height, &pool);
+	StackScene sleeping(columns, height, &pool);
+	awake.getIslands().setEnabled(false);
+	for(unsigned int step = 0; step < settleSteps; ++step)
+	{
+		awake.step();
+		sleeping.step();
+	}
+
+	// Settled, then the same again with one column knocked and then left to settle again
+	const char *labels[] = { "sleeping off", "settled", "one column knocked", "settled again" };
+	double stepMs[4] = { 0.0 };
+	for(unsigned int phase = 0; phase < 4; ++phase)
+	{
+		StackScene &scene = phase == 0 ? awake : sleeping;
+		if(phase == 2)
+		{
+			scene.getWorld().setVelocity(scene.getTopBody(columns * columns / 2), glm::vec3(0.5f, 0.0f, 0.0f));
+		}
+		else if(phase == 3)
+		{
+			for(unsigned int step = 0; step < resettleSteps; ++step)
+			{
+				scene.step();
+			}
+		}
+
+		scene.resetTimes();
+		unsigned int mostAwake = 0;
+		for(unsigned int step = 0; step < steps; ++step)
+		{
+			scene.step();
+			mostAwake = std::max(mostAwake, scene.getIslands().getStats().awakeBodies);
+		}
+
+		const IslandStats &stats = scene.getIslands().getStats();
+		const StackRun run = scene.getRun();
+		stepMs[phase] = run.stepSeconds * 1000.0 / steps;
+		printf("%28s %8u %8u %8u %10.3f %10.3f\n", labels[phase], mostAwake, stats.sleepingBodies, stats.islands,
+			stepMs[phase], run.solveSeconds * 1000.0 / steps);
+
+		// Settled means every box asleep, the knock wakes exactly the one column it hit
+		const unsigned int expectedAwake = phase == 0 ? columns * columns * height : phase == 2 ? height : 0;
+		if(mostAwake != expectedAwake)
+		{
+			printf("Expected %u boxes awake, %u were\n", expectedAwake, mostAwake);
+			failed = true;
+		}
+	}
+
+	printf("Settled steps cost %.1f%% of keeping every box awake, one awake column %.1f%% for %.1f%% of the boxes\n",
+		100.0 * stepMs[1] / stepMs[0], 100.0 * stepMs[2] / stepMs[0], 100.0 / (columns * columns));
+
+	return failed ? 1 : 0;
+}
+
+int runJobsBenchmark()
+{
+	const unsigned int threadCounts[] = { 1, 2, 4, 8, 16, 32 };
+	const unsigned int emptyJobs = 100000;
+	const unsigned int forCount = 1 << 20;
+	const unsigned int forGrain = 4096;
+	const unsigned int sceneBodies = 20000;
+	const unsigned int sceneFrames = 100;
+	const unsigned int columns = 16;
+	const unsigned int height = 10;
+	const unsigned int stackSteps = 100;
+
+	printf("%u hardware threads, scene of %u falling bodies, %u columns of %u boxes kept awake\n",
+		std::thread::hardware_concurrency(), sceneBodies, columns * columns, height);
+	printf("%8s %12s %14s %15s %8s %15s %8s %8s\n", "threads", "jobs/s", "for items/s", "scene ms/frame", "speedup", "stacks ms/step", "speedup", "stolen");
+
+	bool failed = false;
+	double sceneBase = 0.0;
+	double stackBase = 0.0;
+	glm::vec3 sceneResult;
+	glm::vec3 stackResult;
+	std::vector<unsigned int> hits(forCount);
+	std::vector<float> roots(forCount);
+
+	for(unsigned int t = 0; t < sizeof(threadCounts) / sizeof(threadCounts[0]); ++t)
+	{
+		ThreadPool pool(threadCounts[t]);
+
+		// Every index is handed out exactly once
+		std::fill(hits.begin(), hits.end(), 0);
+		pool.parallelFor(forCount, 1000, [&hits](unsigned int begin, unsigned int end)
+		{
+			for(unsigned int i = begin; i < end; ++i)
+			{
+				++hits[i];
+			}
+		});
+		if(std::count(hits.begin(), hits.end(), 1) != (long)forCount)
+		{
+			printf("parallelFor on %u threads missed or repeated indices\n", threadCounts[t]);
+			failed = true;
+		}
+
+		// Jobs held back by a counter only start once all of its jobs are done
+		JobCounter first;
+		JobCounter second;
+		std::atomic<unsigned int> firstDone(0);
+		std::atomic<unsigned int> startedEarly(0);
+		for(unsigned int i = 0; i < 64; ++i)
+		{
+			pool.run([&firstDone]() { firstDone.fetch_add(1); }, &first);
+		}
+		for(unsigned int i = 0; i < 64; ++i)
+		{
+			pool.run([&firstDone, &startedEarly]() { startedEarly.fetch_add(firstDone.load() != 64 ? 1 : 0); }, &second, &first);
+		}
+		pool.wait(second);
+		pool.wait(first);
+		if(startedEarly.load() != 0)
+		{
+			printf("%u jobs on %u threads started before what they waited on\n", startedEarly.load(), threadCounts[t]);
+			failed = true;
+		}
+
+		// What a job costs with nothing in it, the deque fills and the rest run as they are queued
+		JobCounter empty;
+		Clock::time_point start = Clock::now();
+		for(unsigned int i = 0; i < emptyJobs; ++i)
+		{
+			pool.run([]() {}, &empty);
+		}
+		pool.wait(empty);
+		const double jobSeconds = secondsSince(start);
+
+		start = Clock::now();
+		pool.parallelFor(forCount, forGrain, [&roots](unsigned int begin, unsigned int end)
+		{
+			for(unsigned int i = begin; i < end; ++i)
+			{
+				roots[i] = std::sqrt((float)i);
+			}
+		});
+		const double forSeconds = secondsSince(start);
+
+		// The demo scene's update and the solver's stacks, the bodies have to end up in the
+		// same places whatever the thread count as every stage writes each body from one job
+		pool.resetStats();
+		Scene scene(&pool);
+		addSceneClutter(scene, sceneBodies);
+		start = Clock::now();
+		for(unsigned int frame = 0; frame < sceneFrames; ++frame)
+		{
+			updateScene(scene, scene.world.getFixedDt());
+		}
+		const double sceneMs = secondsSince(start) * 1000.0 / sceneFrames;
+
+		StackScene stacks(columns, height, &pool);
+		stacks.getIslands().setEnabled(false);
+		start = Clock::now();
+		for(unsigned int step = 0; step < stackSteps; ++step)
+		{
+			stacks.step();
+		}
+		const double stackMs = secondsSince(start) * 1000.0 / stackSteps;
+		const JobStats stats = pool.getStats();
+
+		glm::vec3 sceneSum(0.0f, 0.0f, 0.0f);
+		for(unsigned int i = 0; i < scene.world.getBodyCount(); ++i)
+		{
+			sceneSum += scene.world.getPosition(i);
+		}
+		glm::vec3 stackSum(0.0f, 0.0f, 0.0f);
+		for(unsigned int i = 0; i < stacks.getWorld().getBodyCount(); ++i)
+		{
+			stackSum += stacks.getWorld().getPosition(i);
+		}
+
+		if(t == 0)
+		{
+			sceneBase = sceneMs;
+			stackBase = stackMs;
+			sceneResult = sceneSum;
+			stackResult = stackSum;
+		}
+		else if(sceneSum != sceneResult || stackSum != stackResult)
+		{
+			printf("Bodies on %u threads ended up somewhere else than on 1\n", threadCounts[t]);
+			failed = true;
+		}
+
+		printf("%8u %12.0f %14.0f %15.3f %7.2fx %15.3f %7.2fx %7.1f%%\n", pool.getThreadCount(), emptyJobs / jobSeconds, forCount / forSeconds,
+			sceneMs, sceneBase / sceneMs, stackMs, stackBase / stackMs, stats.jobs > 0 ? 100.0 * stats.stolen / stats.jobs : 0.0);
+	}
+
+	return failed ? 1 : 0;
+}
+
+namespace
+{
+	// Something for a zone to time that the optimiser cannot take out
+	float profiledWork(unsigned int i, bool zone)
+	{
+		if(zone)
+		{
+			PROFILE_ZONE("Work");
+			return std::sqrt((float)i);
+		}
+
+		return std::sqrt((float)i);
+	}
+}
+
+int runProfilerBenchmark()
+{
+	const unsigned int zones = 1000000;
+	// Fewer than a ring buffer holds, collected between batches as a frame would
+	const unsigned int batch = 10000;
+	const unsigned int frames = 20;
+	const unsigned int threadZones = 10000;
+	const unsigned int chunkSize = 1000;
+	const char *tracePath = "ProfilerBenchmark.json";
+
+	bool failed = false;
+	float sink = 0.0f;
+
+	// The same loop without zones, with zones while profiling is off and while it is on
+	double seconds[3] = { 0.0 };
+	for(unsigned int mode = 0; mode < 3; ++mode)
+	{
+		if(mode == 2)
+		{
+			startProfiling();
+		}
+
+		const Clock::time_point start = Clock::now();
+		for(unsigned int i = 0; i < zones; i += batch)
+		{
+			for(unsigned int j = i; j < i + batch; ++j)
+			{
+				sink += profiledWork(j, mode != 0);
+			}
+			collectProfile();
+		}
+		seconds[mode] = secondsSince(start);
+	}
+	stopProfiling();
+
+	ProfilerStats stats = getProfilerStats();
+	printf("%u zones, %.0f recorded and %llu dropped\n", zones, (double)stats.zones, stats.dropped);
+	printf("%24s %12.2f ns per loop\n", "no zone", seconds[0] * 1e9 / zones);
+	printf("%24s %12.2f ns per zone over no zone\n", "profiling off", (seconds[1] - seconds[0]) * 1e9 / zones);
+	printf("%24s %12.2f ns per zone over no zone\n", "profiling on", (seconds[2] - seconds[0]) * 1e9 / zones);
+	if(stats.zones != zones || stats.dropped != 0)
+	{
+		printf("Expected every zone recorded once\n");
+		failed = true;
+	}
+
+	// Zones and counters from every thread of a pool end up in one trace
+	ThreadPool pool(4);
+	startProfiling();
+	for(unsigned int frame = 0; frame < frames; ++frame)
+	{
+		PROFILE_ZONE("Frame");
+		pool.parallelFor(threadZones, chunkSize, [](unsigned int begin, unsigned int end)
+		{
+			PROFILE_ZONE("Chunk");
+			for(unsigned int i = begin; i < end; ++i)
+			{
+				PROFILE_ZONE("Item");
+			}
+			PROFILE_COUNTER("Chunk size", end - begin);
+		});
+		collectProfile();
+	}
+	stopProfiling();
+
+	const Clock::time_point writeStart = Clock::now();
+	if(!writeChromeTrace(tracePath))
+	{
+		return 1;
+	}
+	const double writeSeconds = secondsSince(writeStart);
+
+	stats = getProfilerStats();
+	// The last frame zone closes after its collect and is picked up by the write
+	const unsigned int chunks = frames * (threadZones / chunkSize);
+	const unsigned int expectedZones = frames * (threadZones + 1) + chunks;
+	printf("%u threads: %llu zones and %llu counters written in %.1f ms, %llu dropped\n", pool.getThreadCount(),
+		stats.zones, stats.counters, writeSeconds * 1000.0, stats.dropped);
+	if(stats.zones != expectedZones || stats.counters != chunks || stats.dropped != 0)
+	{
+		printf("Expected %u zones and %u counters\n", expectedZones, chunks);
+		failed = true;
+	}
+
+	// Every event is a line of its own, check the file holds what was counted
+	std::ifstream trace(tracePath);
+	std::string line;
+	unsigned long long zoneLines = 0;
+	unsigned long long counterLines = 0;
+	bool closed = false;
+	while(std::getline(trace, line))
+	{
+		zoneLines += line.find("\"ph\":\"X\"") != std::string::npos ? 1 : 0;
+		counterLines += line.find("\"ph\":\"C\"") != std::string::npos ? 1 : 0;
+		closed = line == "]}";
+	}
+	trace.close();
+	std::remove(tracePath);
+	if(zoneLines != stats.zones || counterLines != stats.counters || !closed)
+	{
+		printf("The trace holds %llu zones and %llu counters\n", zoneLines, counterLines);
+		failed = true;
+	}
+
+	// Stored so the timed loops are not optimised away
+	volatile float keep = sink;
+	(void)keep;
+	return failed ? 1 : 0;
+}
+
+int runRasterBenchmark()
+{
+	const unsigned int width = 100;
+	const unsigned int height = 75;
+	const unsigned int fieldBoxes = 20000;
+	const unsigned int frames = 20;
+	const unsigned int threadCounts[] = { 1, 2, 4, 8 };
+	const char *imagePath = "RasterBenchmark.png";
+
+	bool failed = false;
+	const glm::vec3 grey(0.5f, 0.5f, 0.5f);
+	const glm::vec3 red(1.0f, 0.0f, 0.0f);
+	const glm::vec3 green(0.0f, 1.0f, 0.0f);
+	const float black[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+
+	// Blended once over black grey gives 0.25, twice 0.375, so every pixel centre on an edge
+	// two triangles share has to go to exactly one of them
+	const unsigned int once = 0xFF404040;
+	const unsigned int clear = 0;
+	printf("Coverage and depth on a %ux%u target\n", width, height);
+	for(unsigned int level = SimdScalar; level <= (unsigned int)getSimdLevel() && level <= SimdSSE2; ++level)
+	{
+		SoftwareRenderBackend backend(width, height);
+		backend.setSimdLevel((SimdLevel)level);
+		backend.setClearColor(black[0], black[1], black[2], black[3]);
+		const unsigned int program = backend.createProgram(SoftwareColor3D);
+		const char *levelName = getSimdLevelName((SimdLevel)level);
+
+		// A rectangle with its edges through pixel centres, as two triangles and as a fan of
+		// eight around its middle. Left and top edges keep their centres, right and bottom do not.
+		const float x0 = 25.5f, y0 = 18.5f, x1 = 74.5f, y1 = 55.5f;
+		const unsigned int expected = 49 * 37;
+		std::vector<float> quad;
+		addPixelQuad(quad, x0, y0, x1, y1, 0.0f, width, height, grey);
+		std::vector<unsigned int> arrays(1, backend.createVertexArray(&quad[0], 6, 0, 0));
+		drawSoftware(backend, arrays, program, true);
+		const unsigned int quadPixels = countPixels(backend.getFramebuffer(), once);
+		const unsigned int quadOther = width * height - quadPixels - countPixels(backend.getFramebuffer(), clear);
+
+		const float rim[8][2] = { { x0, y0 }, { 50.5f, y0 }, { x1, y0 }, { x1, 37.5f }, { x1, y1 }, { 50.5f, y1 }, { x0, y1 }, { x0, 37.5f } };
+		std::vector<float> fan;
+		for(unsigned int i = 0; i < 8; ++i)
+		{
+			addPixelVertex(fan, 50.5f, 37.5f, 0.0f, width, height, grey);
+			addPixelVertex(fan, rim[i][0], rim[i][1], 0.0f, width, height, grey);
+			addPixelVertex(fan, rim[(i + 1) % 8][0], rim[(i + 1) % 8][1], 0.0f, width, height, grey);
+		}
+		RenderQueue queue;
+		RenderCommand command;
+		command.program = program;
+		command.blend = true;
+		command.vertexArray = backend.createVertexArray(&fan[0], 24, 0, 0);
+		command.count = 24;
+		queue.submit(command, 0.0f);
+		backend.execute(queue);
+		const unsigned int fanPixels = countPixels(backend.getFramebuffer(), once);
+		const unsigned int fanOther = width * height - fanPixels - countPixels(backend.getFramebuffer(), clear);
+
+		printf("%8s: quad %u pixels, fan %u pixels, expected %u, %u covered twice or left out\n", levelName, quadPixels, fanPixels, expected, quadOther + fanOther);
+		if(quadPixels != expected || fanPixels != expected || quadOther != 0 || fanOther != 0)
+		{
+			printf("Shared edges drew pixels twice or not at all\n");
+			failed = true;
+		}
+
+		// Nearer wins whichever is drawn first, an equal depth keeps the first
+		const unsigned int redPixel = 0xFF0000FF;
+		const unsigned int greenPixel = 0xFF00FF00;
+		std::vector<float> far, near, same;
+		addPixelQuad(far, 0.0f, 0.0f, (float)width, (float)height, 0.5f, width, height, red);
+		addPixelQuad(near, 0.0f, 0.0f, (float)width, (float)height, -0.5f, width, height, green);
+		addPixelQuad(same, 0.0f, 0.0f, (float)width, (float)height, 0.5f, width, height, green);
+		const unsigned int farArray = backend.createVertexArray(&far[0], 6, 0, 0);
+		const unsigned int nearArray = backend.createVertexArray(&near[0], 6, 0, 0);
+		const unsigned int sameArray = backend.createVertexArray(&same[0], 6, 0, 0);
+		const unsigned int orders[3][2] = { { farArray, nearArray }, { nearArray, farArray }, { farArray, sameArray } };
+		const unsigned int winners[3] = { greenPixel, greenPixel, redPixel };
+		for(unsigned int o = 0; o < 3; ++o)
+		{
+			std::vector<unsigned int> order(orders[o], orders[o] + 2);
+			drawSoftware(backend, order, program, false);
+			if(countPixels(backend.getFramebuffer(), winners[o]) != width * height)
+			{
+				printf("%8s: depth order %u drew the wrong quad\n", levelName, o);
+				failed = true;
+			}
+		}
+	}
+
+	// A floor running from under the camera to past the far plane has to be clipped on both
+	std::vector<float> floor;
+	const float floorCorners[4][2] = { { -100.0f, -100.0f }, { 100.0f, -100.0f }, { 100.0f, 100.0f }, { -100.0f, 100.0f } };
+	const unsigned int floorIndices[6] = { 0, 1, 2, 0, 2, 3 };
+	for(unsigned int i = 0; i < 4; ++i)
+	{
+		const float vertex[meshVertexFloats] = { floorCorners[i][0], floorCorners[i][1], -0.5f, grey.x, grey.y, grey.z };
+		floor.insert(floor.end(), vertex, vertex + meshVertexFloats);
+	}
+	{
+		SoftwareRenderBackend backend(800, 600);
+		backend.setViewProj(glm::lookAt(glm::vec3(0.0f, -5.0f, 2.0f), glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3(0.0f, 0.0f, 1.0f)),
+			glm::perspective(45.0f, 800.0f / 600.0f, 1.0f, 15.0f));
+		RenderQueue queue;
+		RenderCommand command;
+		command.program = backend.createProgram(SoftwareColor3D);
+		command.vertexArray = backend.createVertexArray(&floor[0], 4, floorIndices, 6);
+		command.drawType = DrawElements;
+		command.count = 6;
+		queue.submit(command, 0.0f);
+		backend.execute(queue);
+
+		const Framebuffer &image = backend.getFramebuffer();
+		const SoftwareRenderStats &stats = backend.getStats();
+		const unsigned int floorPixel = 0xFF808080;
+		printf("Floor through the near and far planes: %u triangles clipped, bottom row %s, top row %s\n", stats.clipped,
+			image.getPixel(400, 599) == floorPixel ? "floor" : "not floor", image.getPixel(400, 0) == 0xFFFFFFFF ? "clear" : "not clear");
+		if(stats.clipped != 2 || image.getPixel(400, 599) != floorPixel || image.getPixel(0, 599) != floorPixel || image.getPixel(400, 0) != 0xFFFFFFFF)
+		{
+			printf("The clipped floor does not cover what it should\n");
+			failed = true;
+		}
+	}
+
+	// The same frames through every thread count and SIMD level have to come out the same
+	PhysicsWorld world(benchmarkDt);
+	createBoxField(fieldBoxes, world);
+	MeshData cube;
+	createUnitCube(cube);
+
+	SoftwareRenderStats totals[2];
+	for(unsigned int overhead = 0; overhead < 2; ++overhead)
+	{
+		printf("%u boxes in a field seen from %s at 800x600, %u frames turning round\n", fieldBoxes, overhead ? "above" : "street level", frames);
+		printf("%16s %10s %14s %14s %14s %8s\n", "", "ms/frame", "triangles/s", "rasterized/s", "pixels/s", "speedup");
+
+		std::vector<unsigned long long> reference;
+		double baseline = 0.0;
+		for(unsigned int level = SimdScalar; level <= (unsigned int)getSimdLevel() && level <= SimdSSE2; ++level)
+		{
+			for(unsigned int t = 0; t < sizeof(threadCounts) / sizeof(threadCounts[0]); ++t)
+			{
+				// Scalar only needs the one thread count to check against
+				if(level == SimdScalar && t > 0)
+				{
+					break;
+				}
+
+				ThreadPool pool(threadCounts[t]);
+				SoftwareRenderBackend backend(800, 600, &pool);
+				backend.setSimdLevel((SimdLevel)level);
+				const unsigned int program = backend.createProgram(SoftwareColor3DInstanced);
+				const unsigned int vertexArray = backend.createVertexArray(&cube.vertices[0], cube.getVertexCount(), &cube.indices[0], (unsigned int)cube.indices.size());
+
+				unsigned long long triangles = 0;
+				unsigned long long rasterized = 0;
+				unsigned long long fragments = 0;
+				bool same = true;
+				const Clock::time_point start = Clock::now();
+				for(unsigned int frame = 0; frame < frames; ++frame)
+				{
+					SoftwareRenderStats stats;
+					const unsigned long long hash = renderBoxField(backend, program, vertexArray, (unsigned int)cube.indices.size(), world,
+						rasterCamera(overhead != 0, frame, frames), stats);
+					if(reference.size() <= frame)
+					{
+						reference.push_back(hash);
+					}
+					same &= reference[frame] == hash;
+					triangles += stats.triangles;
+					rasterized += stats.triangles - stats.culled;
+					fragments += stats.fragments;
+					totals[overhead] = stats;
+				}
+				const double seconds = secondsSince(start);
+				baseline = baseline == 0.0 ? seconds : baseline;
+
+				char label[64];
+				snprintf(label, sizeof(label), "%s, %u thread%s", getSimdLevelName((SimdLevel)level), pool.getThreadCount(), pool.getThreadCount() == 1 ? "" : "s");
+				printf("%16s %10.3f %14.0f %14.0f %14.0f %7.2fx%s\n", label, seconds * 1000.0 / frames, triangles / seconds, rasterized / seconds,
+					fragments / seconds, baseline / seconds, same ? "" : "  different image");
+				failed |= !same;
+
+				if(level == SimdScalar && !overhead && !backend.getFramebuffer().writePng(imagePath))
+				{
+					return 1;
+				}
+			}
+		}
+	}
+
+	for(unsigned int overhead = 0; overhead < 2; ++overhead)
+	{
+		const SoftwareRenderStats &stats = totals[overhead];
+		printf("Last frame from %s: %u vertices, %u triangles, %u clipped, %u culled, %u binned into tiles, %llu pixels\n", overhead ? "above" : "street level",
+			stats.vertices, stats.triangles, stats.clipped, stats.culled, stats.binned, stats.fragments);
+	}
+
+	// Rows of a filter byte and the pixels in stored deflate blocks of at most 65535 bytes
+	const size_t raw = (size_t)600 * (1 + 800 * 4);
+	const size_t expectedBytes = 8 + (12 + 13) + (12 + 2 + (raw + 65534) / 65535 * 5 + raw + 4) + 12;
+	std::ifstream image(imagePath, std::ios::binary);
+	char signature[8] = { 0 };
+	image.read(signature, 8);
+	image.seekg(0, std::ios::end);
+	const size_t imageBytes = (size_t)image.tellg();
+	image.close();
+	std::remove(imagePath);
+	printf("PNG of the last frame: %u bytes, expected %u\n", (unsigned int)imageBytes, (unsigned int)expectedBytes);
+	if(memcmp(signature, "\x89PNG\r\n\x1a\n", 8) != 0 || imageBytes != expectedBytes)
+	{
+		printf("The PNG is not what was written\n");
+		failed = true;
+	}
+
+	return failed ? 1 : 0;
+}
+
+int runCcdBenchmark()
+{
+	const unsigned int bullets = 512;
+	const float speed = 40.0f;
+	const float frameRate = 60.0f;
+	const float duration = 0.5f;
+	const unsigned int substepCounts[] = { 1, 2, 4, 8 };
+	ThreadPool pool;
+
+	bool failed = false;
+
+	// A box closing on another from 2 away along x first touches halfway along a motion of 4
+	AABB mover = { glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3(0.5f, 0.5f, 0.5f) };
+	AABB target = { glm::vec3(3.0f, 0.2f, 0.0f), glm::vec3(0.5f, 0.5f, 0.5f) };
+	float time = -1.0f;
+	const bool hits = sweepAABBAABB(mover, glm::vec3(4.0f, 0.0f, 0.0f), target, time);
+	const bool misses = !sweepAABBAABB(mover, glm::vec3(4.0f, 4.0f, 0.0f), target, time);
+	printf("Swept boxes: %s at %.3f of the motion, %s when the motion passes by\n", hits ? "touch" : "miss", time, misses ? "miss" : "touch");
+	if(!hits || std::fabs(time - 0.5f) > 1e-6f || !misses)
+	{
+		printf("Swept box test gave the wrong time of impact\n");
+		failed = true;
+	}
+
+	printf("%u bullets at %.0f m/s against a %.1f thick wall and floor, 1024 resting boxes, %.1f s at %.0f fps, %u threads\n",
+		bullets, speed, 0.1f, duration, frameRate, pool.getThreadCount());
+	printf("%28s %8s %10s %10s %10s %10s %10s\n", "", "tunneled", "steps", "ms/frame", "swept", "substeps", "stopped");
+
+	// Every rate the whole world can be stepped at, then continuous collision at the frame rate
+	// and the 200 Hz the scene steps at
+	struct Config
+	{
+		const char *name;
+		float stepRate;
+		bool continuous;
+	};
+
+	std::vector<Config> configs;
+	for(unsigned int i = 0; i < sizeof(substepCounts) / sizeof(substepCounts[0]); ++i)
+	{
+		const Config discrete = { "discrete", frameRate * substepCounts[i], false };
+		configs.push_back(discrete);
+	}
+	const Config discreteScene = { "discrete", 200.0f, false };
+	const Config continuousFrame = { "continuous", frameRate, true };
+	const Config continuousScene = { "continuous", 200.0f, true };
+	configs.push_back(discreteScene);
+	configs.push_back(continuousFrame);
+	configs.push_back(continuousScene);
+
+	std::vector<BulletRun> runs;
+	for(unsigned int i = 0; i < configs.size(); ++i)
+	{
+		const Config &config = configs[i];
+		BulletScene scene(bullets, speed, 1.0f / config.stepRate, config.continuous, &pool);
+		const unsigned int steps = (unsigned int)(duration * config.stepRate + 0.5f);
+		for(unsigned int step = 0; step < steps; ++step)
+		{
+			scene.step();
+		}
+
+		const BulletRun run = scene.getRun();
+		const double frames = duration * frameRate;
+		runs.push_back(run);
+
+		char label[64];
+		snprintf(label, sizeof(label), "%s, %.0f Hz", config.name, config.stepRate);
+		printf("%28s %8u %10llu %10.3f %10u %10u %10u\n", label, run.tunneled, run.steps, run.seconds * 1000.0 / frames,
+			run.impacts, run.substeps, run.contacts);
+
+		// Bullets fast enough to pass through in a frame's step have to, or nothing is being shown
+		if(config.continuous ? run.tunneled != 0 : config.stepRate == frameRate && run.tunneled == 0)
+		{
+			printf("Expected %s bullets through at %.0f Hz\n", config.continuous ? "no" : "some", config.stepRate);
+			failed = true;
+		}
+	}
+
+	// Against the fewest whole world sub-steps that stop every bullet too
+	const BulletRun &continuous = runs[runs.size() - 2];
+	for(unsigned int i = 0; i < sizeof(substepCounts) / sizeof(substepCounts[0]); ++i)
+	{
+		if(runs[i].tunneled == 0)
+		{
+			printf("Continuous collision at %.0f Hz costs %.1f%% of sub-stepping the whole world %u times\n",
+				frameRate, 100.0 * continuous.seconds / runs[i].seconds, substepCounts[i]);
+			break;
+		}
+		if(i + 1 == sizeof(substepCounts) / sizeof(substepCounts[0]))
+		{
+			printf("Sub-stepping the whole world %u times still lets %u bullets through\n", substepCounts[i], runs[i].tunneled);
+		}
+	}
+
+	return failed ? 1 : 0;
+}
+
+int runDecoupledBenchmark()
+{
+	const unsigned int published = 200000;
+	const unsigned int clutter = 1000;
+	const double frameRate = 60.0;
+	ThreadPool pool;
+
+	bool failed = false;
+
+	// Every value the reader takes is whole and newer than the last
+	{
+		TripleBuffer<SequenceBlock> buffer;
+		std::atomic<bool> done(false);
+		unsigned long long unread = 0;
+		std::thread writer([&buffer, &done, &unread, published]()
+		{
+			for(unsigned int sequence = 1; sequence <= published; ++sequence)
+			{
+				SequenceBlock &block = buffer.getWriteBuffer();
+				std::fill(block.words, block.words + 64, (unsigned long long)sequence);
+				unread += buffer.publish() ? 0 : 1;
+
+				// Gives a reader sharing the core a look in now and then
+				if(sequence % 64 == 0)
+				{
+					std::this_thread::yield();
+				}
+			}
+			done.store(true);
+		});
+
+		unsigned long long last = 0;
+		unsigned long long taken = 0;
+		unsigned long long torn = 0;
+		unsigned long long backwards = 0;
+		bool finished = false;
+		while(!finished)
+		{
+			// Done is only checked before the last acquire, so the final value is always seen
+			finished = done.load();
+			if(!buffer.acquire())
+			{
+				continue;
+			}
+
+			const SequenceBlock &block = buffer.getReadBuffer();
+			for(unsigned int i = 1; i < 64; ++i)
+			{
+				torn += block.words[i] != block.words[0] ? 1 : 0;
+			}
+			backwards += block.words[0] <= last ? 1 : 0;
+			last = block.words[0];
+			++taken;
+		}
+		writer.join();
+
+		printf("Triple buffer: %u published, %llu taken, %llu written over unread, %llu torn, %llu out of order, last %llu\n",
+			published, taken, unread, torn, backwards, last);
+		if(torn != 0 || backwards != 0 || last != published || taken + unread != published)
+		{
+			printf("Triple buffer handed over a torn, repeated or missing value\n");
+			failed = true;
+		}
+	}
+
+	printf("Scene of %u clutter bodies stepped at its fixed rate on its own thread, %u threads in the pool\n",
+		clutter, pool.getThreadCount());
+	printf("%24s %8s %8s %8s %8s %12s %8s %8s %12s %12s %13s %8s %10s\n", "", "steps/s", "late", "unread", "frames/s", "step gap ms", "stale",
+		"taken", "latency ms", "max lat ms", "interp ms", "drawn/s", "jitter ms");
+
+	struct Phase
+	{
+		const char *name;
+		double framePeriod;
+		double frameSleep;
+		unsigned int stepDelay;		// Microseconds
+	};
+
+	// Frames ten times slower than anything sensible, a simulation ten times slower than its
+	// step, and the two at their own rates
+	const Phase phases[] =
+	{
+		{ "slow render", 0.0, 0.1, 0 },
+		{ "slow simulation", 1.0 / frameRate, 0.0, 50000 },
+		{ "60 fps render", 1.0 / frameRate, 0.0, 0 }
+	};
+
+	for(unsigned int p = 0; p < sizeof(phases) / sizeof(phases[0]); ++p)
+	{
+		const Phase &phase = phases[p];
+		const DecoupledRun run = runDecoupled(clutter, 1.0, phase.framePeriod, phase.frameSleep, phase.stepDelay, &pool);
+		const SimulationThreadStats &stats = run.stats;
+		printf("%24s %8.1f %8llu %8llu %8.1f %12.3f %8llu %8llu %12.3f %12.3f %13.4f %8.3f %10.3f\n", phase.name,
+			stats.steps / run.seconds, stats.lateSteps, stats.unreadSnapshots, stats.frames / run.seconds, stats.longestStepGap / 1e6,
+			stats.staleFrames, stats.snapshotsTaken, stats.snapshotsTaken > 0 ? stats.totalLatency / (1e6 * stats.snapshotsTaken) : 0.0,
+			stats.maxLatency / 1e6, stats.longestInterpolate / 1e6, run.drawnRate, run.drawnJitter * 1000.0);
+
+		// Box 1 turns one way at a steady rate, blending has to keep it doing so
+		if(run.angleWentBack || run.timeWentBack)
+		{
+			printf("%s: box 1 was drawn going backwards\n", phase.name);
+			failed = true;
+		}
+
+		// A simulation keeping up is drawn at wall clock rate, each frame a step behind the
+		// newest snapshot however many steps went by since the frame before
+		if(phase.stepDelay == 0 && (std::abs(run.drawnRate - 1.0) > 0.02 || run.drawnJitter > run.dt * 0.5))
+		{
+			printf("%s: drawn time went at %.3f of wall clock and was %.2f ms off it\n", phase.name, run.drawnRate, run.drawnJitter * 1000.0);
+			failed = true;
+		}
+
+		// Never waiting on the other side means each keeps close to its own rate. Whole
+		// steps and frames of slack, a loaded machine wakes sleepers late.
+		const double expectedSteps = phase.stepDelay > 0 ? run.seconds / (phase.stepDelay / 1e6) : run.seconds / run.dt;
+		if(stats.steps < expectedSteps * 0.75)
+		{
+			printf("%s: %llu steps where about %.0f were due, the simulation was held up\n", phase.name, stats.steps, expectedSteps);
+			failed = true;
+		}
+
+		const double framePeriod = std::max(phase.framePeriod, phase.frameSleep);
+		if(run.longestFrame > framePeriod + 0.025)
+		{
+			printf("%s: a frame took %.1f ms, the renderer was held up\n", phase.name, run.longestFrame * 1000.0);
+			failed = true;
+		}
+
+		// Frames between steps find nothing new, steps between frames are written over
+		if(phase.stepDelay > 0 && stats.staleFrames == 0)
+		{
+			printf("%s: no stale frames counted with the simulation behind\n", phase.name);
+			failed = true;
+		}
+		if(phase.frameSleep > 0.0 && stats.unreadSnapshots == 0)
+		{
+			printf("%s: no unread snapshots counted with the renderer behind\n", phase.name);
+			failed = true;
+		}
+	}
+
+	return failed ? 1 : 0;
+}
+
+int runTransformBenchmark()
+{
+	// Odd count so every level also goes through the scalar tail
+	const unsigned int count = 100003;
+	const unsigned int repeats = 20;
+
+	// Randomly placed, rotated and scaled transforms
+	std::mt19937 random(2718);
+	std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+	std::uniform_real_distribution<float> size(0.1f, 2.0f);
+
+	std::vector<float> px(count), py(count), pz(count);
+	std::vector<float> qw(count), qx(count), qy(count), qz(count);
+	std::vector<float> sx(count), sy(count), sz(count);
+	for(unsigned int i = 0; i < count; ++i)
+	{
+		const glm::fquat q = glm::normalize(glm::fquat(unit(random), unit(random), unit(random), unit(random)));
+		px[i] = unit(random) * 50.0f;
+		py[i] = unit(random) * 50.0f;
+		pz[i] = unit(random) * 50.0f;
+		qw[i] = q.w;
+		qx[i] = q.x;
+		qy[i] = q.y;
+		qz[i] = q.z;
+		sx[i] = size(random);
+		sy[i] = size(random);
+		sz[i] = size(random);
+	}
+	const TransformSoA transforms = { &px[0], &py[0], &pz[0], &qw[0], &qx[0], &qy[0], &qz[0], &sx[0], &sy[0], &sz[0], 1.0f, count };
+
+	// Every other transform in no particular order, as culling hands them over
+	std::vector<unsigned int> visible;
+	for(unsigned int i = 0; i < count; i += 2)
+	{
+		visible.push_back(i);
+	}
+	std::shuffle(visible.begin(), visible.end(), random);
+	const unsigned int visibleCount = (unsigned int)visible.size();
+
+	const glm::mat4 viewProj = glm::perspective(45.0f, 800.0f / 600.0f, 1.0f, 200.0f) *
+		glm::lookAt(glm::vec3(0.0f, -80.0f, 40.0f), glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3(0.0f, 0.0f, 1.0f));
+
+	// The per object path the scene used, the quaternion taken apart into an angle and axis
+	std::vector<glm::mat4> models(count);
+	std::vector<glm::mat4> products(count);
+	for(unsigned int i = 0; i < count; ++i)
+	{
+		const glm::fquat q(qw[i], qx[i], qy[i], qz[i]);
+		glm::mat4 model = glm::translate(glm::mat4(), glm::vec3(px[i], py[i], pz[i]));
+		model = glm::rotate(model, glm::angle(q), glm::axis(q));
+		models[i] = glm::scale(model, glm::vec3(sx[i], sy[i], sz[i]));
+		products[i] = viewProj * models[i];
+	}
+
+	std::vector<float> scalarModels(count * transformMatrixFloats);
+	std::vector<float> scalarProducts(count * transformMatrixFloats);
+	std::vector<float> out(count * transformMatrixFloats);
+	const size_t matrixBytes = transformMatrixFloats * sizeof(float);
+
+	// The scalar path has to agree with glm, give or take the trig's rounding
+	setBatchTransformSimdLevel(SimdScalar);
+	composeModelMatrices(transforms, 0, count, &scalarModels[0]);
+	composeModelViewProjMatrices(transforms, 0, count, viewProj, &scalarProducts[0]);
+	float worstModel = 0.0f;
+	float worstProduct = 0.0f;
+	for(unsigned int i = 0; i < count; ++i)
+	{
+		const float *model = glm::value_ptr(models[i]);
+		const float *product = glm::value_ptr(products[i]);
+		for(unsigned int k = 0; k < transformMatrixFloats; ++k)
+		{
+			worstModel = std::max(worstModel, std::fabs(scalarModels[i * transformMatrixFloats + k] - model[k]) / (1.0f + std::fabs(model[k])));
+			worstProduct = std::max(worstProduct, std::fabs(scalarProducts[i * transformMatrixFloats + k] - product[k]) / (1.0f + std::fabs(product[k])));
+		}
+	}
+	printf("Largest relative difference from glm: %g in the models, %g in the model view projections\n", worstModel, worstProduct);
+	if(worstModel > 1e-4f || worstProduct > 1e-4f)
+	{
+		printf("Mismatch between the scalar path and glm\n");
+		return 1;
+	}
+
+	// Every SIMD level does the same sums in the same order, so has to match the scalar path
+	// bit for bit, picking transforms out through a list or not
+	const SimdLevel best = getSimdLevel();
+	for(int level = SimdScalar; level <= best; ++level)
+	{
+		setBatchTransformSimdLevel((SimdLevel)level);
+
+		composeModelMatrices(transforms, 0, count, &out[0]);
+		bool matches = memcmp(&out[0], &scalarModels[0], count * matrixBytes) == 0;
+		composeModelViewProjMatrices(transforms, 0, count, viewProj, &out[0]);
+		matches &= memcmp(&out[0], &scalarProducts[0], count * matrixBytes) == 0;
+
+		composeModelMatrices(transforms, &visible[0], visibleCount, &out[0]);
+		for(unsigned int i = 0; i < visibleCount; ++i)
+		{
+			matches &= memcmp(&out[i * transformMatrixFloats], &scalarModels[visible[i] * transformMatrixFloats], matrixBytes) == 0;
+		}
+		composeModelViewProjMatrices(transforms, &visible[0], visibleCount, viewProj, &out[0]);
+		for(unsigned int i = 0; i < visibleCount; ++i)
+		{
+			matches &= memcmp(&out[i * transformMatrixFloats], &scalarProducts[visible[i] * transformMatrixFloats], matrixBytes) == 0;
+		}
+
+		if(!matches)
+		{
+			printf("Mismatch at %s level against the scalar path\n", getSimdLevelName((SimdLevel)level));
+			return 1;
+		}
+	}
+	printf("All levels match the scalar path exactly for %u transforms, and %u picked out through a list\n", count, visibleCount);
+
+	printf("%36s %16s %10s\n", "path", "matrices/s", "speedup");
+
+	Clock::time_point start = Clock::now();
+	float sink = 0.0f;
+	for(unsigned int r = 0; r < repeats; ++r)
+	{
+		for(unsigned int i = 0; i < count; ++i)
+		{
+			const glm::fquat q(qw[i], qx[i], qy[i], qz[i]);
+			glm::mat4 model = glm::translate(glm::mat4(), glm::vec3(px[i], py[i], pz[i]));
+			model = glm::rotate(model, glm::angle(q), glm::axis(q));
+			models[i] = glm::scale(model, glm::vec3(sx[i], sy[i], sz[i]));
+		}
+		sink += models[r][0][0];
+	}
+	const double baseline = (double)repeats * count / secondsSince(start);
+	printf("%36s %16.0f %9.1fx\n", "glm rotate(angle, axis)", baseline, 1.0);
+
+	start = Clock::now();
+	for(unsigned int r = 0; r < repeats; ++r)
+	{
+		for(unsigned int i = 0; i < count; ++i)
+		{
+			const glm::fquat q(qw[i], qx[i], qy[i], qz[i]);
+			const glm::mat4 model = glm::translate(glm::mat4(), glm::vec3(px[i], py[i], pz[i])) * glm::mat4_cast(q);
+			models[i] = glm::scale(model, glm::vec3(sx[i], sy[i], sz[i]));
+		}
+		sink += models[r][0][0];
+	}
+	double rate = (double)repeats * count / secondsSince(start);
+	printf("%36s %16.0f %9.1fx\n", "glm mat4_cast", rate, rate / baseline);
+
+	for(int level = SimdScalar; level <= best; ++level)
+	{
+		setBatchTransformSimdLevel((SimdLevel)level);
+
+		start = Clock::now();
+		for(unsigned int r = 0; r < repeats; ++r)
+		{
+			composeModelMatrices(transforms, 0, count, &out[0]);
+			sink += out[r];
+		}
+		rate = (double)repeats * count / secondsSince(start);
+		std::string label = std::string("composeModelMatrices ") + getSimdLevelName((SimdLevel)level);
+		printf("%36s %16.0f %9.1fx\n", label.c_str(), rate, rate / baseline);
+
+		start = Clock::now();
+		for(unsigned int r = 0; r < repeats; ++r)
+		{
+			composeModelMatrices(transforms, &visible[0], visibleCount, &out[0]);
+			sink += out[r];
+		}
+		rate = (double)repeats * visibleCount / secondsSince(start);
+		label = std::string("composeModelMatrices listed ") + getSimdLevelName((SimdLevel)level);
+		printf("%36s %16.0f %9.1fx\n", label.c_str(), rate, rate / baseline);
+	}
+
+	// With the view projection multiplied in, against glm doing the same after its model
+	start = Clock::now();
+	for(unsigned int r = 0; r < repeats; ++r)
+	{
+		for(unsigned int i = 0; i < count; ++i)
+		{
+			const glm::fquat q(qw[i], qx[i], qy[i], qz[i]);
+			glm::mat4 model = glm::translate(glm::mat4(), glm::vec3(px[i], py[i], pz[i]));
+			model = glm::rotate(model, glm::angle(q), glm::axis(q));
+			products[i] = viewProj * glm::scale(model, glm::vec3(sx[i], sy[i], sz[i]));
+		}
+		sink += products[r][0][0];
+	}
+	const double productBaseline = (double)repeats * count / secondsSince(start);
+	printf("%36s %16.0f %9.1fx\n", "glm viewProj * rotate(angle, axis)", productBaseline, 1.0);
+
+	for(int level = SimdScalar; level <= best; ++level)
+	{
+		setBatchTransformSimdLevel((SimdLevel)level);
+
+		start = Clock::now();
+		for(unsigned int r = 0; r < repeats; ++r)
+		{
+			composeModelViewProjMatrices(transforms, 0, count, viewProj, &out[0]);
+			sink += out[r];
+		}
+		rate = (double)repeats * count / secondsSince(start);
+		const std::string label = std::string("composeModelViewProjMatrices ") + getSimdLevelName((SimdLevel)level);
+		printf("%36s %16.0f %9.1fx\n", label.c_str(), rate, rate / productBaseline);
+	}
+
+	setBatchTransformSimdLevel(best);
+
+	// Keeps the optimiser from dropping the timed loops
+	return sink == 12345.0f ? 2 : 0;
+}
+
+int runSceneGraphBenchmark()
+{
+	const unsigned int count = 100000;
+	const unsigned int treeSize = 100;
+	const unsigned int frames = 20;
+	const unsigned int moved = count / 100;
+	const unsigned int threadCounts[] = { 1, 2, 4, 8 };
+
+	// The same nodes moved to the same places every run
+	std::vector<unsigned int> moves(frames * moved);
+	std::vector<glm::vec3> movedTo(frames * moved);
+	std::mt19937 random(4040);
+	std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+	for(unsigned int i = 0; i < moves.size(); ++i)
+	{
+		moves[i] = random() % count;
+		movedTo[i] = glm::vec3(unit(random), unit(random), unit(random)) * 2.0f;
+	}
+
+	SceneGraph graph;
+	std::vector<std::unique_ptr<PointerNode> > pointerNodes;
+	buildForest(count, treeSize, graph, &pointerNodes);
+	std::vector<PointerNode*> pointerRoots;
+	for(unsigned int i = 0; i < count; i += treeSize)
+	{
+		pointerRoots.push_back(pointerNodes[i].get());
+	}
+
+	Clock::time_point start = Clock::now();
+	graph.update();
+	printf("%u nodes in trees of %u added out of order, first update sorted them%s in %.3f ms\n",
+		count, treeSize, graph.getStats().reordered ? "" : " (not sorted)", secondsSince(start) * 1000.0);
+
+	printf("%26s %12s %14s %12s %10s %8s %8s\n", "path", "ms/update", "nodes updated", "of pointers", "of arrays", "ranges", "jobs");
+
+	// Every node, walked through the pointers
+	start = Clock::now();
+	for(unsigned int frame = 0; frame < frames; ++frame)
+	{
+		for(unsigned int r = 0; r < pointerRoots.size(); ++r)
+		{
+			updatePointerNode(pointerRoots[r], glm::mat4());
+		}
+	}
+	const double pointerSeconds = secondsSince(start) / frames;
+	printf("%26s %12.3f %14u %11.1f%% %10s %8s %8s\n", "pointers, every node", pointerSeconds * 1000.0, count, 100.0, "", "", "");
+
+	// Every node, through the arrays, by marking every root
+	start = Clock::now();
+	for(unsigned int frame = 0; frame < frames; ++frame)
+	{
+		for(unsigned int root = 0; root < count; root += treeSize)
+		{
+			graph.setLocalPosition(root, graph.getLocalPosition(root));
+		}
+		graph.update();
+	}
+	const double fullSeconds = secondsSince(start) / frames;
+	printf("%26s %12.3f %14u %11.1f%% %9.1f%% %8u %8u\n", "arrays, every node", fullSeconds * 1000.0, graph.getStats().updated,
+		100.0 * fullSeconds / pointerSeconds, 100.0, graph.getStats().ranges, graph.getStats().chunks);
+
+	// 1% of the nodes moved each frame, the pointer nodes follow along for the check below
+	double movedSeconds = 0.0;
+	unsigned long long updated = 0;
+	unsigned long long ranges = 0;
+	for(unsigned int frame = 0; frame < frames; ++frame)
+	{
+		start = Clock::now();
+		for(unsigned int i = frame * moved; i < (frame + 1) * moved; ++i)
+		{
+			graph.setLocalPosition(moves[i], movedTo[i]);
+		}
+		graph.update();
+		movedSeconds += secondsSince(start);
+		updated += graph.getStats().updated;
+		ranges += graph.getStats().ranges;
+
+		for(unsigned int i = frame * moved; i < (frame + 1) * moved; ++i)
+		{
+			pointerNodes[moves[i]]->position = movedTo[i];
+		}
+	}
+	movedSeconds /= frames;
+	printf("%26s %12.3f %14llu %11.1f%% %9.1f%% %8llu %8s\n", "arrays, 1% moved", movedSeconds * 1000.0, updated / frames,
+		100.0 * movedSeconds / pointerSeconds, 100.0 * movedSeconds / fullSeconds, ranges / frames, "");
+
+	// Moving a node moves its subtree, so for 1% of the nodes to change only leaves move
+	std::vector<unsigned int> leaves;
+	for(unsigned int node = 0; node < count; ++node)
+	{
+		if(pointerNodes[node]->children.empty())
+		{
+			leaves.push_back(node);
+		}
+	}
+	double leafSeconds = 0.0;
+	updated = 0;
+	for(unsigned int frame = 0; frame < frames; ++frame)
+	{
+		start = Clock::now();
+		for(unsigned int i = frame * moved; i < (frame + 1) * moved; ++i)
+		{
+			graph.setLocalPosition(leaves[moves[i] % leaves.size()], movedTo[i]);
+		}
+		graph.update();
+		leafSeconds += secondsSince(start);
+		updated += graph.getStats().updated;
+
+		for(unsigned int i = frame * moved; i < (frame + 1) * moved; ++i)
+		{
+			pointerNodes[leaves[moves[i] % leaves.size()]]->position = movedTo[i];
+		}
+	}
+	leafSeconds /= frames;
+	printf("%26s %12.3f %14llu %11.1f%% %9.1f%% %8s %8s\n", "arrays, 1% leaves moved", leafSeconds * 1000.0, updated / frames,
+		100.0 * leafSeconds / pointerSeconds, 100.0 * leafSeconds / fullSeconds, "", "");
+
+	// Only the moved subtrees were worked out again, they still have to agree with every node
+	// worked out from scratch
+	for(unsigned int r = 0; r < pointerRoots.size(); ++r)
+	{
+		updatePointerNode(pointerRoots[r], glm::mat4());
+	}
+	float worst = 0.0f;
+	for(unsigned int node = 0; node < count; ++node)
+	{
+		const float *world = glm::value_ptr(graph.getWorld(node));
+		const float *expected = glm::value_ptr(pointerNodes[node]->world);
+		for(unsigned int k = 0; k < 16; ++k)
+		{
+			worst = std::max(worst, std::fabs(world[k] - expected[k]) / (1.0f + std::fabs(expected[k])));
+		}
+	}
+	printf("Largest relative difference from the pointer walk after %u frames of moves: %g\n", frames, worst);
+	if(worst > 1e-4f)
+	{
+		printf("Mismatch between the scene graph and the pointer walk\n");
+		return 1;
+	}
+
+	// Spread over threads, the same nodes have to come out the same whoever does them
+	for(unsigned int t = 0; t < sizeof(threadCounts) / sizeof(threadCounts[0]); ++t)
+	{
+		ThreadPool pool(threadCounts[t]);
+		SceneGraph parallelGraph(&pool);
+		buildForest(count, treeSize, parallelGraph, 0);
+		parallelGraph.update();
+
+		start = Clock::now();
+		for(unsigned int frame = 0; frame < frames; ++frame)
+		{
+			for(unsigned int root = 0; root < count; root += treeSize)
+			{
+				parallelGraph.setLocalPosition(root, parallelGraph.getLocalPosition(root));
+			}
+			parallelGraph.update();
+		}
+		const double parallelFull = secondsSince(start) / frames;
+		const unsigned int fullChunks = parallelGraph.getStats().chunks;
+
+		start = Clock::now();
+		for(unsigned int frame = 0; frame < frames; ++frame)
+		{
+			for(unsigned int i = frame * moved; i < (frame + 1) * moved; ++i)
+			{
+				parallelGraph.setLocalPosition(moves[i], movedTo[i]);
+			}
+			parallelGraph.update();
+		}
+		const double parallelMoved = secondsSince(start) / frames;
+		const unsigned int movedChunks = parallelGraph.getStats().chunks;
+
+		// The leaves moved as well, to end up where the graph above did
+		for(unsigned int frame = 0; frame < frames; ++frame)
+		{
+			for(unsigned int i = frame * moved; i < (frame + 1) * moved; ++i)
+			{
+				parallelGraph.setLocalPosition(leaves[moves[i] % leaves.size()], movedTo[i]);
+			}
+			parallelGraph.update();
+		}
+
+		char label[64];
+		snprintf(label, sizeof(label), "%u threads, every node", threadCounts[t]);
+		printf("%26s %12.3f %14u %11.1f%% %9.1f%% %8s %8u\n", label, parallelFull * 1000.0, count, 100.0 * parallelFull / pointerSeconds,
+			100.0 * parallelFull / fullSeconds, "", fullChunks);
+		snprintf(label, sizeof(label), "%u threads, 1%% moved", threadCounts[t]);
+		printf("%26s %12.3f %14s %11.1f%% %9.1f%% %8s %8u\n", label, parallelMoved * 1000.0, "", 100.0 * parallelMoved / pointerSeconds,
+			100.0 * parallelMoved / fullSeconds, "", movedChunks);
+
+		for(unsigned int node = 0; node < count; ++node)
+		{
+			if(memcmp(glm::value_ptr(parallelGraph.getWorld(node)), glm::value_ptr(graph.getWorld(node)), sizeof(glm::mat4)) != 0)
+			{
+				printf("Node %u came out different on %u threads\n", node, threadCounts[t]);
+				return 1;
+			}
+		}
+	}
+
+	return 0;
+}
+
+int runMemoryBenchmark()
+{
+	const unsigned int blocks = 10000;
+	const unsigned int rounds = 200;
+	bool failed = false;
+
+	// The counters have to see a plain new and delete, or nothing below can show the heap was
+	// left alone. The delete is the sized one where the compiler has sized deallocation.
+	const HeapStats beforeNew = getHeapStats();
+	int *probe = new int(1);
+	const bool counting = getHeapStats().allocations - beforeNew.allocations == 1;
+	delete probe;
+	const bool countingFrees = getHeapStats().frees - beforeNew.frees == 1;
+	if(!heapCountersEnabled)
+	{
+		printf("Heap counters are not built in without MEMORY_COUNTERS_ENABLED, allocation counts below are all 0\n");
+	}
+	else if(!counting || !countingFrees)
+	{
+		printf("The heap counters missed a plain new or delete\n");
+		failed = true;
+	}
+
+	// Sizes as the per frame lists ask for them, from a few bytes to a few hundred
+	std::mt19937 random(2525);
+	std::vector<unsigned int> sizes(blocks);
+	for(unsigned int i = 0; i < blocks; ++i)
+	{
+		sizes[i] = 4 + random() % 252;
+	}
+	std::vector<void*> pointers(blocks);
+
+	// Every block at a known alignment and none overlapping, checked by filling each with
+	// its own byte and reading them all back
+	{
+		FrameArena arena(4096);
+		std::vector<unsigned char*> filled(blocks);
+		for(unsigned int frame = 0; frame < 3; ++frame)
+		{
+			arena.reset();
+			for(unsigned int i = 0; i < blocks; ++i)
+			{
+				const size_t alignment = (size_t)4 << (i % 5);
+				filled[i] = static_cast<unsigned char*>(arena.allocate(sizes[i], alignment));
+				if(((size_t)filled[i] & (alignment - 1)) != 0)
+				{
+					printf("Frame arena block %u not aligned to %u\n", i, (unsigned int)alignment);
+					failed = true;
+				}
+				memset(filled[i], i & 0xff, sizes[i]);
+			}
+			for(unsigned int i = 0; i < blocks; ++i)
+			{
+				for(unsigned int b = 0; b < sizes[i]; ++b)
+				{
+					if(filled[i][b] != (i & 0xff))
+					{
+						printf("Frame arena block %u written over\n", i);
+						failed = true;
+						break;
+					}
+				}
+			}
+		}
+
+		// The first frame overflowed a block too small for it, the ones after fit
+		const FrameArenaStats &stats = arena.getStats();
+		printf("Frame arena: %u overflows in the first frame, grew %u times to %u KB, %u KB used a frame\n",
+			stats.overflows, stats.grows, (unsigned int)(stats.capacity / 1024), (unsigned int)(stats.used / 1024));
+		if(stats.grows != 1 || stats.overflows == 0)
+		{
+			printf("Frame arena should have grown once to fit and stopped overflowing\n");
+			failed = true;
+		}
+	}
+
+	// What one frame allocated is still there while the next allocates
+	{
+		DoubleFrameArena arenas;
+		arenas.beginFrame();
+		unsigned int *last = arenas.allocateArray<unsigned int>(1000);
+		for(unsigned int i = 0; i < 1000; ++i)
+		{
+			last[i] = i * 7;
+		}
+		arenas.beginFrame();
+		unsigned int *current = arenas.allocateArray<unsigned int>(1000);
+		for(unsigned int i = 0; i < 1000; ++i)
+		{
+			current[i] = 0xffffffff;
+		}
+		for(unsigned int i = 0; i < 1000; ++i)
+		{
+			if(last[i] != i * 7)
+			{
+				printf("Double frame arena gave the last frame's memory out again\n");
+				failed = true;
+				break;
+			}
+		}
+	}
+
+	// Blocks given back are what is handed out next
+	{
+		FixedPool pool(48, 16);
+		for(unsigned int i = 0; i < 1000; ++i)
+		{
+			pointers[i] = pool.allocate();
+		}
+		const unsigned int capacity = pool.getCapacity();
+		for(unsigned int i = 0; i < 1000; i += 2)
+		{
+			pool.deallocate(pointers[i]);
+		}
+		for(unsigned int i = 0; i < 1000; i += 2)
+		{
+			pointers[i] = pool.allocate();
+			if(((size_t)pointers[i] & 15) != 0)
+			{
+				printf("Pool block not aligned to 16\n");
+				failed = true;
+			}
+		}
+		std::vector<void*> sorted(pointers.begin(), pointers.begin() + 1000);
+		std::sort(sorted.begin(), sorted.end());
+		if(std::adjacent_find(sorted.begin(), sorted.end()) != sorted.end() || pool.getCapacity() != capacity || pool.getUsedCount() != 1000)
+		{
+			printf("Pool handed a block out twice or grew with blocks free\n");
+			failed = true;
+		}
+	}
+
+	printf("%32s %12s %10s %14s\n", "allocation", "ns each", "speedup", "heap calls");
+
+	// A frame's worth of blocks then all of them given back
+	HeapStats heapBefore = getHeapStats();
+	Clock::time_point start = Clock::now();
+	for(unsigned int round = 0; round < rounds; ++round)
+	{
+		for(unsigned int i = 0; i < blocks; ++i)
+		{
+			pointers[i] = malloc(sizes[i]);
+			*static_cast<char*>(pointers[i]) = 1;
+		}
+		for(unsigned int i = 0; i < blocks; ++i)
+		{
+			free(pointers[i]);
+		}
+	}
+	const double mallocSeconds = secondsSince(start) / ((double)rounds * blocks);
+	printf("%32s %12.2f %9.1fx %14s\n", "malloc and free", mallocSeconds * 1e9, 1.0, "not seen");
+
+	heapBefore = getHeapStats();
+	start = Clock::now();
+	for(unsigned int round = 0; round < rounds; ++round)
+	{
+		for(unsigned int i = 0; i < blocks; ++i)
+		{
+			pointers[i] = new char[sizes[i]];
+			*static_cast<char*>(pointers[i]) = 1;
+		}
+		for(unsigned int i = 0; i < blocks; ++i)
+		{
+			delete[] static_cast<char*>(pointers[i]);
+		}
+	}
+	const double newSeconds = secondsSince(start) / ((double)rounds * blocks);
+	printf("%32s %12.2f %9.1fx %14llu\n", "new and delete", newSeconds * 1e9, mallocSeconds / newSeconds,
+		getHeapStats().allocations - heapBefore.allocations);
+
+	{
+		// Grown to a frame's blocks first, as a frame loop's arena is after its first frame
+		FrameArena arena;
+		for(unsigned int i = 0; i < blocks; ++i)
+		{
+			arena.allocate(sizes[i]);
+		}
+		arena.reset();
+
+		heapBefore = getHeapStats();
+		start = Clock::now();
+		for(unsigned int round = 0; round < rounds; ++round)
+		{
+			arena.reset();
+			for(unsigned int i = 0; i < blocks; ++i)
+			{
+				pointers[i] = arena.allocate(sizes[i]);
+				*static_cast<char*>(pointers[i]) = 1;
+			}
+		}
+		const double arenaSeconds = secondsSince(start) / ((double)rounds * blocks);
+		printf("%32s %12.2f %9.1fx %14llu\n", "frame arena, reset each frame", arenaSeconds * 1e9, mallocSeconds / arenaSeconds,
+			getHeapStats().allocations - heapBefore.allocations);
+	}
+
+	// Map nodes inserted and erased at random, as pair and contact caches keyed by body do
+	typedef std::pair<const unsigned int, unsigned int> MapValue;
+	typedef std::map<unsigned int, unsigned int, std::less<unsigned int>, PoolAllocator<MapValue> > PooledMap;
+	const unsigned int keys = 4096;
+	std::vector<unsigned int> churn(blocks);
+	for(unsigned int i = 0; i < blocks; ++i)
+	{
+		churn[i] = random() % keys;
+	}
+
+	unsigned long long heapMapCalls = 0;
+	double heapMapSeconds = 0.0;
+	{
+		std::map<unsigned int, unsigned int> map;
+		heapBefore = getHeapStats();
+		start = Clock::now();
+		for(unsigned int round = 0; round < rounds; ++round)
+		{
+			for(unsigned int i = 0; i < blocks; ++i)
+			{
+				if(!map.insert(std::make_pair(churn[i], i)).second)
+				{
+					map.erase(churn[i]);
+				}
+			}
+		}
+		heapMapSeconds = secondsSince(start) / ((double)rounds * blocks);
+		heapMapCalls = getHeapStats().allocations - heapBefore.allocations;
+		printf("%32s %12.2f %9.1fx %14llu\n", "std::map nodes from the heap", heapMapSeconds * 1e9, 1.0, heapMapCalls);
+	}
+
+	{
+		FixedPool pool(sizeof(MapValue) + containerNodeOverhead, std::alignment_of<MapValue>::value);
+		pool.reserve(keys);
+		const PoolAllocator<MapValue> allocator(pool);
+		PooledMap map(std::less<unsigned int>(), allocator);
+		heapBefore = getHeapStats();
+		start = Clock::now();
+		for(unsigned int round = 0; round < rounds; ++round)
+		{
+			for(unsigned int i = 0; i < blocks; ++i)
+			{
+				if(!map.insert(std::make_pair(churn[i], i)).second)
+				{
+					map.erase(churn[i]);
+				}
+			}
+		}
+		const double poolSeconds = secondsSince(start) / ((double)rounds * blocks);
+		const unsigned long long poolCalls = getHeapStats().allocations - heapBefore.allocations;
+		printf("%32s %12.2f %9.1fx %14llu\n", "std::map nodes from a pool", poolSeconds * 1e9, heapMapSeconds / poolSeconds, poolCalls);
+		if(poolCalls != 0)
+		{
+			printf("Pooled map went to the heap with the pool reserved\n");
+			failed = true;
+		}
+	}
+
+	// A vector per frame, reserved in the arena and dropped with it
+	{
+		FrameArena arena;
+		for(unsigned int round = 0; round < 2; ++round)
+		{
+			arena.reset();
+			std::vector<unsigned int, ArenaAllocator<unsigned int> > list((ArenaAllocator<unsigned int>(arena)));
+			list.reserve(blocks);
+		}
+
+		heapBefore = getHeapStats();
+		start = Clock::now();
+		unsigned long long sum = 0;
+		for(unsigned int round = 0; round < rounds; ++round)
+		{
+			arena.reset();
+			std::vector<unsigned int, ArenaAllocator<unsigned int> > list((ArenaAllocator<unsigned int>(arena)));
+			list.reserve(blocks);
+			for(unsigned int i = 0; i < blocks; ++i)
+			{
+				list.push_back(churn[i]);
+			}
+			sum += list.back();
+		}
+		const double arenaVectorSeconds = secondsSince(start) / ((double)rounds * blocks);
+		const unsigned long long arenaVectorCalls = getHeapStats().allocations - heapBefore.allocations;
+		printf("%32s %12.2f %10s %14llu\n", "push_back into an arena vector", arenaVectorSeconds * 1e9, "", arenaVectorCalls + (sum == 0 ? 1 : 0));
+		if(arenaVectorCalls != 0)
+		{
+			printf("Arena vector went to the heap\n");
+			failed = true;
+		}
+	}
+
+	// The frame loops, every thread counted, once the scene's containers have grown
+	printf("%32s %12s %14s\n", "frame loop", "frames", "heap calls");
+	const unsigned int threadCounts[] = { 1, 4 };
+	for(unsigned int t = 0; t < sizeof(threadCounts) / sizeof(threadCounts[0]); ++t)
+	{
+		ThreadPool pool(threadCounts[t]);
+		const unsigned int frames = 600;
+		const unsigned long long calls = countFrameAllocations(&pool, 2000, 100, frames);
+
+		char label[64];
+		snprintf(label, sizeof(label), "%u threads, in step", threadCounts[t]);
+		printf("%32s %12u %14llu\n", label, frames, calls);
+		failed |= calls != 0;
+
+		unsigned int decoupledFrames = 0;
+		const unsigned long long decoupledCalls = countDecoupledAllocations(&pool, 2000, 0.5, 1.0, decoupledFrames);
+		snprintf(label, sizeof(label), "%u threads, simulation thread", threadCounts[t]);
+		printf("%32s %12u %14llu\n", label, decoupledFrames, decoupledCalls);
+		failed |= decoupledCalls != 0;
+	}
+
+	if(failed)
+	{
+		printf("Memory checks failed\n");
+	}
+	return failed ? 1 : 0;
+}
@@ -0,0 +1,815 @@
+/*
+	Name:			ContactSolver.cpp
+	Project:		OpenGL
+	Description:	Sequential impulse contact solver, graph colored so batches run on every thread
+	Doc Version:	1.0
+	Author:			Jonathan Simon Jones
+	Date(D/M/Y):	16-10-2026
+	To do:
+*/
+
+#include "ContactSolver.h"
+#include "Profiler.h"
+#include "ThreadPool.h"
+
+// Math includes
+#include <glm/gtc/quaternion.hpp>
+
+// STL includes
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace
+{
+	// Overlap left alone so resting boxes keep touching and their contacts stay warm
+	const float contactSlop = 0.01f;
+	// Fraction of the remaining overlap pushed out each step
+	const float baumgarte = 0.2f;
+	// Furthest a point can move between frames and still be given its old impulses
+	const float warmStartDistance = 0.05f;
+	// Batches per chunk handed to a thread
+	const unsigned int colorGrain = 16;
+
+	// Overlap the bias pushes out at baumgarte / dt. A gap comes out negative and scaled so
+	// the bias lets the bodies close it in one step but no further.
+	float penetration(float depth)
+	{
+		if(depth < 0.0f)
+		{
+			return depth / baumgarte;
+		}
+
+		return std::max(depth - contactSlop, 0.0f);
+	}
+
+	unsigned long long pairKey(unsigned int a, unsigned int b)
+	{
+		return ((unsigned long long)a << 32) | b;
+	}
+
+	// Any two unit vectors perpendicular to normal and each other, the same ones every time
+	// for the same normal so friction impulses carry over between frames
+	void tangentBasis(const glm::vec3 &normal, glm::vec3 &tangent1, glm::vec3 &tangent2)
+	{
+		if(std::fabs(normal.x) >= 0.57735f)
+		{
+			tangent1 = glm::normalize(glm::vec3(normal.y, -normal.x, 0.0f));
+		}
+		else
+		{
+			tangent1 = glm::normalize(glm::vec3(0.0f, normal.z, -normal.y));
+		}
+		tangent2 = glm::cross(normal, tangent1);
+	}
+
+	// Sleeping bodies are held as still as static ones
+	float solverInverseMass(const BodySoA &b, unsigned int body)
+	{
+		return b.awake[body] ? b.inverseMass[body] : 0.0f;
+	}
+
+	// R * diag(1 / I) * R^T for a solid box, zero for bodies nothing moves
+	glm::mat3 worldInverseInertia(const BodySoA &b, unsigned int body)
+	{
+		const float inverseMass = solverInverseMass(b, body);
+		if(inverseMass <= 0.0f)
+		{
+			return glm::mat3(0.0f);
+		}
+
+		const float xx = b.hx[body] * b.hx[body];
+		const float yy = b.hy[body] * b.hy[body];
+		const float zz = b.hz[body] * b.hz[body];
+		const glm::mat3 local(3.0f * inverseMass / (yy + zz), 0.0f, 0.0f,
+			0.0f, 3.0f * inverseMass / (xx + zz), 0.0f,
+			0.0f, 0.0f, 3.0f * inverseMass / (xx + yy));
+		const glm::mat3 rotation = glm::mat3_cast(glm::fquat(b.qw[body], b.qx[body], b.qy[body], b.qz[body]));
+
+		return rotation * local * glm::transpose(rotation);
+	}
+
+	void setDirection(SolverDirection &d, unsigned int lane, const glm::vec3 &direction, const glm::vec3 &rA, const glm::vec3 &rB,
+		const glm::mat3 &inertiaA, const glm::mat3 &inertiaB, float inverseMassA, float inverseMassB, float impulse)
+	{
+		const glm::vec3 armA = glm::cross(rA, direction);
+		const glm::vec3 armB = glm::cross(rB, direction);
+		const glm::vec3 turnA = inertiaA * armA;
+		const glm::vec3 turnB = inertiaB * armB;
+		const float k = inverseMassA + inverseMassB + glm::dot(armA, turnA) + glm::dot(armB, turnB);
+
+		d.x[lane] = direction.x;
+		d.y[lane] = direction.y;
+		d.z[lane] = direction.z;
+		d.rAx[lane] = armA.x;
+		d.rAy[lane] = armA.y;
+		d.rAz[lane] = armA.z;
+		d.rBx[lane] = armB.x;
+		d.rBy[lane] = armB.y;
+		d.rBz[lane] = armB.z;
+		d.iAx[lane] = turnA.x;
+		d.iAy[lane] = turnA.y;
+		d.iAz[lane] = turnA.z;
+		d.iBx[lane] = turnB.x;
+		d.iBy[lane] = turnB.y;
+		d.iBz[lane] = turnB.z;
+		d.mass[lane] = k > 0.0f ? 1.0f / k : 0.0f;
+		d.impulse[lane] = impulse;
+	}
+
+	void clearDirection(SolverDirection &d, unsigned int lane)
+	{
+		const glm::vec3 zero(0.0f);
+		setDirection(d, lane, zero, zero, zero, glm::mat3(0.0f), glm::mat3(0.0f), 0.0f, 0.0f, 0.0f);
+	}
+
+	// Velocities of both bodies of one lane
+	struct LaneVelocities
+	{
+		glm::vec3 vA, wA, vB, wB;
+	};
+
+	float relativeVelocity(const LaneVelocities &v, const SolverDirection &d, unsigned int l)
+	{
+		return (v.vB.x - v.vA.x) * d.x[l] + (v.vB.y - v.vA.y) * d.y[l] + (v.vB.z - v.vA.z) * d.z[l]
+			+ v.wB.x * d.rBx[l] + v.wB.y * d.rBy[l] + v.wB.z * d.rBz[l]
+			- v.wA.x * d.rAx[l] - v.wA.y * d.rAy[l] - v.wA.z * d.rAz[l];
+	}
+
+	void applyImpulse(LaneVelocities &v, const SolverDirection &d, unsigned int l, float inverseMassA, float inverseMassB, float impulse)
+	{
+		const glm::vec3 direction(d.x[l], d.y[l], d.z[l]);
+		v.vA -= direction * (inverseMassA * impulse);
+		v.wA -= glm::vec3(d.iAx[l], d.iAy[l], d.iAz[l]) * impulse;
+		v.vB += direction * (inverseMassB * impulse);
+		v.wB += glm::vec3(d.iBx[l], d.iBy[l], d.iBz[l]) * impulse;
+	}
+
+	void solveFriction(LaneVelocities &v, SolverDirection &d, unsigned int l, float inverseMassA, float inverseMassB, float limit)
+	{
+		const float old = d.impulse[l];
+		const float impulse = std::min(std::max(old - d.mass[l] * relativeVelocity(v, d, l), -limit), limit);
+		d.impulse[l] = impulse;
+		applyImpulse(v, d, l, inverseMassA, inverseMassB, impulse - old);
+	}
+
+	void solveBatchScalar(const SolverBatch &batch, SolverRow rows[], BodySoA &b, float biasFactor, float friction, bool warmStart, bool backwards)
+	{
+		for(unsigned int l = 0; l < solverLanes; ++l)
+		{
+			if(batch.manifold[l] == noSolverManifold)
+			{
+				continue;
+			}
+
+			const unsigned int a = batch.bodyA[l];
+			const unsigned int c = batch.bodyB[l];
+			const float inverseMassA = batch.inverseMassA[l];
+			const float inverseMassB = batch.inverseMassB[l];
+
+			LaneVelocities v;
+			v.vA = glm::vec3(b.vx[a], b.vy[a], b.vz[a]);
+			v.wA = glm::vec3(b.wx[a], b.wy[a], b.wz[a]);
+			v.vB = glm::vec3(b.vx[c], b.vy[c], b.vz[c]);
+			v.wB = glm::vec3(b.wx[c], b.wy[c], b.wz[c]);
+
+			for(unsigned int r = 0; r < batch.rowCount; ++r)
+			{
+				SolverRow &row = rows[backwards ? batch.rowCount - 1 - r : r];
+				if(warmStart)
+				{
+					applyImpulse(v, row.normal, l, inverseMassA, inverseMassB, row.normal.impulse[l]);
+					applyImpulse(v, row.tangent1, l, inverseMassA, inverseMassB, row.tangent1.impulse[l]);
+					applyImpulse(v, row.tangent2, l, inverseMassA, inverseMassB, row.tangent2.impulse[l]);
+					continue;
+				}
+
+				// Friction first, bounded by how hard the point pushed last iteration
+				const float limit = friction * row.normal.impulse[l];
+				solveFriction(v, row.tangent1, l, inverseMassA, inverseMassB, limit);
+				solveFriction(v, row.tangent2, l, inverseMassA, inverseMassB, limit);
+
+				SolverDirection &n = row.normal;
+				const float old = n.impulse[l];
+				const float impulse = std::max(old + n.mass[l] * (biasFactor * row.penetration[l] - relativeVelocity(v, n, l)), 0.0f);
+				n.impulse[l] = impulse;
+				applyImpulse(v, n, l, inverseMassA, inverseMassB, impulse - old);
+			}
+
+			if(inverseMassA > 0.0f)
+			{
+				b.vx[a] = v.vA.x; b.vy[a] = v.vA.y; b.vz[a] = v.vA.z;
+				b.wx[a] = v.wA.x; b.wy[a] = v.wA.y; b.wz[a] = v.wA.z;
+			}
+			if(inverseMassB > 0.0f)
+			{
+				b.vx[c] = v.vB.x; b.vy[c] = v.vB.y; b.vz[c] = v.vB.z;
+				b.wx[c] = v.wB.x; b.wy[c] = v.wB.y; b.wz[c] = v.wB.z;
+			}
+		}
+	}
+
+#if SIMD_HAS_SSE2
+	// Velocities of both bodies for four lanes
+	struct VelocitiesSSE2
+	{
+		__m128 vAx, vAy, vAz, wAx, wAy, wAz;
+		__m128 vBx, vBy, vBz, wBx, wBy, wBz;
+	};
+
+	__m128 relativeVelocitySSE2(const VelocitiesSSE2 &v, const SolverDirection &d, unsigned int o)
+	{
+		const __m128 linear = _mm_add_ps(_mm_add_ps(
+			_mm_mul_ps(_mm_sub_ps(v.vBx, v.vAx), _mm_loadu_ps(&d.x[o])),
+			_mm_mul_ps(_mm_sub_ps(v.vBy, v.vAy), _mm_loadu_ps(&d.y[o]))),
+			_mm_mul_ps(_mm_sub_ps(v.vBz, v.vAz), _mm_loadu_ps(&d.z[o])));
+		const __m128 angularB = _mm_add_ps(_mm_add_ps(
+			_mm_mul_ps(v.wBx, _mm_loadu_ps(&d.rBx[o])),
+			_mm_mul_ps(v.wBy, _mm_loadu_ps(&d.rBy[o]))),
+			_mm_mul_ps(v.wBz, _mm_loadu_ps(&d.rBz[o])));
+		const __m128 angularA = _mm_add_ps(_mm_add_ps(
+			_mm_mul_ps(v.wAx, _mm_loadu_ps(&d.rAx[o])),
+			_mm_mul_ps(v.wAy, _mm_loadu_ps(&d.rAy[o]))),
+			_mm_mul_ps(v.wAz, _mm_loadu_ps(&d.rAz[o])));
+
+		return _mm_sub_ps(_mm_add_ps(linear, angularB), angularA);
+	}
+
+	void applyImpulseSSE2(VelocitiesSSE2 &v, const SolverDirection &d, unsigned int o, __m128 inverseMassA, __m128 inverseMassB, __m128 impulse)
+	{
+		const __m128 dx = _mm_loadu_ps(&d.x[o]);
+		const __m128 dy = _mm_loadu_ps(&d.y[o]);
+		const __m128 dz = _mm_loadu_ps(&d.z[o]);
+		const __m128 linearA = _mm_mul_ps(inverseMassA, impulse);
+		const __m128 linearB = _mm_mul_ps(inverseMassB, impulse);
+
+		v.vAx = _mm_sub_ps(v.vAx, _mm_mul_ps(dx, linearA));
+		v.vAy = _mm_sub_ps(v.vAy, _mm_mul_ps(dy, linearA));
+		v.vAz = _mm_sub_ps(v.vAz, _mm_mul_ps(dz, linearA));
+		v.wAx = _mm_sub_ps(v.wAx, _mm_mul_ps(_mm_loadu_ps(&d.iAx[o]), impulse));
+		v.wAy = _mm_sub_ps(v.wAy, _mm_mul_ps(_mm_loadu_ps(&d.iAy[o]), impulse));
+		v.wAz = _mm_sub_ps(v.wAz, _mm_mul_ps(_mm_loadu_ps(&d.iAz[o]), impulse));
+		v.vBx = _mm_add_ps(v.vBx, _mm_mul_ps(dx, linearB));
+		v.vBy = _mm_add_ps(v.vBy, _mm_mul_ps(dy, linearB));
+		v.vBz = _mm_add_ps(v.vBz, _mm_mul_ps(dz, linearB));
+		v.wBx = _mm_add_ps(v.wBx, _mm_mul_ps(_mm_loadu_ps(&d.iBx[o]), impulse));
+		v.wBy = _mm_add_ps(v.wBy, _mm_mul_ps(_mm_loadu_ps(&d.iBy[o]), impulse));
+		v.wBz = _mm_add_ps(v.wBz, _mm_mul_ps(_mm_loadu_ps(&d.iBz[o]), impulse));
+	}
+
+	void solveFrictionSSE2(VelocitiesSSE2 &v, SolverDirection &d, unsigned int o, __m128 inverseMassA, __m128 inverseMassB, __m128 limit)
+	{
+		const __m128 old = _mm_loadu_ps(&d.impulse[o]);
+		const __m128 wanted = _mm_sub_ps(old, _mm_mul_ps(_mm_loadu_ps(&d.mass[o]), relativeVelocitySSE2(v, d, o)));
+		const __m128 impulse = _mm_min_ps(_mm_max_ps(wanted, _mm_sub_ps(_mm_setzero_ps(), limit)), limit);
+		_mm_storeu_ps(&d.impulse[o], impulse);
+		applyImpulseSSE2(v, d, o, inverseMassA, inverseMassB, _mm_sub_ps(impulse, old));
+	}
+
+	// Lanes are solved four at a time, bodies are gathered and scattered a lane at a time
+	void solveBatchSSE2(const SolverBatch &batch, SolverRow rows[], BodySoA &b, float biasFactor, float friction, bool warmStart, bool backwards)
+	{
+		const __m128 bias = _mm_set1_ps(biasFactor);
+		const __m128 mu = _mm_set1_ps(friction);
+
+		for(unsigned int o = 0; o < solverLanes; o += 4)
+		{
+			float gathered[12][4];
+			for(unsigned int l = 0; l < 4; ++l)
+			{
+				const unsigned int a = batch.bodyA[o + l];
+				const unsigned int c = batch.bodyB[o + l];
+				gathered[0][l] = b.vx[a]; gathered[1][l] = b.vy[a]; gathered[2][l] = b.vz[a];
+				gathered[3][l] = b.wx[a]; gathered[4][l] = b.wy[a]; gathered[5][l] = b.wz[a];
+				gathered[6][l] = b.vx[c]; gathered[7][l] = b.vy[c]; gathered[8][l] = b.vz[c];
+				gathered[9][l] = b.wx[c]; gathered[10][l] = b.wy[c]; gathered[11][l] = b.wz[c];
+			}
+
+			VelocitiesSSE2 v;
+			v.vAx = _mm_loadu_ps(gathered[0]); v.vAy = _mm_loadu_ps(gathered[1]); v.vAz = _mm_loadu_ps(gathered[2]);
+			v.wAx = _mm_loadu_ps(gathered[3]); v.wAy = _mm_loadu_ps(gathered[4]); v.wAz = _mm_loadu_ps(gathered[5]);
+			v.vBx = _mm_loadu_ps(gathered[6]); v.vBy = _mm_loadu_ps(gathered[7]); v.vBz = _mm_loadu_ps(gathered[8]);
+			v.wBx = _mm_loadu_ps(gathered[9]); v.wBy = _mm_loadu_ps(gathered[10]); v.wBz = _mm_loadu_ps(gathered[11]);
+
+			const __m128 inverseMassA = _mm_loadu_ps(&batch.inverseMassA[o]);
+			const __m128 inverseMassB = _mm_loadu_ps(&batch.inverseMassB[o]);
+
+			for(unsigned int r = 0; r < batch.rowCount; ++r)
+			{
+				SolverRow &row = rows[backwards ? batch.rowCount - 1 - r : r];
+				if(warmStart)
+				{
+					applyImpulseSSE2(v, row.normal, o, inverseMassA, inverseMassB, _mm_loadu_ps(&row.normal.impulse[o]));
+					applyImpulseSSE2(v, row.tangent1, o, inverseMassA, inverseMassB, _mm_loadu_ps(&row.tangent1.impulse[o]));
+					applyImpulseSSE2(v, row.tangent2, o, inverseMassA, inverseMassB, _mm_loadu_ps(&row.tangent2.impulse[o]));
+					continue;
+				}
+
+				const __m128 limit = _mm_mul_ps(mu, _mm_loadu_ps(&row.normal.impulse[o]));
+				solveFrictionSSE2(v, row.tangent1, o, inverseMassA, inverseMassB, limit);
+				solveFrictionSSE2(v, row.tangent2, o, inverseMassA, inverseMassB, limit);
+
+				SolverDirection &n = row.normal;
+				const __m128 old = _mm_loadu_ps(&n.impulse[o]);
+				const __m128 push = _mm_sub_ps(_mm_mul_ps(bias, _mm_loadu_ps(&row.penetration[o])), relativeVelocitySSE2(v, n, o));
+				const __m128 impulse = _mm_max_ps(_mm_add_ps(old, _mm_mul_ps(_mm_loadu_ps(&n.mass[o]), push)), _mm_setzero_ps());
+				_mm_storeu_ps(&n.impulse[o], impulse);
+				applyImpulseSSE2(v, n, o, inverseMassA, inverseMassB, _mm_sub_ps(impulse, old));
+			}
+
+			_mm_storeu_ps(gathered[0], v.vAx); _mm_storeu_ps(gathered[1], v.vAy); _mm_storeu_ps(gathered[2], v.vAz);
+			_mm_storeu_ps(gathered[3], v.wAx); _mm_storeu_ps(gathered[4], v.wAy); _mm_storeu_ps(gathered[5], v.wAz);
+			_mm_storeu_ps(gathered[6], v.vBx); _mm_storeu_ps(gathered[7], v.vBy); _mm_storeu_ps(gathered[8], v.vBz);
+			_mm_storeu_ps(gathered[9], v.wBx); _mm_storeu_ps(gathered[10], v.wBy); _mm_storeu_ps(gathered[11], v.wBz);
+
+			// Static and kinematic bodies can be in several lanes at once, they are only read
+			for(unsigned int l = 0; l < 4; ++l)
+			{
+				if(batch.inverseMassA[o + l] > 0.0f)
+				{
+					const unsigned int a = batch.bodyA[o + l];
+					b.vx[a] = gathered[0][l]; b.vy[a] = gathered[1][l]; b.vz[a] = gathered[2][l];
+					b.wx[a] = gathered[3][l]; b.wy[a] = gathered[4][l]; b.wz[a] = gathered[5][l];
+				}
+				if(batch.inverseMassB[o + l] > 0.0f)
+				{
+					const unsigned int c = batch.bodyB[o + l];
+					b.vx[c] = gathered[6][l]; b.vy[c] = gathered[7][l]; b.vz[c] = gathered[8][l];
+					b.wx[c] = gathered[9][l]; b.wy[c] = gathered[10][l]; b.wz[c] = gathered[11][l];
+				}
+			}
+		}
+	}
+
+	// Same again eight lanes wide, the gathers are done by the CPU
+	struct VelocitiesAVX2
+	{
+		__m256 vAx, vAy, vAz, wAx, wAy, wAz;
+		__m256 vBx, vBy, vBz, wBx, wBy, wBz;
+	};
+
+	SIMD_TARGET_AVX2 __m256 relativeVelocityAVX2(const VelocitiesAVX2 &v, const SolverDirection &d)
+	{
+		const __m256 linear = _mm256_add_ps(_mm256_add_ps(
+			_mm256_mul_ps(_mm256_sub_ps(v.vBx, v.vAx), _mm256_loadu_ps(d.x)),
+			_mm256_mul_ps(_mm256_sub_ps(v.vBy, v.vAy), _mm256_loadu_ps(d.y))),
+			_mm256_mul_ps(_mm256_sub_ps(v.vBz, v.vAz), _mm256_loadu_ps(d.z)));
+		const __m256 angularB = _mm256_add_ps(_mm256_add_ps(
+			_mm256_mul_ps(v.wBx, _mm256_loadu_ps(d.rBx)),
+			_mm256_mul_ps(v.wBy, _mm256_loadu_ps(d.rBy))),
+			_mm256_mul_ps(v.wBz, _mm256_loadu_ps(d.rBz)));
+		const __m256 angularA = _mm256_add_ps(_mm256_add_ps(
+			_mm256_mul_ps(v.wAx, _mm256_loadu_ps(d.rAx)),
+			_mm256_mul_ps(v.wAy, _mm256_loadu_ps(d.rAy))),
+			_mm256_mul_ps(v.wAz, _mm256_loadu_ps(d.rAz)));
+
+		return _mm256_sub_ps(_mm256_add_ps(linear, angularB), angularA);
+	}
+
+	SIMD_TARGET_AVX2 void applyImpulseAVX2(VelocitiesAVX2 &v, const SolverDirection &d, __m256 inverseMassA, __m256 inverseMassB, __m256 impulse)
+	{
+		const __m256 dx = _mm256_loadu_ps(d.x);
+		const __m256 dy = _mm256_loadu_ps(d.y);
+		const __m256 dz = _mm256_loadu_ps(d.z);
+		const __m256 linearA = _mm256_mul_ps(inverseMassA, impulse);
+		const __m256 linearB = _mm256_mul_ps(inverseMassB, impulse);
+
+		v.vAx = _mm256_sub_ps(v.vAx, _mm256_mul_ps(dx, linearA));
+		v.vAy = _mm256_sub_ps(v.vAy, _mm256_mul_ps(dy, linearA));
+		v.vAz = _mm256_sub_ps(v.vAz, _mm256_mul_ps(dz, linearA));
+		v.wAx = _mm256_sub_ps(v.wAx, _mm256_mul_ps(_mm256_loadu_ps(d.iAx), impulse));
+		v.wAy = _mm256_sub_ps(v.wAy, _mm256_mul_ps(_mm256_loadu_ps(d.iAy), impulse));
+		v.wAz = _mm256_sub_ps(v.wAz, _mm256_mul_ps(_mm256_loadu_ps(d.iAz), impulse));
+		v.vBx = _mm256_add_ps(v.vBx, _mm256_mul_ps(dx, linearB));
+		v.vBy = _mm256_add_ps(v.vBy, _mm256_mul_ps(dy, linearB));
+		v.vBz = _mm256_add_ps(v.vBz, _mm256_mul_ps(dz, linearB));
+		v.wBx = _mm256_add_ps(v.wBx, _mm256_mul_ps(_mm256_loadu_ps(d.iBx), impulse));
+		v.wBy = _mm256_add_ps(v.wBy, _mm256_mul_ps(_mm256_loadu_ps(d.iBy), impulse));
+		v.wBz = _mm256_add_ps(v.wBz, _mm256_mul_ps(_mm256_loadu_ps(d.iBz), impulse));
+	}
+
+	SIMD_TARGET_AVX2 void solveFrictionAVX2(VelocitiesAVX2 &v, SolverDirection &d, __m256 inverseMassA, __m256 inverseMassB, __m256 limit)
+	{
+		const __m256 old = _mm256_loadu_ps(d.impulse);
+		const __m256 wanted = _mm256_sub_ps(old, _mm256_mul_ps(_mm256_loadu_ps(d.mass), relativeVelocityAVX2(v, d)));
+		const __m256 impulse = _mm256_min_ps(_mm256_max_ps(wanted, _mm256_sub_ps(_mm256_setzero_ps(), limit)), limit);
+		_mm256_storeu_ps(d.impulse, impulse);
+		applyImpulseAVX2(v, d, inverseMassA, inverseMassB, _mm256_sub_ps(impulse, old));
+	}
+
+	SIMD_TARGET_AVX2 void solveBatchAVX2(const SolverBatch &batch, SolverRow rows[], BodySoA &b, float biasFactor, float friction, bool warmStart, bool backwards)
+	{
+		const __m256 bias = _mm256_set1_ps(biasFactor);
+		const __m256 mu = _mm256_set1_ps(friction);
+		const __m256i a = _mm256_loadu_si256((const __m256i *)batch.bodyA);
+		const __m256i c = _mm256_loadu_si256((const __m256i *)batch.bodyB);
+
+		VelocitiesAVX2 v;
+		v.vAx = _mm256_i32gather_ps(&b.vx[0], a, 4); v.vAy = _mm256_i32gather_ps(&b.vy[0], a, 4); v.vAz = _mm256_i32gather_ps(&b.vz[0], a, 4);
+		v.wAx = _mm256_i32gather_ps(&b.wx[0], a, 4); v.wAy = _mm256_i32gather_ps(&b.wy[0], a, 4); v.wAz = _mm256_i32gather_ps(&b.wz[0], a, 4);
+		v.vBx = _mm256_i32gather_ps(&b.vx[0], c, 4); v.vBy = _mm256_i32gather_ps(&b.vy[0], c, 4); v.vBz = _mm256_i32gather_ps(&b.vz[0], c, 4);
+		v.wBx = _mm256_i32gather_ps(&b.wx[0], c, 4); v.wBy = _mm256_i32gather_ps(&b.wy[0], c, 4); v.wBz = _mm256_i32gather_ps(&b.wz[0], c, 4);
+
+		const __m256 inverseMassA = _mm256_loadu_ps(batch.inverseMassA);
+		const __m256 inverseMassB = _mm256_loadu_ps(batch.inverseMassB);
+
+		for(unsigned int r = 0; r < batch.rowCount; ++r)
+		{
+			SolverRow &row = rows[backwards ? batch.rowCount - 1 - r : r];
+			if(warmStart)
+			{
+				applyImpulseAVX2(v, row.normal, inverseMassA, inverseMassB, _mm256_loadu_ps(row.normal.impulse));
+				applyImpulseAVX2(v, row.tangent1, inverseMassA, inverseMassB, _mm256_loadu_ps(row.tangent1.impulse));
+				applyImpulseAVX2(v, row.tangent2, inverseMassA, inverseMassB, _mm256_loadu_ps(row.tangent2.impulse));
+				continue;
+			}
+
+			const __m256 limit = _mm256_mul_ps(mu, _mm256_loadu_ps(row.normal.impulse));
+			solveFrictionAVX2(v, row.tangent1, inverseMassA, inverseMassB, limit);
+			solveFrictionAVX2(v, row.tangent2, inverseMassA, inverseMassB, limit);
+
+			SolverDirection &n = row.normal;
+			const __m256 old = _mm256_loadu_ps(n.impulse);
+			const __m256 push = _mm256_sub_ps(_mm256_mul_ps(bias, _mm256_loadu_ps(row.penetration)), relativeVelocityAVX2(v, n));
+			const __m256 impulse = _mm256_max_ps(_mm256_add_ps(old, _mm256_mul_ps(_mm256_loadu_ps(n.mass), push)), _mm256_setzero_ps());
+			_mm256_storeu_ps(n.impulse, impulse);
+			applyImpulseAVX2(v, n, inverseMassA, inverseMassB, _mm256_sub_ps(impulse, old));
+		}
+
+		float scattered[12][solverLanes];
+		_mm256_storeu_ps(scattered[0], v.vAx); _mm256_storeu_ps(scattered[1], v.vAy); _mm256_storeu_ps(scattered[2], v.vAz);
+		_mm256_storeu_ps(scattered[3], v.wAx); _mm256_storeu_ps(scattered[4], v.wAy); _mm256_storeu_ps(scattered[5], v.wAz);
+		_mm256_storeu_ps(scattered[6], v.vBx); _mm256_storeu_ps(scattered[7], v.vBy); _mm256_storeu_ps(scattered[8], v.vBz);
+		_mm256_storeu_ps(scattered[9], v.wBx); _mm256_storeu_ps(scattered[10], v.wBy); _mm256_storeu_ps(scattered[11], v.wBz);
+
+		for(unsigned int l = 0; l < solverLanes; ++l)
+		{
+			if(batch.inverseMassA[l] > 0.0f)
+			{
+				const unsigned int body = batch.bodyA[l];
+				b.vx[body] = scattered[0][l]; b.vy[body] = scattered[1][l]; b.vz[body] = scattered[2][l];
+				b.wx[body] = scattered[3][l]; b.wy[body] = scattered[4][l]; b.wz[body] = scattered[5][l];
+			}
+			if(batch.inverseMassB[l] > 0.0f)
+			{
+				const unsigned int body = batch.bodyB[l];
+				b.vx[body] = scattered[6][l]; b.vy[body] = scattered[7][l]; b.vz[body] = scattered[8][l];
+				b.wx[body] = scattered[9][l]; b.wy[body] = scattered[10][l]; b.wz[body] = scattered[11][l];
+			}
+		}
+	}
+#endif
+}
+
+ContactSolver::ContactSolver(ThreadPool *pool): m_pool(pool)
+, m_iterations(10)
+, m_friction(0.5f)
+, m_warmStarting(true)
+, m_simdLevel(::getSimdLevel())
+{
+}
+
+void ContactSolver::setSimdLevel(SimdLevel level)
+{
+	m_simdLevel = level > ::getSimdLevel() ? ::getSimdLevel() : level;
+}
+
+void ContactSolver::setContacts(const BodySoA &bodies, const ContactManifold manifolds[], unsigned int count)
+{
+	PROFILE_ZONE("Solver setup");
+
+	saveImpulses();
+
+	m_manifolds.assign(manifolds, manifolds + count);
+	m_stats = SolverStats();
+	m_stats.manifolds = count;
+
+	colorManifolds(bodies);
+
+	const unsigned int batchCount = (unsigned int)m_batches.size();
+	if(m_pool)
+	{
+		m_pool->parallelFor(batchCount, colorGrain, [this, &bodies](unsigned int begin, unsigned int end)
+		{
+			PROFILE_ZONE("Solver setup chunk");
+			for(unsigned int i = begin; i < end; ++i)
+			{
+				prepareBatch(bodies, i);
+			}
+		});
+	}
+	else
+	{
+		for(unsigned int i = 0; i < batchCount; ++i)
+		{
+			prepareBatch(bodies, i);
+		}
+	}
+
+	// Counted afterwards so the batches can be prepared without sharing anything
+	for(unsigned int i = 0; i < batchCount; ++i)
+	{
+		const SolverBatch &batch = m_batches[i];
+		for(unsigned int l = 0; l < solverLanes; ++l)
+		{
+			if(batch.manifold[l] == noSolverManifold)
+			{
+				continue;
+			}
+
+			const unsigned int pointCount = m_manifolds[batch.manifold[l]].pointCount;
+			for(unsigned int k = 0; k < pointCount; ++k)
+			{
+				m_stats.warmStarted += m_rows[batch.firstRow + k].normal.impulse[l] > 0.0f ? 1 : 0;
+			}
+			m_stats.points += pointCount;
+			++m_stats.lanesUsed;
+		}
+	}
+}
+
+void ContactSolver::saveImpulses()
+{
+	m_warmStarts.clear();
+
+	for(unsigned int i = 0; i < m_batches.size(); ++i)
+	{
+		const SolverBatch &batch = m_batches[i];
+		for(unsigned int l = 0; l < solverLanes; ++l)
+		{
+			if(batch.manifold[l] == noSolverManifold)
+			{
+				continue;
+			}
+
+			const ContactManifold &manifold = m_manifolds[batch.manifold[l]];
+			WarmStart saved;
+			saved.key = pairKey(manifold.a, manifold.b);
+			saved.pointCount = manifold.pointCount;
+			for(unsigned int k = 0; k < manifold.pointCount; ++k)
+			{
+				const SolverRow &row = m_rows[batch.firstRow + k];
+				saved.points[k] = manifold.points[k];
+				saved.normal[k] = row.normal.impulse[l];
+				saved.tangent1[k] = row.tangent1.impulse[l];
+				saved.tangent2[k] = row.tangent2.impulse[l];
+			}
+			m_warmStarts.push_back(saved);
+		}
+	}
+
+	std::sort(m_warmStarts.begin(), m_warmStarts.end());
+}
+
+void ContactSolver::colorManifolds(const BodySoA &bodies)
+{
+	// Greedy coloring, each manifold takes the lowest color neither of its moving bodies
+	// is in yet. Bodies that do not move can be in every manifold of a color.
+	const unsigned int count = (unsigned int)m_manifolds.size();
+	m_bodyColors.assign(bodies.size(), 0);
+	m_manifoldColors.resize(count);
+	m_colorCounts.assign(maxSolverColors + 1, 0);
+
+	for(unsigned int i = 0; i < count; ++i)
+	{
+		const unsigned int a = m_manifolds[i].a;
+		const unsigned int b = m_manifolds[i].b;
+		const bool movesA = solverInverseMass(bodies, a) > 0.0f;
+		const bool movesB = solverInverseMass(bodies, b) > 0.0f;
+		const unsigned int used = (movesA ? m_bodyColors[a] : 0) | (movesB ? m_bodyColors[b] : 0);
+
+		unsigned int color = maxSolverColors;
+		if(used != 0xffffffff)
+		{
+			color = countTrailingZeros(~used);
+			m_bodyColors[a] |= movesA ? 1u << color : 0;
+			m_bodyColors[b] |= movesB ? 1u << color : 0;
+		}
+		m_manifoldColors[i] = color;
+		++m_colorCounts[color];
+	}
+
+	// Colors are cut into batches of solverLanes, the uncolored get a batch each
+	m_colorStarts.resize(maxSolverColors + 2);
+	unsigned int batchCount = 0;
+	for(unsigned int c = 0; c <= maxSolverColors; ++c)
+	{
+		m_colorStarts[c] = batchCount;
+		batchCount += c == maxSolverColors ? m_colorCounts[c] : (m_colorCounts[c] + solverLanes - 1) / solverLanes;
+		m_stats.colors += c < maxSolverColors && m_colorCounts[c] > 0 ? 1 : 0;
+	}
+	m_colorStarts[maxSolverColors + 1] = batchCount;
+	m_stats.batches = batchCount;
+	m_stats.serialManifolds = m_colorCounts[maxSolverColors];
+
+	SolverBatch empty;
+	for(unsigned int l = 0; l < solverLanes; ++l)
+	{
+		empty.bodyA[l] = 0;
+		empty.bodyB[l] = 0;
+		empty.inverseMassA[l] = 0.0f;
+		empty.inverseMassB[l] = 0.0f;
+		empty.manifold[l] = noSolverManifold;
+	}
+	empty.firstRow = 0;
+	empty.rowCount = 0;
+	m_batches.assign(batchCount, empty);
+
+	// m_colorCounts becomes the number placed so far
+	std::fill(m_colorCounts.begin(), m_colorCounts.end(), 0);
+	for(unsigned int i = 0; i < count; ++i)
+	{
+		const unsigned int color = m_manifoldColors[i];
+		const unsigned int placed = m_colorCounts[color]++;
+		const unsigned int lanes = color == maxSolverColors ? 1 : solverLanes;
+		SolverBatch &batch = m_batches[m_colorStarts[color] + placed / lanes];
+		const unsigned int l = placed % lanes;
+
+		const ContactManifold &manifold = m_manifolds[i];
+		batch.bodyA[l] = manifold.a;
+		batch.bodyB[l] = manifold.b;
+		batch.inverseMassA[l] = solverInverseMass(bodies, manifold.a);
+		batch.inverseMassB[l] = solverInverseMass(bodies, manifold.b);
+		batch.manifold[l] = i;
+		batch.rowCount = std::max(batch.rowCount, manifold.pointCount);
+	}
+
+	unsigned int rowCount = 0;
+	for(unsigned int i = 0; i < batchCount; ++i)
+	{
+		m_batches[i].firstRow = rowCount;
+		rowCount += m_batches[i].rowCount;
+	}
+	m_rows.resize(rowCount);
+}
+
+void ContactSolver::prepareBatch(const BodySoA &bodies, unsigned int batchIndex)
+{
+	const SolverBatch &batch = m_batches[batchIndex];
+	if(batch.rowCount == 0)
+	{
+		return;
+	}
+	SolverRow *rows = &m_rows[batch.firstRow];
+
+	for(unsigned int l = 0; l < solverLanes; ++l)
+	{
+		const unsigned int pointCount = batch.manifold[l] == noSolverManifold ? 0 : m_manifolds[batch.manifold[l]].pointCount;
+		for(unsigned int k = pointCount; k < batch.rowCount; ++k)
+		{
+			clearDirection(rows[k].normal, l);
+			clearDirection(rows[k].tangent1, l);
+			clearDirection(rows[k].tangent2, l);
+			rows[k].penetration[l] = 0.0f;
+		}
+
+		if(pointCount == 0)
+		{
+			continue;
+		}
+
+		const ContactManifold &manifold = m_manifolds[batch.manifold[l]];
+		const unsigned int a = manifold.a;
+		const unsigned int b = manifold.b;
+		const glm::vec3 centerA(bodies.px[a], bodies.py[a], bodies.pz[a]);
+		const glm::vec3 centerB(bodies.px[b], bodies.py[b], bodies.pz[b]);
+		const glm::mat3 inertiaA = worldInverseInertia(bodies, a);
+		const glm::mat3 inertiaB = worldInverseInertia(bodies, b);
+		const float inverseMassA = batch.inverseMassA[l];
+		const float inverseMassB = batch.inverseMassB[l];
+
+		glm::vec3 tangent1, tangent2;
+		tangentBasis(manifold.normal, tangent1, tangent2);
+
+		// Last step's impulses for this pair, if it had any
+		const WarmStart *previous = 0;
+		if(m_warmStarting)
+		{
+			WarmStart probe;
+			probe.key = pairKey(a, b);
+			std::vector<WarmStart>::const_iterator found = std::lower_bound(m_warmStarts.begin(), m_warmStarts.end(), probe);
+			previous = found != m_warmStarts.end() && found->key == probe.key ? &*found : 0;
+		}
+
+		for(unsigned int k = 0; k < pointCount; ++k)
+		{
+			const glm::vec3 &point = manifold.points[k];
+
+			float normalImpulse = 0.0f, tangent1Impulse = 0.0f, tangent2Impulse = 0.0f;
+			float closest = warmStartDistance * warmStartDistance;
+			for(unsigned int j = 0; previous && j < previous->pointCount; ++j)
+			{
+				const glm::vec3 offset = previous->points[j] - point;
+				const float distanceSquared = glm::dot(offset, offset);
+				if(distanceSquared < closest)
+				{
+					closest = distanceSquared;
+					normalImpulse = previous->normal[j];
+					tangent1Impulse = previous->tangent1[j];
+					tangent2Impulse = previous->tangent2[j];
+				}
+			}
+
+			const glm::vec3 rA = point - centerA;
+			const glm::vec3 rB = point - centerB;
+			setDirection(rows[k].normal, l, manifold.normal, rA, rB, inertiaA, inertiaB, inverseMassA, inverseMassB, normalImpulse);
+			setDirection(rows[k].tangent1, l, tangent1, rA, rB, inertiaA, inertiaB, inverseMassA, inverseMassB, tangent1Impulse);
+			setDirection(rows[k].tangent2, l, tangent2, rA, rB, inertiaA, inertiaB, inverseMassA, inverseMassB, tangent2Impulse);
+			rows[k].penetration[l] = penetration(manifold.depths[k]);
+		}
+	}
+}
+
+void ContactSolver::solve(BodySoA &bodies, float dt)
+{
+	PROFILE_ZONE("Solve");
+
+	if(m_batches.empty() || dt <= 0.0f)
+	{
+		return;
+	}
+
+	// Last step's impulses go back in for every contact before any are solved, the
+	// iterations then only have to correct them
+	const float biasFactor = baumgarte / dt;
+	if(m_warmStarting)
+	{
+		for(unsigned int c = 0; c <= maxSolverColors; ++c)
+		{
+			solveColor(bodies, c, biasFactor, true, false);
+		}
+	}
+	else
+	{
+		for(unsigned int i = 0; i < m_rows.size(); ++i)
+		{
+			std::memset(m_rows[i].normal.impulse, 0, sizeof(m_rows[i].normal.impulse));
+			std::memset(m_rows[i].tangent1.impulse, 0, sizeof(m_rows[i].tangent1.impulse));
+			std::memset(m_rows[i].tangent2.impulse, 0, sizeof(m_rows[i].tangent2.impulse));
+		}
+	}
+
+	// Every other iteration takes a manifold's points last to first. Always solving the
+	// same corner first leaves a slight twist in each manifold that rocks tall stacks.
+	for(unsigned int iteration = 0; iteration < m_iterations; ++iteration)
+	{
+		for(unsigned int c = 0; c <= maxSolverColors; ++c)
+		{
+			solveColor(bodies, c, biasFactor, false, (iteration & 1) != 0);
+		}
+	}
+}
+
+void ContactSolver::solveColor(BodySoA &bodies, unsigned int color, float biasFactor, bool warmStart, bool backwards)
+{
+	const unsigned int begin = m_colorStarts[color];
+	const unsigned int end = m_colorStarts[color + 1];
+	if(begin == end)
+	{
+		return;
+	}
+
+	if(m_pool && color < maxSolverColors)
+	{
+		m_pool->parallelFor(end - begin, colorGrain, [this, &bodies, begin, biasFactor, warmStart, backwards](unsigned int first, unsigned int last)
+		{
+			PROFILE_ZONE("Solve chunk");
+			for(unsigned int i = first; i < last; ++i)
+			{
+				solveBatch(bodies, begin + i, biasFactor, warmStart, backwards);
+			}
+		});
+	}
+	else
+	{
+		for(unsigned int i = begin; i < end; ++i)
+		{
+			solveBatch(bodies, i, biasFactor, warmStart, backwards);
+		}
+	}
+}
+
+void ContactSolver::solveBatch(BodySoA &bodies, unsigned int batchIndex, float biasFactor, bool warmStart, bool backwards)
+{
+	const SolverBatch &batch = m_batches[batchIndex];
+	if(batch.rowCount == 0)
+	{
+		return;
+	}
+	SolverRow *rows = &m_rows[batch.firstRow];
+
+#if SIMD_HAS_SSE2
+	if(m_simdLevel == SimdAVX2)
+	{
+		solveBatchAVX2(batch, rows, bodies, biasFactor, m_friction, warmStart, backwards);
+		return;
+	}
+	if(m_simdLevel == SimdSSE2)
+	{
+		solveBatchSSE2(batch, rows, bodies, biasFactor, m_friction, warmStart, backwards);
+		return;
+	}
+#endif
+
+	solveBatchScalar(batch, rows, bodies, biasFactor, m_friction, warmStart, backwards);
+}
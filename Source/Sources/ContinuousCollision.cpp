@@ -0,0 +1,232 @@
+/*
+	Name:			ContinuousCollision.cpp
+	Project:		OpenGL
+	Description:	Swept boxes and time of impact sub-stepping for bodies fast enough to pass through others in a step
+	Doc Version:	1.0
+	Author:			Jonathan Simon Jones
+	Date(D/M/Y):	16-10-2026
+	To do:
+*/
+
+#include "ContinuousCollision.h"
+#include "Narrowphase.h"
+#include "Profiler.h"
+
+// Math includes
+#include <glm/gtc/quaternion.hpp>
+
+// STL includes
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+	float smallestHalfWidth(const BodySoA &bodies, unsigned int body)
+	{
+		return std::min(bodies.hx[body], std::min(bodies.hy[body], bodies.hz[body]));
+	}
+
+	OrientedBox getBodyBox(const BodySoA &bodies, unsigned int body, const glm::vec3 &center)
+	{
+		const glm::mat3 rotation = glm::mat3_cast(glm::fquat(bodies.qw[body], bodies.qx[body], bodies.qy[body], bodies.qz[body]));
+
+		OrientedBox box;
+		box.center = center;
+		box.axes[0] = rotation[0];
+		box.axes[1] = rotation[1];
+		box.axes[2] = rotation[2];
+		box.halfExtents = glm::vec3(bodies.hx[body], bodies.hy[body], bodies.hz[body]);
+		return box;
+	}
+
+	AABB getBoxAABB(const OrientedBox &box)
+	{
+		AABB aabb;
+		aabb.center_position = box.center;
+		aabb.radius = glm::abs(box.axes[0]) * box.halfExtents.x
+			+ glm::abs(box.axes[1]) * box.halfExtents.y
+			+ glm::abs(box.axes[2]) * box.halfExtents.z;
+		return aabb;
+	}
+}
+
+bool isFastBody(const BodySoA &bodies, unsigned int body, float dt)
+{
+	if(!bodies.awake[body])
+	{
+		return false;
+	}
+
+	const glm::vec3 velocity(bodies.vx[body], bodies.vy[body], bodies.vz[body]);
+	const float limit = ccdMotionThreshold * smallestHalfWidth(bodies, body);
+	return glm::dot(velocity, velocity) * dt * dt > limit * limit;
+}
+
+AABB sweepBodyAABB(const BodySoA &bodies, unsigned int body, float time)
+{
+	// No turn takes a corner further from the centre than the half widths' length
+	const glm::vec3 halfExtents(bodies.hx[body], bodies.hy[body], bodies.hz[body]);
+	const glm::vec3 motion = glm::vec3(bodies.vx[body], bodies.vy[body], bodies.vz[body]) * time;
+
+	AABB box;
+	box.center_position = glm::vec3(bodies.px[body], bodies.py[body], bodies.pz[body]) + motion * 0.5f;
+	box.radius = glm::vec3(glm::length(halfExtents)) + glm::abs(motion) * 0.5f;
+	return box;
+}
+
+ContinuousCollision::ContinuousCollision(): m_step(0)
+, m_enabled(true)
+{
+}
+
+void ContinuousCollision::setPairs(const BodySoA &bodies, const BroadphasePair pairs[], unsigned int count, float dt)
+{
+	m_pairs.clear();
+	m_stats = CcdStats();
+	if(!m_enabled)
+	{
+		return;
+	}
+
+	for(unsigned int i = 0; i < count; ++i)
+	{
+		if(isFastBody(bodies, pairs[i].a, dt) || isFastBody(bodies, pairs[i].b, dt))
+		{
+			m_pairs.push_back(pairs[i]);
+		}
+	}
+	m_stats.pairs = (unsigned int)m_pairs.size();
+}
+
+void ContinuousCollision::resolve(BodySoA &bodies, float dt)
+{
+	if(m_pairs.empty())
+	{
+		return;
+	}
+
+	PROFILE_ZONE("Continuous collision");
+
+	// Counting steps means the marks never have to be cleared
+	++m_step;
+	if(m_stepsResolved.size() < bodies.size())
+	{
+		m_stepsResolved.resize(bodies.size(), 0);
+	}
+
+	for(unsigned int i = 0; i < m_pairs.size(); ++i)
+	{
+		const unsigned int a = m_pairs[i].a;
+		const unsigned int b = m_pairs[i].b;
+
+		// A body an impact has moved no longer started where its velocity says it did
+		if(m_stepsResolved[a] == m_step || m_stepsResolved[b] == m_step)
+		{
+			continue;
+		}
+
+		if(resolvePair(bodies, a, b, dt))
+		{
+			++m_stats.contacts;
+		}
+	}
+}
+
+bool ContinuousCollision::resolvePair(BodySoA &bodies, unsigned int a, unsigned int b, float dt)
+{
+	// Sleeping bodies are never written, so they stop a fast body like static ones do
+	const float inverseMassA = bodies.awake[a] ? bodies.inverseMass[a] : 0.0f;
+	const float inverseMassB = bodies.awake[b] ? bodies.inverseMass[b] : 0.0f;
+	glm::vec3 velocityA(bodies.vx[a], bodies.vy[a], bodies.vz[a]);
+	glm::vec3 velocityB(bodies.vx[b], bodies.vy[b], bodies.vz[b]);
+
+	const glm::vec3 motion = (velocityA - velocityB) * dt;
+	const float closeLimit = ccdMotionThreshold * (smallestHalfWidth(bodies, a) + smallestHalfWidth(bodies, b));
+	if(glm::dot(motion, motion) <= closeLimit * closeLimit)
+	{
+		return false;
+	}
+	++m_stats.sweptPairs;
+
+	// The step moved every body by its velocity, so that far back is where it started
+	glm::vec3 positionA = glm::vec3(bodies.px[a], bodies.py[a], bodies.pz[a]) - velocityA * dt;
+	glm::vec3 positionB = glm::vec3(bodies.px[b], bodies.py[b], bodies.pz[b]) - velocityB * dt;
+	OrientedBox boxA = getBodyBox(bodies, a, positionA);
+	OrientedBox boxB = getBodyBox(bodies, b, positionB);
+
+	// Relative to b, a's box sweeps along motion and nothing can touch before its boxes do
+	float time = 0.0f;
+	if(!sweepAABBAABB(getBoxAABB(boxA), motion, getBoxAABB(boxB), time))
+	{
+		return false;
+	}
+	++m_stats.impacts;
+
+	int axis = noSeparatingAxis;
+	if(collideOBBOBB(boxA, boxB, axis, 0))
+	{
+		return false;
+	}
+
+	positionA += velocityA * (dt * time);
+	positionB += velocityB * (dt * time);
+	const float closing = glm::length(motion) * (1.0f - time);
+	const unsigned int substeps = std::min(ccdMaxSubsteps, std::max(1u, (unsigned int)std::ceil(closing / closeLimit)));
+	const float substep = dt * (1.0f - time) / substeps;
+	m_stats.substeps += substeps;
+
+	bool touched = false;
+	for(unsigned int i = 0; i < substeps; ++i)
+	{
+		boxA.center = positionA + velocityA * substep;
+		boxB.center = positionB + velocityB * substep;
+
+		// Stay at the last sub-step apart and take out the closing velocity, the rest of
+		// the step goes on with what is left of it
+		ContactManifold manifold;
+		if(collideOBBOBB(boxA, boxB, axis, &manifold))
+		{
+			const float normalVelocity = glm::dot(velocityB - velocityA, manifold.normal);
+			if(normalVelocity < 0.0f && inverseMassA + inverseMassB > 0.0f)
+			{
+				const float impulse = -normalVelocity / (inverseMassA + inverseMassB);
+				velocityA -= manifold.normal * (impulse * inverseMassA);
+				velocityB += manifold.normal * (impulse * inverseMassB);
+				touched = true;
+				continue;
+			}
+		}
+
+		positionA = boxA.center;
+		positionB = boxB.center;
+	}
+
+	if(!touched)
+	{
+		return false;
+	}
+
+	// Only the bodies written are marked, a wall many bodies hit stays where it was
+	if(inverseMassA > 0.0f)
+	{
+		m_stepsResolved[a] = m_step;
+		bodies.px[a] = positionA.x;
+		bodies.py[a] = positionA.y;
+		bodies.pz[a] = positionA.z;
+		bodies.vx[a] = velocityA.x;
+		bodies.vy[a] = velocityA.y;
+		bodies.vz[a] = velocityA.z;
+	}
+	if(inverseMassB > 0.0f)
+	{
+		m_stepsResolved[b] = m_step;
+		bodies.px[b] = positionB.x;
+		bodies.py[b] = positionB.y;
+		bodies.pz[b] = positionB.z;
+		bodies.vx[b] = velocityB.x;
+		bodies.vy[b] = velocityB.y;
+		bodies.vz[b] = velocityB.z;
+	}
+
+	return true;
+}
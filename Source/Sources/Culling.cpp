@@ -0,0 +1,427 @@
+/*
+	Name:			Culling.cpp
+	Project:		OpenGL
+	Description:	Frustum and occlusion culling of world boxes before anything is submitted to draw
+	Doc Version:	1.0
+	Author:			Jonathan Simon Jones
+	Date(D/M/Y):	16-10-2026
+	To do:
+*/
+
+#include "Culling.h"
+#include "Profiler.h"
+
+// STL includes
+#include <algorithm>
+#include <cmath>
+#include <utility>
+
+namespace
+{
+	// Scalar test of boxes [first, boxes.size()), same sums in the same order as the SIMD kernels
+	unsigned int cullScalar(const Frustum &frustum, const AABBSoA &boxes, unsigned int first, unsigned int indices[], unsigned int found)
+	{
+		const unsigned int count = boxes.size();
+		for(unsigned int i = first; i < count; ++i)
+		{
+			bool inside = true;
+			for(unsigned int p = 0; p < 6; ++p)
+			{
+				const glm::vec4 &plane = frustum.planes[p];
+				const float distance = plane.x * boxes.cx[i] + plane.y * boxes.cy[i] + plane.z * boxes.cz[i] + plane.w;
+				const float reach = std::fabs(plane.x) * boxes.rx[i] + std::fabs(plane.y) * boxes.ry[i] + std::fabs(plane.z) * boxes.rz[i];
+				inside &= distance + reach >= 0.0f;
+			}
+
+			if(inside)
+			{
+				indices[found++] = i;
+			}
+		}
+
+		return found;
+	}
+
+#if SIMD_HAS_SSE2
+	// SIMD kernels only handle whole registers, they return how many boxes they tested
+	// and add the visible ones to indices
+	unsigned int cullSSE2(const Frustum &frustum, const AABBSoA &boxes, unsigned int indices[], unsigned int &found)
+	{
+		const unsigned int count = boxes.size() & ~3u;
+		for(unsigned int i = 0; i < count; i += 4)
+		{
+			const __m128 cx = _mm_loadu_ps(&boxes.cx[i]);
+			const __m128 cy = _mm_loadu_ps(&boxes.cy[i]);
+			const __m128 cz = _mm_loadu_ps(&boxes.cz[i]);
+			const __m128 rx = _mm_loadu_ps(&boxes.rx[i]);
+			const __m128 ry = _mm_loadu_ps(&boxes.ry[i]);
+			const __m128 rz = _mm_loadu_ps(&boxes.rz[i]);
+
+			__m128 inside = _mm_castsi128_ps(_mm_set1_epi32(-1));
+			for(unsigned int p = 0; p < 6; ++p)
+			{
+				const glm::vec4 &plane = frustum.planes[p];
+				const __m128 distance = _mm_add_ps(_mm_add_ps(_mm_add_ps(
+					_mm_mul_ps(_mm_set1_ps(plane.x), cx), _mm_mul_ps(_mm_set1_ps(plane.y), cy)), _mm_mul_ps(_mm_set1_ps(plane.z), cz)), _mm_set1_ps(plane.w));
+				const __m128 reach = _mm_add_ps(_mm_add_ps(
+					_mm_mul_ps(_mm_set1_ps(std::fabs(plane.x)), rx), _mm_mul_ps(_mm_set1_ps(std::fabs(plane.y)), ry)), _mm_mul_ps(_mm_set1_ps(std::fabs(plane.z)), rz));
+				inside = _mm_and_ps(inside, _mm_cmpge_ps(_mm_add_ps(distance, reach), _mm_setzero_ps()));
+			}
+
+			unsigned int bits = (unsigned int)_mm_movemask_ps(inside);
+			while(bits)
+			{
+				indices[found++] = i + countTrailingZeros(bits);
+				bits &= bits - 1;
+			}
+		}
+
+		return count;
+	}
+
+	SIMD_TARGET_AVX2 unsigned int cullAVX2(const Frustum &frustum, const AABBSoA &boxes, unsigned int indices[], unsigned int &found)
+	{
+		const unsigned int count = boxes.size() & ~7u;
+		for(unsigned int i = 0; i < count; i += 8)
+		{
+			const __m256 cx = _mm256_loadu_ps(&boxes.cx[i]);
+			const __m256 cy = _mm256_loadu_ps(&boxes.cy[i]);
+			const __m256 cz = _mm256_loadu_ps(&boxes.cz[i]);
+			const __m256 rx = _mm256_loadu_ps(&boxes.rx[i]);
+			const __m256 ry = _mm256_loadu_ps(&boxes.ry[i]);
+			const __m256 rz = _mm256_loadu_ps(&boxes.rz[i]);
+
+			__m256 inside = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+			for(unsigned int p = 0; p < 6; ++p)
+			{
+				const glm::vec4 &plane = frustum.planes[p];
+				const __m256 distance = _mm256_add_ps(_mm256_add_ps(_mm256_add_ps(
+					_mm256_mul_ps(_mm256_set1_ps(plane.x), cx), _mm256_mul_ps(_mm256_set1_ps(plane.y), cy)), _mm256_mul_ps(_mm256_set1_ps(plane.z), cz)), _mm256_set1_ps(plane.w));
+				const __m256 reach = _mm256_add_ps(_mm256_add_ps(
+					_mm256_mul_ps(_mm256_set1_ps(std::fabs(plane.x)), rx), _mm256_mul_ps(_mm256_set1_ps(std::fabs(plane.y)), ry)), _mm256_mul_ps(_mm256_set1_ps(std::fabs(plane.z)), rz));
+				inside = _mm256_and_ps(inside, _mm256_cmp_ps(_mm256_add_ps(distance, reach), _mm256_setzero_ps(), _CMP_GE_OQ));
+			}
+
+			unsigned int bits = (unsigned int)_mm256_movemask_ps(inside);
+			while(bits)
+			{
+				indices[found++] = i + countTrailingZeros(bits);
+				bits &= bits - 1;
+			}
+		}
+
+		return count;
+	}
+#endif
+
+	// Screen position in pixels and depth in [0, 1], false when p is in front of the near plane
+	bool projectToScreen(const glm::mat4 &viewProj, const glm::vec3 &p, float width, float height, glm::vec3 &screen)
+	{
+		const glm::vec4 clip = viewProj * glm::vec4(p, 1.0f);
+		if(clip.z < -clip.w || clip.w <= 0.0f)
+		{
+			return false;
+		}
+
+		const float inverseW = 1.0f / clip.w;
+		screen.x = (clip.x * inverseW * 0.5f + 0.5f) * width;
+		screen.y = (clip.y * inverseW * 0.5f + 0.5f) * height;
+		screen.z = clip.z * inverseW * 0.5f + 0.5f;
+		return true;
+	}
+
+	// Corner i of a box takes +x when bit 0 is set, +y for bit 1 and +z for bit 2.
+	// Faces go counter clockwise seen from outside.
+	const unsigned char boxFaces[24] =
+	{
+		0, 4, 6, 2,							// -x
+		1, 3, 7, 5,							// +x
+		0, 1, 5, 4,							// -y
+		2, 6, 7, 3,							// +y
+		0, 2, 3, 1,							// -z
+		4, 5, 7, 6							// +z
+	};
+}
+
+Frustum extractFrustum(const glm::mat4 &viewProj)
+{
+	// Rows of the matrix, glm stores columns
+	glm::vec4 rows[4];
+	for(unsigned int i = 0; i < 4; ++i)
+	{
+		rows[i] = glm::vec4(viewProj[0][i], viewProj[1][i], viewProj[2][i], viewProj[3][i]);
+	}
+
+	// A clip space point is inside when -w <= x, y, z <= w, each side is one plane
+	Frustum frustum;
+	frustum.planes[0] = rows[3] + rows[0];
+	frustum.planes[1] = rows[3] - rows[0];
+	frustum.planes[2] = rows[3] + rows[1];
+	frustum.planes[3] = rows[3] - rows[1];
+	frustum.planes[4] = rows[3] + rows[2];
+	frustum.planes[5] = rows[3] - rows[2];
+
+	for(unsigned int p = 0; p < 6; ++p)
+	{
+		frustum.planes[p] /= glm::length(glm::vec3(frustum.planes[p]));
+	}
+
+	return frustum;
+}
+
+bool testFrustumAABB(const Frustum &frustum, const AABB &box)
+{
+	for(unsigned int p = 0; p < 6; ++p)
+	{
+		// Signed distance of the center and how far the box reaches towards the plane
+		const glm::vec4 &plane = frustum.planes[p];
+		const float distance = plane.x * box.center_position.x + plane.y * box.center_position.y + plane.z * box.center_position.z + plane.w;
+		const float reach = std::fabs(plane.x) * box.radius.x + std::fabs(plane.y) * box.radius.y + std::fabs(plane.z) * box.radius.z;
+		if(distance + reach < 0.0f)
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+
+unsigned int cullAABBBatch(const Frustum &frustum, const AABBSoA &boxes, unsigned int indices[])
+{
+	unsigned int found = 0;
+	unsigned int done = 0;
+#if SIMD_HAS_SSE2
+	const SimdLevel level = getBatchAABBSimdLevel();
+	if(level == SimdAVX2)
+	{
+		done = cullAVX2(frustum, boxes, indices, found);
+	}
+	else if(level == SimdSSE2)
+	{
+		done = cullSSE2(frustum, boxes, indices, found);
+	}
+#endif
+
+	return cullScalar(frustum, boxes, done, indices, found);
+}
+
+OcclusionBuffer::OcclusionBuffer(unsigned int width, unsigned int height): m_depth(width * height, 1.0f)
+, m_width(width)
+, m_height(height)
+{
+}
+
+void OcclusionBuffer::clear(const glm::mat4 &viewProj)
+{
+	m_viewProj = viewProj;
+	std::fill(m_depth.begin(), m_depth.end(), 1.0f);
+}
+
+bool OcclusionBuffer::drawOccluder(const glm::vec3 &center, const glm::fquat &orientation, const glm::vec3 &halfExtents)
+{
+	const glm::mat3 rotation = glm::mat3_cast(orientation);
+
+	glm::vec3 corners[8];
+	for(unsigned int i = 0; i < 8; ++i)
+	{
+		const glm::vec3 local((i & 1) ? halfExtents.x : -halfExtents.x, (i & 2) ? halfExtents.y : -halfExtents.y, (i & 4) ? halfExtents.z : -halfExtents.z);
+
+		// Clipping is not worth it for an occluder, just leave the box out
+		if(!projectToScreen(m_viewProj, center + rotation * local, (float)m_width, (float)m_height, corners[i]))
+		{
+			return false;
+		}
+	}
+
+	for(unsigned int f = 0; f < 24; f += 4)
+	{
+		const glm::vec3 face[4] = { corners[boxFaces[f]], corners[boxFaces[f + 1]], corners[boxFaces[f + 2]], corners[boxFaces[f + 3]] };
+		drawFace(face);
+	}
+
+	return true;
+}
+
+void OcclusionBuffer::drawFace(const glm::vec3 corners[4])
+{
+	// Screen y points up like clip space, so faces turned away wind clockwise and are skipped
+	const glm::vec3 &p0 = corners[0];
+	const float area = (corners[1].x - p0.x) * (corners[2].y - p0.y) - (corners[1].y - p0.y) * (corners[2].x - p0.x);
+	if(area < 1e-6f)
+	{
+		return;
+	}
+
+	// Edge functions ex * x + ey * y + e0, positive inside. A flat face stays convex when
+	// projected so four edges bound it, with no seam along a diagonal.
+	float ex[4], ey[4], e0[4], inset[4];
+	for(unsigned int i = 0; i < 4; ++i)
+	{
+		const glm::vec3 &from = corners[i];
+		const glm::vec3 &to = corners[(i + 1) & 3];
+		ex[i] = from.y - to.y;
+		ey[i] = to.x - from.x;
+		e0[i] = from.x * to.y - from.y * to.x;
+
+		// Only pixels the face covers all of, so each edge is moved in by half a pixel
+		inset[i] = 0.5f * (std::fabs(ex[i]) + std::fabs(ey[i]));
+	}
+
+	// Depth is linear in screen space, the farthest it gets inside a pixel is stored
+	const float inverseArea = 1.0f / area;
+	const float dzdx = ((corners[1].z - p0.z) * (corners[2].y - p0.y) - (corners[2].z - p0.z) * (corners[1].y - p0.y)) * inverseArea;
+	const float dzdy = ((corners[2].z - p0.z) * (corners[1].x - p0.x) - (corners[1].z - p0.z) * (corners[2].x - p0.x)) * inverseArea;
+	const float depthSlack = 0.5f * (std::fabs(dzdx) + std::fabs(dzdy));
+
+	glm::vec3 lower = p0;
+	glm::vec3 upper = p0;
+	for(unsigned int i = 1; i < 4; ++i)
+	{
+		lower = glm::min(lower, corners[i]);
+		upper = glm::max(upper, corners[i]);
+	}
+
+	const int minX = std::max(0, (int)std::floor(lower.x));
+	const int maxX = std::min((int)m_width - 1, (int)std::ceil(upper.x));
+	const int minY = std::max(0, (int)std::floor(lower.y));
+	const int maxY = std::min((int)m_height - 1, (int)std::ceil(upper.y));
+
+	for(int y = minY; y <= maxY; ++y)
+	{
+		const float py = y + 0.5f;
+		float *row = &m_depth[y * m_width];
+		for(int x = minX; x <= maxX; ++x)
+		{
+			const float px = x + 0.5f;
+			if(ex[0] * px + ey[0] * py + e0[0] < inset[0] || ex[1] * px + ey[1] * py + e0[1] < inset[1] ||
+				ex[2] * px + ey[2] * py + e0[2] < inset[2] || ex[3] * px + ey[3] * py + e0[3] < inset[3])
+			{
+				continue;
+			}
+
+			const float depth = p0.z + dzdx * (px - p0.x) + dzdy * (py - p0.y) + depthSlack;
+			row[x] = depth < row[x] ? depth : row[x];
+		}
+	}
+}
+
+bool OcclusionBuffer::testAABB(const AABB &box) const
+{
+	glm::vec3 lower((float)m_width, (float)m_height, 1.0f);
+	glm::vec3 upper(0.0f, 0.0f, 0.0f);
+	for(unsigned int i = 0; i < 8; ++i)
+	{
+		const glm::vec3 corner = box.center_position + glm::vec3((i & 1) ? box.radius.x : -box.radius.x, (i & 2) ? box.radius.y : -box.radius.y, (i & 4) ? box.radius.z : -box.radius.z);
+
+		glm::vec3 screen;
+		if(!projectToScreen(m_viewProj, corner, (float)m_width, (float)m_height, screen))
+		{
+			// Reaches in front of the near plane, nothing can be in front of it
+			return true;
+		}
+
+		lower = glm::min(lower, screen);
+		upper = glm::max(upper, screen);
+	}
+
+	// The box's nearest point is at one of its corners
+	const int minX = std::max(0, (int)std::floor(lower.x));
+	const int maxX = std::min((int)m_width - 1, (int)std::floor(upper.x));
+	const int minY = std::max(0, (int)std::floor(lower.y));
+	const int maxY = std::min((int)m_height - 1, (int)std::floor(upper.y));
+	if(minX > maxX || minY > maxY)
+	{
+		return true;
+	}
+
+	for(int y = minY; y <= maxY; ++y)
+	{
+		const float *row = &m_depth[y * m_width];
+		for(int x = minX; x <= maxX; ++x)
+		{
+			if(row[x] >= lower.z)
+			{
+				return true;
+			}
+		}
+	}
+
+	return false;
+}
+
+SceneCuller::SceneCuller(unsigned int maxOccluders): m_frustum(extractFrustum(glm::mat4()))
+, m_maxOccluders(maxOccluders)
+, m_occlusionEnabled(true)
+{
+}
+
+const std::vector<unsigned int>& SceneCuller::cull(const glm::mat4 &viewProj, const glm::vec3 &eye, const AABBSoA &boxes, const OrientedBoxSoA &shapes)
+{
+	PROFILE_ZONE("Cull");
+
+	m_frustum = extractFrustum(viewProj);
+	m_occlusion.clear(viewProj);
+	m_stats = CullStats();
+	m_stats.tested = boxes.size();
+	m_visible.clear();
+
+	if(m_inFrustum.size() < boxes.size())
+	{
+		m_inFrustum.resize(boxes.size());
+		m_visible.reserve(boxes.size());
+	}
+	const unsigned int inFrustum = boxes.size() > 0 ? cullAABBBatch(m_frustum, boxes, &m_inFrustum[0]) : 0;
+	m_stats.frustumCulled = m_stats.tested - inFrustum;
+
+	if(!m_occlusionEnabled)
+	{
+		m_visible.assign(m_inFrustum.begin(), m_inFrustum.begin() + inFrustum);
+		m_stats.visible = inFrustum;
+		return m_visible;
+	}
+
+	// The nearest boxes hide the most, only they are drawn into the buffer
+	typedef std::pair<float, unsigned int> Distance;
+	m_scratch.reset();
+	Distance *byDistance = m_scratch.allocateArray<Distance>(inFrustum);
+	for(unsigned int i = 0; i < inFrustum; ++i)
+	{
+		const unsigned int index = m_inFrustum[i];
+		const glm::vec3 offset = glm::vec3(boxes.cx[index], boxes.cy[index], boxes.cz[index]) - eye;
+		new(&byDistance[i]) Distance(glm::dot(offset, offset), index);
+	}
+
+	const unsigned int occluders = std::min(m_maxOccluders, inFrustum);
+	std::partial_sort(byDistance, byDistance + occluders, byDistance + inFrustum);
+
+	for(unsigned int i = 0; i < occluders; ++i)
+	{
+		const unsigned int index = byDistance[i].second;
+		const glm::vec3 center(shapes.px[index], shapes.py[index], shapes.pz[index]);
+		const glm::fquat orientation(shapes.qw[index], shapes.qx[index], shapes.qy[index], shapes.qz[index]);
+		const glm::vec3 halfExtents(shapes.hx[index], shapes.hy[index], shapes.hz[index]);
+		m_stats.occluders += m_occlusion.drawOccluder(center, orientation, halfExtents) ? 1 : 0;
+		m_visible.push_back(index);
+	}
+
+	for(unsigned int i = occluders; i < inFrustum; ++i)
+	{
+		const unsigned int index = byDistance[i].second;
+		if(m_occlusion.testAABB(boxes.get(index)))
+		{
+			m_visible.push_back(index);
+		}
+		else
+		{
+			++m_stats.occluded;
+		}
+	}
+
+	m_stats.visible = (unsigned int)m_visible.size();
+	return m_visible;
+}
+
+bool SceneCuller::isVisible(const AABB &box) const
+{
+	return testFrustumAABB(m_frustum, box) && (!m_occlusionEnabled || m_occlusion.testAABB(box));
+}
@@ -0,0 +1,621 @@
+/*
+	Name:			DynamicAABBTree.cpp
+	Project:		OpenGL
+	Description:	Dynamic bounding volume hierarchy over AABB leaves
+	Doc Version:	1.0
+	Author:			Jonathan Simon Jones
+	Date(D/M/Y):	16-10-2026
+	To do:
+*/
+
+#include "DynamicAABBTree.h"
+#include "Culling.h"
+
+// STL includes
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+	// How far ahead of a moving box the fat box is stretched, in frames of displacement
+	const float displacementMultiplier = 4.0f;
+
+	float surfaceArea(const glm::vec3 &lower, const glm::vec3 &upper)
+	{
+		const glm::vec3 d = upper - lower;
+		return 2.0f * (d.x * d.y + d.y * d.z + d.z * d.x);
+	}
+
+	float unionArea(const glm::vec3 &lowerA, const glm::vec3 &upperA, const glm::vec3 &lowerB, const glm::vec3 &upperB)
+	{
+		return surfaceArea(glm::min(lowerA, lowerB), glm::max(upperA, upperB));
+	}
+
+	bool overlaps(const glm::vec3 &lowerA, const glm::vec3 &upperA, const glm::vec3 &lowerB, const glm::vec3 &upperB)
+	{
+		if(lowerA.x > upperB.x || lowerB.x > upperA.x) return false;
+		if(lowerA.y > upperB.y || lowerB.y > upperA.y) return false;
+		if(lowerA.z > upperB.z || lowerB.z > upperA.z) return false;
+
+		return true;
+	}
+
+	bool contains(const glm::vec3 &lowerA, const glm::vec3 &upperA, const glm::vec3 &lowerB, const glm::vec3 &upperB)
+	{
+		return lowerA.x <= lowerB.x && lowerA.y <= lowerB.y && lowerA.z <= lowerB.z
+			&& upperB.x <= upperA.x && upperB.y <= upperA.y && upperB.z <= upperA.z;
+	}
+
+	// Slab test, invDirection components may be infinite for axis parallel rays
+	bool rayHitsBox(const glm::vec3 &start, const glm::vec3 &invDirection, float maxT, const glm::vec3 &lower, const glm::vec3 &upper)
+	{
+		float tMin = 0.0f;
+		float tMax = maxT;
+		for(unsigned int axis = 0; axis < 3; ++axis)
+		{
+			float t1 = (lower[axis] - start[axis]) * invDirection[axis];
+			float t2 = (upper[axis] - start[axis]) * invDirection[axis];
+			if(t1 > t2)
+			{
+				std::swap(t1, t2);
+			}
+
+			// Written so a NaN from 0 * infinity leaves the interval unchanged
+			tMin = t1 > tMin ? t1 : tMin;
+			tMax = t2 < tMax ? t2 : tMax;
+			if(tMin > tMax)
+			{
+				return false;
+			}
+		}
+
+		return true;
+	}
+}
+
+DynamicAABBTree::DynamicAABBTree(float margin): m_root(nullNode)
+, m_freeList(nullNode)
+, m_leafCount(0)
+, m_rotationCount(0)
+, m_margin(margin)
+{
+}
+
+int DynamicAABBTree::allocateNode()
+{
+	int node;
+	if(m_freeList != nullNode)
+	{
+		node = m_freeList;
+		m_freeList = m_nodes[node].parent;
+	}
+	else
+	{
+		node = (int)m_nodes.size();
+		m_nodes.push_back(Node());
+	}
+
+	Node &n = m_nodes[node];
+	n.parent = nullNode;
+	n.child1 = nullNode;
+	n.child2 = nullNode;
+	n.height = 0;
+	n.userData = 0;
+	return node;
+}
+
+void DynamicAABBTree::freeNode(int node)
+{
+	m_nodes[node].parent = m_freeList;
+	m_nodes[node].height = -1;
+	m_freeList = node;
+}
+
+int DynamicAABBTree::insert(const AABB &box, unsigned int userData)
+{
+	const int leaf = allocateNode();
+	Node &node = m_nodes[leaf];
+	node.lower = box.center_position - box.radius - m_margin;
+	node.upper = box.center_position + box.radius + m_margin;
+	node.userData = userData;
+
+	insertLeaf(leaf);
+	++m_leafCount;
+	return leaf;
+}
+
+void DynamicAABBTree::remove(int proxy)
+{
+	removeLeaf(proxy);
+	freeNode(proxy);
+	--m_leafCount;
+}
+
+bool DynamicAABBTree::move(int proxy, const AABB &box, const glm::vec3 &displacement)
+{
+	const glm::vec3 lower = box.center_position - box.radius;
+	const glm::vec3 upper = box.center_position + box.radius;
+
+	Node &node = m_nodes[proxy];
+	if(contains(node.lower, node.upper, lower, upper))
+	{
+		// Still inside, unless the fat box has grown far too big for a body that slowed down
+		const glm::vec3 hugeLower = lower - 4.0f * m_margin;
+		const glm::vec3 hugeUpper = upper + 4.0f * m_margin;
+		if(contains(hugeLower, hugeUpper, node.lower, node.upper))
+		{
+			return false;
+		}
+	}
+
+	removeLeaf(proxy);
+
+	// Fatten, and stretch towards where the body is heading
+	glm::vec3 fatLower = lower - m_margin;
+	glm::vec3 fatUpper = upper + m_margin;
+	const glm::vec3 stretch = displacement * displacementMultiplier;
+	for(unsigned int axis = 0; axis < 3; ++axis)
+	{
+		if(stretch[axis] < 0.0f)
+		{
+			fatLower[axis] += stretch[axis];
+		}
+		else
+		{
+			fatUpper[axis] += stretch[axis];
+		}
+	}
+
+	m_nodes[proxy].lower = fatLower;
+	m_nodes[proxy].upper = fatUpper;
+
+	insertLeaf(proxy);
+	return true;
+}
+
+AABB DynamicAABBTree::getFatAABB(int proxy) const
+{
+	AABB box;
+	box.center_position = (m_nodes[proxy].lower + m_nodes[proxy].upper) * 0.5f;
+	box.radius = (m_nodes[proxy].upper - m_nodes[proxy].lower) * 0.5f;
+	return box;
+}
+
+int DynamicAABBTree::findBestSibling(const glm::vec3 &lower, const glm::vec3 &upper) const
+{
+	// Walk down using the surface area heuristic: stop when pairing with the
+	// current node is cheaper than descending into either child
+	int index = m_root;
+	while(!m_nodes[index].isLeaf())
+	{
+		const Node &node = m_nodes[index];
+		const float area = surfaceArea(node.lower, node.upper);
+		const float combinedArea = unionArea(node.lower, node.upper, lower, upper);
+
+		// Cost of a new parent here, and the cost every level below pays for growing this node
+		const float cost = 2.0f * combinedArea;
+		const float inheritanceCost = 2.0f * (combinedArea - area);
+
+		float childCosts[2];
+		const int children[2] = { node.child1, node.child2 };
+		for(unsigned int c = 0; c < 2; ++c)
+		{
+			const Node &child = m_nodes[children[c]];
+			const float childCombined = unionArea(child.lower, child.upper, lower, upper);
+			if(child.isLeaf())
+			{
+				childCosts[c] = childCombined + inheritanceCost;
+			}
+			else
+			{
+				childCosts[c] = (childCombined - surfaceArea(child.lower, child.upper)) + inheritanceCost;
+			}
+		}
+
+		if(cost < childCosts[0] && cost < childCosts[1])
+		{
+			break;
+		}
+
+		index = childCosts[0] < childCosts[1] ? node.child1 : node.child2;
+	}
+
+	return index;
+}
+
+void DynamicAABBTree::insertLeaf(int leaf)
+{
+	if(m_root == nullNode)
+	{
+		m_root = leaf;
+		m_nodes[leaf].parent = nullNode;
+		return;
+	}
+
+	const glm::vec3 lower = m_nodes[leaf].lower;
+	const glm::vec3 upper = m_nodes[leaf].upper;
+	const int sibling = findBestSibling(lower, upper);
+
+	// New parent takes the sibling's place
+	const int oldParent = m_nodes[sibling].parent;
+	const int newParent = allocateNode();
+	Node &parent = m_nodes[newParent];
+	parent.parent = oldParent;
+	parent.lower = glm::min(lower, m_nodes[sibling].lower);
+	parent.upper = glm::max(upper, m_nodes[sibling].upper);
+	parent.height = m_nodes[sibling].height + 1;
+	parent.child1 = sibling;
+	parent.child2 = leaf;
+
+	if(oldParent != nullNode)
+	{
+		if(m_nodes[oldParent].child1 == sibling)
+		{
+			m_nodes[oldParent].child1 = newParent;
+		}
+		else
+		{
+			m_nodes[oldParent].child2 = newParent;
+		}
+	}
+	else
+	{
+		m_root = newParent;
+	}
+
+	m_nodes[sibling].parent = newParent;
+	m_nodes[leaf].parent = newParent;
+
+	refitAncestors(m_nodes[leaf].parent);
+}
+
+void DynamicAABBTree::removeLeaf(int leaf)
+{
+	if(leaf == m_root)
+	{
+		m_root = nullNode;
+		return;
+	}
+
+	const int parent = m_nodes[leaf].parent;
+	const int grandParent = m_nodes[parent].parent;
+	const int sibling = m_nodes[parent].child1 == leaf ? m_nodes[parent].child2 : m_nodes[parent].child1;
+
+	// The sibling replaces the parent
+	if(grandParent != nullNode)
+	{
+		if(m_nodes[grandParent].child1 == parent)
+		{
+			m_nodes[grandParent].child1 = sibling;
+		}
+		else
+		{
+			m_nodes[grandParent].child2 = sibling;
+		}
+
+		m_nodes[sibling].parent = grandParent;
+		freeNode(parent);
+
+		refitAncestors(grandParent);
+	}
+	else
+	{
+		m_root = sibling;
+		m_nodes[sibling].parent = nullNode;
+		freeNode(parent);
+	}
+}
+
+void DynamicAABBTree::refitAncestors(int node)
+{
+	while(node != nullNode)
+	{
+		rotate(node);
+
+		// Children may have changed in the rotation, rebuild from whatever is there now
+		Node &n = m_nodes[node];
+		const Node &child1 = m_nodes[n.child1];
+		const Node &child2 = m_nodes[n.child2];
+		n.height = 1 + std::max(child1.height, child2.height);
+		n.lower = glm::min(child1.lower, child2.lower);
+		n.upper = glm::max(child1.upper, child2.upper);
+
+		node = n.parent;
+	}
+}
+
+void DynamicAABBTree::rotate(int a)
+{
+	// Tries swapping each child of a with a grandchild under the other child and
+	// keeps the swap that shrinks the surface area of the changed child the most
+	const Node &nodeA = m_nodes[a];
+	if(nodeA.isLeaf() || nodeA.height < 2)
+	{
+		return;
+	}
+
+	int bestChild = nullNode;
+	int bestGrandchild = nullNode;
+	float bestGain = 0.0f;
+
+	const int children[2] = { nodeA.child1, nodeA.child2 };
+	for(unsigned int c = 0; c < 2; ++c)
+	{
+		const int child = children[c];
+		const int other = children[1 - c];
+		const Node &otherNode = m_nodes[other];
+		if(otherNode.isLeaf())
+		{
+			continue;
+		}
+
+		// Swapping child with one grandchild leaves other holding child and the remaining grandchild
+		const float otherArea = surfaceArea(otherNode.lower, otherNode.upper);
+		const int grandchildren[2] = { otherNode.child1, otherNode.child2 };
+		for(unsigned int g = 0; g < 2; ++g)
+		{
+			const Node &remaining = m_nodes[grandchildren[1 - g]];
+			const float gain = otherArea - unionArea(m_nodes[child].lower, m_nodes[child].upper, remaining.lower, remaining.upper);
+			if(gain > bestGain)
+			{
+				bestGain = gain;
+				bestChild = child;
+				bestGrandchild = grandchildren[g];
+			}
+		}
+	}
+
+	if(bestChild == nullNode)
+	{
+		return;
+	}
+
+	const int other = m_nodes[a].child1 == bestChild ? m_nodes[a].child2 : m_nodes[a].child1;
+	Node &otherNode = m_nodes[other];
+
+	// Grandchild moves up under a, child moves down under other
+	if(m_nodes[a].child1 == bestChild)
+	{
+		m_nodes[a].child1 = bestGrandchild;
+	}
+	else
+	{
+		m_nodes[a].child2 = bestGrandchild;
+	}
+	m_nodes[bestGrandchild].parent = a;
+
+	if(otherNode.child1 == bestGrandchild)
+	{
+		otherNode.child1 = bestChild;
+	}
+	else
+	{
+		otherNode.child2 = bestChild;
+	}
+	m_nodes[bestChild].parent = other;
+
+	const Node &child1 = m_nodes[otherNode.child1];
+	const Node &child2 = m_nodes[otherNode.child2];
+	otherNode.lower = glm::min(child1.lower, child2.lower);
+	otherNode.upper = glm::max(child1.upper, child2.upper);
+	otherNode.height = 1 + std::max(child1.height, child2.height);
+
+	++m_rotationCount;
+}
+
+void DynamicAABBTree::query(const AABB &box, std::vector<unsigned int> &results) const
+{
+	if(m_root == nullNode)
+	{
+		return;
+	}
+
+	const glm::vec3 lower = box.center_position - box.radius;
+	const glm::vec3 upper = box.center_position + box.radius;
+
+	m_stack.clear();
+	m_stack.push_back(m_root);
+	while(!m_stack.empty())
+	{
+		const Node &node = m_nodes[m_stack.back()];
+		m_stack.pop_back();
+
+		if(!overlaps(node.lower, node.upper, lower, upper))
+		{
+			continue;
+		}
+
+		if(node.isLeaf())
+		{
+			results.push_back(node.userData);
+		}
+		else
+		{
+			m_stack.push_back(node.child1);
+			m_stack.push_back(node.child2);
+		}
+	}
+}
+
+unsigned int DynamicAABBTree::rayCast(const glm::vec3 &start, const glm::vec3 &direction, float maxT, std::vector<unsigned int> &results) const
+{
+	if(m_root == nullNode)
+	{
+		return 0;
+	}
+
+	const glm::vec3 invDirection(1.0f / direction.x, 1.0f / direction.y, 1.0f / direction.z);
+	unsigned int hits = 0;
+
+	m_stack.clear();
+	m_stack.push_back(m_root);
+	while(!m_stack.empty())
+	{
+		const Node &node = m_nodes[m_stack.back()];
+		m_stack.pop_back();
+
+		if(!rayHitsBox(start, invDirection, maxT, node.lower, node.upper))
+		{
+			continue;
+		}
+
+		if(node.isLeaf())
+		{
+			results.push_back(node.userData);
+			++hits;
+		}
+		else
+		{
+			m_stack.push_back(node.child1);
+			m_stack.push_back(node.child2);
+		}
+	}
+
+	return hits;
+}
+
+unsigned int DynamicAABBTree::queryFrustum(const Frustum &frustum, std::vector<unsigned int> &results) const
+{
+	if(m_root == nullNode)
+	{
+		return 0;
+	}
+
+	// Node and a bit per plane it still has to be tested against
+	const int allPlanes = (1 << 6) - 1;
+	std::vector<std::pair<int, int> > &work = m_pairStack;
+	work.clear();
+	work.push_back(std::make_pair(m_root, allPlanes));
+
+	unsigned int tested = 0;
+	while(!work.empty())
+	{
+		const std::pair<int, int> item = work.back();
+		work.pop_back();
+
+		const Node &node = m_nodes[item.first];
+		int planes = item.second;
+		if(planes != 0)
+		{
+			++tested;
+			const glm::vec3 center = (node.lower + node.upper) * 0.5f;
+			const glm::vec3 radius = (node.upper - node.lower) * 0.5f;
+
+			bool outside = false;
+			for(int p = 0; p < 6 && !outside; ++p)
+			{
+				if(!(planes & (1 << p)))
+				{
+					continue;
+				}
+
+				// Same sums as testFrustumAABB, and whether the near side is inside as well
+				const glm::vec4 &plane = frustum.planes[p];
+				const float distance = plane.x * center.x + plane.y * center.y + plane.z * center.z + plane.w;
+				const float reach = std::abs(plane.x) * radius.x + std::abs(plane.y) * radius.y + std::abs(plane.z) * radius.z;
+				outside = distance + reach < 0.0f;
+				if(distance - reach >= 0.0f)
+				{
+					planes &= ~(1 << p);
+				}
+			}
+
+			if(outside)
+			{
+				continue;
+			}
+		}
+
+		if(node.isLeaf())
+		{
+			results.push_back(node.userData);
+		}
+		else
+		{
+			work.push_back(std::make_pair(node.child1, planes));
+			work.push_back(std::make_pair(node.child2, planes));
+		}
+	}
+
+	return tested;
+}
+
+void DynamicAABBTree::queryAllPairs(std::vector<BroadphasePair> &pairs) const
+{
+	if(m_root == nullNode || m_nodes[m_root].isLeaf())
+	{
+		return;
+	}
+
+	// Pairs of subtrees to test, second = nullNode means pairs within the first
+	std::vector<std::pair<int, int> > &work = m_pairStack;
+	work.clear();
+	work.push_back(std::make_pair(m_root, (int)nullNode));
+
+	while(!work.empty())
+	{
+		const std::pair<int, int> item = work.back();
+		work.pop_back();
+
+		const Node &a = m_nodes[item.first];
+		if(item.second == nullNode)
+		{
+			if(!a.isLeaf())
+			{
+				work.push_back(std::make_pair(a.child1, (int)nullNode));
+				work.push_back(std::make_pair(a.child2, (int)nullNode));
+				work.push_back(std::make_pair(a.child1, a.child2));
+			}
+			continue;
+		}
+
+		const Node &b = m_nodes[item.second];
+		if(!overlaps(a.lower, a.upper, b.lower, b.upper))
+		{
+			continue;
+		}
+
+		if(a.isLeaf() && b.isLeaf())
+		{
+			BroadphasePair pair;
+			pair.a = std::min(a.userData, b.userData);
+			pair.b = std::max(a.userData, b.userData);
+			pairs.push_back(pair);
+		}
+		else if(b.isLeaf() || (!a.isLeaf() && a.height >= b.height))
+		{
+			// Split the bigger subtree
+			work.push_back(std::make_pair(a.child1, item.second));
+			work.push_back(std::make_pair(a.child2, item.second));
+		}
+		else
+		{
+			work.push_back(std::make_pair(item.first, b.child1));
+			work.push_back(std::make_pair(item.first, b.child2));
+		}
+	}
+}
+
+int DynamicAABBTree::getHeight() const
+{
+	return m_root == nullNode ? 0 : m_nodes[m_root].height;
+}
+
+float DynamicAABBTree::getAreaRatio() const
+{
+	if(m_root == nullNode)
+	{
+		return 0.0f;
+	}
+
+	float total = 0.0f;
+	for(unsigned int i = 0; i < m_nodes.size(); ++i)
+	{
+		if(m_nodes[i].height > 0)
+		{
+			total += surfaceArea(m_nodes[i].lower, m_nodes[i].upper);
+		}
+	}
+
+	return total / surfaceArea(m_nodes[m_root].lower, m_nodes[m_root].upper);
+}
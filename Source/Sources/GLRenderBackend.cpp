@@ -0,0 +1,81 @@
+/*
+	Name:			GLRenderBackend.cpp
+	Project:		OpenGL
+	Description:	Render backend that issues the queue's commands through OpenGL
+	Doc Version:	1.0
+	Author:			Jonathan Simon Jones
+	Date(D/M/Y):	16-10-2026
+	To do:
+*/
+
+#include "GLRenderBackend.h"
+#include "ShaderCache.h"
+
+GLRenderBackend::GLRenderBackend(ShaderCache &shaders): m_shaders(shaders)
+, m_model(-1)
+, m_alpha(-1)
+{
+}
+
+void GLRenderBackend::applyProgram(unsigned int program)
+{
+	glUseProgram(program);
+	m_model = m_shaders.getProgramUniformLocation(program, "model");
+	m_alpha = m_shaders.getProgramUniformLocation(program, "Alpha");
+}
+
+void GLRenderBackend::applyVertexArray(unsigned int vertexArray)
+{
+	glBindVertexArray(vertexArray);
+}
+
+void GLRenderBackend::applyBlend(bool blend)
+{
+	if(blend)
+	{
+		glEnable(GL_BLEND);
+		glBlendFunc(GL_SRC_COLOR, GL_ONE_MINUS_SRC_COLOR);
+	}
+	else
+	{
+		glDisable(GL_BLEND);
+	}
+}
+
+void GLRenderBackend::applyModel(const float model[16])
+{
+	if(m_model != -1)
+	{
+		glUniformMatrix4fv(m_model, 1, GL_FALSE, model);
+	}
+}
+
+void GLRenderBackend::applyAlpha(float alpha)
+{
+	if(m_alpha != -1)
+	{
+		glUniform1f(m_alpha, alpha);
+	}
+}
+
+void GLRenderBackend::draw(const RenderCommand &command)
+{
+	switch(command.drawType)
+	{
+	case DrawArrays:
+		glDrawArrays(command.primitive, command.first, command.count);
+		break;
+
+	case DrawElements:
+		glDrawElements(command.primitive, command.count, GL_UNSIGNED_INT, (void*)(command.first * sizeof(GLuint)));
+		break;
+
+	case DrawArraysInstanced:
+		glDrawArraysInstanced(command.primitive, command.first, command.count, command.instanceCount);
+		break;
+
+	case DrawElementsInstanced:
+		glDrawElementsInstanced(command.primitive, command.count, GL_UNSIGNED_INT, (void*)(command.first * sizeof(GLuint)), command.instanceCount);
+		break;
+	}
+}
@@ -0,0 +1,145 @@
+/*
+	Name:			GpuBuffer.cpp
+	Project:		OpenGL
+	Description:	Buffer objects for geometry uploaded once and for data rewritten every frame
+	Doc Version:	1.0
+	Author:			Jonathan Simon Jones
+	Date(D/M/Y):	16-10-2026
+	To do:
+*/
+
+#include "GpuBuffer.h"
+#include "RenderStats.h"
+
+// STL includes
+#include <cstring>
+
+namespace
+{
+	// How long to wait on a fence before flushing and trying again, in nanoseconds
+	const GLuint64 fenceTimeout = 1000000;
+}
+
+GLuint createStaticBuffer(GLenum target, GLsizeiptr size, const void *data)
+{
+	GLuint buffer;
+	glGenBuffers(1, &buffer);
+	glBindBuffer(target, buffer);
+	glBufferData(target, size, data, GL_STATIC_DRAW);
+	countUpload(size);
+
+	return buffer;
+}
+
+StreamingBuffer::StreamingBuffer(GLenum target, GLsizeiptr regionSize, unsigned int regionCount): m_target(target)
+, m_buffer(0)
+, m_regionSize(regionSize)
+, m_regionCount(regionCount < 2 ? 2 : regionCount)
+, m_region(0)
+, m_used(0)
+, m_mapped(0)
+, m_fences(m_regionCount, (GLsync)0)
+{
+	const GLsizeiptr totalSize = m_regionSize * m_regionCount;
+
+	glGenBuffers(1, &m_buffer);
+	glBindBuffer(m_target, m_buffer);
+
+	if(GLEW_ARB_buffer_storage && GLEW_ARB_sync)
+	{
+		// Coherent so writes are seen by the GPU without flushing each range
+		const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+		glBufferStorage(m_target, totalSize, NULL, flags);
+		m_mapped = (char*)glMapBufferRange(m_target, 0, totalSize, flags);
+	}
+
+	if(!m_mapped)
+	{
+		glBufferData(m_target, totalSize, NULL, GL_STREAM_DRAW);
+	}
+
+	// Start on the last region so the first beginFrame lands on region 0
+	m_region = m_regionCount - 1;
+}
+
+StreamingBuffer::~StreamingBuffer()
+{
+	for(unsigned int i = 0; i < m_regionCount; ++i)
+	{
+		if(m_fences[i])
+		{
+			glDeleteSync(m_fences[i]);
+		}
+	}
+
+	if(m_mapped)
+	{
+		glBindBuffer(m_target, m_buffer);
+		glUnmapBuffer(m_target);
+	}
+
+	glDeleteBuffers(1, &m_buffer);
+}
+
+void StreamingBuffer::beginFrame()
+{
+	m_region = (m_region + 1) % m_regionCount;
+	m_used = 0;
+
+	if(m_mapped)
+	{
+		GLsync fence = m_fences[m_region];
+		if(fence)
+		{
+			if(glClientWaitSync(fence, 0, 0) == GL_TIMEOUT_EXPIRED)
+			{
+				++getRenderStats().fenceWaits;
+				while(glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, fenceTimeout) == GL_TIMEOUT_EXPIRED)
+				{
+				}
+			}
+
+			glDeleteSync(fence);
+			m_fences[m_region] = 0;
+		}
+	}
+	else if(m_region == 0)
+	{
+		// Orphan the storage, the driver hands back fresh memory while the GPU finishes
+		// with the old copy, so none of the regions need to be waited on
+		glBindBuffer(m_target, m_buffer);
+		glBufferData(m_target, m_regionSize * m_regionCount, NULL, GL_STREAM_DRAW);
+	}
+}
+
+GLintptr StreamingBuffer::write(const void *data, GLsizeiptr size)
+{
+	if(m_used + size > m_regionSize)
+	{
+		return -1;
+	}
+
+	const GLintptr offset = m_region * m_regionSize + m_used;
+	m_used += size;
+
+	glBindBuffer(m_target, m_buffer);
+	if(m_mapped)
+	{
+		memcpy(m_mapped + offset, data, size);
+	}
+	else
+	{
+		glBufferSubData(m_target, offset, size, data);
+	}
+	countUpload(size);
+
+	return offset;
+}
+
+void StreamingBuffer::endFrame()
+{
+	if(m_mapped)
+	{
+		m_fences[m_region] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	}
+}
@@ -0,0 +1,109 @@
+/*
+	Name:			GpuProfiler.cpp
+	Project:		OpenGL
+	Description:	GPU spans measured with timestamp queries and handed to the profiler
+	Doc Version:	1.0
+	Author:			Jonathan Simon Jones
+	Date(D/M/Y):	16-10-2026
+	To do:
+*/
+
+#include "GpuProfiler.h"
+
+GpuProfiler::GpuProfiler(): m_frame(0)
+, m_available(GLEW_ARB_timer_query || GLEW_VERSION_3_3)
+{
+}
+
+GpuProfiler::~GpuProfiler()
+{
+	if(!m_allQueries.empty())
+	{
+		glDeleteQueries((GLsizei)m_allQueries.size(), &m_allQueries[0]);
+	}
+}
+
+void GpuProfiler::beginZone(const char *name)
+{
+	if(!m_available || !isProfiling())
+	{
+		m_open.push_back(noZone);
+		return;
+	}
+
+	std::vector<Zone> &zones = m_frames[m_frame];
+	Zone zone = { name, takeQuery(), takeQuery() };
+	glQueryCounter(zone.begin, GL_TIMESTAMP);
+	m_open.push_back((unsigned int)zones.size());
+	zones.push_back(zone);
+}
+
+void GpuProfiler::endZone()
+{
+	if(m_open.empty())
+	{
+		return;
+	}
+
+	const unsigned int zone = m_open.back();
+	m_open.pop_back();
+	if(zone != noZone)
+	{
+		glQueryCounter(m_frames[m_frame][zone].end, GL_TIMESTAMP);
+	}
+}
+
+void GpuProfiler::endFrame()
+{
+	if(!m_available)
+	{
+		return;
+	}
+
+	// Queries count from a point of the GPU's own, the two clocks are lined up every frame
+	GLint64 gpuNow = 0;
+	glGetInteger64v(GL_TIMESTAMP, &gpuNow);
+	const long long offset = (long long)profilerNow() - (long long)gpuNow;
+
+	m_frame = (m_frame + 1) % frameLatency;
+	std::vector<Zone> &oldest = m_frames[m_frame];
+
+	// Normally long done, if the GPU is that far behind the frame is dropped rather than waited for
+	GLuint ready = GL_TRUE;
+	if(!oldest.empty())
+	{
+		glGetQueryObjectuiv(oldest.back().end, GL_QUERY_RESULT_AVAILABLE, &ready);
+	}
+
+	for(unsigned int i = 0; i < oldest.size(); ++i)
+	{
+		const Zone &zone = oldest[i];
+		if(ready && isProfiling())
+		{
+			GLuint64 begin = 0;
+			GLuint64 end = 0;
+			glGetQueryObjectui64v(zone.begin, GL_QUERY_RESULT, &begin);
+			glGetQueryObjectui64v(zone.end, GL_QUERY_RESULT, &end);
+			recordGpuZone(zone.name, (unsigned long long)((long long)begin + offset), (unsigned long long)((long long)end + offset));
+		}
+
+		m_freeQueries.push_back(zone.begin);
+		m_freeQueries.push_back(zone.end);
+	}
+	oldest.clear();
+}
+
+GLuint GpuProfiler::takeQuery()
+{
+	if(m_freeQueries.empty())
+	{
+		GLuint query = 0;
+		glGenQueries(1, &query);
+		m_allQueries.push_back(query);
+		return query;
+	}
+
+	const GLuint query = m_freeQueries.back();
+	m_freeQueries.pop_back();
+	return query;
+}
@@ -0,0 +1,305 @@
+/*
+	Name:			Headless.cpp
+	Project:		OpenGL
+	Description:	Runs the per frame scene update without a window or GL context
+	Doc Version:	1.0
+	Author:			Jonathan Simon Jones
+	Date(D/M/Y):	16-10-2026
+	To do:
+*/
+
+#include "Headless.h"
+#include "Memory.h"
+#include "Mesh.h"
+#include "Profiler.h"
+#include "Scene.h"
+#include "SoftwareRenderBackend.h"
+#include "ThreadPool.h"
+
+// Math includes
+#include <glm/gtc/matrix_transform.hpp>
+
+// STL includes
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <vector>
+
+namespace
+{
+	typedef std::chrono::high_resolution_clock Clock;
+
+	// Frames left out of the heap counts while containers grow to what the scene needs
+	const unsigned int heapWarmUpFrames = 10;
+
+	double percentile(const std::vector<double> &sorted, double fraction)
+	{
+		const unsigned int index = (unsigned int)(fraction * (sorted.size() - 1) + 0.5);
+		return sorted[index];
+	}
+
+	// warm was taken heapWarmUpFrames in, or at the start of a run too short to have them
+	void printHeapUse(unsigned int frames, const HeapStats &warm, const HeapStats &end)
+	{
+		if(!heapCountersEnabled)
+		{
+			return;
+		}
+
+		const unsigned int counted = frames > heapWarmUpFrames ? frames - heapWarmUpFrames : frames;
+		printf("Heap after %u warm up frames: %.2f allocations per frame, %llu allocations and %llu bytes in all\n",
+			frames - counted, (double)(end.allocations - warm.allocations) / counted, end.allocations - warm.allocations, end.bytes - warm.bytes);
+	}
+}
+
+int runHeadless(unsigned int frames, unsigned int extraBodies, const char *tracePath)
+{
+	if(frames == 0)
+	{
+		printf("Nothing to run, frame count is 0\n");
+		return 1;
+	}
+
+	ThreadPool threadPool;
+	Scene scene(&threadPool);
+	addSceneClutter(scene, extraBodies);
+
+	// Every frame is handed exactly one fixed step of time so runs are repeatable
+	const float frameTime = scene.world.getFixedDt();
+
+	// The windowed build's camera, so the culling numbers match what it would draw
+	const glm::vec3 cameraPosition(0.0f, -5.0f, 2.0f);
+	const glm::mat4 viewProj = glm::perspective(45.0f, 800.0f / 600.0f, 1.0f, 15.0f) *
+		glm::lookAt(cameraPosition, glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3(0.0f, 0.0f, 1.0f));
+
+	std::vector<double> frameTimes;
+	frameTimes.reserve(frames);
+	double cullSeconds = 0.0;
+	unsigned long long frustumCulled = 0;
+	unsigned long long occluded = 0;
+	unsigned long long visible = 0;
+	SceneSnapshot snapshot;
+	SceneVisibility visibility;
+
+	unsigned int collidingFrames = 0;
+	unsigned int aabbOnlyFrames = 0;
+	unsigned long long pairs = 0;
+	unsigned long long manifolds = 0;
+	unsigned long long contactPoints = 0;
+	unsigned long long warmStarted = 0;
+	unsigned long long solverBatches = 0;
+	unsigned long long lanesUsed = 0;
+	unsigned int maxColors = 0;
+	unsigned long long awakeBodies = 0;
+	unsigned long long sleepingBodies = 0;
+	unsigned long long islands = 0;
+	const unsigned long long firstStep = scene.world.getStepCount();
+
+	if(tracePath)
+	{
+		setProfilerThreadName("Main");
+		startProfiling();
+	}
+
+	const Clock::time_point runStart = Clock::now();
+	HeapStats warmHeap = getHeapStats();
+	for(unsigned int frame = 0; frame < frames; ++frame)
+	{
+		if(frame == heapWarmUpFrames)
+		{
+			warmHeap = getHeapStats();
+		}
+
+		collectProfile();
+		PROFILE_ZONE("Frame");
+
+		const Clock::time_point start = Clock::now();
+		updateScene(scene, frameTime);
+		frameTimes.push_back(std::chrono::duration<double, std::milli>(Clock::now() - start).count());
+
+		PROFILE_COUNTER("Broadphase pairs", scene.pairCount);
+		PROFILE_COUNTER("Pairs tested", scene.narrowphase.getStats().pairsTested);
+		PROFILE_COUNTER("Contact manifolds", scene.narrowphase.getStats().manifolds);
+		PROFILE_COUNTER("Awake bodies", scene.islands.getStats().awakeBodies);
+
+		// Culled from a snapshot as the windowed build does, though here nothing steps meanwhile
+		takeSceneSnapshot(scene, scene.world.getStepCount() * (double)frameTime, scene.world.getStepCount(), snapshot);
+		const Clock::time_point cullStart = Clock::now();
+		cullScene(snapshot, viewProj, cameraPosition, visibility);
+		cullSeconds += std::chrono::duration<double>(Clock::now() - cullStart).count();
+		frustumCulled += visibility.culler.getStats().frustumCulled;
+		occluded += visibility.culler.getStats().occluded;
+		visible += visibility.culler.getStats().visible;
+
+		collidingFrames += scene.colliding ? 1 : 0;
+		aabbOnlyFrames += scene.boxesOverlapAABB && !scene.colliding ? 1 : 0;
+		pairs += scene.pairCount;
+		manifolds += scene.narrowphase.getStats().manifolds;
+		contactPoints += scene.narrowphase.getStats().points;
+		warmStarted += scene.solver.getStats().warmStarted;
+		solverBatches += scene.solver.getStats().batches;
+		lanesUsed += scene.solver.getStats().lanesUsed;
+		maxColors = std::max(maxColors, scene.solver.getStats().colors);
+		awakeBodies += scene.islands.getStats().awakeBodies;
+		sleepingBodies += scene.islands.getStats().sleepingBodies;
+		islands += scene.islands.getStats().islands;
+	}
+	const double runSeconds = std::chrono::duration<double>(Clock::now() - runStart).count();
+	const HeapStats heap = getHeapStats();
+
+	if(tracePath)
+	{
+		stopProfiling();
+		if(!writeChromeTrace(tracePath))
+		{
+			return 1;
+		}
+	}
+	const unsigned long long steps = scene.world.getStepCount() - firstStep;
+
+	std::sort(frameTimes.begin(), frameTimes.end());
+
+	printf("Headless run: %u frames, %u bodies, %u threads\n", frames, scene.world.getBodyCount(), threadPool.getThreadCount());
+	printf("Frame time ms: p50 %.4f  p90 %.4f  p99 %.4f  max %.4f\n",
+		percentile(frameTimes, 0.5), percentile(frameTimes, 0.9), percentile(frameTimes, 0.99), frameTimes.back());
+	printf("Simulation steps/sec: %.0f (%llu steps in %.3f s)\n", steps / runSeconds, steps, runSeconds);
+	printf("Box 1 and box 2 colliding in %u frames, only their AABBs overlapping in %u more\n", collidingFrames, aabbOnlyFrames);
+	printf("Per frame: %.1f broadphase pairs, %.1f touching with %.1f contact points\n",
+		(double)pairs / frames, (double)manifolds / frames, (double)contactPoints / frames);
+	printf("Solver per frame: %.1f points warm started, %.1f batches %.0f%% filled, at most %u colors\n",
+		(double)warmStarted / frames, (double)solverBatches / frames, solverBatches > 0 ? 100.0 * lanesUsed / (solverBatches * solverLanes) : 0.0, maxColors);
+	printf("Islands per frame: %.1f bodies awake in %.1f islands, %.1f asleep, %u asleep at the end\n",
+		(double)awakeBodies / frames, (double)islands / frames, (double)sleepingBodies / frames, scene.islands.getStats().sleepingBodies);
+	printf("Culling per frame: %.4f ms, %.1f visible, %.1f outside the frustum, %.1f occluded\n",
+		cullSeconds * 1000.0 / frames, (double)visible / frames, (double)frustumCulled / frames, (double)occluded / frames);
+	printHeapUse(frames, warmHeap, heap);
+	if(tracePath)
+	{
+		const ProfilerStats stats = getProfilerStats();
+		printf("Trace written to %s: %llu zones, %llu counters, %llu events dropped\n", tracePath, stats.zones, stats.counters, stats.dropped);
+	}
+
+	return 0;
+}
+
+int runHeadlessRender(unsigned int frames, unsigned int extraBodies, const char *imagePath)
+{
+	if(frames == 0)
+	{
+		printf("Nothing to run, frame count is 0\n");
+		return 1;
+	}
+
+	ThreadPool threadPool;
+	Scene scene(&threadPool);
+	addSceneClutter(scene, extraBodies);
+	const float frameTime = scene.world.getFixedDt();
+
+	// The windowed build's camera and window
+	const unsigned int width = 800;
+	const unsigned int height = 600;
+	const float farPlane = 15.0f;
+	const glm::vec3 cameraPosition(0.0f, -5.0f, 2.0f);
+	const glm::mat4 view = glm::lookAt(cameraPosition, glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3(0.0f, 0.0f, 1.0f));
+	const glm::mat4 proj = glm::perspective(45.0f, (float)width / (float)height, 1.0f, farPlane);
+
+	SoftwareRenderBackend renderBackend(width, height, &threadPool);
+	renderBackend.setViewProj(view, proj);
+
+	// What main loads from Meshes/cube.mesh and streams for the bounding box
+	MeshData cube;
+	createUnitCube(cube);
+	SceneDrawSetup drawSetup;
+	drawSetup.colorProgram = renderBackend.createProgram(SoftwareColor3D);
+	drawSetup.cubeVertexArray = renderBackend.createVertexArray(&cube.vertices[0], cube.getVertexCount(), &cube.indices[0], (unsigned int)cube.indices.size());
+	drawSetup.cubeIndexCount = (unsigned int)cube.indices.size();
+	drawSetup.boundingBoxVertexArray = renderBackend.createVertexArray(scene.boundingBoxCoords, 8, boundingBoxIndices, 36);
+	const unsigned int instancedProgram = renderBackend.createProgram(SoftwareColor3DInstanced);
+	const unsigned int instancedVertexArray = renderBackend.createVertexArray(&cube.vertices[0], cube.getVertexCount(), &cube.indices[0], (unsigned int)cube.indices.size());
+
+	RenderQueue renderQueue;
+	SceneSnapshot snapshot;
+	SceneVisibility visibility;
+	SceneProps props(&threadPool);
+	std::vector<CubeInstance> instances;
+	std::vector<double> simulationTimes;
+	std::vector<double> renderTimes;
+	simulationTimes.reserve(frames);
+	renderTimes.reserve(frames);
+	double renderSeconds = 0.0;
+	unsigned long long triangles = 0;
+	unsigned long long drawnTriangles = 0;
+	unsigned long long fragments = 0;
+
+	HeapStats warmHeap = getHeapStats();
+	for(unsigned int frame = 0; frame < frames; ++frame)
+	{
+		if(frame == heapWarmUpFrames)
+		{
+			warmHeap = getHeapStats();
+		}
+
+		const Clock::time_point start = Clock::now();
+		updateScene(scene, frameTime);
+		takeSceneSnapshot(scene, scene.world.getStepCount() * (double)frameTime, scene.world.getStepCount(), snapshot);
+		cullScene(snapshot, proj * view, cameraPosition, visibility);
+		const Clock::time_point simulated = Clock::now();
+
+		renderQueue.clear();
+		renderBackend.setVertices(drawSetup.boundingBoxVertexArray, snapshot.boundingBoxCoords, 8);
+		submitSceneDraws(snapshot, visibility, props, drawSetup, cameraPosition, farPlane, false, renderQueue);
+
+		makeCubeInstances(snapshot.getOrientedBoxes(), visibility.visibleClutter, instances);
+		if(!instances.empty())
+		{
+			renderBackend.setInstances(instancedVertexArray, &instances[0], (unsigned int)instances.size());
+
+			RenderCommand command;
+			command.program = instancedProgram;
+			command.vertexArray = instancedVertexArray;
+			command.drawType = DrawElementsInstanced;
+			command.count = drawSetup.cubeIndexCount;
+			command.instanceCount = (unsigned int)instances.size();
+			renderQueue.submit(command, 0.0f);
+		}
+
+		renderQueue.sort();
+		renderBackend.execute(renderQueue);
+		const Clock::time_point rendered = Clock::now();
+
+		simulationTimes.push_back(std::chrono::duration<double, std::milli>(simulated - start).count());
+		renderTimes.push_back(std::chrono::duration<double, std::milli>(rendered - simulated).count());
+		renderSeconds += std::chrono::duration<double>(rendered - simulated).count();
+
+		const SoftwareRenderStats &stats = renderBackend.getStats();
+		triangles += stats.triangles;
+		drawnTriangles += stats.triangles - stats.culled;
+		fragments += stats.fragments;
+	}
+	const HeapStats heap = getHeapStats();
+
+	std::sort(simulationTimes.begin(), simulationTimes.end());
+	std::sort(renderTimes.begin(), renderTimes.end());
+
+	printf("Software render: %u frames at %ux%u, %u bodies, %u threads, %s\n", frames, width, height, scene.world.getBodyCount(),
+		threadPool.getThreadCount(), getSimdLevelName(renderBackend.getSimdLevel()));
+	printf("Simulation ms: p50 %.4f  p90 %.4f  p99 %.4f  max %.4f\n",
+		percentile(simulationTimes, 0.5), percentile(simulationTimes, 0.9), percentile(simulationTimes, 0.99), simulationTimes.back());
+	printf("Render ms:     p50 %.4f  p90 %.4f  p99 %.4f  max %.4f\n",
+		percentile(renderTimes, 0.5), percentile(renderTimes, 0.9), percentile(renderTimes, 0.99), renderTimes.back());
+	printf("Per frame: %.1f triangles, %.1f reaching the rasterizer, %.0f pixels written\n",
+		(double)triangles / frames, (double)drawnTriangles / frames, (double)fragments / frames);
+	printf("Triangles/sec: %.0f submitted, %.0f rasterized\n", triangles / renderSeconds, drawnTriangles / renderSeconds);
+	printHeapUse(frames, warmHeap, heap);
+
+	if(imagePath)
+	{
+		if(!renderBackend.getFramebuffer().writePng(imagePath))
+		{
+			return 1;
+		}
+		printf("Last frame written to %s\n", imagePath);
+	}
+
+	return 0;
+}
@@ -0,0 +1,117 @@
+/*
+	Name:			InstancedCubeRenderer.cpp
+	Project:		OpenGL
+	Description:	Draws every cube in a list of bodies with a single instanced draw call
+	Doc Version:	1.0
+	Author:			Jonathan Simon Jones
+	Date(D/M/Y):	16-10-2026
+	To do:
+*/
+
+#include "InstancedCubeRenderer.h"
+
+// STL includes
+#include <cstddef>
+
+namespace
+{
+	const GLsizei vertexStride = 6 * sizeof(float);
+
+	// Buffers never start smaller than this many instances
+	const unsigned int minimumCapacity = 256;
+}
+
+InstancedCubeRenderer::InstancedCubeRenderer(GLuint cubeBuffer, GLuint cubeIndices, GLsizei indexCount, GLuint shaderProgram): m_vao(0)
+, m_indexCount(indexCount)
+, m_instancePosition(glGetAttribLocation(shaderProgram, "instancePosition"))
+, m_instanceScale(glGetAttribLocation(shaderProgram, "instanceScale"))
+, m_instanceOrientation(glGetAttribLocation(shaderProgram, "instanceOrientation"))
+, m_capacity(0)
+, m_uploaded(false)
+{
+	const GLint posAttrib = glGetAttribLocation(shaderProgram, "position");
+	const GLint colAttrib = glGetAttribLocation(shaderProgram, "color");
+
+	glGenVertexArrays(1, &m_vao);
+	glBindVertexArray(m_vao);
+
+	// Per vertex attributes come from the shared cube geometry
+	glBindBuffer(GL_ARRAY_BUFFER, cubeBuffer);
+	glVertexAttribPointer(posAttrib, 3, GL_FLOAT, GL_FALSE, vertexStride, 0);
+	glVertexAttribPointer(colAttrib, 3, GL_FLOAT, GL_FALSE, vertexStride, (void*)(3 * sizeof(float)));
+	glEnableVertexAttribArray(posAttrib);
+	glEnableVertexAttribArray(colAttrib);
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, cubeIndices);
+
+	// Per instance attributes step once per cube, they are pointed at the stream in draw
+	glEnableVertexAttribArray(m_instancePosition);
+	glEnableVertexAttribArray(m_instanceScale);
+	glEnableVertexAttribArray(m_instanceOrientation);
+	glVertexAttribDivisor(m_instancePosition, 1);
+	glVertexAttribDivisor(m_instanceScale, 1);
+	glVertexAttribDivisor(m_instanceOrientation, 1);
+
+	glBindVertexArray(0);
+}
+
+InstancedCubeRenderer::~InstancedCubeRenderer()
+{
+	glDeleteVertexArrays(1, &m_vao);
+}
+
+void InstancedCubeRenderer::setInstances(const OrientedBoxSoA &boxes, const std::vector<unsigned int> &bodies)
+{
+	makeCubeInstances(boxes, bodies, m_instances);
+}
+
+void InstancedCubeRenderer::upload()
+{
+	const unsigned int count = getInstanceCount();
+	if(count == 0)
+	{
+		return;
+	}
+
+	if(count > m_capacity)
+	{
+		m_capacity = m_capacity < minimumCapacity ? minimumCapacity : m_capacity;
+		while(m_capacity < count)
+		{
+			m_capacity *= 2;
+		}
+		m_stream.reset(new StreamingBuffer(GL_ARRAY_BUFFER, m_capacity * sizeof(CubeInstance)));
+	}
+
+	m_stream->beginFrame();
+	m_uploaded = true;
+	const GLintptr offset = m_stream->write(&m_instances[0], count * sizeof(CubeInstance));
+
+	// Attribute pointers are part of the vertex array object, so the command only has to bind it
+	glBindVertexArray(m_vao);
+	const GLsizei stride = sizeof(CubeInstance);
+	glVertexAttribPointer(m_instancePosition, 3, GL_FLOAT, GL_FALSE, stride, (void*)(offset + offsetof(CubeInstance, position)));
+	glVertexAttribPointer(m_instanceScale, 3, GL_FLOAT, GL_FALSE, stride, (void*)(offset + offsetof(CubeInstance, scale)));
+	glVertexAttribPointer(m_instanceOrientation, 4, GL_FLOAT, GL_FALSE, stride, (void*)(offset + offsetof(CubeInstance, orientation)));
+	glBindVertexArray(0);
+}
+
+RenderCommand InstancedCubeRenderer::getCommand(GLuint program) const
+{
+	RenderCommand command;
+	command.program = program;
+	command.vertexArray = m_vao;
+	command.drawType = DrawElementsInstanced;
+	command.count = m_indexCount;
+	command.instanceCount = getInstanceCount();
+
+	return command;
+}
+
+void InstancedCubeRenderer::endFrame()
+{
+	if(m_uploaded)
+	{
+		m_stream->endFrame();
+		m_uploaded = false;
+	}
+}
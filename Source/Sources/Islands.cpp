@@ -0,0 +1,209 @@
+/*
+	Name:			Islands.cpp
+	Project:		OpenGL
+	Description:	Groups touching bodies into islands and puts islands that have come to rest to sleep
+	Doc Version:	1.0
+	Author:			Jonathan Simon Jones
+	Date(D/M/Y):	16-10-2026
+	To do:
+*/
+
+#include "Islands.h"
+#include "Profiler.h"
+
+// STL includes
+#include <algorithm>
+
+namespace
+{
+	// Below both of these a body counts as still, in metres and radians per second
+	const float sleepLinearVelocity = 0.05f;
+	const float sleepAngularVelocity = 0.05f;
+	// How long a whole island has to stay still before it sleeps
+	const float sleepDelay = 0.5f;
+
+	const unsigned int noIslandBody = 0xffffffff;
+
+	bool isDynamic(const BodySoA &b, unsigned int body)
+	{
+		return b.inverseMass[body] > 0.0f;
+	}
+
+	bool isStill(const BodySoA &b, unsigned int body)
+	{
+		const float linear = b.vx[body] * b.vx[body] + b.vy[body] * b.vy[body] + b.vz[body] * b.vz[body];
+		const float angular = b.wx[body] * b.wx[body] + b.wy[body] * b.wy[body] + b.wz[body] * b.wz[body];
+		return linear < sleepLinearVelocity * sleepLinearVelocity && angular < sleepAngularVelocity * sleepAngularVelocity;
+	}
+
+	bool isStopped(const BodySoA &b, unsigned int body)
+	{
+		return b.vx[body] == 0.0f && b.vy[body] == 0.0f && b.vz[body] == 0.0f
+			&& b.wx[body] == 0.0f && b.wy[body] == 0.0f && b.wz[body] == 0.0f;
+	}
+}
+
+IslandManager::IslandManager(): m_sleepingCount(0)
+, m_enabled(true)
+{
+}
+
+void IslandManager::update(PhysicsWorld &world, const ContactManifold manifolds[], unsigned int count, float elapsed)
+{
+	PROFILE_ZONE("Islands");
+
+	const BodySoA &bodies = world.getBodies();
+	const unsigned int bodyCount = bodies.size();
+	if(m_nextSleeping.size() < bodyCount)
+	{
+		m_parent.resize(bodyCount);
+		m_stillTime.resize(bodyCount, 0.0f);
+		m_islandStillTime.resize(bodyCount);
+		m_nextSleeping.resize(bodyCount, noIslandBody);
+	}
+	m_stats = IslandStats();
+
+	for(unsigned int i = 0; !m_enabled && m_sleepingCount > 0 && i < bodyCount; ++i)
+	{
+		wakeIsland(world, i);
+	}
+
+	// A body a setter woke brings the rest of its island with it
+	const std::vector<BodyRange> &woken = world.getAwakeRanges();
+	for(unsigned int r = 0; m_sleepingCount > 0 && r < woken.size(); ++r)
+	{
+		for(unsigned int i = woken[r].begin; i < woken[r].end; ++i)
+		{
+			wakeIsland(world, i);
+		}
+	}
+
+	// So does an awake body touching it
+	for(unsigned int m = 0; m_sleepingCount > 0 && m < count; ++m)
+	{
+		const unsigned int a = manifolds[m].a;
+		const unsigned int b = manifolds[m].b;
+		if(world.isAwake(a) != world.isAwake(b))
+		{
+			wakeIsland(world, world.isAwake(a) ? b : a);
+		}
+	}
+
+	// Islands of what is awake now, taken a second time as waking changes the ranges
+	const std::vector<BodyRange> &ranges = world.getAwakeRanges();
+	for(unsigned int r = 0; r < ranges.size(); ++r)
+	{
+		for(unsigned int i = ranges[r].begin; i < ranges[r].end; ++i)
+		{
+			m_parent[i] = i;
+			m_stillTime[i] = isStill(bodies, i) ? m_stillTime[i] + elapsed : 0.0f;
+			m_islandStillTime[i] = m_stillTime[i];
+		}
+	}
+
+	for(unsigned int m = 0; m < count; ++m)
+	{
+		const unsigned int a = manifolds[m].a;
+		const unsigned int b = manifolds[m].b;
+		if(isDynamic(bodies, a) && isDynamic(bodies, b) && world.isAwake(a) && world.isAwake(b))
+		{
+			join(a, b);
+		}
+	}
+
+	for(unsigned int r = 0; r < ranges.size(); ++r)
+	{
+		for(unsigned int i = ranges[r].begin; i < ranges[r].end; ++i)
+		{
+			if(isDynamic(bodies, i))
+			{
+				const unsigned int root = findRoot(i);
+				m_islandStillTime[root] = std::min(m_islandStillTime[root], m_stillTime[i]);
+			}
+		}
+	}
+
+	// Whole islands fall asleep together, each linked into a ring through its root. The
+	// ranges are left as they are until the next time they are asked for.
+	for(unsigned int r = 0; r < ranges.size(); ++r)
+	{
+		for(unsigned int i = ranges[r].begin; i < ranges[r].end; ++i)
+		{
+			// Static and kinematic bodies have nothing to settle, they sleep as soon as they stop
+			if(!isDynamic(bodies, i))
+			{
+				if(m_enabled && isStopped(bodies, i))
+				{
+					world.setAwake(i, false);
+				}
+				continue;
+			}
+
+			const unsigned int root = findRoot(i);
+			if(!m_enabled || m_islandStillTime[root] < sleepDelay)
+			{
+				m_stats.awakeBodies += 1;
+				m_stats.islands += root == i ? 1 : 0;
+				continue;
+			}
+
+			if(m_nextSleeping[root] == noIslandBody)
+			{
+				m_nextSleeping[root] = root;
+			}
+			if(i != root)
+			{
+				m_nextSleeping[i] = m_nextSleeping[root];
+				m_nextSleeping[root] = i;
+			}
+			world.setAwake(i, false);
+			++m_sleepingCount;
+			++m_stats.fellAsleep;
+		}
+	}
+
+	m_stats.sleepingBodies = m_sleepingCount;
+}
+
+unsigned int IslandManager::findRoot(unsigned int body)
+{
+	// Path halving, every other node on the way up skips to its grandparent
+	while(m_parent[body] != body)
+	{
+		m_parent[body] = m_parent[m_parent[body]];
+		body = m_parent[body];
+	}
+
+	return body;
+}
+
+void IslandManager::join(unsigned int a, unsigned int b)
+{
+	const unsigned int rootA = findRoot(a);
+	const unsigned int rootB = findRoot(b);
+	if(rootA != rootB)
+	{
+		m_parent[std::max(rootA, rootB)] = std::min(rootA, rootB);
+	}
+}
+
+void IslandManager::wakeIsland(PhysicsWorld &world, unsigned int body)
+{
+	if(m_nextSleeping[body] == noIslandBody)
+	{
+		return;
+	}
+
+	unsigned int i = body;
+	do
+	{
+		const unsigned int next = m_nextSleeping[i];
+		m_nextSleeping[i] = noIslandBody;
+		m_stillTime[i] = 0.0f;
+		world.setAwake(i, true);
+		--m_sleepingCount;
+		++m_stats.woken;
+		i = next;
+	}
+	while(i != body);
+}
@@ -0,0 +1,369 @@
+/*
+	Name:			Memory.cpp
+	Project:		OpenGL
+	Description:	Per frame arenas, fixed size pools, STL allocators over them and heap counters
+	Doc Version:	1.0
+	Author:			Jonathan Simon Jones
+	Date(D/M/Y):	16-10-2026
+	To do:
+*/
+
+#include "Memory.h"
+
+// STL includes
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstdlib>
+
+namespace
+{
+	// Overflow is sized up to whole pages when the main block grows to take it in
+	const size_t arenaGrowthGranularity = 4096;
+
+	// Constant initialised, so they are ready before any static constructor allocates
+	std::atomic<unsigned long long> heapAllocations(0);
+	std::atomic<unsigned long long> heapFrees(0);
+	std::atomic<unsigned long long> heapBytes(0);
+
+	char* alignUp(char *pointer, size_t alignment)
+	{
+		const std::uintptr_t address = (std::uintptr_t)pointer;
+		return pointer + (((address + alignment - 1) & ~(std::uintptr_t)(alignment - 1)) - address);
+	}
+}
+
+#ifdef MEMORY_COUNTERS_ENABLED
+namespace
+{
+	void* countedAllocate(size_t bytes)
+	{
+		heapAllocations.fetch_add(1, std::memory_order_relaxed);
+		heapBytes.fetch_add(bytes, std::memory_order_relaxed);
+		return std::malloc(bytes > 0 ? bytes : 1);
+	}
+
+	void countedFree(void *pointer)
+	{
+		if(pointer)
+		{
+			heapFrees.fetch_add(1, std::memory_order_relaxed);
+			std::free(pointer);
+		}
+	}
+
+#ifdef __cpp_aligned_new
+	// Over allocated from malloc, with the pointer malloc gave kept just in front of the
+	// aligned one for countedFreeAligned
+	void* countedAllocateAligned(size_t bytes, std::align_val_t alignment)
+	{
+		const size_t align = std::max((size_t)alignment, sizeof(void*));
+		heapAllocations.fetch_add(1, std::memory_order_relaxed);
+		heapBytes.fetch_add(bytes, std::memory_order_relaxed);
+		char *block = static_cast<char*>(std::malloc(bytes + align + sizeof(void*)));
+		if(!block)
+		{
+			return 0;
+		}
+
+		char *pointer = alignUp(block + sizeof(void*), align);
+		reinterpret_cast<void**>(pointer)[-1] = block;
+		return pointer;
+	}
+
+	void countedFreeAligned(void *pointer)
+	{
+		if(pointer)
+		{
+			heapFrees.fetch_add(1, std::memory_order_relaxed);
+			std::free(static_cast<void**>(pointer)[-1]);
+		}
+	}
+#endif // __cpp_aligned_new
+}
+
+// Every form of the global operators, the array, nothrow and sized ones included, so the
+// standard library's own never see a pointer these gave out. The aligned forms are only
+// there when the compiler has C++17 aligned new.
+void* operator new(size_t bytes)
+{
+	void *pointer = countedAllocate(bytes);
+	if(!pointer)
+	{
+		throw std::bad_alloc();
+	}
+	return pointer;
+}
+
+void* operator new[](size_t bytes)
+{
+	void *pointer = countedAllocate(bytes);
+	if(!pointer)
+	{
+		throw std::bad_alloc();
+	}
+	return pointer;
+}
+
+void* operator new(size_t bytes, const std::nothrow_t &) noexcept
+{
+	return countedAllocate(bytes);
+}
+
+void* operator new[](size_t bytes, const std::nothrow_t &) noexcept
+{
+	return countedAllocate(bytes);
+}
+
+void operator delete(void *pointer) noexcept
+{
+	countedFree(pointer);
+}
+
+void operator delete[](void *pointer) noexcept
+{
+	countedFree(pointer);
+}
+
+void operator delete(void *pointer, size_t) noexcept
+{
+	countedFree(pointer);
+}
+
+void operator delete[](void *pointer, size_t) noexcept
+{
+	countedFree(pointer);
+}
+
+void operator delete(void *pointer, const std::nothrow_t &) noexcept
+{
+	countedFree(pointer);
+}
+
+void operator delete[](void *pointer, const std::nothrow_t &) noexcept
+{
+	countedFree(pointer);
+}
+
+#ifdef __cpp_aligned_new
+void* operator new(size_t bytes, std::align_val_t alignment)
+{
+	void *pointer = countedAllocateAligned(bytes, alignment);
+	if(!pointer)
+	{
+		throw std::bad_alloc();
+	}
+	return pointer;
+}
+
+void* operator new[](size_t bytes, std::align_val_t alignment)
+{
+	void *pointer = countedAllocateAligned(bytes, alignment);
+	if(!pointer)
+	{
+		throw std::bad_alloc();
+	}
+	return pointer;
+}
+
+void* operator new(size_t bytes, std::align_val_t alignment, const std::nothrow_t &) noexcept
+{
+	return countedAllocateAligned(bytes, alignment);
+}
+
+void* operator new[](size_t bytes, std::align_val_t alignment, const std::nothrow_t &) noexcept
+{
+	return countedAllocateAligned(bytes, alignment);
+}
+
+void operator delete(void *pointer, std::align_val_t) noexcept
+{
+	countedFreeAligned(pointer);
+}
+
+void operator delete[](void *pointer, std::align_val_t) noexcept
+{
+	countedFreeAligned(pointer);
+}
+
+void operator delete(void *pointer, size_t, std::align_val_t) noexcept
+{
+	countedFreeAligned(pointer);
+}
+
+void operator delete[](void *pointer, size_t, std::align_val_t) noexcept
+{
+	countedFreeAligned(pointer);
+}
+
+void operator delete(void *pointer, std::align_val_t, const std::nothrow_t &) noexcept
+{
+	countedFreeAligned(pointer);
+}
+
+void operator delete[](void *pointer, std::align_val_t, const std::nothrow_t &) noexcept
+{
+	countedFreeAligned(pointer);
+}
+#endif // __cpp_aligned_new
+#endif // MEMORY_COUNTERS_ENABLED
+
+HeapStats getHeapStats()
+{
+	HeapStats stats;
+	stats.allocations = heapAllocations.load(std::memory_order_relaxed);
+	stats.frees = heapFrees.load(std::memory_order_relaxed);
+	stats.bytes = heapBytes.load(std::memory_order_relaxed);
+	return stats;
+}
+
+FrameArena::FrameArena(size_t capacity): m_block(0)
+, m_used(0)
+{
+	if(capacity > 0)
+	{
+		m_block = static_cast<char*>(::operator new(capacity));
+		m_stats.capacity = capacity;
+	}
+}
+
+FrameArena::~FrameArena()
+{
+	for(unsigned int i = 0; i < m_overflow.size(); ++i)
+	{
+		::operator delete(m_overflow[i]);
+	}
+	::operator delete(m_block);
+}
+
+void* FrameArena::allocate(size_t bytes, size_t alignment)
+{
+	if(m_block)
+	{
+		char *start = alignUp(m_block + m_used, alignment);
+		const size_t end = (size_t)(start - m_block) + bytes;
+		if(end <= m_stats.capacity)
+		{
+			m_stats.used += end - m_used;
+			m_stats.highWater = std::max(m_stats.highWater, m_stats.used);
+			m_used = end;
+			return start;
+		}
+	}
+
+	// Padded so it can be aligned, counted whole so the block grown to take it in has room
+	const size_t padded = bytes + alignment - 1;
+	char *block = static_cast<char*>(::operator new(padded > 0 ? padded : 1));
+	m_overflow.push_back(block);
+	++m_stats.overflows;
+	m_stats.used += padded;
+	m_stats.highWater = std::max(m_stats.highWater, m_stats.used);
+	return alignUp(block, alignment);
+}
+
+void FrameArena::reset()
+{
+	if(!m_overflow.empty())
+	{
+		for(unsigned int i = 0; i < m_overflow.size(); ++i)
+		{
+			::operator delete(m_overflow[i]);
+		}
+		m_overflow.clear();
+
+		// Big enough for the frame that overflowed, and anything that fitted before it
+		const size_t capacity = (m_stats.highWater + arenaGrowthGranularity - 1) / arenaGrowthGranularity * arenaGrowthGranularity;
+		if(capacity > m_stats.capacity)
+		{
+			::operator delete(m_block);
+			m_block = static_cast<char*>(::operator new(capacity));
+			m_stats.capacity = capacity;
+			++m_stats.grows;
+		}
+	}
+
+	m_used = 0;
+	m_stats.used = 0;
+}
+
+DoubleFrameArena::DoubleFrameArena(size_t capacity): m_first(capacity)
+, m_second(capacity)
+, m_current(&m_first)
+, m_previous(&m_second)
+{
+}
+
+void DoubleFrameArena::beginFrame()
+{
+	std::swap(m_current, m_previous);
+	m_current->reset();
+}
+
+FixedPool::FixedPool(size_t blockSize, size_t alignment, unsigned int blocksPerChunk): m_alignment(std::max(alignment, std::alignment_of<FreeBlock>::value))
+, m_blocksPerChunk(std::max(blocksPerChunk, 1u))
+, m_free(0)
+, m_used(0)
+, m_capacity(0)
+{
+	m_blockSize = std::max(blockSize, sizeof(FreeBlock));
+	m_blockSize = (m_blockSize + m_alignment - 1) / m_alignment * m_alignment;
+}
+
+FixedPool::~FixedPool()
+{
+	for(unsigned int i = 0; i < m_chunks.size(); ++i)
+	{
+		::operator delete(m_chunks[i]);
+	}
+}
+
+void* FixedPool::allocate()
+{
+	if(!m_free)
+	{
+		addChunk(m_blocksPerChunk);
+	}
+
+	FreeBlock *block = m_free;
+	m_free = block->next;
+	++m_used;
+	return block;
+}
+
+void FixedPool::deallocate(void *block)
+{
+	if(!block)
+	{
+		return;
+	}
+
+	FreeBlock *freed = static_cast<FreeBlock*>(block);
+	freed->next = m_free;
+	m_free = freed;
+	--m_used;
+}
+
+void FixedPool::reserve(unsigned int blocks)
+{
+	const unsigned int available = m_capacity - m_used;
+	if(available < blocks)
+	{
+		addChunk(std::max(blocks - available, m_blocksPerChunk));
+	}
+}
+
+void FixedPool::addChunk(unsigned int blocks)
+{
+	char *chunk = static_cast<char*>(::operator new(m_blockSize * blocks + m_alignment - 1));
+	m_chunks.push_back(chunk);
+	m_capacity += blocks;
+
+	// Linked from the back so blocks are handed out in address order
+	char *first = alignUp(chunk, m_alignment);
+	for(unsigned int i = blocks; i-- > 0;)
+	{
+		FreeBlock *block = reinterpret_cast<FreeBlock*>(first + i * m_blockSize);
+		block->next = m_free;
+		m_free = block;
+	}
+}
@@ -0,0 +1,352 @@
+/*
+	Name:			Mesh.cpp
+	Project:		OpenGL
+	Description:	Binary mesh files that upload straight from a memory map, and the OBJ converter that writes them
+	Doc Version:	1.0
+	Author:			Jonathan Simon Jones
+	Date(D/M/Y):	16-10-2026
+	To do:
+*/
+
+#include "Mesh.h"
+#include "AssetLoader.h"
+#include "MeshOptimizer.h"
+
+// STL includes
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+
+namespace
+{
+	const unsigned int blockAlignment = 16;
+
+	unsigned int alignUp(unsigned int offset)
+	{
+		return (offset + blockAlignment - 1) & ~(blockAlignment - 1);
+	}
+
+	const char* skipSpaces(const char *text)
+	{
+		while(*text == ' ' || *text == '\t')
+		{
+			++text;
+		}
+		return text;
+	}
+
+	const char* nextLine(const char *text)
+	{
+		while(*text && *text != '\n')
+		{
+			++text;
+		}
+		return *text ? text + 1 : text;
+	}
+
+	// Reads up to count floats from the rest of the line, returns how many it found
+	unsigned int readFloats(const char *&text, float values[], unsigned int count)
+	{
+		unsigned int found = 0;
+		while(found < count)
+		{
+			char *end;
+			const float value = strtof(text, &end);
+			if(end == text)
+			{
+				break;
+			}
+			values[found++] = value;
+			text = end;
+		}
+		return found;
+	}
+
+	// OBJ indices start at 1 and count back from the end when negative, returns -1 if out of range
+	int resolveIndex(long index, size_t count)
+	{
+		const long resolved = index < 0 ? (long)count + index : index - 1;
+		return resolved >= 0 && resolved < (long)count ? (int)resolved : -1;
+	}
+}
+
+bool openMeshView(const MappedFile &file, MeshView &view)
+{
+	if(file.getSize() < sizeof(MeshHeader))
+	{
+		return false;
+	}
+
+	const MeshHeader *header = (const MeshHeader*)file.getData();
+	if(memcmp(header->magic, "MESH", 4) != 0 || header->version != meshFileVersion || header->vertexStride != meshVertexFloats * sizeof(float))
+	{
+		return false;
+	}
+
+	const unsigned long long vertexEnd = header->vertexOffset + (unsigned long long)header->vertexCount * header->vertexStride;
+	const unsigned long long indexEnd = header->indexOffset + (unsigned long long)header->indexCount * sizeof(unsigned int);
+	if(header->vertexOffset % blockAlignment != 0 || header->indexOffset % blockAlignment != 0 || vertexEnd > file.getSize() || indexEnd > file.getSize())
+	{
+		return false;
+	}
+
+	view.header = header;
+	view.vertices = (const float*)(file.getData() + header->vertexOffset);
+	view.indices = (const unsigned int*)(file.getData() + header->indexOffset);
+	return true;
+}
+
+bool loadObj(const std::string &path, MeshData &mesh)
+{
+	// The parser needs the text null terminated, so this one copy is made
+	MappedFile file;
+	if(!file.open(path))
+	{
+		printf("Could not open %s\n", path.c_str());
+		return false;
+	}
+	const std::string text(file.getData(), file.getSize());
+	file.close();
+
+	std::vector<float> positions;		// x, y, z, r, g, b with r < 0 when there is no color
+	std::vector<float> normals;
+	std::vector<unsigned int> polygon;
+
+	mesh.vertices.clear();
+	mesh.indices.clear();
+
+	unsigned int lineNumber = 1;
+	for(const char *line = text.c_str(); *line; line = nextLine(line), ++lineNumber)
+	{
+		const char *cursor = skipSpaces(line);
+
+		if(cursor[0] == 'v' && (cursor[1] == ' ' || cursor[1] == '\t'))
+		{
+			cursor += 2;
+			float values[6] = { 0.0f, 0.0f, 0.0f, -1.0f, -1.0f, -1.0f };
+			if(readFloats(cursor, values, 6) < 3)
+			{
+				printf("%s:%u: vertex needs three coordinates\n", path.c_str(), lineNumber);
+				return false;
+			}
+			positions.insert(positions.end(), values, values + 6);
+		}
+		else if(cursor[0] == 'v' && cursor[1] == 'n')
+		{
+			cursor += 2;
+			float values[3] = { 0.0f, 0.0f, 0.0f };
+			readFloats(cursor, values, 3);
+			normals.insert(normals.end(), values, values + 3);
+		}
+		else if(cursor[0] == 'f' && (cursor[1] == ' ' || cursor[1] == '\t'))
+		{
+			cursor += 2;
+			polygon.clear();
+
+			for(;;)
+			{
+				cursor = skipSpaces(cursor);
+				char *end;
+				const long positionIndex = strtol(cursor, &end, 10);
+				if(end == cursor)
+				{
+					break;
+				}
+				cursor = end;
+
+				// v, v/vt, v//vn or v/vt/vn, texture coordinates are not used
+				long normalIndex = 0;
+				if(*cursor == '/')
+				{
+					++cursor;
+					strtol(cursor, &end, 10);
+					cursor = end;
+					if(*cursor == '/')
+					{
+						++cursor;
+						normalIndex = strtol(cursor, &end, 10);
+						cursor = end;
+					}
+				}
+
+				const int p = resolveIndex(positionIndex, positions.size() / 6);
+				const int n = normalIndex != 0 ? resolveIndex(normalIndex, normals.size() / 3) : -1;
+				if(p < 0 || (normalIndex != 0 && n < 0))
+				{
+					printf("%s:%u: face index out of range\n", path.c_str(), lineNumber);
+					return false;
+				}
+
+				// Every corner gets its own vertex for now, weldVertices merges them at the end
+				float vertex[meshVertexFloats];
+				const float *position = &positions[p * 6];
+				for(unsigned int i = 0; i < 3; ++i)
+				{
+					// Adding zero turns -0 into 0 so they weld
+					vertex[i] = position[i] + 0.0f;
+					if(position[3] >= 0.0f)
+					{
+						vertex[3 + i] = position[3 + i] + 0.0f;
+					}
+					else
+					{
+						vertex[3 + i] = n >= 0 ? std::fabs(normals[n * 3 + i]) + 0.0f : 0.7f;
+					}
+				}
+
+				polygon.push_back(mesh.getVertexCount());
+				mesh.vertices.insert(mesh.vertices.end(), vertex, vertex + meshVertexFloats);
+			}
+
+			for(unsigned int i = 2; i < polygon.size(); ++i)
+			{
+				mesh.indices.push_back(polygon[0]);
+				mesh.indices.push_back(polygon[i - 1]);
+				mesh.indices.push_back(polygon[i]);
+			}
+		}
+	}
+
+	weldVertices(mesh);
+	return true;
+}
+
+void createUnitCube(MeshData &mesh)
+{
+	// Bottom, top, left, right, front, back, as cube.obj lists them
+	const float vertices[36 * meshVertexFloats] = {
+		-0.5f, -0.5f, -0.5f, 0.0f, 0.0f, 1.0f,
+		 0.5f, -0.5f, -0.5f, 0.0f, 1.0f, 0.0f,
+		 0.5f,  0.5f, -0.5f, 1.0f, 0.0f, 0.0f,
+		 0.5f,  0.5f, -0.5f, 1.0f, 1.0f, 0.0f,
+		-0.5f,  0.5f, -0.5f, 1.0f, 0.0f, 1.0f,
+		-0.5f, -0.5f, -0.5f, 0.0f, 1.0f, 1.0f,
+
+		-0.5f, -0.5f,  0.5f, 0.0f, 0.0f, 1.0f,
+		 0.5f, -0.5f,  0.5f, 0.0f, 1.0f, 0.0f,
+		 0.5f,  0.5f,  0.5f, 1.0f, 0.0f, 0.0f,
+		 0.5f,  0.5f,  0.5f, 1.0f, 1.0f, 0.0f,
+		-0.5f,  0.5f,  0.5f, 1.0f, 0.0f, 1.0f,
+		-0.5f, -0.5f,  0.5f, 0.0f, 1.0f, 1.0f,
+
+		-0.5f,  0.5f,  0.5f, 0.0f, 0.0f, 1.0f,
+		-0.5f,  0.5f, -0.5f, 0.0f, 1.0f, 0.0f,
+		-0.5f, -0.5f, -0.5f, 1.0f, 0.0f, 0.0f,
+		-0.5f, -0.5f, -0.5f, 1.0f, 1.0f, 0.0f,
+		-0.5f, -0.5f,  0.5f, 1.0f, 0.0f, 1.0f,
+		-0.5f,  0.5f,  0.5f, 0.0f, 1.0f, 1.0f,
+
+		 0.5f,  0.5f,  0.5f, 0.0f, 0.0f, 1.0f,
+		 0.5f,  0.5f, -0.5f, 0.0f, 1.0f, 0.0f,
+		 0.5f, -0.5f, -0.5f, 1.0f, 0.0f, 0.0f,
+		 0.5f, -0.5f, -0.5f, 1.0f, 1.0f, 0.0f,
+		 0.5f, -0.5f,  0.5f, 1.0f, 0.0f, 1.0f,
+		 0.5f,  0.5f,  0.5f, 0.0f, 1.0f, 1.0f,
+
+		-0.5f, -0.5f, -0.5f, 0.0f, 0.0f, 1.0f,
+		 0.5f, -0.5f, -0.5f, 0.0f, 1.0f, 0.0f,
+		 0.5f, -0.5f,  0.5f, 1.0f, 0.0f, 0.0f,
+		 0.5f, -0.5f,  0.5f, 1.0f, 1.0f, 0.0f,
+		-0.5f, -0.5f,  0.5f, 1.0f, 0.0f, 1.0f,
+		-0.5f, -0.5f, -0.5f, 0.0f, 1.0f, 1.0f,
+
+		-0.5f,  0.5f, -0.5f, 0.0f, 0.0f, 1.0f,
+		 0.5f,  0.5f, -0.5f, 0.0f, 1.0f, 0.0f,
+		 0.5f,  0.5f,  0.5f, 1.0f, 0.0f, 0.0f,
+		 0.5f,  0.5f,  0.5f, 1.0f, 1.0f, 0.0f,
+		-0.5f,  0.5f,  0.5f, 1.0f, 0.0f, 1.0f,
+		-0.5f,  0.5f, -0.5f, 0.0f, 1.0f, 1.0f,
+	};
+
+	mesh.vertices.assign(vertices, vertices + 36 * meshVertexFloats);
+	mesh.indices.resize(36);
+	for(unsigned int i = 0; i < 36; ++i)
+	{
+		mesh.indices[i] = i;
+	}
+
+	// Corners two faces give the same color come out shared, as loadObj leaves them
+	weldVertices(mesh);
+}
+
+bool writeMeshFile(const std::string &path, const MeshData &mesh)
+{
+	MeshHeader header;
+	memset(&header, 0, sizeof(header));
+	memcpy(header.magic, "MESH", 4);
+	header.version = meshFileVersion;
+	header.vertexCount = mesh.getVertexCount();
+	header.vertexStride = meshVertexFloats * sizeof(float);
+	header.indexCount = (unsigned int)mesh.indices.size();
+	header.vertexOffset = alignUp(sizeof(MeshHeader));
+	header.indexOffset = alignUp(header.vertexOffset + header.vertexCount * header.vertexStride);
+
+	for(unsigned int i = 0; i < 3; ++i)
+	{
+		header.boundsMin[i] = header.vertexCount > 0 ? mesh.vertices[i] : 0.0f;
+		header.boundsMax[i] = header.boundsMin[i];
+	}
+	for(unsigned int v = 1; v < header.vertexCount; ++v)
+	{
+		for(unsigned int i = 0; i < 3; ++i)
+		{
+			const float value = mesh.vertices[v * meshVertexFloats + i];
+			header.boundsMin[i] = value < header.boundsMin[i] ? value : header.boundsMin[i];
+			header.boundsMax[i] = value > header.boundsMax[i] ? value : header.boundsMax[i];
+		}
+	}
+
+	std::ofstream file(path.c_str(), std::ios::out | std::ios::binary);
+	if(!file)
+	{
+		printf("Could not create %s\n", path.c_str());
+		return false;
+	}
+
+	const char padding[blockAlignment] = { 0 };
+	file.write((const char*)&header, sizeof(header));
+	file.write(padding, header.vertexOffset - sizeof(header));
+	if(header.vertexCount > 0)
+	{
+		file.write((const char*)&mesh.vertices[0], header.vertexCount * header.vertexStride);
+	}
+	file.write(padding, header.indexOffset - (header.vertexOffset + header.vertexCount * header.vertexStride));
+	if(header.indexCount > 0)
+	{
+		file.write((const char*)&mesh.indices[0], header.indexCount * sizeof(unsigned int));
+	}
+
+	return file.good();
+}
+
+int convertObjToMesh(const std::string &objPath, const std::string &meshPath)
+{
+	const std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+
+	MeshData mesh;
+	if(!loadObj(objPath, mesh))
+	{
+		return 1;
+	}
+
+	// Ordered for the vertex cache, overdraw and vertex fetch once here rather than at every load
+	MeshCacheStats before, after;
+	optimizeMesh(mesh, &before, &after);
+
+	if(!writeMeshFile(meshPath, mesh))
+	{
+		return 1;
+	}
+
+	const double seconds = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count();
+	const unsigned int corners = (unsigned int)mesh.indices.size();
+	printf("%s: %u triangles, %u vertices after welding\n", meshPath.c_str(), corners / 3, mesh.getVertexCount());
+	printf("ACMR %.3f -> %.3f, ATVR %.3f -> %.3f, overfetch %.3f -> %.3f\n", before.acmr, after.acmr, before.atvr, after.atvr, before.overfetch, after.overfetch);
+	printf("%u bytes indexed, %u bytes as a plain vertex array, %.2f ms\n",
+		(unsigned int)(mesh.vertices.size() * sizeof(float) + corners * sizeof(unsigned int)),
+		(unsigned int)(corners * meshVertexFloats * sizeof(float)), seconds * 1000.0);
+	return 0;
+}
@@ -0,0 +1,563 @@
+/*
+	Name:			MeshOptimizer.cpp
+	Project:		OpenGL
+	Description:	CPU passes that weld, reorder and analyse indexed triangle lists before upload
+	Doc Version:	1.0
+	Author:			Jonathan Simon Jones
+	Date(D/M/Y):	16-10-2026
+	To do:
+*/
+
+#include "MeshOptimizer.h"
+#include "Mesh.h"
+
+// STL includes
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <unordered_map>
+#include <vector>
+
+namespace
+{
+	// Forsyth's scoring, the cache it models is bigger than the one analyzeMesh reports on
+	// so vertices are not given up on too early
+	const unsigned int scoringCacheSize = 32;
+	const float cacheDecayPower = 1.5f;
+	const float lastTriangleScore = 0.75f;
+	const float valenceBoostScale = 2.0f;
+	const float valenceBoostPower = 0.5f;
+
+	// Vertex fetch cache, 256 lines of 64 bytes mapped directly
+	const unsigned int fetchLineBytes = 64;
+	const unsigned int fetchLineCount = 256;
+
+	// Scores are looked up rather than calling pow for every vertex on every triangle
+	const unsigned int valenceTableSize = 32;
+
+	struct ScoreTables
+	{
+		float cache[scoringCacheSize];
+		float valence[valenceTableSize];
+
+		ScoreTables()
+		{
+			for(unsigned int i = 0; i < scoringCacheSize; ++i)
+			{
+				// The three vertices of the last triangle score the same whatever their order
+				const float scaler = 1.0f / (scoringCacheSize - 3);
+				cache[i] = i < 3 ? lastTriangleScore : std::pow(1.0f - (i - 3) * scaler, cacheDecayPower);
+			}
+
+			// Vertices with few triangles left get finished off so they leave the cache for good
+			valence[0] = 0.0f;
+			for(unsigned int i = 1; i < valenceTableSize; ++i)
+			{
+				valence[i] = valenceBoostScale * std::pow((float)i, -valenceBoostPower);
+			}
+		}
+	};
+
+	float vertexScore(const ScoreTables &tables, int cachePosition, unsigned int remainingTriangles)
+	{
+		if(remainingTriangles == 0)
+		{
+			return -1.0f;
+		}
+
+		const float valence = remainingTriangles < valenceTableSize ? tables.valence[remainingTriangles] :
+			valenceBoostScale * std::pow((float)remainingTriangles, -valenceBoostPower);
+		return (cachePosition >= 0 ? tables.cache[cachePosition] : 0.0f) + valence;
+	}
+
+	// One finished vertex, compared bit for bit when welding
+	struct VertexKey
+	{
+		const float *v;
+
+		bool operator==(const VertexKey &other) const { return memcmp(v, other.v, meshVertexFloats * sizeof(float)) == 0; }
+	};
+
+	struct VertexKeyHash
+	{
+		size_t operator()(const VertexKey &key) const
+		{
+			const unsigned char *bytes = (const unsigned char*)key.v;
+			size_t hash = (size_t)14695981039346656037ull;
+			for(unsigned int i = 0; i < meshVertexFloats * sizeof(float); ++i)
+			{
+				hash ^= bytes[i];
+				hash *= (size_t)1099511628211ull;
+			}
+			return hash;
+		}
+	};
+
+	// Triangles [first, first + count) of a list, sorted by how much they face away from the middle
+	struct Cluster
+	{
+		size_t first;
+		size_t count;
+		float sortKey;
+	};
+
+	bool clusterDrawsFirst(const Cluster &a, const Cluster &b)
+	{
+		return a.sortKey > b.sortKey;
+	}
+}
+
+MeshCacheStats analyzeMesh(const unsigned int *indices, size_t indexCount, unsigned int vertexCount, unsigned int vertexBytes, unsigned int cacheSize)
+{
+	MeshCacheStats stats;
+	if(indexCount == 0)
+	{
+		return stats;
+	}
+
+	// FIFO post transform cache, timestamps say when each vertex went in
+	std::vector<unsigned int> cachedAt(vertexCount, 0);
+	std::vector<bool> used(vertexCount, false);
+	unsigned int time = cacheSize + 1;
+	unsigned int transformed = 0;
+
+	std::vector<size_t> lineTags(fetchLineCount, (size_t)-1);
+	unsigned int linesFetched = 0;
+
+	for(size_t i = 0; i < indexCount; ++i)
+	{
+		const unsigned int vertex = indices[i];
+		used[vertex] = true;
+
+		if(time - cachedAt[vertex] > cacheSize)
+		{
+			cachedAt[vertex] = time++;
+			++transformed;
+
+			// Only a transformed vertex is fetched, a vertex may span two lines
+			const size_t firstLine = (size_t)vertex * vertexBytes / fetchLineBytes;
+			const size_t lastLine = ((size_t)vertex * vertexBytes + vertexBytes - 1) / fetchLineBytes;
+			for(size_t line = firstLine; line <= lastLine; ++line)
+			{
+				if(lineTags[line % fetchLineCount] != line)
+				{
+					lineTags[line % fetchLineCount] = line;
+					++linesFetched;
+				}
+			}
+		}
+	}
+
+	const unsigned int usedCount = (unsigned int)std::count(used.begin(), used.end(), true);
+	stats.acmr = transformed / (indexCount / 3.0f);
+	stats.atvr = transformed / (float)usedCount;
+	stats.overfetch = linesFetched * (float)fetchLineBytes / ((float)usedCount * vertexBytes);
+	return stats;
+}
+
+unsigned int weldVertices(MeshData &mesh)
+{
+	const unsigned int vertexCount = mesh.getVertexCount();
+	if(mesh.indices.empty())
+	{
+		mesh.indices.resize(vertexCount);
+		for(unsigned int i = 0; i < vertexCount; ++i)
+		{
+			mesh.indices[i] = i;
+		}
+	}
+
+	// Keys point into the old array, which stays alive until the remap is done
+	std::vector<float> oldVertices;
+	oldVertices.swap(mesh.vertices);
+	mesh.vertices.reserve(oldVertices.size());
+
+	std::unordered_map<VertexKey, unsigned int, VertexKeyHash> welded;
+	welded.reserve(vertexCount);
+	std::vector<unsigned int> remap(vertexCount);
+	for(unsigned int i = 0; i < vertexCount; ++i)
+	{
+		const VertexKey key = { &oldVertices[i * meshVertexFloats] };
+		std::pair<std::unordered_map<VertexKey, unsigned int, VertexKeyHash>::iterator, bool> found = welded.insert(std::make_pair(key, mesh.getVertexCount()));
+		if(found.second)
+		{
+			mesh.vertices.insert(mesh.vertices.end(), key.v, key.v + meshVertexFloats);
+		}
+		remap[i] = found.first->second;
+	}
+
+	// Welding can collapse a triangle to a line, those are dropped
+	size_t kept = 0;
+	for(size_t i = 0; i + 2 < mesh.indices.size(); i += 3)
+	{
+		const unsigned int a = remap[mesh.indices[i]];
+		const unsigned int b = remap[mesh.indices[i + 1]];
+		const unsigned int c = remap[mesh.indices[i + 2]];
+		if(a != b && a != c && b != c)
+		{
+			mesh.indices[kept++] = a;
+			mesh.indices[kept++] = b;
+			mesh.indices[kept++] = c;
+		}
+	}
+	mesh.indices.resize(kept);
+
+	return vertexCount - mesh.getVertexCount();
+}
+
+void optimizeVertexCache(unsigned int *indices, size_t indexCount, unsigned int vertexCount)
+{
+	const size_t triangleCount = indexCount / 3;
+	if(triangleCount == 0)
+	{
+		return;
+	}
+
+	// Triangles using each vertex, packed into one array
+	std::vector<unsigned int> remaining(vertexCount, 0);
+	for(size_t i = 0; i < triangleCount * 3; ++i)
+	{
+		++remaining[indices[i]];
+	}
+
+	std::vector<unsigned int> firstTriangle(vertexCount + 1, 0);
+	for(unsigned int v = 0; v < vertexCount; ++v)
+	{
+		firstTriangle[v + 1] = firstTriangle[v] + remaining[v];
+	}
+
+	std::vector<unsigned int> adjacency(triangleCount * 3);
+	std::vector<unsigned int> filled(firstTriangle.begin(), firstTriangle.end() - 1);
+	for(size_t t = 0; t < triangleCount; ++t)
+	{
+		for(unsigned int k = 0; k < 3; ++k)
+		{
+			const unsigned int vertex = indices[t * 3 + k];
+			adjacency[filled[vertex]++] = (unsigned int)t;
+		}
+	}
+
+	const ScoreTables tables;
+	std::vector<int> cachePosition(vertexCount, -1);
+	std::vector<float> score(vertexCount);
+	for(unsigned int v = 0; v < vertexCount; ++v)
+	{
+		score[v] = vertexScore(tables, -1, remaining[v]);
+	}
+
+	std::vector<float> triangleScore(triangleCount);
+	for(size_t t = 0; t < triangleCount; ++t)
+	{
+		triangleScore[t] = score[indices[t * 3]] + score[indices[t * 3 + 1]] + score[indices[t * 3 + 2]];
+	}
+
+	std::vector<bool> emitted(triangleCount, false);
+	std::vector<unsigned int> output;
+	output.reserve(triangleCount * 3);
+
+	// The cache holds three more than it scores so the newest triangle always fits
+	std::vector<unsigned int> cache;
+	std::vector<unsigned int> nextCache;
+	cache.reserve(scoringCacheSize + 3);
+	nextCache.reserve(scoringCacheSize + 3);
+
+	size_t bestTriangle = 0;
+	for(size_t t = 1; t < triangleCount; ++t)
+	{
+		if(triangleScore[t] > triangleScore[bestTriangle])
+		{
+			bestTriangle = t;
+		}
+	}
+
+	// When no cached vertex has triangles left the next start is found by scanning forwards
+	size_t scanCursor = 0;
+
+	for(size_t emittedCount = 0; emittedCount < triangleCount; ++emittedCount)
+	{
+		if(bestTriangle == (size_t)-1)
+		{
+			while(emitted[scanCursor])
+			{
+				++scanCursor;
+			}
+			bestTriangle = scanCursor;
+		}
+
+		const unsigned int *corners = &indices[bestTriangle * 3];
+		emitted[bestTriangle] = true;
+		output.insert(output.end(), corners, corners + 3);
+
+		// The triangle's vertices go to the front, the rest shuffle back
+		nextCache.assign(corners, corners + 3);
+		for(unsigned int k = 0; k < 3; ++k)
+		{
+			const unsigned int vertex = corners[k];
+			--remaining[vertex];
+
+			// Drop the finished triangle from the vertex's list
+			unsigned int *list = &adjacency[firstTriangle[vertex]];
+			const unsigned int count = remaining[vertex] + 1;
+			for(unsigned int j = 0; j < count; ++j)
+			{
+				if(list[j] == bestTriangle)
+				{
+					list[j] = list[count - 1];
+					break;
+				}
+			}
+		}
+		for(unsigned int i = 0; i < cache.size(); ++i)
+		{
+			const unsigned int vertex = cache[i];
+			if(vertex != corners[0] && vertex != corners[1] && vertex != corners[2])
+			{
+				nextCache.push_back(vertex);
+			}
+		}
+
+		// Rescore everything that was or is in the cache, then the triangles around it
+		for(unsigned int i = 0; i < nextCache.size(); ++i)
+		{
+			const unsigned int vertex = nextCache[i];
+			cachePosition[vertex] = i < scoringCacheSize ? (int)i : -1;
+			const float newScore = vertexScore(tables, cachePosition[vertex], remaining[vertex]);
+			const float change = newScore - score[vertex];
+			score[vertex] = newScore;
+
+			const unsigned int *list = &adjacency[firstTriangle[vertex]];
+			for(unsigned int j = 0; j < remaining[vertex]; ++j)
+			{
+				triangleScore[list[j]] += change;
+			}
+		}
+
+		bestTriangle = (size_t)-1;
+		float bestScore = -1.0f;
+		for(unsigned int i = 0; i < nextCache.size() && i < scoringCacheSize; ++i)
+		{
+			const unsigned int vertex = nextCache[i];
+			const unsigned int *list = &adjacency[firstTriangle[vertex]];
+			for(unsigned int j = 0; j < remaining[vertex]; ++j)
+			{
+				if(triangleScore[list[j]] > bestScore)
+				{
+					bestScore = triangleScore[list[j]];
+					bestTriangle = list[j];
+				}
+			}
+		}
+
+		if(nextCache.size() > scoringCacheSize)
+		{
+			nextCache.resize(scoringCacheSize);
+		}
+		cache.swap(nextCache);
+	}
+
+	std::copy(output.begin(), output.end(), indices);
+}
+
+void optimizeOverdraw(unsigned int *indices, size_t indexCount, const float *vertices, unsigned int vertexCount, unsigned int vertexFloats, float threshold)
+{
+	const size_t triangleCount = indexCount / 3;
+	if(triangleCount < 2)
+	{
+		return;
+	}
+
+	const unsigned int vertexBytes = vertexFloats * sizeof(float);
+	const float oldAcmr = analyzeMesh(indices, indexCount, vertexCount, vertexBytes).acmr;
+
+	// A new cluster starts wherever a triangle misses the cache on all three corners,
+	// reordering at those points costs the cache next to nothing
+	std::vector<Cluster> clusters;
+	std::vector<unsigned int> cachedAt(vertexCount, 0);
+	unsigned int time = defaultVertexCacheSize + 1;
+	for(size_t t = 0; t < triangleCount; ++t)
+	{
+		unsigned int misses = 0;
+		for(unsigned int k = 0; k < 3; ++k)
+		{
+			const unsigned int vertex = indices[t * 3 + k];
+			if(time - cachedAt[vertex] > defaultVertexCacheSize)
+			{
+				cachedAt[vertex] = time++;
+				++misses;
+			}
+		}
+
+		if(misses == 3 || clusters.empty())
+		{
+			Cluster cluster = { t, 0, 0.0f };
+			clusters.push_back(cluster);
+		}
+		++clusters.back().count;
+	}
+
+	if(clusters.size() < 2)
+	{
+		return;
+	}
+
+	// Area weighted centre and facing of each cluster, and the centre of the whole mesh
+	std::vector<float> centres(clusters.size() * 3, 0.0f);
+	std::vector<float> normals(clusters.size() * 3, 0.0f);
+	std::vector<float> areas(clusters.size(), 0.0f);
+	float meshCentre[3] = { 0.0f, 0.0f, 0.0f };
+	float meshArea = 0.0f;
+
+	for(size_t c = 0; c < clusters.size(); ++c)
+	{
+		for(size_t t = clusters[c].first; t < clusters[c].first + clusters[c].count; ++t)
+		{
+			const float *a = &vertices[indices[t * 3] * vertexFloats];
+			const float *b = &vertices[indices[t * 3 + 1] * vertexFloats];
+			const float *p = &vertices[indices[t * 3 + 2] * vertexFloats];
+
+			const float ab[3] = { b[0] - a[0], b[1] - a[1], b[2] - a[2] };
+			const float ac[3] = { p[0] - a[0], p[1] - a[1], p[2] - a[2] };
+			const float normal[3] = { ab[1] * ac[2] - ab[2] * ac[1], ab[2] * ac[0] - ab[0] * ac[2], ab[0] * ac[1] - ab[1] * ac[0] };
+			const float area = std::sqrt(normal[0] * normal[0] + normal[1] * normal[1] + normal[2] * normal[2]);
+
+			for(unsigned int i = 0; i < 3; ++i)
+			{
+				const float centre = (a[i] + b[i] + p[i]) / 3.0f;
+				centres[c * 3 + i] += centre * area;
+				normals[c * 3 + i] += normal[i];
+				meshCentre[i] += centre * area;
+			}
+			areas[c] += area;
+			meshArea += area;
+		}
+	}
+
+	if(meshArea <= 0.0f)
+	{
+		return;
+	}
+
+	for(unsigned int i = 0; i < 3; ++i)
+	{
+		meshCentre[i] /= meshArea;
+	}
+
+	for(size_t c = 0; c < clusters.size(); ++c)
+	{
+		const float *normal = &normals[c * 3];
+		const float length = std::sqrt(normal[0] * normal[0] + normal[1] * normal[1] + normal[2] * normal[2]);
+		if(areas[c] <= 0.0f || length <= 0.0f)
+		{
+			continue;
+		}
+
+		float key = 0.0f;
+		for(unsigned int i = 0; i < 3; ++i)
+		{
+			key += (centres[c * 3 + i] / areas[c] - meshCentre[i]) * normal[i] / length;
+		}
+		clusters[c].sortKey = key;
+	}
+
+	std::stable_sort(clusters.begin(), clusters.end(), clusterDrawsFirst);
+
+	std::vector<unsigned int> sorted;
+	sorted.reserve(triangleCount * 3);
+	for(size_t c = 0; c < clusters.size(); ++c)
+	{
+		sorted.insert(sorted.end(), indices + clusters[c].first * 3, indices + (clusters[c].first + clusters[c].count) * 3);
+	}
+
+	const float newAcmr = analyzeMesh(&sorted[0], sorted.size(), vertexCount, vertexBytes).acmr;
+	if(newAcmr <= oldAcmr * threshold)
+	{
+		std::copy(sorted.begin(), sorted.end(), indices);
+	}
+}
+
+void optimizeVertexFetch(MeshData &mesh)
+{
+	const unsigned int vertexCount = mesh.getVertexCount();
+	const unsigned int vertexBytes = meshVertexFloats * sizeof(float);
+	const unsigned int unused = 0xffffffff;
+	if(mesh.indices.empty())
+	{
+		mesh.vertices.clear();
+		return;
+	}
+
+	// Vertices numbered in the order the triangles first use them
+	std::vector<unsigned int> firstUse(vertexCount, unused);
+	unsigned int usedCount = 0;
+	for(size_t i = 0; i < mesh.indices.size(); ++i)
+	{
+		if(firstUse[mesh.indices[i]] == unused)
+		{
+			firstUse[mesh.indices[i]] = usedCount++;
+		}
+	}
+
+	// And in the order they are in already, less the unused ones
+	std::vector<unsigned int> kept(vertexCount, unused);
+	for(unsigned int vertex = 0, next = 0; vertex < vertexCount; ++vertex)
+	{
+		if(firstUse[vertex] != unused)
+		{
+			kept[vertex] = next++;
+		}
+	}
+
+	// First use order walks the buffer forwards, but where the cache order goes back and
+	// forth between two rows of a grid it interleaves them and each row reads the other's
+	// lines as well. Whichever order the fetch cache model reads fewer lines for is kept.
+	std::vector<unsigned int> indices(mesh.indices.size());
+	for(size_t i = 0; i < indices.size(); ++i)
+	{
+		indices[i] = firstUse[mesh.indices[i]];
+	}
+	const float firstUseOverfetch = analyzeMesh(&indices[0], indices.size(), usedCount, vertexBytes).overfetch;
+	for(size_t i = 0; i < indices.size(); ++i)
+	{
+		indices[i] = kept[mesh.indices[i]];
+	}
+	const float keptOverfetch = analyzeMesh(&indices[0], indices.size(), usedCount, vertexBytes).overfetch;
+	const std::vector<unsigned int> &remap = firstUseOverfetch < keptOverfetch ? firstUse : kept;
+
+	std::vector<float> vertices(usedCount * meshVertexFloats);
+	for(unsigned int vertex = 0; vertex < vertexCount; ++vertex)
+	{
+		if(remap[vertex] != unused)
+		{
+			std::copy(&mesh.vertices[vertex * meshVertexFloats], &mesh.vertices[vertex * meshVertexFloats] + meshVertexFloats, &vertices[remap[vertex] * meshVertexFloats]);
+		}
+	}
+	for(size_t i = 0; i < mesh.indices.size(); ++i)
+	{
+		mesh.indices[i] = remap[mesh.indices[i]];
+	}
+
+	mesh.vertices.swap(vertices);
+}
+
+void optimizeMesh(MeshData &mesh, MeshCacheStats *before, MeshCacheStats *after)
+{
+	const unsigned int vertexBytes = meshVertexFloats * sizeof(float);
+	weldVertices(mesh);
+
+	if(before)
+	{
+		*before = mesh.indices.empty() ? MeshCacheStats() : analyzeMesh(&mesh.indices[0], mesh.indices.size(), mesh.getVertexCount(), vertexBytes);
+	}
+
+	if(!mesh.indices.empty())
+	{
+		optimizeVertexCache(&mesh.indices[0], mesh.indices.size(), mesh.getVertexCount());
+		optimizeOverdraw(&mesh.indices[0], mesh.indices.size(), &mesh.vertices[0], mesh.getVertexCount(), meshVertexFloats);
+		optimizeVertexFetch(mesh);
+	}
+
+	if(after)
+	{
+		*after = mesh.indices.empty() ? MeshCacheStats() : analyzeMesh(&mesh.indices[0], mesh.indices.size(), mesh.getVertexCount(), vertexBytes);
+	}
+}
@@ -0,0 +1,533 @@
+/*
+	Name:			Narrowphase.cpp
+	Project:		OpenGL
+	Description:	Separating axis tests between oriented boxes and the contact manifolds they produce
+	Doc Version:	1.0
+	Author:			Jonathan Simon Jones
+	Date(D/M/Y):	16-10-2026
+	To do:
+*/
+
+#include "Narrowphase.h"
+#include "Profiler.h"
+#include "ThreadPool.h"
+
+// Math includes
+#include <glm/gtc/quaternion.hpp>
+
+// STL includes
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+	// Pairs a job tests, enough that queueing it costs little next to the tests
+	const unsigned int pairBatch = 256;
+
+	// Keeps near parallel edges from producing a cross product of nothing
+	const float parallelEpsilon = 1e-6f;
+
+	// An axis has to beat the one before it in the preference order by this much to win,
+	// so resting contacts do not flip between a face and an edge from frame to frame
+	const float relativeTolerance = 0.95f;
+	const float absoluteTolerance = 0.01f;
+
+	// Frame of the pair worked out once and shared by every axis test
+	struct SatFrame
+	{
+		float r[3][3];						// r[i][j] = dot(a axis i, b axis j)
+		float absR[3][3];
+		float t[3];							// b's center less a's in a's frame
+		float tb[3];						// The same in b's frame
+	};
+
+	void buildFrame(const OrientedBox &a, const OrientedBox &b, SatFrame &frame)
+	{
+		const glm::vec3 d = b.center - a.center;
+		for(unsigned int i = 0; i < 3; ++i)
+		{
+			for(unsigned int j = 0; j < 3; ++j)
+			{
+				frame.r[i][j] = glm::dot(a.axes[i], b.axes[j]);
+				frame.absR[i][j] = std::fabs(frame.r[i][j]) + parallelEpsilon;
+			}
+			frame.t[i] = glm::dot(d, a.axes[i]);
+			frame.tb[i] = glm::dot(d, b.axes[i]);
+		}
+	}
+
+	// Gap between the boxes along axis, negative when they overlap on it. Edge axes are
+	// scaled to unit length, near parallel edges report -infinity as the faces cover them.
+	float axisSeparation(const OrientedBox &a, const OrientedBox &b, const SatFrame &f, int axis)
+	{
+		const glm::vec3 &ea = a.halfExtents;
+		const glm::vec3 &eb = b.halfExtents;
+
+		if(axis < 3)
+		{
+			const int i = axis;
+			return std::fabs(f.t[i]) - (ea[i] + eb[0] * f.absR[i][0] + eb[1] * f.absR[i][1] + eb[2] * f.absR[i][2]);
+		}
+
+		if(axis < 6)
+		{
+			const int j = axis - 3;
+			return std::fabs(f.tb[j]) - (ea[0] * f.absR[0][j] + ea[1] * f.absR[1][j] + ea[2] * f.absR[2][j] + eb[j]);
+		}
+
+		const int i = (axis - 6) / 3;
+		const int j = (axis - 6) % 3;
+		const int i1 = (i + 1) % 3, i2 = (i + 2) % 3;
+		const int j1 = (j + 1) % 3, j2 = (j + 2) % 3;
+
+		const float length = std::sqrt(std::max(0.0f, 1.0f - f.r[i][j] * f.r[i][j]));
+		if(length < 1e-5f)
+		{
+			return -HUGE_VALF;
+		}
+
+		const float ra = ea[i1] * f.absR[i2][j] + ea[i2] * f.absR[i1][j];
+		const float rb = eb[j1] * f.absR[i][j2] + eb[j2] * f.absR[i][j1];
+		const float distance = std::fabs(f.t[i2] * f.r[i1][j] - f.t[i1] * f.r[i2][j]);
+		return (distance - (ra + rb)) / length;
+	}
+
+	// Gap along one world axis straight from the boxes, cheaper than building the whole
+	// frame when only last frame's separating axis is wanted
+	float worldAxisSeparation(const OrientedBox &a, const OrientedBox &b, const glm::vec3 &axis)
+	{
+		// Padded like absR so a pair never counts as apart here and touching in the frame
+		float reach = 0.0f;
+		for(unsigned int k = 0; k < 3; ++k)
+		{
+			reach += a.halfExtents[k] * (std::fabs(glm::dot(a.axes[k], axis)) + parallelEpsilon);
+			reach += b.halfExtents[k] * (std::fabs(glm::dot(b.axes[k], axis)) + parallelEpsilon);
+		}
+		return std::fabs(glm::dot(b.center - a.center, axis)) - reach;
+	}
+
+	// Keeps the part of polygon on the side of the plane where dot(normal, p) <= offset
+	unsigned int clipPolygon(const glm::vec3 in[], unsigned int count, const glm::vec3 &normal, float offset, glm::vec3 out[])
+	{
+		unsigned int written = 0;
+		for(unsigned int i = 0; i < count; ++i)
+		{
+			const glm::vec3 &from = in[i];
+			const glm::vec3 &to = in[(i + 1) % count];
+			const float fromDistance = glm::dot(normal, from) - offset;
+			const float toDistance = glm::dot(normal, to) - offset;
+
+			if(fromDistance <= 0.0f)
+			{
+				out[written++] = from;
+			}
+
+			if((fromDistance < 0.0f && toDistance > 0.0f) || (fromDistance > 0.0f && toDistance < 0.0f))
+			{
+				out[written++] = from + (to - from) * (fromDistance / (fromDistance - toDistance));
+			}
+		}
+
+		return written;
+	}
+
+	// Deepest point first, then the one farthest from it, then the two that add the most
+	// area on either side of the line between them
+	void reducePoints(const glm::vec3 points[], const float depths[], unsigned int count, const glm::vec3 &normal, ContactManifold &manifold)
+	{
+		if(count <= maxManifoldPoints)
+		{
+			for(unsigned int i = 0; i < count; ++i)
+			{
+				manifold.points[i] = points[i];
+				manifold.depths[i] = depths[i];
+			}
+			manifold.pointCount = count;
+			return;
+		}
+
+		unsigned int chosen[maxManifoldPoints] = { 0, 0, 0, 0 };
+		for(unsigned int i = 1; i < count; ++i)
+		{
+			chosen[0] = depths[i] > depths[chosen[0]] ? i : chosen[0];
+		}
+
+		float best = -1.0f;
+		for(unsigned int i = 0; i < count; ++i)
+		{
+			const glm::vec3 offset = points[i] - points[chosen[0]];
+			if(glm::dot(offset, offset) > best)
+			{
+				best = glm::dot(offset, offset);
+				chosen[1] = i;
+			}
+		}
+
+		float most = 0.0f, least = 0.0f;
+		chosen[2] = chosen[0];
+		chosen[3] = chosen[1];
+		const glm::vec3 line = points[chosen[1]] - points[chosen[0]];
+		for(unsigned int i = 0; i < count; ++i)
+		{
+			const float area = glm::dot(glm::cross(line, points[i] - points[chosen[0]]), normal);
+			if(area > most)
+			{
+				most = area;
+				chosen[2] = i;
+			}
+			if(area < least)
+			{
+				least = area;
+				chosen[3] = i;
+			}
+		}
+
+		manifold.pointCount = 0;
+		for(unsigned int c = 0; c < maxManifoldPoints; ++c)
+		{
+			// Dropped when there was nothing on that side
+			bool repeated = false;
+			for(unsigned int k = 0; k < c; ++k)
+			{
+				repeated |= chosen[k] == chosen[c];
+			}
+
+			if(!repeated)
+			{
+				manifold.points[manifold.pointCount] = points[chosen[c]];
+				manifold.depths[manifold.pointCount] = depths[chosen[c]];
+				++manifold.pointCount;
+			}
+		}
+	}
+
+	// Face of the reference box against the face of the incident box that points most
+	// against it, the incident face clipped to the sides of the reference face. Returns
+	// false if no clipped point reaches below the reference face, which happens when two
+	// edges cross while a face axis is still the shallowest.
+	bool faceContact(const OrientedBox &reference, const OrientedBox &incident, int face, const glm::vec3 &referenceNormal, ContactManifold &manifold)
+	{
+		unsigned int incidentAxis = 0;
+		float mostAligned = -1.0f;
+		for(unsigned int m = 0; m < 3; ++m)
+		{
+			const float alignment = std::fabs(glm::dot(referenceNormal, incident.axes[m]));
+			if(alignment > mostAligned)
+			{
+				mostAligned = alignment;
+				incidentAxis = m;
+			}
+		}
+
+		// Clipped relative to the reference box so far from the origin the small distances
+		// to its faces are not lost in the rounding of the positions
+		const float facing = glm::dot(referenceNormal, incident.axes[incidentAxis]) > 0.0f ? -1.0f : 1.0f;
+		const glm::vec3 faceCenter = incident.center - reference.center + incident.axes[incidentAxis] * (facing * incident.halfExtents[incidentAxis]);
+		const glm::vec3 u = incident.axes[(incidentAxis + 1) % 3] * incident.halfExtents[(incidentAxis + 1) % 3];
+		const glm::vec3 v = incident.axes[(incidentAxis + 2) % 3] * incident.halfExtents[(incidentAxis + 2) % 3];
+
+		// Each clip can add a corner, 4 sides take a quad to at most 8
+		glm::vec3 polygon[8] = { faceCenter + u + v, faceCenter - u + v, faceCenter - u - v, faceCenter + u - v };
+		glm::vec3 clipped[8];
+		unsigned int count = 4;
+		for(unsigned int side = 1; side < 3 && count > 0; ++side)
+		{
+			const unsigned int k = (face + side) % 3;
+			count = clipPolygon(polygon, count, reference.axes[k], reference.halfExtents[k], clipped);
+			count = clipPolygon(clipped, count, -reference.axes[k], reference.halfExtents[k], polygon);
+		}
+
+		// Only the points below the reference face or just off it are touching
+		glm::vec3 points[8];
+		float depths[8];
+		unsigned int touching = 0;
+		unsigned int below = 0;
+		for(unsigned int i = 0; i < count; ++i)
+		{
+			const float separation = glm::dot(referenceNormal, polygon[i]) - reference.halfExtents[face];
+			below += separation <= 0.0f ? 1 : 0;
+			if(separation <= contactMargin)
+			{
+				points[touching] = reference.center + polygon[i] - referenceNormal * (0.5f * separation);
+				depths[touching] = -separation;
+				++touching;
+			}
+		}
+
+		if(below == 0)
+		{
+			return false;
+		}
+
+		reducePoints(points, depths, touching, manifold.normal, manifold);
+		return true;
+	}
+
+	// Closest points of the two edges that made the axis, one contact halfway between them.
+	// normal is the edge axis pointing from a to b.
+	void edgeContact(const OrientedBox &a, const OrientedBox &b, int axis, const glm::vec3 &normal, float depth, ContactManifold &manifold)
+	{
+		const int i = (axis - 6) / 3;
+		const int j = (axis - 6) % 3;
+
+		// The edge of a nearest b and the edge of b nearest a
+		glm::vec3 onA = a.center;
+		glm::vec3 onB = b.center;
+		for(int k = 0; k < 3; ++k)
+		{
+			if(k != i)
+			{
+				onA += a.axes[k] * (glm::dot(normal, a.axes[k]) > 0.0f ? a.halfExtents[k] : -a.halfExtents[k]);
+			}
+			if(k != j)
+			{
+				onB += b.axes[k] * (glm::dot(normal, b.axes[k]) > 0.0f ? -b.halfExtents[k] : b.halfExtents[k]);
+			}
+		}
+
+		const glm::vec3 &u = a.axes[i];
+		const glm::vec3 &v = b.axes[j];
+		const glm::vec3 r = onA - onB;
+		const float uv = glm::dot(u, v);
+		const float ur = glm::dot(u, r);
+		const float vr = glm::dot(v, r);
+		const float denominator = std::max(1.0f - uv * uv, parallelEpsilon);
+
+		const float s = glm::clamp((uv * vr - ur) / denominator, -a.halfExtents[i], a.halfExtents[i]);
+		const float t = glm::clamp(vr + s * uv, -b.halfExtents[j], b.halfExtents[j]);
+
+		manifold.points[0] = ((onA + u * s) + (onB + v * t)) * 0.5f;
+		manifold.depths[0] = depth;
+		manifold.pointCount = 1;
+	}
+}
+
+OrientedBox getOrientedBox(const OrientedBoxSoA &boxes, unsigned int index)
+{
+	const glm::mat3 rotation = glm::mat3_cast(glm::fquat(boxes.qw[index], boxes.qx[index], boxes.qy[index], boxes.qz[index]));
+
+	OrientedBox box;
+	box.center = glm::vec3(boxes.px[index], boxes.py[index], boxes.pz[index]);
+	box.axes[0] = rotation[0];
+	box.axes[1] = rotation[1];
+	box.axes[2] = rotation[2];
+	box.halfExtents = glm::vec3(boxes.hx[index], boxes.hy[index], boxes.hz[index]);
+	return box;
+}
+
+glm::vec3 getSatAxis(const OrientedBox &a, const OrientedBox &b, int axis)
+{
+	if(axis < 3)
+	{
+		return a.axes[axis];
+	}
+
+	if(axis < 6)
+	{
+		return b.axes[axis - 3];
+	}
+
+	const glm::vec3 edge = glm::cross(a.axes[(axis - 6) / 3], b.axes[(axis - 6) % 3]);
+	const float length = glm::length(edge);
+	return length > 1e-5f ? edge / length : a.axes[0];
+}
+
+bool collideOBBOBB(const OrientedBox &a, const OrientedBox &b, int &axis, ContactManifold *manifold)
+{
+	// Boxes that were apart last frame are usually still apart along the same axis
+	if(axis != noSeparatingAxis && worldAxisSeparation(a, b, getSatAxis(a, b, axis)) > 0.0f)
+	{
+		return false;
+	}
+
+	SatFrame frame;
+	buildFrame(a, b, frame);
+
+	// Face axes first, they separate most pairs and are the cheapest. Every axis is
+	// tested in turn and the first gap ends it.
+	int bestFace = 0;
+	float bestFaceSeparation = -HUGE_VALF;
+	for(int face = 0; face < 6; ++face)
+	{
+		const float separation = axisSeparation(a, b, frame, face);
+		if(separation > 0.0f)
+		{
+			axis = face;
+			return false;
+		}
+
+		// b's faces have to do clearly better than a's so the reference stays put
+		const bool better = face < 3 ? separation > bestFaceSeparation : separation > relativeTolerance * bestFaceSeparation + absoluteTolerance;
+		if(better)
+		{
+			bestFaceSeparation = separation;
+			bestFace = face;
+		}
+	}
+
+	int bestEdge = noSeparatingAxis;
+	float bestEdgeSeparation = -HUGE_VALF;
+	for(int edge = 6; edge < satAxisCount; ++edge)
+	{
+		const float separation = axisSeparation(a, b, frame, edge);
+		if(separation > 0.0f)
+		{
+			axis = edge;
+			return false;
+		}
+
+		if(separation > bestEdgeSeparation)
+		{
+			bestEdgeSeparation = separation;
+			bestEdge = edge;
+		}
+	}
+
+	// Edge contacts only win when they are clearly shallower than every face
+	const bool useEdge = bestEdge != noSeparatingAxis && bestEdgeSeparation > relativeTolerance * bestFaceSeparation + absoluteTolerance;
+	axis = useEdge ? bestEdge : bestFace;
+
+	if(!manifold)
+	{
+		return true;
+	}
+
+	// Normal from a towards b
+	glm::vec3 normal = getSatAxis(a, b, axis);
+	if(glm::dot(normal, b.center - a.center) < 0.0f)
+	{
+		normal = -normal;
+	}
+
+	manifold->normal = normal;
+	manifold->axis = axis;
+	if(useEdge)
+	{
+		edgeContact(a, b, axis, normal, -bestEdgeSeparation, *manifold);
+		return true;
+	}
+
+	const bool faceTouches = axis < 3 ? faceContact(a, b, axis, normal, *manifold) : faceContact(b, a, axis - 3, -normal, *manifold);
+	if(!faceTouches)
+	{
+		// The face keeps the normal and depth, the crossing edges give the point
+		int edge = bestEdge;
+		if(edge == noSeparatingAxis)
+		{
+			edge = 6;
+		}
+
+		glm::vec3 edgeNormal = getSatAxis(a, b, edge);
+		if(glm::dot(edgeNormal, b.center - a.center) < 0.0f)
+		{
+			edgeNormal = -edgeNormal;
+		}
+		edgeContact(a, b, edge, edgeNormal, -bestFaceSeparation, *manifold);
+	}
+
+	return true;
+}
+
+Narrowphase::Narrowphase(ThreadPool *pool, unsigned int manifoldCapacity): m_pool(pool)
+, m_manifolds(manifoldCapacity)
+, m_manifoldCount(0)
+{
+}
+
+unsigned int Narrowphase::collide(const OrientedBoxSoA &boxes, const BroadphasePair pairs[], unsigned int pairCount)
+{
+	PROFILE_ZONE("Narrowphase");
+
+	m_stats = NarrowphaseStats();
+	m_stats.pairsTested = pairCount;
+	m_manifoldCount = 0;
+
+	// Every pair could touch, grows by doubling so a steady scene stops allocating
+	if(m_manifolds.size() < pairCount)
+	{
+		m_manifolds.resize(std::max((size_t)pairCount, m_manifolds.size() * 2));
+	}
+
+	const unsigned int batchCount = (pairCount + pairBatch - 1) / pairBatch;
+	m_batchManifolds.resize(batchCount);
+	m_batchStats.resize(batchCount);
+	if(m_pool)
+	{
+		m_pool->parallelFor(batchCount, 1, [this, &boxes, pairs, pairCount](unsigned int begin, unsigned int end)
+		{
+			PROFILE_ZONE("Narrowphase chunk");
+			for(unsigned int batch = begin; batch < end; ++batch)
+			{
+				collideBatch(boxes, pairs, pairCount, batch);
+			}
+		});
+	}
+	else
+	{
+		for(unsigned int batch = 0; batch < batchCount; ++batch)
+		{
+			collideBatch(boxes, pairs, pairCount, batch);
+		}
+	}
+
+	// Batches in order, so the manifolds come out in pair order whatever ran them
+	for(unsigned int batch = 0; batch < batchCount; ++batch)
+	{
+		const NarrowphaseStats &stats = m_batchStats[batch];
+		m_stats.separated += stats.separated;
+		m_stats.points += stats.points;
+
+		const unsigned int first = batch * pairBatch;
+		if(first != m_manifoldCount)
+		{
+			std::copy(m_manifolds.begin() + first, m_manifolds.begin() + first + m_batchManifolds[batch], m_manifolds.begin() + m_manifoldCount);
+		}
+		m_manifoldCount += m_batchManifolds[batch];
+	}
+
+	m_stats.manifolds = m_manifoldCount;
+	return m_manifoldCount;
+}
+
+void Narrowphase::collideBatch(const OrientedBoxSoA &boxes, const BroadphasePair pairs[], unsigned int pairCount, unsigned int batch)
+{
+	const unsigned int first = batch * pairBatch;
+	const unsigned int end = std::min(first + pairBatch, pairCount);
+	NarrowphaseStats stats;
+	unsigned int written = 0;
+
+	for(unsigned int p = first; p < end; ++p)
+	{
+		const BroadphasePair &pair = pairs[p];
+		int axis = noSeparatingAxis;
+
+		ContactManifold &manifold = m_manifolds[first + written];
+		if(collideOBBOBB(getOrientedBox(boxes, pair.a), getOrientedBox(boxes, pair.b), axis, &manifold))
+		{
+			manifold.a = pair.a;
+			manifold.b = pair.b;
+			stats.points += manifold.pointCount;
+			++written;
+		}
+		else
+		{
+			++stats.separated;
+		}
+	}
+
+	m_batchManifolds[batch] = written;
+	m_batchStats[batch] = stats;
+}
+
+const ContactManifold* Narrowphase::findManifold(unsigned int a, unsigned int b) const
+{
+	for(unsigned int i = 0; i < m_manifoldCount; ++i)
+	{
+		if(m_manifolds[i].a == a && m_manifolds[i].b == b)
+		{
+			return &m_manifolds[i];
+		}
+	}
+
+	return 0;
+}
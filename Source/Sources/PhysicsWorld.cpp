@@ -0,0 +1,371 @@
+/*
+	Name:			PhysicsWorld.cpp
+	Project:		OpenGL
+	Description:	Rigid body store kept as structure of arrays and a fixed timestep integrator
+	Doc Version:	1.0
+	Author:			Jonathan Simon Jones
+	Date(D/M/Y):	16-10-2026
+	To do:
+*/
+
+#include "PhysicsWorld.h"
+#include "Profiler.h"
+#include "ContactSolver.h"
+#include "ContinuousCollision.h"
+#include "ThreadPool.h"
+#include "Simd.h"
+
+// STL includes
+#include <algorithm>
+
+namespace
+{
+	// Bodies per chunk handed to a thread, a multiple of the SIMD width
+	const unsigned int integrateGrain = 4096;
+
+	// Runs task over every range, ranges are grouped so a chunk still holds about
+	// integrateGrain bodies however the awake ones are spread
+	template<class Task>
+	void forEachRange(ThreadPool *pool, const std::vector<BodyRange> &ranges, unsigned int bodyCount, const Task &task)
+	{
+		const unsigned int count = (unsigned int)ranges.size();
+		if(!pool)
+		{
+			for(unsigned int i = 0; i < count; ++i)
+			{
+				task(ranges[i].begin, ranges[i].end);
+			}
+			return;
+		}
+
+		const unsigned int grain = std::max(1u, (unsigned int)((unsigned long long)count * integrateGrain / std::max(bodyCount, 1u)));
+		pool->parallelFor(count, grain, [&ranges, &task](unsigned int first, unsigned int last)
+		{
+			PROFILE_ZONE("Integrate chunk");
+			for(unsigned int i = first; i < last; ++i)
+			{
+				task(ranges[i].begin, ranges[i].end);
+			}
+		});
+	}
+}
+
+PhysicsWorld::PhysicsWorld(float fixedDt, ThreadPool *pool): m_gravity(0.0f, 0.0f, -1.0f)
+, m_fixedDt(fixedDt)
+, m_accumulator(0.0f)
+, m_stepCount(0)
+, m_pool(pool)
+, m_solver(0)
+, m_ccd(0)
+, m_awakeCount(0)
+, m_awakeRangesDirty(true)
+{
+}
+
+unsigned int PhysicsWorld::addBody(const glm::vec3 &position, const glm::fquat &orientation, const glm::vec3 &halfExtents, float inverseMass)
+{
+	BodySoA &b = m_bodies;
+	b.px.push_back(position.x);
+	b.py.push_back(position.y);
+	b.pz.push_back(position.z);
+	b.vx.push_back(0.0f);
+	b.vy.push_back(0.0f);
+	b.vz.push_back(0.0f);
+	b.qw.push_back(orientation.w);
+	b.qx.push_back(orientation.x);
+	b.qy.push_back(orientation.y);
+	b.qz.push_back(orientation.z);
+	b.wx.push_back(0.0f);
+	b.wy.push_back(0.0f);
+	b.wz.push_back(0.0f);
+	b.hx.push_back(halfExtents.x);
+	b.hy.push_back(halfExtents.y);
+	b.hz.push_back(halfExtents.z);
+	b.inverseMass.push_back(inverseMass);
+	b.awake.push_back(1);
+	++m_awakeCount;
+	m_awakeRangesDirty = true;
+
+	return b.size() - 1;
+}
+
+unsigned int PhysicsWorld::step(float frameTime, unsigned int maxSteps)
+{
+	m_accumulator += frameTime;
+
+	unsigned int steps = 0;
+	while(m_accumulator >= m_fixedDt && steps < maxSteps)
+	{
+		integrate(m_fixedDt);
+		m_accumulator -= m_fixedDt;
+		++steps;
+	}
+
+	// Drop whatever we could not catch up on rather than carrying it into the next frame
+	if(steps == maxSteps && m_accumulator >= m_fixedDt)
+	{
+		m_accumulator = 0.0f;
+	}
+
+	return steps;
+}
+
+void PhysicsWorld::integrate(float dt)
+{
+	PROFILE_ZONE("Integrate");
+
+	// Sleeping bodies are left out altogether, so a step costs what the awake ones do
+	const std::vector<BodyRange> &ranges = getAwakeRanges();
+	forEachRange(m_pool, ranges, m_awakeCount, [this, dt](unsigned int begin, unsigned int end)
+	{
+		applyGravityRange(begin, end, dt);
+	});
+
+	if(m_solver)
+	{
+		m_solver->solve(m_bodies, dt);
+	}
+
+	forEachRange(m_pool, ranges, m_awakeCount, [this, dt](unsigned int begin, unsigned int end)
+	{
+		integrateRange(begin, end, dt);
+	});
+
+	if(m_ccd)
+	{
+		m_ccd->resolve(m_bodies, dt);
+	}
+
+	++m_stepCount;
+}
+
+void PhysicsWorld::setAwake(unsigned int body, bool awake)
+{
+	if(isAwake(body) == awake)
+	{
+		return;
+	}
+
+	m_bodies.awake[body] = awake ? 1 : 0;
+	m_awakeCount = awake ? m_awakeCount + 1 : m_awakeCount - 1;
+	m_awakeRangesDirty = true;
+
+	if(!awake)
+	{
+		m_bodies.vx[body] = m_bodies.vy[body] = m_bodies.vz[body] = 0.0f;
+		m_bodies.wx[body] = m_bodies.wy[body] = m_bodies.wz[body] = 0.0f;
+	}
+}
+
+const std::vector<BodyRange>& PhysicsWorld::getAwakeRanges() const
+{
+	if(!m_awakeRangesDirty)
+	{
+		return m_awakeRanges;
+	}
+
+	m_awakeRanges.clear();
+	const unsigned int count = m_bodies.size();
+	unsigned int i = 0;
+	while(i < count)
+	{
+		for(; i < count && !m_bodies.awake[i]; ++i)
+		{
+		}
+
+		BodyRange range = { i, i };
+		for(; i < count && m_bodies.awake[i] && i - range.begin < integrateGrain; ++i)
+		{
+		}
+		range.end = i;
+
+		if(range.end > range.begin)
+		{
+			m_awakeRanges.push_back(range);
+		}
+	}
+	m_awakeRangesDirty = false;
+
+	return m_awakeRanges;
+}
+
+void PhysicsWorld::applyGravityRange(unsigned int begin, unsigned int end, float dt)
+{
+	BodySoA &b = m_bodies;
+	unsigned int i = begin;
+
+#if SIMD_HAS_SSE2
+	const __m128 zero = _mm_setzero_ps();
+	const __m128 gx = _mm_set1_ps(m_gravity.x * dt);
+	const __m128 gy = _mm_set1_ps(m_gravity.y * dt);
+	const __m128 gz = _mm_set1_ps(m_gravity.z * dt);
+
+	for(; i + 4 <= end; i += 4)
+	{
+		const __m128 dynamic = _mm_cmpgt_ps(_mm_loadu_ps(&b.inverseMass[i]), zero);
+		_mm_storeu_ps(&b.vx[i], _mm_add_ps(_mm_loadu_ps(&b.vx[i]), _mm_and_ps(dynamic, gx)));
+		_mm_storeu_ps(&b.vy[i], _mm_add_ps(_mm_loadu_ps(&b.vy[i]), _mm_and_ps(dynamic, gy)));
+		_mm_storeu_ps(&b.vz[i], _mm_add_ps(_mm_loadu_ps(&b.vz[i]), _mm_and_ps(dynamic, gz)));
+	}
+#endif
+
+	for(; i < end; ++i)
+	{
+		if(b.inverseMass[i] > 0.0f)
+		{
+			b.vx[i] += m_gravity.x * dt;
+			b.vy[i] += m_gravity.y * dt;
+			b.vz[i] += m_gravity.z * dt;
+		}
+	}
+}
+
+void PhysicsWorld::integrateRange(unsigned int begin, unsigned int end, float dt)
+{
+	BodySoA &b = m_bodies;
+	unsigned int i = begin;
+
+#if SIMD_HAS_SSE2
+	const __m128 zero = _mm_setzero_ps();
+	const __m128 half = _mm_set1_ps(0.5f);
+	const __m128 step = _mm_set1_ps(dt);
+
+	for(; i + 4 <= end; i += 4)
+	{
+		// Semi-implicit Euler, the velocities gravity and the solver left move the body
+		const __m128 vx = _mm_loadu_ps(&b.vx[i]);
+		const __m128 vy = _mm_loadu_ps(&b.vy[i]);
+		const __m128 vz = _mm_loadu_ps(&b.vz[i]);
+		_mm_storeu_ps(&b.px[i], _mm_add_ps(_mm_loadu_ps(&b.px[i]), _mm_mul_ps(vx, step)));
+		_mm_storeu_ps(&b.py[i], _mm_add_ps(_mm_loadu_ps(&b.py[i]), _mm_mul_ps(vy, step)));
+		_mm_storeu_ps(&b.pz[i], _mm_add_ps(_mm_loadu_ps(&b.pz[i]), _mm_mul_ps(vz, step)));
+
+		// AngularVelocityToSpin for four bodies: 0.5 * (0, w) * q
+		const __m128 qw = _mm_loadu_ps(&b.qw[i]);
+		const __m128 qx = _mm_loadu_ps(&b.qx[i]);
+		const __m128 qy = _mm_loadu_ps(&b.qy[i]);
+		const __m128 qz = _mm_loadu_ps(&b.qz[i]);
+		const __m128 wx = _mm_loadu_ps(&b.wx[i]);
+		const __m128 wy = _mm_loadu_ps(&b.wy[i]);
+		const __m128 wz = _mm_loadu_ps(&b.wz[i]);
+
+		const __m128 spinW = _mm_sub_ps(zero, _mm_add_ps(_mm_add_ps(_mm_mul_ps(wx, qx), _mm_mul_ps(wy, qy)), _mm_mul_ps(wz, qz)));
+		const __m128 spinX = _mm_add_ps(_mm_mul_ps(qw, wx), _mm_sub_ps(_mm_mul_ps(wy, qz), _mm_mul_ps(wz, qy)));
+		const __m128 spinY = _mm_add_ps(_mm_mul_ps(qw, wy), _mm_sub_ps(_mm_mul_ps(wz, qx), _mm_mul_ps(wx, qz)));
+		const __m128 spinZ = _mm_add_ps(_mm_mul_ps(qw, wz), _mm_sub_ps(_mm_mul_ps(wx, qy), _mm_mul_ps(wy, qx)));
+
+		const __m128 halfStep = _mm_mul_ps(half, step);
+		const __m128 nw = _mm_add_ps(qw, _mm_mul_ps(spinW, halfStep));
+		const __m128 nx = _mm_add_ps(qx, _mm_mul_ps(spinX, halfStep));
+		const __m128 ny = _mm_add_ps(qy, _mm_mul_ps(spinY, halfStep));
+		const __m128 nz = _mm_add_ps(qz, _mm_mul_ps(spinZ, halfStep));
+
+		// Renormalise, a full divide keeps drift down over long runs
+		const __m128 lengthSquared = _mm_add_ps(_mm_add_ps(_mm_mul_ps(nw, nw), _mm_mul_ps(nx, nx)), _mm_add_ps(_mm_mul_ps(ny, ny), _mm_mul_ps(nz, nz)));
+		const __m128 invLength = _mm_div_ps(_mm_set1_ps(1.0f), _mm_sqrt_ps(lengthSquared));
+		_mm_storeu_ps(&b.qw[i], _mm_mul_ps(nw, invLength));
+		_mm_storeu_ps(&b.qx[i], _mm_mul_ps(nx, invLength));
+		_mm_storeu_ps(&b.qy[i], _mm_mul_ps(ny, invLength));
+		_mm_storeu_ps(&b.qz[i], _mm_mul_ps(nz, invLength));
+	}
+#endif
+
+	for(; i < end; ++i)
+	{
+		b.px[i] += b.vx[i] * dt;
+		b.py[i] += b.vy[i] * dt;
+		b.pz[i] += b.vz[i] * dt;
+
+		glm::fquat orientation(b.qw[i], b.qx[i], b.qy[i], b.qz[i]);
+		const glm::fquat spin = AngularVelocityToSpin(orientation, glm::vec3(b.wx[i], b.wy[i], b.wz[i]));
+		orientation = glm::normalize(orientation + spin * dt);
+
+		b.qw[i] = orientation.w;
+		b.qx[i] = orientation.x;
+		b.qy[i] = orientation.y;
+		b.qz[i] = orientation.z;
+	}
+}
+
+glm::vec3 PhysicsWorld::getPosition(unsigned int body) const
+{
+	return glm::vec3(m_bodies.px[body], m_bodies.py[body], m_bodies.pz[body]);
+}
+
+glm::fquat PhysicsWorld::getOrientation(unsigned int body) const
+{
+	return glm::fquat(m_bodies.qw[body], m_bodies.qx[body], m_bodies.qy[body], m_bodies.qz[body]);
+}
+
+glm::vec3 PhysicsWorld::getVelocity(unsigned int body) const
+{
+	return glm::vec3(m_bodies.vx[body], m_bodies.vy[body], m_bodies.vz[body]);
+}
+
+glm::vec3 PhysicsWorld::getAngularVelocity(unsigned int body) const
+{
+	return glm::vec3(m_bodies.wx[body], m_bodies.wy[body], m_bodies.wz[body]);
+}
+
+glm::vec3 PhysicsWorld::getHalfExtents(unsigned int body) const
+{
+	return glm::vec3(m_bodies.hx[body], m_bodies.hy[body], m_bodies.hz[body]);
+}
+
+void PhysicsWorld::setPosition(unsigned int body, const glm::vec3 &position)
+{
+	if(position != getPosition(body))
+	{
+		setAwake(body, true);
+	}
+	m_bodies.px[body] = position.x;
+	m_bodies.py[body] = position.y;
+	m_bodies.pz[body] = position.z;
+}
+
+void PhysicsWorld::setOrientation(unsigned int body, const glm::fquat &orientation)
+{
+	if(orientation != getOrientation(body))
+	{
+		setAwake(body, true);
+	}
+	m_bodies.qw[body] = orientation.w;
+	m_bodies.qx[body] = orientation.x;
+	m_bodies.qy[body] = orientation.y;
+	m_bodies.qz[body] = orientation.z;
+}
+
+void PhysicsWorld::setVelocity(unsigned int body, const glm::vec3 &velocity)
+{
+	if(velocity != getVelocity(body))
+	{
+		setAwake(body, true);
+	}
+	m_bodies.vx[body] = velocity.x;
+	m_bodies.vy[body] = velocity.y;
+	m_bodies.vz[body] = velocity.z;
+}
+
+void PhysicsWorld::setAngularVelocity(unsigned int body, const glm::vec3 &angularVelocity)
+{
+	if(angularVelocity != getAngularVelocity(body))
+	{
+		setAwake(body, true);
+	}
+	m_bodies.wx[body] = angularVelocity.x;
+	m_bodies.wy[body] = angularVelocity.y;
+	m_bodies.wz[body] = angularVelocity.z;
+}
+
+OrientedBoxSoA PhysicsWorld::getOrientedBoxes() const
+{
+	const BodySoA &b = m_bodies;
+	OrientedBoxSoA boxes = { 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, b.size() };
+	if(b.size() > 0)
+	{
+		OrientedBoxSoA filled = { &b.px[0], &b.py[0], &b.pz[0], &b.qw[0], &b.qx[0], &b.qy[0], &b.qz[0], &b.hx[0], &b.hy[0], &b.hz[0], b.size() };
+		boxes = filled;
+	}
+
+	return boxes;
+}
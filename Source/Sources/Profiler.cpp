@@ -0,0 +1,379 @@
+/*
+	Name:			Profiler.cpp
+	Project:		OpenGL
+	Description:	Scoped CPU zones, GPU spans and per frame counters, written out as a Chrome trace
+	Doc Version:	1.0
+	Author:			Jonathan Simon Jones
+	Date(D/M/Y):	16-10-2026
+	To do:
+*/
+
+#include "Profiler.h"
+#include "Simd.h"
+
+// STL includes
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#if SIMD_HAS_SSE2 && !defined(_MSC_VER)
+#include <x86intrin.h>
+#endif
+
+// Visual Studio only has thread_local from 2015, before that plain data can be __declspec(thread)
+#if defined(_MSC_VER) && _MSC_VER < 1900
+#define PROFILER_THREAD_LOCAL __declspec(thread)
+#else
+#define PROFILER_THREAD_LOCAL thread_local
+#endif
+
+std::atomic<bool> profilingEnabled(false);
+
+namespace
+{
+	typedef std::chrono::steady_clock Clock;
+
+	// Events a thread can record between two collectProfile calls
+	const unsigned int ringCapacity = 16384;
+	// A capture left running stops growing here, about 80 MB of events
+	const size_t maxCapturedEvents = 2 << 20;
+	const unsigned int threadNameLength = 32;
+	// Tracks are numbered from 1, the GPU gets this one
+	const unsigned int gpuTrack = 0;
+
+	enum ProfileEventType
+	{
+		ZoneEvent,
+		GpuZoneEvent,
+		CounterEvent
+	};
+
+	// Times are profilerTicks until collected and nanoseconds after, GPU zones are always nanoseconds
+	struct ProfileEvent
+	{
+		const char *name;
+		unsigned long long start;
+		unsigned long long end;				// Zones only
+		double value;						// Counters only
+		unsigned int type;
+		unsigned int track;					// Filled in when collected
+	};
+
+	// Only its own thread writes events and moves head, only collectProfile moves tail
+	struct ThreadBuffer
+	{
+		ProfileEvent events[ringCapacity];
+		std::atomic<unsigned long long> head;
+		std::atomic<unsigned long long> tail;
+		std::atomic<unsigned long long> dropped;
+		char name[threadNameLength];
+		unsigned int track;
+	};
+
+	// Every thread that has recorded anything, and the capture they are collected into
+	struct Capture
+	{
+		std::mutex mutex;
+		std::vector<ThreadBuffer*> buffers;
+		std::vector<ProfileEvent> events;
+		ProfilerStats stats;
+	};
+
+	Capture& getCapture()
+	{
+		// Buffers outlive their threads, a thread pool made again gets new ones
+		static Capture capture;
+		return capture;
+	}
+
+	Clock::time_point getClockStart()
+	{
+		static const Clock::time_point start = Clock::now();
+		return start;
+	}
+
+	// A tick count and the nanoseconds it was read at, and how many ticks make a nanosecond
+	struct TickRate
+	{
+		unsigned long long ticks;
+		unsigned long long nanoseconds;
+		double ticksPerNanosecond;
+	};
+
+	TickRate measureTickRate()
+	{
+		TickRate rate;
+		rate.nanoseconds = profilerNow();
+		rate.ticks = profilerTicks();
+
+#if SIMD_HAS_SSE2
+		// Long enough that reading either clock is lost in the difference
+		const unsigned long long until = rate.nanoseconds + 10000000;
+		unsigned long long now = rate.nanoseconds;
+		while(now < until)
+		{
+			std::this_thread::yield();
+			now = profilerNow();
+		}
+		rate.ticksPerNanosecond = (double)(profilerTicks() - rate.ticks) / (double)(now - rate.nanoseconds);
+#else
+		rate.ticksPerNanosecond = 1.0;
+#endif
+
+		return rate;
+	}
+
+	const TickRate& getTickRate()
+	{
+		static const TickRate rate = measureTickRate();
+		return rate;
+	}
+
+	unsigned long long ticksToNanoseconds(unsigned long long ticks)
+	{
+		const TickRate &rate = getTickRate();
+		const double offset = ((double)ticks - (double)rate.ticks) / rate.ticksPerNanosecond;
+		return offset < -(double)rate.nanoseconds ? 0 : (unsigned long long)((double)rate.nanoseconds + offset);
+	}
+
+	PROFILER_THREAD_LOCAL ThreadBuffer *threadBuffer = 0;
+	PROFILER_THREAD_LOCAL char threadName[threadNameLength] = { 0 };
+
+	ThreadBuffer* getThreadBuffer()
+	{
+		if(!threadBuffer)
+		{
+			ThreadBuffer *buffer = new ThreadBuffer;
+			buffer->head.store(0);
+			buffer->tail.store(0);
+			buffer->dropped.store(0);
+			memcpy(buffer->name, threadName, threadNameLength);
+
+			Capture &capture = getCapture();
+			std::lock_guard<std::mutex> lock(capture.mutex);
+			buffer->track = (unsigned int)capture.buffers.size() + 1;
+			capture.buffers.push_back(buffer);
+			threadBuffer = buffer;
+		}
+
+		return threadBuffer;
+	}
+
+	void push(const ProfileEvent &event)
+	{
+		ThreadBuffer *buffer = getThreadBuffer();
+		const unsigned long long head = buffer->head.load(std::memory_order_relaxed);
+		if(head - buffer->tail.load(std::memory_order_acquire) >= ringCapacity)
+		{
+			buffer->dropped.fetch_add(1, std::memory_order_relaxed);
+			return;
+		}
+
+		buffer->events[head & (ringCapacity - 1)] = event;
+		buffer->head.store(head + 1, std::memory_order_release);
+	}
+
+	void writeJsonString(FILE *file, const char *text)
+	{
+		fputc('"', file);
+		for(; *text; ++text)
+		{
+			if(*text == '"' || *text == '\\')
+			{
+				fputc('\\', file);
+				fputc(*text, file);
+			}
+			else if((unsigned char)*text < 0x20)
+			{
+				fprintf(file, "\\u%04x", (unsigned int)(unsigned char)*text);
+			}
+			else
+			{
+				fputc(*text, file);
+			}
+		}
+		fputc('"', file);
+	}
+
+	void writeTrackName(FILE *file, unsigned int track, const char *name)
+	{
+		fprintf(file, ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%u,\"args\":{\"name\":", track);
+		writeJsonString(file, name);
+		fprintf(file, "}}");
+	}
+}
+
+unsigned long long profilerNow()
+{
+	return (unsigned long long)std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - getClockStart()).count();
+}
+
+unsigned long long profilerTicks()
+{
+#if SIMD_HAS_SSE2
+	return __rdtsc();
+#else
+	return profilerNow();
+#endif
+}
+
+void startProfiling()
+{
+	getTickRate();
+
+	Capture &capture = getCapture();
+	{
+		std::lock_guard<std::mutex> lock(capture.mutex);
+		capture.events.clear();
+		capture.stats = ProfilerStats();
+
+		// Whatever is left over from the last capture goes
+		for(unsigned int i = 0; i < capture.buffers.size(); ++i)
+		{
+			ThreadBuffer *buffer = capture.buffers[i];
+			buffer->tail.store(buffer->head.load(std::memory_order_acquire), std::memory_order_release);
+			buffer->dropped.store(0, std::memory_order_relaxed);
+		}
+	}
+
+	profilingEnabled.store(true);
+}
+
+void stopProfiling()
+{
+	profilingEnabled.store(false);
+}
+
+void setProfilerThreadName(const char *name)
+{
+	strncpy(threadName, name, threadNameLength - 1);
+	threadName[threadNameLength - 1] = 0;
+
+	if(threadBuffer)
+	{
+		std::lock_guard<std::mutex> lock(getCapture().mutex);
+		memcpy(threadBuffer->name, threadName, threadNameLength);
+	}
+}
+
+void recordProfileZone(const char *name, unsigned long long start, unsigned long long end)
+{
+	const ProfileEvent event = { name, start, end, 0.0, ZoneEvent, 0 };
+	push(event);
+}
+
+void recordGpuZone(const char *name, unsigned long long start, unsigned long long end)
+{
+	const ProfileEvent event = { name, start, end, 0.0, GpuZoneEvent, gpuTrack };
+	push(event);
+}
+
+void recordProfileCounter(const char *name, double value)
+{
+	const unsigned long long now = profilerTicks();
+	const ProfileEvent event = { name, now, now, value, CounterEvent, 0 };
+	push(event);
+}
+
+void collectProfile()
+{
+	Capture &capture = getCapture();
+	std::lock_guard<std::mutex> lock(capture.mutex);
+
+	for(unsigned int i = 0; i < capture.buffers.size(); ++i)
+	{
+		ThreadBuffer *buffer = capture.buffers[i];
+		const unsigned long long head = buffer->head.load(std::memory_order_acquire);
+		for(unsigned long long e = buffer->tail.load(std::memory_order_relaxed); e < head; ++e)
+		{
+			if(capture.events.size() >= maxCapturedEvents)
+			{
+				++capture.stats.dropped;
+				continue;
+			}
+
+			// GPU zones come in nanoseconds already
+			ProfileEvent event = buffer->events[e & (ringCapacity - 1)];
+			event.track = event.type == GpuZoneEvent ? gpuTrack : buffer->track;
+			if(event.type != GpuZoneEvent)
+			{
+				event.start = ticksToNanoseconds(event.start);
+				event.end = ticksToNanoseconds(event.end);
+			}
+			capture.events.push_back(event);
+
+			capture.stats.zones += event.type == ZoneEvent ? 1 : 0;
+			capture.stats.gpuZones += event.type == GpuZoneEvent ? 1 : 0;
+			capture.stats.counters += event.type == CounterEvent ? 1 : 0;
+		}
+		buffer->tail.store(head, std::memory_order_release);
+		capture.stats.dropped += buffer->dropped.exchange(0, std::memory_order_relaxed);
+	}
+}
+
+bool writeChromeTrace(const char *path)
+{
+	collectProfile();
+
+	FILE *file = fopen(path, "w");
+	if(!file)
+	{
+		printf("Could not open %s to write the trace to\n", path);
+		return false;
+	}
+
+	Capture &capture = getCapture();
+	std::lock_guard<std::mutex> lock(capture.mutex);
+
+	// Times are in microseconds, the nanoseconds kept as decimals
+	fprintf(file, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+	fprintf(file, "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"args\":{\"name\":\"OpenGL\"}}");
+	writeTrackName(file, gpuTrack, "GPU");
+	for(unsigned int i = 0; i < capture.buffers.size(); ++i)
+	{
+		char name[threadNameLength + 16];
+		if(capture.buffers[i]->name[0])
+		{
+			snprintf(name, sizeof(name), "%s", capture.buffers[i]->name);
+		}
+		else
+		{
+			snprintf(name, sizeof(name), "Thread %u", capture.buffers[i]->track);
+		}
+		writeTrackName(file, capture.buffers[i]->track, name);
+	}
+
+	for(unsigned int i = 0; i < capture.events.size(); ++i)
+	{
+		const ProfileEvent &event = capture.events[i];
+		fprintf(file, ",\n{\"name\":");
+		writeJsonString(file, event.name);
+		if(event.type == CounterEvent)
+		{
+			fprintf(file, ",\"ph\":\"C\",\"pid\":1,\"tid\":%u,\"ts\":%.3f,\"args\":{\"value\":%.17g}}",
+				event.track, event.start / 1000.0, event.value);
+		}
+		else
+		{
+			fprintf(file, ",\"cat\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f}",
+				event.type == GpuZoneEvent ? "gpu" : "cpu", event.track, event.start / 1000.0, (event.end - event.start) / 1000.0);
+		}
+	}
+	fprintf(file, "\n]}\n");
+
+	capture.events.clear();
+
+	const bool written = ferror(file) == 0;
+	return fclose(file) == 0 && written;
+}
+
+ProfilerStats getProfilerStats()
+{
+	Capture &capture = getCapture();
+	std::lock_guard<std::mutex> lock(capture.mutex);
+	return capture.stats;
+}
@@ -0,0 +1,99 @@
+/*
+	Name:			RenderBackend.cpp
+	Project:		OpenGL
+	Description:	Walks a sorted render queue and only changes state that differs from the last draw
+	Doc Version:	1.0
+	Author:			Jonathan Simon Jones
+	Date(D/M/Y):	16-10-2026
+	To do:
+*/
+
+#include "RenderBackend.h"
+#include "Profiler.h"
+#include "RenderStats.h"
+
+// STL includes
+#include <cstring>
+
+RenderBackend::RenderBackend(): m_program(0)
+, m_vertexArray(0)
+, m_blend(false)
+, m_alpha(0.0f)
+{
+	memset(m_model, 0, sizeof(m_model));
+}
+
+void RenderBackend::execute(const RenderQueue &queue)
+{
+	PROFILE_ZONE("Execute draws");
+
+	RenderStats &stats = getRenderStats();
+
+	for(unsigned int i = 0; i < queue.size(); ++i)
+	{
+		const RenderCommand &command = queue.getCommand(i);
+		const bool first = i == 0;
+
+		// Uniforms belong to the program, so a new program needs them all set again
+		const bool newProgram = first || command.program != m_program;
+		if(newProgram)
+		{
+			applyProgram(command.program);
+			m_program = command.program;
+			++stats.stateChanges;
+		}
+		else
+		{
+			++stats.stateChangesSkipped;
+		}
+
+		if(first || command.vertexArray != m_vertexArray)
+		{
+			applyVertexArray(command.vertexArray);
+			m_vertexArray = command.vertexArray;
+			++stats.stateChanges;
+		}
+		else
+		{
+			++stats.stateChangesSkipped;
+		}
+
+		if(first || command.blend != m_blend)
+		{
+			applyBlend(command.blend);
+			m_blend = command.blend;
+			++stats.stateChanges;
+		}
+		else
+		{
+			++stats.stateChangesSkipped;
+		}
+
+		if(newProgram || memcmp(command.model, m_model, sizeof(m_model)) != 0)
+		{
+			applyModel(command.model);
+			memcpy(m_model, command.model, sizeof(m_model));
+			++stats.stateChanges;
+		}
+		else
+		{
+			++stats.stateChangesSkipped;
+		}
+
+		if(newProgram || command.alpha != m_alpha)
+		{
+			applyAlpha(command.alpha);
+			m_alpha = command.alpha;
+			++stats.stateChanges;
+		}
+		else
+		{
+			++stats.stateChangesSkipped;
+		}
+
+		draw(command);
+		countDraw(command.drawType == DrawArraysInstanced || command.drawType == DrawElementsInstanced ? command.instanceCount : 1);
+	}
+
+	flush();
+}
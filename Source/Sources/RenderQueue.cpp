@@ -0,0 +1,122 @@
+/*
+	Name:			RenderQueue.cpp
+	Project:		OpenGL
+	Description:	Draw submissions recorded as commands and sorted by a 64 bit key
+	Doc Version:	1.0
+	Author:			Jonathan Simon Jones
+	Date(D/M/Y):	16-10-2026
+	To do:
+*/
+
+#include "RenderQueue.h"
+#include "BatchAABB.h"
+
+// STL includes
+#include <algorithm>
+#include <cstring>
+
+namespace
+{
+	const unsigned int stateBits = 10;
+	const unsigned int depthBits = 24;
+	const unsigned int unusedBits = 19;
+
+	const unsigned long long stateMask = (1ull << stateBits) - 1;
+	const unsigned long long depthMax = (1ull << depthBits) - 1;
+
+	// GL_TRIANGLES, repeated here so the queue does not need the GL headers
+	const unsigned int triangles = 0x0004;
+
+	unsigned long long quantiseDepth(float depth)
+	{
+		depth = depth < 0.0f ? 0.0f : (depth > 1.0f ? 1.0f : depth);
+		return (unsigned long long)(depth * depthMax);
+	}
+}
+
+RenderCommand::RenderCommand(): program(0)
+, vertexArray(0)
+, blend(false)
+, drawType(DrawArrays)
+, primitive(triangles)
+, first(0)
+, count(0)
+, instanceCount(1)
+, alpha(1.0f)
+{
+	// Identity
+	for(unsigned int i = 0; i < 16; ++i)
+	{
+		model[i] = (i % 5 == 0) ? 1.0f : 0.0f;
+	}
+}
+
+void RenderCommand::setModel(const float matrix[16])
+{
+	memcpy(model, matrix, sizeof(model));
+}
+
+void makeCubeInstances(const OrientedBoxSoA &b, const std::vector<unsigned int> &bodies, std::vector<CubeInstance> &instances)
+{
+	instances.resize(bodies.size());
+
+	for(unsigned int i = 0; i < bodies.size(); ++i)
+	{
+		const unsigned int body = bodies[i];
+		CubeInstance &instance = instances[i];
+
+		instance.position[0] = b.px[body];
+		instance.position[1] = b.py[body];
+		instance.position[2] = b.pz[body];
+
+		instance.scale[0] = 2.0f * b.hx[body];
+		instance.scale[1] = 2.0f * b.hy[body];
+		instance.scale[2] = 2.0f * b.hz[body];
+
+		instance.orientation[0] = b.qx[body];
+		instance.orientation[1] = b.qy[body];
+		instance.orientation[2] = b.qz[body];
+		instance.orientation[3] = b.qw[body];
+	}
+}
+
+unsigned long long makeSortKey(bool translucent, unsigned int program, unsigned int vertexArray, float depth)
+{
+	// Names past the state bits share a group, which only costs a redundant bind
+	const unsigned long long state = ((program & stateMask) << stateBits) | (vertexArray & stateMask);
+	const unsigned long long z = quantiseDepth(depth);
+
+	if(!translucent)
+	{
+		return (state << (depthBits + unusedBits)) | (z << unusedBits);
+	}
+
+	return (1ull << 63) | ((depthMax - z) << (2 * stateBits + unusedBits)) | (state << unusedBits);
+}
+
+void RenderQueue::clear()
+{
+	m_commands.clear();
+	m_entries.clear();
+}
+
+void RenderQueue::reserve(unsigned int count)
+{
+	m_commands.reserve(count);
+	m_entries.reserve(count);
+}
+
+void RenderQueue::submit(const RenderCommand &command, float depth)
+{
+	SortEntry entry;
+	entry.key = makeSortKey(command.blend, command.program, command.vertexArray, depth);
+	entry.command = (unsigned int)m_commands.size();
+
+	m_commands.push_back(command);
+	m_entries.push_back(entry);
+}
+
+void RenderQueue::sort()
+{
+	std::sort(m_entries.begin(), m_entries.end());
+}
@@ -0,0 +1,22 @@
+/*
+	Name:			RenderStats.cpp
+	Project:		OpenGL
+	Description:	Per frame counters for the work handed to the graphics card
+	Doc Version:	1.0
+	Author:			Jonathan Simon Jones
+	Date(D/M/Y):	16-10-2026
+	To do:
+*/
+
+#include "RenderStats.h"
+
+namespace
+{
+	// Only the thread that owns the GL context touches this
+	RenderStats frameStats;
+}
+
+RenderStats& getRenderStats()
+{
+	return frameStats;
+}
@@ -0,0 +1,589 @@
+/*
+	Name:			Scene.cpp
+	Project:		OpenGL
+	Description:	Simulation state for the demo scene and the per frame update shared by
+					the windowed and headless builds
+	Doc Version:	1.0
+	Author:			Jonathan Simon Jones
+	Date(D/M/Y):	16-10-2026
+	To do:
+*/
+
+#include "Scene.h"
+#include "BatchTransform.h"
+#include "Profiler.h"
+#include "ThreadPool.h"
+
+// Math includes
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/type_ptr.hpp>
+
+// STL includes
+#include <algorithm>
+#include <cmath>
+#include <random>
+
+namespace
+{
+	const float fps = 200.0f;
+	const float dt = 1 / fps;
+	// Steps a frame can take, fast bodies are swept over all of them
+	const unsigned int maxStepsPerFrame = 8;
+
+	// Box 1's model, the corners of its world box and the box itself
+	void boundBox1(const glm::vec3 &position, const glm::fquat &orientation, glm::mat4 &model, float boundingBoxCoords[48], extremes &boxExtremes, AABB &bounds)
+	{
+		model = composeModelMatrix(position, orientation, glm::vec3(1.0f, 1.0f, 1.0f));
+
+		calculateBoxExtremes(model, boundingBoxCoords, boxExtremes);
+
+		const extremes &e = boxExtremes;
+		bounds.center_position = glm::vec3(e.maxX + e.minX, e.maxY + e.minY, e.maxZ + e.minZ) * 0.5f;
+		bounds.radius = glm::vec3(e.maxX - e.minX, e.maxY - e.minY, e.maxZ - e.minZ) * 0.5f;
+	}
+
+	// out = from + (to - from) * alpha over count floats
+	void blend(const float *from, const float *to, float alpha, unsigned int count, float *out)
+	{
+		unsigned int i = 0;
+
+#if SIMD_HAS_SSE2
+		const __m128 weight = _mm_set1_ps(alpha);
+		for(; i + 4 <= count; i += 4)
+		{
+			const __m128 a = _mm_loadu_ps(from + i);
+			_mm_storeu_ps(out + i, _mm_add_ps(a, _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(to + i), a), weight)));
+		}
+#endif
+
+		for(; i < count; ++i)
+		{
+			out[i] = from[i] + (to[i] - from[i]) * alpha;
+		}
+	}
+
+	// Orientations blended the short way round and renormalised
+	void blendOrientations(const SceneSnapshot &from, const SceneSnapshot &to, float alpha, unsigned int count, SceneSnapshot &out)
+	{
+		unsigned int i = 0;
+
+#if SIMD_HAS_SSE2
+		const __m128 weight = _mm_set1_ps(alpha);
+		const __m128 signMask = _mm_castsi128_ps(_mm_set1_epi32(0x80000000));
+		for(; i + 4 <= count; i += 4)
+		{
+			const __m128 fw = _mm_loadu_ps(&from.qw[i]);
+			const __m128 fx = _mm_loadu_ps(&from.qx[i]);
+			const __m128 fy = _mm_loadu_ps(&from.qy[i]);
+			const __m128 fz = _mm_loadu_ps(&from.qz[i]);
+			__m128 tw = _mm_loadu_ps(&to.qw[i]);
+			__m128 tx = _mm_loadu_ps(&to.qx[i]);
+			__m128 ty = _mm_loadu_ps(&to.qy[i]);
+			__m128 tz = _mm_loadu_ps(&to.qz[i]);
+
+			// q and -q are the same turn, flip to so the blend does not go the long way
+			const __m128 dot = _mm_add_ps(_mm_add_ps(_mm_mul_ps(fw, tw), _mm_mul_ps(fx, tx)), _mm_add_ps(_mm_mul_ps(fy, ty), _mm_mul_ps(fz, tz)));
+			const __m128 flip = _mm_and_ps(_mm_cmplt_ps(dot, _mm_setzero_ps()), signMask);
+			tw = _mm_xor_ps(tw, flip);
+			tx = _mm_xor_ps(tx, flip);
+			ty = _mm_xor_ps(ty, flip);
+			tz = _mm_xor_ps(tz, flip);
+
+			const __m128 w = _mm_add_ps(fw, _mm_mul_ps(_mm_sub_ps(tw, fw), weight));
+			const __m128 x = _mm_add_ps(fx, _mm_mul_ps(_mm_sub_ps(tx, fx), weight));
+			const __m128 y = _mm_add_ps(fy, _mm_mul_ps(_mm_sub_ps(ty, fy), weight));
+			const __m128 z = _mm_add_ps(fz, _mm_mul_ps(_mm_sub_ps(tz, fz), weight));
+			const __m128 lengthSquared = _mm_add_ps(_mm_add_ps(_mm_mul_ps(w, w), _mm_mul_ps(x, x)), _mm_add_ps(_mm_mul_ps(y, y), _mm_mul_ps(z, z)));
+			const __m128 invLength = _mm_div_ps(_mm_set1_ps(1.0f), _mm_sqrt_ps(lengthSquared));
+			_mm_storeu_ps(&out.qw[i], _mm_mul_ps(w, invLength));
+			_mm_storeu_ps(&out.qx[i], _mm_mul_ps(x, invLength));
+			_mm_storeu_ps(&out.qy[i], _mm_mul_ps(y, invLength));
+			_mm_storeu_ps(&out.qz[i], _mm_mul_ps(z, invLength));
+		}
+#endif
+
+		for(; i < count; ++i)
+		{
+			float tw = to.qw[i];
+			float tx = to.qx[i];
+			float ty = to.qy[i];
+			float tz = to.qz[i];
+			if(from.qw[i] * tw + from.qx[i] * tx + (from.qy[i] * ty + from.qz[i] * tz) < 0.0f)
+			{
+				tw = -tw;
+				tx = -tx;
+				ty = -ty;
+				tz = -tz;
+			}
+
+			const float w = from.qw[i] + (tw - from.qw[i]) * alpha;
+			const float x = from.qx[i] + (tx - from.qx[i]) * alpha;
+			const float y = from.qy[i] + (ty - from.qy[i]) * alpha;
+			const float z = from.qz[i] + (tz - from.qz[i]) * alpha;
+			const float invLength = 1.0f / std::sqrt(w * w + x * x + (y * y + z * z));
+			out.qw[i] = w * invLength;
+			out.qx[i] = x * invLength;
+			out.qy[i] = y * invLength;
+			out.qz[i] = z * invLength;
+		}
+	}
+
+	template<class T>
+	void copyTail(const std::vector<T> &from, unsigned int first, std::vector<T> &out)
+	{
+		out.resize(from.size());
+		std::copy(from.begin() + first, from.end(), out.begin() + first);
+	}
+}
+
+const unsigned int boundingBoxIndices[36] = {
+	// Bottom
+	0, 2, 1,
+	3, 0, 2,
+
+	// Top
+	4, 6, 5,
+	7, 4, 6,
+
+	// Front
+	0, 5, 1,
+	4, 0, 5,
+
+	// Right
+	1, 6, 2,
+	5, 1, 6,
+
+	// Back
+	2, 7, 3,
+	6, 2, 7,
+
+	// Left
+	3, 4, 0,
+	7, 3, 4,
+};
+
+Scene::Scene(ThreadPool *pool): pool(pool)
+, world(dt, pool)
+, box1Body(0)
+, box2Body(0)
+, box2Pos(3.0f, 0.0f, 0.5f)
+, box1Proxy(0)
+, box2Proxy(0)
+, narrowphase(pool)
+, solver(pool)
+, colliding(false)
+, boxesOverlapAABB(false)
+, pairCount(0)
+{
+	const glm::vec3 unitHalf(0.5f, 0.5f, 0.5f);
+	world.setContactSolver(&solver);
+	world.setContinuousCollision(&ccd);
+
+	// No inverse mass so gravity leaves it where it is, it only spins
+	world.setGravity(glm::vec3(0.0f, 0.0f, -1.0f));
+	box1Body = world.addBody(glm::vec3(0.0f, 0.0f, 0.0f), glm::fquat(1.0f, 0.0f, 0.0f, 0.0f), unitHalf, 0.0f);
+	world.setAngularVelocity(box1Body, glm::vec3(0.0f, 0.0f, 0.1f));
+	box2Body = world.addBody(box2Pos, glm::fquat(1.0f, 0.0f, 0.0f, 0.0f), unitHalf, 0.0f);
+
+	BBB1.center_position = world.getPosition(box1Body);
+	BBB1.radius = unitHalf;
+	BBB2.center_position = box2Pos;
+	BBB2.radius = unitHalf;
+
+	for(unsigned int i = 0; i < 48; ++i)
+	{
+		boundingBoxCoords[i] = 0.0f;
+	}
+
+	// Broadphase, keeps the boxes sorted between frames so only nearby pairs get tested
+	box1Proxy = broadphase.addBody(BBB1);
+	box2Proxy = broadphase.addBody(BBB2);
+	proxyBodies.resize(box2Proxy + 1);
+	proxyBodies[box1Proxy] = box1Body;
+	proxyBodies[box2Proxy] = box2Body;
+	bodyProxies.resize(box2Body + 1);
+	bodyProxies[box1Body] = box1Proxy;
+	bodyProxies[box2Body] = box2Proxy;
+}
+
+void addSceneClutter(Scene &scene, unsigned int count)
+{
+	std::mt19937 random(2014);
+	const float spread = 2.0f * std::pow((float)count, 1.0f / 3.0f);
+	std::uniform_real_distribution<float> position(-spread, spread);
+	std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+
+	const unsigned int first = (unsigned int)scene.clutterBodies.size();
+	for(unsigned int i = 0; i < count; ++i)
+	{
+		const unsigned int body = scene.world.addBody(glm::vec3(position(random), position(random), position(random) + spread + 2.0f),
+			glm::normalize(glm::fquat(unit(random), unit(random), unit(random), unit(random))),
+			glm::vec3(0.5f, 0.5f, 0.5f), 1.0f);
+		scene.world.setAngularVelocity(body, glm::vec3(unit(random), unit(random), unit(random)));
+		scene.clutterBodies.push_back(body);
+	}
+
+	// Boxes are refit from the whole world in one batch, indexed by body
+	computeWorldAABBsSoA(scene.world.getOrientedBoxes(), scene.clutterBoxes);
+	for(unsigned int i = first; i < scene.clutterBodies.size(); ++i)
+	{
+		const unsigned int proxy = scene.broadphase.addBody(scene.clutterBoxes.get(scene.clutterBodies[i]));
+		scene.clutterProxies.push_back(proxy);
+		if(scene.proxyBodies.size() <= proxy)
+		{
+			scene.proxyBodies.resize(proxy + 1);
+		}
+		scene.proxyBodies[proxy] = scene.clutterBodies[i];
+		if(scene.bodyProxies.size() <= scene.clutterBodies[i])
+		{
+			scene.bodyProxies.resize(scene.clutterBodies[i] + 1);
+		}
+		scene.bodyProxies[scene.clutterBodies[i]] = proxy;
+	}
+}
+
+void updateScene(Scene &scene, float frameTime)
+{
+	PROFILE_ZONE("Update scene");
+
+	// Box 2 only moves when the keys move it
+	scene.world.setPosition(scene.box2Body, scene.box2Pos);
+	scene.world.step(frameTime, maxStepsPerFrame);
+
+	// Box 1, a sleeping box has not moved since its extremes were last worked out
+	if(scene.world.isAwake(scene.box1Body))
+	{
+		boundBox1(scene.world.getPosition(scene.box1Body), scene.world.getOrientation(scene.box1Body),
+			scene.box1Model, scene.boundingBoxCoords, scene.box1Extremes, scene.BBB1);
+		scene.broadphase.updateBody(scene.box1Proxy, scene.BBB1);
+	}
+
+	// Box 2
+	scene.BBB2.center_position = scene.box2Pos;
+	scene.broadphase.updateBody(scene.box2Proxy, scene.BBB2);
+
+	// Everything else that is awake, culling reads the refit boxes even when there is no clutter
+	const OrientedBoxSoA oriented = scene.world.getOrientedBoxes();
+	if(scene.clutterBoxes.size() != oriented.count)
+	{
+		computeWorldAABBsSoA(oriented, scene.clutterBoxes);
+	}
+	// The ranges are cut to the integration grain, so each is worth a job of its own. The
+	// broadphase is one sorted structure and is updated on this thread once they are done.
+	const std::vector<BodyRange> &awake = scene.world.getAwakeRanges();
+	if(scene.pool)
+	{
+		scene.pool->parallelFor((unsigned int)awake.size(), 1, [&scene, &oriented, &awake](unsigned int begin, unsigned int end)
+		{
+			PROFILE_ZONE("Refit chunk");
+			for(unsigned int r = begin; r < end; ++r)
+			{
+				computeWorldAABBsSoA(oriented, awake[r].begin, awake[r].end, scene.clutterBoxes);
+			}
+		});
+	}
+	else
+	{
+		for(unsigned int r = 0; r < awake.size(); ++r)
+		{
+			computeWorldAABBsSoA(oriented, awake[r].begin, awake[r].end, scene.clutterBoxes);
+		}
+	}
+
+	// A fast body is given the box it sweeps over the most the next frame can step, so
+	// whatever it could hit on the way is paired with it
+	const BodySoA &bodies = scene.world.getBodies();
+	for(unsigned int r = 0; r < awake.size(); ++r)
+	{
+		for(unsigned int body = awake[r].begin; body < awake[r].end; ++body)
+		{
+			if(body == scene.box1Body || body == scene.box2Body)
+			{
+				continue;
+			}
+
+			if(isFastBody(bodies, body, dt))
+			{
+				scene.broadphase.updateBody(scene.bodyProxies[body], sweepBodyAABB(bodies, body, maxStepsPerFrame * dt));
+			}
+			else
+			{
+				scene.broadphase.updateBody(scene.bodyProxies[body], scene.clutterBoxes.get(body));
+			}
+		}
+	}
+
+	// The broadphase only says the boxes around two bodies overlap, the narrowphase tests
+	// the bodies themselves. Two sleeping or static bodies have nothing to tell each other.
+	const std::vector<BroadphasePair> &pairs = scene.broadphase.findOverlappingPairs();
+	scene.pairCount = (unsigned int)pairs.size();
+	scene.bodyPairs.clear();
+	scene.boxesOverlapAABB = false;
+	for(unsigned int i = 0; i < pairs.size(); ++i)
+	{
+		BroadphasePair pair = { scene.proxyBodies[pairs[i].a], scene.proxyBodies[pairs[i].b] };
+
+		// Box 1 first so the contact normal points from it to box 2
+		if(pair.a == scene.box2Body && pair.b == scene.box1Body)
+		{
+			std::swap(pair.a, pair.b);
+		}
+		scene.boxesOverlapAABB |= pair.a == scene.box1Body && pair.b == scene.box2Body;
+
+		if(scene.world.isAwake(pair.a) || scene.world.isAwake(pair.b))
+		{
+			scene.bodyPairs.push_back(pair);
+		}
+	}
+
+	scene.narrowphase.collide(oriented, scene.bodyPairs.empty() ? 0 : &scene.bodyPairs[0], (unsigned int)scene.bodyPairs.size());
+	scene.islands.update(scene.world, scene.narrowphase.getManifolds(), scene.narrowphase.getManifoldCount(), frameTime);
+	scene.solver.setContacts(scene.world.getBodies(), scene.narrowphase.getManifolds(), scene.narrowphase.getManifoldCount());
+	scene.ccd.setPairs(scene.world.getBodies(), scene.bodyPairs.empty() ? 0 : &scene.bodyPairs[0], (unsigned int)scene.bodyPairs.size(), dt);
+
+	const ContactManifold *contact = scene.narrowphase.findManifold(scene.box1Body, scene.box2Body);
+	scene.colliding = contact != 0;
+	if(contact)
+	{
+		scene.boxContact = *contact;
+	}
+}
+
+SceneSnapshot::SceneSnapshot(): box1Body(0)
+, box2Body(0)
+, colliding(false)
+, boxesOverlapAABB(false)
+, pairCount(0)
+, pairsTested(0)
+, manifolds(0)
+, awakeBodies(0)
+, time(0.0)
+, steps(0)
+, published(0)
+{
+	for(unsigned int i = 0; i < 48; ++i)
+	{
+		boundingBoxCoords[i] = 0.0f;
+	}
+}
+
+OrientedBoxSoA SceneSnapshot::getOrientedBoxes() const
+{
+	OrientedBoxSoA boxes = { 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, getBodyCount() };
+	if(!px.empty())
+	{
+		OrientedBoxSoA filled = { &px[0], &py[0], &pz[0], &qw[0], &qx[0], &qy[0], &qz[0], &hx[0], &hy[0], &hz[0], getBodyCount() };
+		boxes = filled;
+	}
+
+	return boxes;
+}
+
+void takeSceneSnapshot(const Scene &scene, double time, unsigned long long steps, SceneSnapshot &snapshot)
+{
+	PROFILE_ZONE("Take snapshot");
+
+	// Assigning reuses what the vectors already hold, so this stops allocating once warmed up
+	const BodySoA &b = scene.world.getBodies();
+	snapshot.px.assign(b.px.begin(), b.px.end());
+	snapshot.py.assign(b.py.begin(), b.py.end());
+	snapshot.pz.assign(b.pz.begin(), b.pz.end());
+	snapshot.qw.assign(b.qw.begin(), b.qw.end());
+	snapshot.qx.assign(b.qx.begin(), b.qx.end());
+	snapshot.qy.assign(b.qy.begin(), b.qy.end());
+	snapshot.qz.assign(b.qz.begin(), b.qz.end());
+	snapshot.hx.assign(b.hx.begin(), b.hx.end());
+	snapshot.hy.assign(b.hy.begin(), b.hy.end());
+	snapshot.hz.assign(b.hz.begin(), b.hz.end());
+	snapshot.box1Body = scene.box1Body;
+	snapshot.box2Body = scene.box2Body;
+
+	snapshot.box1Model = scene.box1Model;
+	std::copy(scene.boundingBoxCoords, scene.boundingBoxCoords + 48, snapshot.boundingBoxCoords);
+	snapshot.BBB1 = scene.BBB1;
+
+	snapshot.colliding = scene.colliding;
+	snapshot.boxesOverlapAABB = scene.boxesOverlapAABB;
+	snapshot.boxContact = scene.boxContact;
+	snapshot.pairCount = scene.pairCount;
+	snapshot.pairsTested = scene.narrowphase.getStats().pairsTested;
+	snapshot.manifolds = scene.narrowphase.getStats().manifolds;
+	snapshot.awakeBodies = scene.islands.getStats().awakeBodies;
+
+	snapshot.time = time;
+	snapshot.steps = steps;
+	snapshot.published = 0;
+}
+
+void interpolateSceneSnapshots(const SceneSnapshot &from, const SceneSnapshot &to, float alpha, SceneSnapshot &out)
+{
+	PROFILE_ZONE("Interpolate snapshots");
+
+	const unsigned int count = std::min(from.getBodyCount(), to.getBodyCount());
+	copyTail(to.px, count, out.px);
+	copyTail(to.py, count, out.py);
+	copyTail(to.pz, count, out.pz);
+	copyTail(to.qw, count, out.qw);
+	copyTail(to.qx, count, out.qx);
+	copyTail(to.qy, count, out.qy);
+	copyTail(to.qz, count, out.qz);
+	out.hx.assign(to.hx.begin(), to.hx.end());
+	out.hy.assign(to.hy.begin(), to.hy.end());
+	out.hz.assign(to.hz.begin(), to.hz.end());
+	out.box1Body = to.box1Body;
+	out.box2Body = to.box2Body;
+
+	if(count > 0)
+	{
+		blend(&from.px[0], &to.px[0], alpha, count, &out.px[0]);
+		blend(&from.py[0], &to.py[0], alpha, count, &out.py[0]);
+		blend(&from.pz[0], &to.pz[0], alpha, count, &out.pz[0]);
+		blendOrientations(from, to, alpha, count, out);
+	}
+
+	if(out.box1Body < count)
+	{
+		const unsigned int body = out.box1Body;
+		extremes boxExtremes;
+		boundBox1(glm::vec3(out.px[body], out.py[body], out.pz[body]), glm::fquat(out.qw[body], out.qx[body], out.qy[body], out.qz[body]),
+			out.box1Model, out.boundingBoxCoords, boxExtremes, out.BBB1);
+	}
+	else
+	{
+		out.box1Model = to.box1Model;
+		std::copy(to.boundingBoxCoords, to.boundingBoxCoords + 48, out.boundingBoxCoords);
+		out.BBB1 = to.BBB1;
+	}
+
+	out.colliding = to.colliding;
+	out.boxesOverlapAABB = to.boxesOverlapAABB;
+	out.boxContact = to.boxContact;
+	out.pairCount = to.pairCount;
+	out.pairsTested = to.pairsTested;
+	out.manifolds = to.manifolds;
+	out.awakeBodies = to.awakeBodies;
+
+	out.time = from.time + (to.time - from.time) * alpha;
+	out.steps = to.steps;
+	out.published = to.published;
+}
+
+void cullScene(const SceneSnapshot &snapshot, const glm::mat4 &viewProj, const glm::vec3 &eye, SceneVisibility &visibility)
+{
+	// Every body may have moved since the last snapshot culled, so every box is refit
+	const OrientedBoxSoA oriented = snapshot.getOrientedBoxes();
+	computeWorldAABBsSoA(oriented, visibility.boxes);
+	const std::vector<unsigned int> &visible = visibility.culler.cull(viewProj, eye, visibility.boxes, oriented);
+
+	// Box 1 and 2 are bodies like the clutter but are drawn on their own
+	visibility.box1Visible = false;
+	visibility.box2Visible = false;
+	visibility.visibleClutter.clear();
+	visibility.visibleClutter.reserve(visibility.boxes.size());
+	for(unsigned int i = 0; i < visible.size(); ++i)
+	{
+		if(visible[i] == snapshot.box1Body)
+		{
+			visibility.box1Visible = true;
+		}
+		else if(visible[i] == snapshot.box2Body)
+		{
+			visibility.box2Visible = true;
+		}
+		else
+		{
+			visibility.visibleClutter.push_back(visible[i]);
+		}
+	}
+}
+
+void showWholeScene(const SceneSnapshot &snapshot, SceneVisibility &visibility)
+{
+	visibility.box1Visible = true;
+	visibility.box2Visible = true;
+	visibility.visibleClutter.clear();
+	for(unsigned int body = 0; body < snapshot.getBodyCount(); ++body)
+	{
+		if(body != snapshot.box1Body && body != snapshot.box2Body)
+		{
+			visibility.visibleClutter.push_back(body);
+		}
+	}
+}
+
+SceneProps::SceneProps(ThreadPool *pool): graph(pool)
+, groundNode(0)
+, floorNode(0)
+{
+	const glm::fquat noRotation(1.0f, 0.0f, 0.0f, 0.0f);
+	groundNode = graph.addNode(noParentNode, glm::vec3(0.0f, 0.0f, 0.0f), noRotation, glm::vec3(1.0f, 1.0f, 1.0f));
+	floorNode = graph.addNode(groundNode, glm::vec3(0.0f, 0.0f, -0.5f), noRotation, glm::vec3(10.0f, 10.0f, 1.0f));
+}
+
+void submitSceneDraws(const SceneSnapshot &snapshot, SceneVisibility &visibility, SceneProps &props, const SceneDrawSetup &setup, const glm::vec3 &eye, float farPlane, bool perObjectClutter, RenderQueue &queue)
+{
+	visibility.frameMemory.beginFrame();
+	visibility.clutterModels = 0;
+
+	// Room for every body, the floor and the bounding box, so the queue stops growing once
+	// it has held the whole scene rather than whenever more of it comes into view
+	queue.reserve(queue.size() + snapshot.getBodyCount() + 2);
+
+	RenderCommand cube;
+	cube.program = setup.colorProgram;
+	cube.vertexArray = setup.cubeVertexArray;
+	cube.drawType = DrawElements;
+	cube.count = setup.cubeIndexCount;
+
+	// Box 1
+	if(visibility.box1Visible)
+	{
+		const unsigned int body = snapshot.box1Body;
+		cube.setModel(glm::value_ptr(snapshot.box1Model));
+		queue.submit(cube, glm::length(glm::vec3(snapshot.px[body], snapshot.py[body], snapshot.pz[body]) - eye) / farPlane);
+	}
+
+	// Box 2, never turns
+	if(visibility.box2Visible)
+	{
+		const unsigned int body = snapshot.box2Body;
+		const glm::vec3 position(snapshot.px[body], snapshot.py[body], snapshot.pz[body]);
+		const glm::mat4 model = glm::translate(glm::mat4(), position);
+		cube.setModel(glm::value_ptr(model));
+		queue.submit(cube, glm::length(position - eye) / farPlane);
+	}
+
+	// Floor, always drawn and where the graph puts it. Only nodes moved since the last
+	// update and what hangs off them are worked out again.
+	props.graph.update();
+	const glm::mat4 &floorWorld = props.graph.getWorld(props.floorNode);
+	cube.setModel(glm::value_ptr(floorWorld));
+	queue.submit(cube, glm::length(glm::vec3(floorWorld[3]) - eye) / farPlane);
+
+	// AABB of box 1, always drawn as it is a debug view of the box. Its corners are
+	// already in world space and it is alpha blended.
+	RenderCommand boundingBox;
+	boundingBox.program = setup.colorProgram;
+	boundingBox.vertexArray = setup.boundingBoxVertexArray;
+	boundingBox.blend = true;
+	boundingBox.drawType = DrawElements;
+	boundingBox.count = 36;
+	boundingBox.alpha = 0.5f;
+	queue.submit(boundingBox, glm::length(snapshot.BBB1.center_position - eye) / farPlane);
+
+	if(perObjectClutter && !visibility.visibleClutter.empty())
+	{
+		const unsigned int count = (unsigned int)visibility.visibleClutter.size();
+		float *models = visibility.frameMemory.allocateArray<float>(count * transformMatrixFloats);
+		composeModelMatrices(getCubeTransforms(snapshot.getOrientedBoxes()), &visibility.visibleClutter[0], count, models);
+		visibility.clutterModels = models;
+
+		for(unsigned int i = 0; i < count; ++i)
+		{
+			const unsigned int body = visibility.visibleClutter[i];
+			const glm::vec3 position(snapshot.px[body], snapshot.py[body], snapshot.pz[body]);
+			cube.setModel(models + i * transformMatrixFloats);
+			queue.submit(cube, glm::length(position - eye) / farPlane);
+		}
+	}
+}
@@ -0,0 +1,365 @@
+/*
+	Name:			SceneGraph.cpp
+	Project:		OpenGL
+	Description:	Parent and child transforms kept in flat arrays, only what moved is worked out again
+	Doc Version:	1.0
+	Author:			Jonathan Simon Jones
+	Date(D/M/Y):	16-10-2026
+	To do:
+*/
+
+#include "SceneGraph.h"
+#include "BatchTransform.h"
+#include "Profiler.h"
+#include "ThreadPool.h"
+
+// Math includes
+#include <glm/gtc/type_ptr.hpp>
+
+// STL includes
+#include <algorithm>
+#include <cstdio>
+
+namespace
+{
+	// Local transforms worked out at once before their parents are applied
+	const unsigned int localBatch = 64;
+
+	// Puts values[i] at place order[i], through scratch
+	template<class T>
+	void permute(std::vector<T> &values, const std::vector<unsigned int> &order, std::vector<T> &scratch)
+	{
+		scratch.resize(values.size());
+		for(unsigned int i = 0; i < order.size(); ++i)
+		{
+			scratch[i] = values[order[i]];
+		}
+		values.swap(scratch);
+	}
+}
+
+SceneGraph::SceneGraph(ThreadPool *pool): m_pool(pool)
+, m_outOfOrder(false)
+{
+}
+
+unsigned int SceneGraph::addNode(unsigned int parent, const glm::vec3 &position, const glm::fquat &orientation, const glm::vec3 &scale)
+{
+	const unsigned int node = getNodeCount();
+	if(parent != noParentNode && parent >= node)
+	{
+		printf("Scene graph node %u given parent %u, which does not exist yet, added as a root\n", node, parent);
+		parent = noParentNode;
+	}
+
+	// Appended, which keeps the arrays depth first only if the parent's subtree ends them
+	const unsigned int slot = node;
+	const unsigned int parentSlot = parent == noParentNode ? noParentNode : m_slots[parent];
+	if(parentSlot != noParentNode && parentSlot + m_subtreeSizes[parentSlot] != slot)
+	{
+		m_outOfOrder = true;
+	}
+
+	m_parents.push_back(parent);
+	m_slots.push_back(slot);
+	m_nodes.push_back(node);
+	m_parentSlots.push_back(parentSlot);
+	m_subtreeSizes.push_back(1);
+	m_px.push_back(position.x);
+	m_py.push_back(position.y);
+	m_pz.push_back(position.z);
+	m_qw.push_back(orientation.w);
+	m_qx.push_back(orientation.x);
+	m_qy.push_back(orientation.y);
+	m_qz.push_back(orientation.z);
+	m_sx.push_back(scale.x);
+	m_sy.push_back(scale.y);
+	m_sz.push_back(scale.z);
+	m_dirty.push_back(0);
+	m_world.push_back(glm::mat4());
+
+	// Sizes are all worked out again when sorting, no need to keep them until then
+	if(!m_outOfOrder)
+	{
+		for(unsigned int ancestor = parentSlot; ancestor != noParentNode; ancestor = m_parentSlots[ancestor])
+		{
+			++m_subtreeSizes[ancestor];
+		}
+	}
+
+	markDirty(slot);
+	return node;
+}
+
+void SceneGraph::setLocalPosition(unsigned int node, const glm::vec3 &position)
+{
+	const unsigned int slot = m_slots[node];
+	m_px[slot] = position.x;
+	m_py[slot] = position.y;
+	m_pz[slot] = position.z;
+	markDirty(slot);
+}
+
+void SceneGraph::setLocalOrientation(unsigned int node, const glm::fquat &orientation)
+{
+	const unsigned int slot = m_slots[node];
+	m_qw[slot] = orientation.w;
+	m_qx[slot] = orientation.x;
+	m_qy[slot] = orientation.y;
+	m_qz[slot] = orientation.z;
+	markDirty(slot);
+}
+
+void SceneGraph::setLocalScale(unsigned int node, const glm::vec3 &scale)
+{
+	const unsigned int slot = m_slots[node];
+	m_sx[slot] = scale.x;
+	m_sy[slot] = scale.y;
+	m_sz[slot] = scale.z;
+	markDirty(slot);
+}
+
+void SceneGraph::setLocalTransform(unsigned int node, const glm::vec3 &position, const glm::fquat &orientation)
+{
+	setLocalPosition(node, position);
+	setLocalOrientation(node, orientation);
+}
+
+glm::vec3 SceneGraph::getLocalPosition(unsigned int node) const
+{
+	const unsigned int slot = m_slots[node];
+	return glm::vec3(m_px[slot], m_py[slot], m_pz[slot]);
+}
+
+glm::fquat SceneGraph::getLocalOrientation(unsigned int node) const
+{
+	const unsigned int slot = m_slots[node];
+	return glm::fquat(m_qw[slot], m_qx[slot], m_qy[slot], m_qz[slot]);
+}
+
+glm::vec3 SceneGraph::getLocalScale(unsigned int node) const
+{
+	const unsigned int slot = m_slots[node];
+	return glm::vec3(m_sx[slot], m_sy[slot], m_sz[slot]);
+}
+
+void SceneGraph::markDirty(unsigned int slot)
+{
+	if(!m_dirty[slot])
+	{
+		m_dirty[slot] = 1;
+		m_dirtySlots.push_back(slot);
+	}
+}
+
+void SceneGraph::reorder()
+{
+	PROFILE_ZONE("Sort scene graph");
+
+	const unsigned int count = getNodeCount();
+
+	// Children in the order they were added, so the sort always comes out the same
+	std::vector<unsigned int> firstChild(count, noParentNode);
+	std::vector<unsigned int> nextSibling(count, noParentNode);
+	std::vector<unsigned int> lastChild(count, noParentNode);
+	std::vector<unsigned int> roots;
+	for(unsigned int node = 0; node < count; ++node)
+	{
+		const unsigned int parent = m_parents[node];
+		if(parent == noParentNode)
+		{
+			roots.push_back(node);
+		}
+		else if(firstChild[parent] == noParentNode)
+		{
+			firstChild[parent] = node;
+			lastChild[parent] = node;
+		}
+		else
+		{
+			nextSibling[lastChild[parent]] = node;
+			lastChild[parent] = node;
+		}
+	}
+
+	// Depth first, order[slot] is the node's old slot, which is its index until the first sort
+	std::vector<unsigned int> order;
+	order.reserve(count);
+	std::vector<unsigned int> stack;
+	for(unsigned int r = 0; r < roots.size(); ++r)
+	{
+		stack.push_back(roots[r]);
+		while(!stack.empty())
+		{
+			const unsigned int node = stack.back();
+			stack.pop_back();
+			order.push_back(m_slots[node]);
+
+			// Pushed last child first so the first comes off next
+			const unsigned int first = stack.size();
+			for(unsigned int child = firstChild[node]; child != noParentNode; child = nextSibling[child])
+			{
+				stack.push_back(child);
+			}
+			std::reverse(stack.begin() + first, stack.end());
+		}
+	}
+
+	std::vector<float> floats;
+	permute(m_px, order, floats);
+	permute(m_py, order, floats);
+	permute(m_pz, order, floats);
+	permute(m_qw, order, floats);
+	permute(m_qx, order, floats);
+	permute(m_qy, order, floats);
+	permute(m_qz, order, floats);
+	permute(m_sx, order, floats);
+	permute(m_sy, order, floats);
+	permute(m_sz, order, floats);
+	std::vector<unsigned int> indices;
+	permute(m_nodes, order, indices);
+
+	for(unsigned int slot = 0; slot < count; ++slot)
+	{
+		m_slots[m_nodes[slot]] = slot;
+	}
+
+	// Parents come first, so adding each size into its parent's from the back finishes every
+	// subtree before its parent is reached
+	for(unsigned int slot = 0; slot < count; ++slot)
+	{
+		const unsigned int parent = m_parents[m_nodes[slot]];
+		m_parentSlots[slot] = parent == noParentNode ? noParentNode : m_slots[parent];
+		m_subtreeSizes[slot] = 1;
+	}
+	for(unsigned int slot = count; slot-- > 0;)
+	{
+		if(m_parentSlots[slot] != noParentNode)
+		{
+			m_subtreeSizes[m_parentSlots[slot]] += m_subtreeSizes[slot];
+		}
+	}
+
+	// Marks were made against the old order, every root now covers everything anyway
+	std::fill(m_dirty.begin(), m_dirty.end(), 0);
+	m_dirtySlots.clear();
+	for(unsigned int r = 0; r < roots.size(); ++r)
+	{
+		markDirty(m_slots[roots[r]]);
+	}
+
+	m_outOfOrder = false;
+}
+
+void SceneGraph::update()
+{
+	PROFILE_ZONE("Update scene graph");
+
+	m_stats = SceneGraphStats();
+	m_stats.nodes = getNodeCount();
+	if(m_outOfOrder)
+	{
+		reorder();
+		m_stats.reordered = true;
+	}
+	m_stats.marked = (unsigned int)m_dirtySlots.size();
+
+	// A marked node inside a run already taken has been covered by it
+	std::sort(m_dirtySlots.begin(), m_dirtySlots.end());
+	const unsigned int grain = m_pool ? sceneGraphGrain : 0xffffffff;
+	m_ranges.clear();
+	unsigned int covered = 0;
+	for(unsigned int i = 0; i < m_dirtySlots.size(); ++i)
+	{
+		const unsigned int slot = m_dirtySlots[i];
+		m_dirty[slot] = 0;
+		if(slot < covered)
+		{
+			continue;
+		}
+
+		covered = slot + m_subtreeSizes[slot];
+		m_stats.updated += m_subtreeSizes[slot];
+		addRange(slot, covered, grain);
+	}
+	m_dirtySlots.clear();
+	m_stats.ranges = (unsigned int)m_ranges.size();
+
+	// Runs gathered into chunks of about a grain of nodes each
+	m_chunks.clear();
+	unsigned int nodes = 0;
+	for(unsigned int r = 0; r < m_ranges.size(); ++r)
+	{
+		if(m_chunks.empty() || nodes >= grain)
+		{
+			const Range chunk = { r, r };
+			m_chunks.push_back(chunk);
+			nodes = 0;
+		}
+		m_chunks.back().end = r + 1;
+		nodes += m_ranges[r].end - m_ranges[r].begin;
+	}
+	m_stats.chunks = (unsigned int)m_chunks.size();
+
+	if(m_pool && m_chunks.size() > 1)
+	{
+		m_pool->parallelFor((unsigned int)m_chunks.size(), 1, [this](unsigned int begin, unsigned int end)
+		{
+			PROFILE_ZONE("Scene graph chunk");
+			for(unsigned int c = begin; c < end; ++c)
+			{
+				for(unsigned int r = m_chunks[c].begin; r < m_chunks[c].end; ++r)
+				{
+					updateRange(m_ranges[r].begin, m_ranges[r].end);
+				}
+			}
+		});
+	}
+	else
+	{
+		for(unsigned int r = 0; r < m_ranges.size(); ++r)
+		{
+			updateRange(m_ranges[r].begin, m_ranges[r].end);
+		}
+	}
+}
+
+void SceneGraph::addRange(unsigned int begin, unsigned int end, unsigned int grain)
+{
+	if(end - begin <= grain)
+	{
+		const Range range = { begin, end };
+		m_ranges.push_back(range);
+		return;
+	}
+
+	// The children's runs read this node, so it is done before they are handed out
+	updateRange(begin, begin + 1);
+	for(unsigned int child = begin + 1; child < end; child += m_subtreeSizes[child])
+	{
+		addRange(child, child + m_subtreeSizes[child], grain);
+	}
+}
+
+void SceneGraph::updateRange(unsigned int begin, unsigned int end)
+{
+	// The local transforms a batch at a time straight into the world array, then each one
+	// times its parent's world in order, a parent always being done before its children.
+	// Nothing is staged on the stack, a range of one leaf costs one matrix.
+	for(unsigned int first = begin; first < end; first += localBatch)
+	{
+		const unsigned int count = std::min(localBatch, end - first);
+		const TransformSoA transforms = { &m_px[first], &m_py[first], &m_pz[first], &m_qw[first], &m_qx[first], &m_qy[first], &m_qz[first],
+			&m_sx[first], &m_sy[first], &m_sz[first], 1.0f, count };
+		composeModelMatrices(transforms, 0, count, glm::value_ptr(m_world[first]));
+
+		for(unsigned int i = first; i < first + count; ++i)
+		{
+			const unsigned int parent = m_parentSlots[i];
+			if(parent != noParentNode)
+			{
+				m_world[i] = m_world[parent] * m_world[i];
+			}
+		}
+	}
+}
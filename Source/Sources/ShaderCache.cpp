@@ -0,0 +1,477 @@
+/*
+	Name:			ShaderCache.cpp
+	Project:		OpenGL
+	Description:	Builds shader programs once, keeps linked binaries on disk and reloads edited shaders
+	Doc Version:	1.0
+	Author:			Jonathan Simon Jones
+	Date(D/M/Y):	16-10-2026
+	To do:
+*/
+
+#include "ShaderCache.h"
+
+// OS includes
+#include <sys/types.h>
+#include <sys/stat.h>
+#ifdef _WIN32
+#include <direct.h>
+#endif
+
+// STL includes
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+
+namespace
+{
+	typedef std::chrono::high_resolution_clock Clock;
+
+	// Fixed attribute locations, see ShaderCache.h
+	const char *attributeSlots[] = { "position", "color", "instancePosition", "instanceScale", "instanceOrientation" };
+	const unsigned int attributeSlotCount = sizeof(attributeSlots) / sizeof(attributeSlots[0]);
+
+	// FNV-1a, continued from hash so several strings can be folded together
+	unsigned long long hashText(const char *text, size_t size, unsigned long long hash = 14695981039346656037ull)
+	{
+		for(size_t i = 0; i < size; ++i)
+		{
+			hash ^= (unsigned char)text[i];
+			hash *= 1099511628211ull;
+		}
+
+		// Separator so "ab" + "c" and "a" + "bc" differ
+		hash ^= 0xff;
+		hash *= 1099511628211ull;
+		return hash;
+	}
+
+	time_t modifiedTime(const std::string &path)
+	{
+		struct stat info;
+		return stat(path.c_str(), &info) == 0 ? info.st_mtime : 0;
+	}
+
+	void makeDirectory(const std::string &path)
+	{
+#ifdef _WIN32
+		_mkdir(path.c_str());
+#else
+		mkdir(path.c_str(), 0755);
+#endif
+	}
+
+	// Returns 0 and prints the log if it did not compile
+	GLuint compileShader(GLenum type, const MappedFile &source, const std::string &path)
+	{
+		// Mapped files are not null terminated, so the length goes along with the text
+		const char *text = source.getData();
+		const GLint length = (GLint)source.getSize();
+		GLuint shader = glCreateShader(type);
+		glShaderSource(shader, 1, &text, &length);
+		glCompileShader(shader);
+
+		GLint status;
+		glGetShaderiv(shader, GL_COMPILE_STATUS, &status);
+		if(status != GL_TRUE)
+		{
+			char buffer[512];
+			glGetShaderInfoLog(shader, 512, NULL, buffer);
+			printf("Failed to compile %s, reasons to follow:\n%s\n", path.c_str(), buffer);
+			glDeleteShader(shader);
+			return 0;
+		}
+
+		return shader;
+	}
+
+	bool isLinked(GLuint program)
+	{
+		GLint status;
+		glGetProgramiv(program, GL_LINK_STATUS, &status);
+		return status == GL_TRUE;
+	}
+}
+
+ShaderCache::ShaderCache(AssetLoader &assets, const std::string &cacheDirectory, unsigned int pollMilliseconds): m_assets(assets)
+, m_cacheDirectory(cacheDirectory)
+, m_binariesSupported(false)
+, m_pollMilliseconds(pollMilliseconds)
+, m_quit(false)
+{
+	if(!m_cacheDirectory.empty() && GLEW_ARB_get_program_binary)
+	{
+		GLint formats = 0;
+		glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+		m_binariesSupported = formats > 0;
+	}
+
+	if(m_binariesSupported)
+	{
+		makeDirectory(m_cacheDirectory);
+
+		const char *renderer = (const char*)glGetString(GL_RENDERER);
+		const char *version = (const char*)glGetString(GL_VERSION);
+		m_driver = std::string(renderer ? renderer : "") + "|" + (version ? version : "");
+	}
+
+	m_watcher = std::thread(&ShaderCache::watchLoop, this);
+}
+
+ShaderCache::~ShaderCache()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_quit = true;
+	}
+	m_wake.notify_one();
+	m_watcher.join();
+
+	for(unsigned int i = 0; i < m_programs.size(); ++i)
+	{
+		if(m_programs[i].name)
+		{
+			glDeleteProgram(m_programs[i].name);
+		}
+	}
+}
+
+unsigned int ShaderCache::load(const std::string &vertexFile, const std::string &fragmentFile)
+{
+	for(unsigned int i = 0; i < m_programs.size(); ++i)
+	{
+		if(m_programs[i].vertexFile == vertexFile && m_programs[i].fragmentFile == fragmentFile)
+		{
+			return i;
+		}
+	}
+
+	const Clock::time_point start = Clock::now();
+
+	Program program;
+	program.vertexFile = vertexFile;
+	program.fragmentFile = fragmentFile;
+	program.name = 0;
+	program.hash = 0;
+	program.reloading = false;
+
+	// Both files are read at once on the loader threads
+	program.vertexAsset = m_assets.request(vertexFile);
+	program.fragmentAsset = m_assets.request(fragmentFile);
+	const bool vertexLoaded = m_assets.wait(program.vertexAsset);
+	const bool fragmentLoaded = m_assets.wait(program.fragmentAsset);
+	if(vertexLoaded && fragmentLoaded)
+	{
+		const MappedFile &vertexSource = m_assets.getFile(program.vertexAsset);
+		const MappedFile &fragmentSource = m_assets.getFile(program.fragmentAsset);
+		program.hash = hashSources(vertexSource, fragmentSource);
+		program.name = build(vertexFile, vertexSource, fragmentFile, fragmentSource, program.hash);
+	}
+	m_assets.release(program.vertexAsset);
+	m_assets.release(program.fragmentAsset);
+
+	if(!program.name)
+	{
+		printf("Could not build %s + %s\n", vertexFile.c_str(), fragmentFile.c_str());
+	}
+
+	const unsigned int handle = (unsigned int)m_programs.size();
+	m_programs.push_back(program);
+	if(program.name)
+	{
+		m_handleByName[program.name] = handle;
+	}
+
+	// Watch both files, even if they are missing now they may turn up later
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		WatchedFile vertex = { vertexFile, handle, modifiedTime(vertexFile) };
+		WatchedFile fragment = { fragmentFile, handle, modifiedTime(fragmentFile) };
+		m_watched.push_back(vertex);
+		m_watched.push_back(fragment);
+	}
+
+	m_stats.seconds += std::chrono::duration<double>(Clock::now() - start).count();
+	return handle;
+}
+
+GLint ShaderCache::getUniformLocation(unsigned int handle, const std::string &name)
+{
+	Program &program = m_programs[handle];
+	std::map<std::string, GLint>::iterator it = program.uniforms.find(name);
+	if(it == program.uniforms.end())
+	{
+		it = program.uniforms.insert(std::make_pair(name, program.name ? glGetUniformLocation(program.name, name.c_str()) : -1)).first;
+	}
+
+	return it->second;
+}
+
+GLint ShaderCache::getAttribLocation(unsigned int handle, const std::string &name)
+{
+	Program &program = m_programs[handle];
+	std::map<std::string, GLint>::iterator it = program.attributes.find(name);
+	if(it == program.attributes.end())
+	{
+		it = program.attributes.insert(std::make_pair(name, program.name ? glGetAttribLocation(program.name, name.c_str()) : -1)).first;
+	}
+
+	return it->second;
+}
+
+GLint ShaderCache::getProgramUniformLocation(GLuint program, const std::string &name)
+{
+	std::map<GLuint, unsigned int>::const_iterator it = m_handleByName.find(program);
+	return it == m_handleByName.end() ? -1 : getUniformLocation(it->second, name);
+}
+
+bool ShaderCache::update()
+{
+	std::vector<unsigned int> changed;
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		changed.swap(m_changed);
+	}
+
+	// Both files of a program changing in one poll lists it twice
+	std::sort(changed.begin(), changed.end());
+	changed.erase(std::unique(changed.begin(), changed.end()), changed.end());
+
+	// Start reading the changed files. A program still waiting on an earlier read may have
+	// missed the newer text, so it is asked again once that read has been dealt with.
+	std::vector<unsigned int> deferred;
+	for(unsigned int i = 0; i < changed.size(); ++i)
+	{
+		Program &program = m_programs[changed[i]];
+		if(program.reloading)
+		{
+			deferred.push_back(changed[i]);
+		}
+		else
+		{
+			program.vertexAsset = m_assets.request(program.vertexFile);
+			program.fragmentAsset = m_assets.request(program.fragmentFile);
+			program.reloading = true;
+		}
+	}
+
+	if(!deferred.empty())
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_changed.insert(m_changed.end(), deferred.begin(), deferred.end());
+	}
+
+	const Clock::time_point start = Clock::now();
+	bool replaced = false;
+
+	for(unsigned int i = 0; i < m_programs.size(); ++i)
+	{
+		const Program &program = m_programs[i];
+		if(program.reloading && m_assets.getState(program.vertexAsset) != AssetLoading && m_assets.getState(program.fragmentAsset) != AssetLoading)
+		{
+			replaced = rebuild(i) || replaced;
+		}
+	}
+
+	m_stats.seconds += std::chrono::duration<double>(Clock::now() - start).count();
+	return replaced;
+}
+
+unsigned long long ShaderCache::hashSources(const MappedFile &vertexSource, const MappedFile &fragmentSource) const
+{
+	unsigned long long hash = hashText(m_driver.c_str(), m_driver.size());
+	hash = hashText(vertexSource.getData(), vertexSource.getSize(), hash);
+	return hashText(fragmentSource.getData(), fragmentSource.getSize(), hash);
+}
+
+bool ShaderCache::rebuild(unsigned int handle)
+{
+	Program &program = m_programs[handle];
+	program.reloading = false;
+
+	bool replaced = false;
+	if(m_assets.getState(program.vertexAsset) == AssetReady && m_assets.getState(program.fragmentAsset) == AssetReady)
+	{
+		const MappedFile &vertexSource = m_assets.getFile(program.vertexAsset);
+		const MappedFile &fragmentSource = m_assets.getFile(program.fragmentAsset);
+
+		// Saving a file without changing it touches the time but not the text
+		const unsigned long long hash = hashSources(vertexSource, fragmentSource);
+		const GLuint name = (hash == program.hash && program.name) ? 0 : build(program.vertexFile, vertexSource, program.fragmentFile, fragmentSource, hash);
+
+		if(name)
+		{
+			if(program.name)
+			{
+				m_handleByName.erase(program.name);
+				glDeleteProgram(program.name);
+			}
+
+			program.name = name;
+			program.hash = hash;
+			program.uniforms.clear();
+			program.attributes.clear();
+			m_handleByName[name] = handle;
+
+			++m_stats.reloads;
+			replaced = true;
+			printf("Reloaded %s + %s\n", program.vertexFile.c_str(), program.fragmentFile.c_str());
+		}
+		else if(hash != program.hash)
+		{
+			printf("Keeping the last working build of %s + %s\n", program.vertexFile.c_str(), program.fragmentFile.c_str());
+		}
+	}
+
+	m_assets.release(program.vertexAsset);
+	m_assets.release(program.fragmentAsset);
+	return replaced;
+}
+
+GLuint ShaderCache::build(const std::string &vertexFile, const MappedFile &vertexSource, const std::string &fragmentFile, const MappedFile &fragmentSource, unsigned long long hash)
+{
+	if(m_binariesSupported)
+	{
+		const GLuint program = loadBinary(hash);
+		if(program)
+		{
+			return program;
+		}
+	}
+
+	const GLuint vertexShader = compileShader(GL_VERTEX_SHADER, vertexSource, vertexFile);
+	const GLuint fragmentShader = compileShader(GL_FRAGMENT_SHADER, fragmentSource, fragmentFile);
+	m_stats.compiles += 2;
+
+	if(!vertexShader || !fragmentShader)
+	{
+		glDeleteShader(vertexShader);
+		glDeleteShader(fragmentShader);
+		return 0;
+	}
+
+	GLuint program = glCreateProgram();
+	glAttachShader(program, vertexShader);
+	glAttachShader(program, fragmentShader);
+
+	for(unsigned int i = 0; i < attributeSlotCount; ++i)
+	{
+		glBindAttribLocation(program, i, attributeSlots[i]);
+	}
+	glBindFragDataLocation(program, 0, "outColor");
+
+	if(m_binariesSupported)
+	{
+		glProgramParameteri(program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+	}
+
+	glLinkProgram(program);
+	++m_stats.links;
+
+	// The program keeps what it needs, the shaders can go now
+	glDetachShader(program, vertexShader);
+	glDetachShader(program, fragmentShader);
+	glDeleteShader(vertexShader);
+	glDeleteShader(fragmentShader);
+
+	if(!isLinked(program))
+	{
+		char buffer[512];
+		glGetProgramInfoLog(program, 512, NULL, buffer);
+		printf("Failed to link program, reasons to follow:\n%s\n", buffer);
+		glDeleteProgram(program);
+		return 0;
+	}
+
+	if(m_binariesSupported)
+	{
+		saveBinary(program, hash);
+	}
+
+	return program;
+}
+
+GLuint ShaderCache::loadBinary(unsigned long long hash)
+{
+	std::ifstream file(binaryPath(hash).c_str(), std::ios::in | std::ios::binary);
+	if(!file)
+	{
+		return 0;
+	}
+
+	// A GLenum format followed by the binary itself
+	GLenum format = 0;
+	if(!file.read((char*)&format, sizeof(format)))
+	{
+		return 0;
+	}
+
+	std::vector<char> binary((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+	if(binary.empty())
+	{
+		return 0;
+	}
+
+	GLuint program = glCreateProgram();
+	glProgramBinary(program, format, &binary[0], (GLsizei)binary.size());
+
+	// A driver update makes old binaries fail here, in which case we just compile
+	if(!isLinked(program))
+	{
+		glDeleteProgram(program);
+		return 0;
+	}
+
+	++m_stats.binaryLoads;
+	return program;
+}
+
+void ShaderCache::saveBinary(GLuint program, unsigned long long hash)
+{
+	GLint length = 0;
+	glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+	if(length <= 0)
+	{
+		return;
+	}
+
+	std::vector<char> binary(length);
+	GLenum format = 0;
+	glGetProgramBinary(program, length, NULL, &format, &binary[0]);
+
+	std::ofstream file(binaryPath(hash).c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+	file.write((const char*)&format, sizeof(format));
+	file.write(&binary[0], length);
+	if(file)
+	{
+		++m_stats.binarySaves;
+	}
+}
+
+std::string ShaderCache::binaryPath(unsigned long long hash) const
+{
+	char name[32];
+	sprintf(name, "%016llx.bin", hash);
+	return m_cacheDirectory + "/" + name;
+}
+
+void ShaderCache::watchLoop()
+{
+	std::unique_lock<std::mutex> lock(m_mutex);
+	while(!m_quit)
+	{
+		m_wake.wait_for(lock, std::chrono::milliseconds(m_pollMilliseconds));
+
+		// stat is quick, the real work happens on the GL thread in update
+		for(unsigned int i = 0; i < m_watched.size() && !m_quit; ++i)
+		{
+			WatchedFile &watched = m_watched[i];
+			const time_t modified = modifiedTime(watched.path);
+			if(modified != watched.modified)
+			{
+				watched.modified = modified;
+				m_changed.push_back(watched.handle);
+			}
+		}
+	}
+}
@@ -0,0 +1,62 @@
+/*
+	Name:			Simd.cpp
+	Project:		OpenGL
+	Description:	SIMD instruction set detection
+	Doc Version:	1.0
+	Author:			Jonathan Simon Jones
+	Date(D/M/Y):	16-10-2026
+	To do:
+*/
+
+#include "Simd.h"
+
+namespace
+{
+	SimdLevel detectSimdLevel()
+	{
+#if !SIMD_HAS_SSE2
+		return SimdScalar;
+#elif defined(_MSC_VER)
+		int info[4];
+		__cpuid(info, 0);
+		if(info[0] < 7)
+		{
+			return SimdSSE2;
+		}
+
+		// The OS has to save the YMM registers as well as the CPU having the instructions
+		__cpuid(info, 1);
+		const bool osxsave = (info[2] & (1 << 27)) != 0;
+		const bool avx = (info[2] & (1 << 28)) != 0;
+		if(!osxsave || !avx || (_xgetbv(0) & 0x6) != 0x6)
+		{
+			return SimdSSE2;
+		}
+
+		__cpuidex(info, 7, 0);
+		return (info[1] & (1 << 5)) ? SimdAVX2 : SimdSSE2;
+#else
+		__builtin_cpu_init();
+		return __builtin_cpu_supports("avx2") ? SimdAVX2 : SimdSSE2;
+#endif
+	}
+}
+
+SimdLevel getSimdLevel()
+{
+	static const SimdLevel level = detectSimdLevel();
+	return level;
+}
+
+const char* getSimdLevelName(SimdLevel level)
+{
+	switch(level)
+	{
+	case SimdAVX2:
+		return "AVX2";
+	case SimdSSE2:
+		return "SSE2";
+	default:
+		return "scalar";
+	}
+}
@@ -0,0 +1,193 @@
+/*
+	Name:			SimulationThread.cpp
+	Project:		OpenGL
+	Description:	Steps the scene at its fixed rate on a thread of its own and hands snapshots to the renderer
+	Doc Version:	1.0
+	Author:			Jonathan Simon Jones
+	Date(D/M/Y):	16-10-2026
+	To do:
+*/
+
+#include "SimulationThread.h"
+#include "Profiler.h"
+
+// STL includes
+#include <algorithm>
+#include <chrono>
+#include <utility>
+
+namespace
+{
+	typedef std::chrono::steady_clock Clock;
+
+	// Raises value to at least candidate, only one thread ever writes it
+	void raiseTo(std::atomic<unsigned long long> &value, unsigned long long candidate)
+	{
+		if(candidate > value.load(std::memory_order_relaxed))
+		{
+			value.store(candidate, std::memory_order_relaxed);
+		}
+	}
+}
+
+SimulationThread::SimulationThread(Scene &scene): m_scene(scene)
+, m_dt(scene.world.getFixedDt())
+, m_running(false)
+, m_stepDelay(0)
+, m_steps(0)
+, m_lateSteps(0)
+, m_droppedSteps(0)
+, m_unreadSnapshots(0)
+, m_longestStepGap(0)
+{
+}
+
+SimulationThread::~SimulationThread()
+{
+	stop();
+}
+
+void SimulationThread::start()
+{
+	if(isRunning())
+	{
+		return;
+	}
+
+	SceneSnapshot &snapshot = m_snapshots.getWriteBuffer();
+	takeSceneSnapshot(m_scene, m_scene.world.getStepCount() * (double)m_dt, m_scene.world.getStepCount(), snapshot);
+	snapshot.published = profilerNow();
+	m_snapshots.publish();
+
+	m_box2Positions.getWriteBuffer() = m_scene.box2Pos;
+	m_running.store(true);
+	m_thread = std::thread(&SimulationThread::run, this);
+}
+
+void SimulationThread::stop()
+{
+	if(!isRunning())
+	{
+		return;
+	}
+
+	m_running.store(false);
+	m_thread.join();
+}
+
+void SimulationThread::interpolate(SceneSnapshot &out)
+{
+	const unsigned long long start = profilerNow();
+	++m_renderStats.frames;
+
+	// The read buffer is handed back as acquire takes the new one, so what it holds is
+	// swapped out first and kept as the previous snapshot
+	if(m_snapshots.isFresh())
+	{
+		std::swap(m_previous, m_snapshots.getReadBuffer());
+		m_snapshots.acquire();
+
+		const unsigned long long latency = start - std::min(start, m_snapshots.getReadBuffer().published);
+		++m_renderStats.snapshotsTaken;
+		m_renderStats.totalLatency += latency;
+		m_renderStats.maxLatency = std::max(m_renderStats.maxLatency, latency);
+	}
+	else
+	{
+		++m_renderStats.staleFrames;
+	}
+
+	// What is drawn runs a step behind the newer snapshot and reaches it one step after it
+	// was published, a simulation that stalls leaves it there rather than guessing where
+	// things went
+	const SceneSnapshot &current = m_snapshots.getReadBuffer();
+	const SceneSnapshot &previous = m_previous.published != 0 ? m_previous : current;
+	const double stepNanoseconds = m_dt * 1e9;
+	const double elapsed = (double)(start - std::min(start, current.published));
+	double alpha = std::min(1.0, elapsed / stepNanoseconds);
+
+	// The previous snapshot is the one the last frame took, which is several steps back when
+	// the simulation outruns the frames. The blend is rescaled over the time between the two
+	// so what is drawn still trails the newer one by what is left of a step.
+	const double gap = current.time - previous.time;
+	if(gap > m_dt)
+	{
+		alpha = std::max(0.0, 1.0 - (1.0 - alpha) * m_dt / gap);
+	}
+	interpolateSceneSnapshots(previous, current, (float)alpha, out);
+
+	m_renderStats.longestInterpolate = std::max(m_renderStats.longestInterpolate, profilerNow() - start);
+}
+
+void SimulationThread::setBox2Position(const glm::vec3 &position)
+{
+	m_box2Positions.getWriteBuffer() = position;
+	m_box2Positions.publish();
+}
+
+SimulationThreadStats SimulationThread::getStats() const
+{
+	SimulationThreadStats stats = m_renderStats;
+	stats.steps = m_steps.load(std::memory_order_relaxed);
+	stats.lateSteps = m_lateSteps.load(std::memory_order_relaxed);
+	stats.droppedSteps = m_droppedSteps.load(std::memory_order_relaxed);
+	stats.unreadSnapshots = m_unreadSnapshots.load(std::memory_order_relaxed);
+	stats.longestStepGap = m_longestStepGap.load(std::memory_order_relaxed);
+	return stats;
+}
+
+void SimulationThread::run()
+{
+	setProfilerThreadName("Simulation");
+
+	const Clock::duration step = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(m_dt));
+	Clock::time_point due = Clock::now();
+	Clock::time_point lastStart = due;
+
+	while(m_running.load(std::memory_order_acquire))
+	{
+		const Clock::time_point now = Clock::now();
+		raiseTo(m_longestStepGap, (unsigned long long)std::chrono::duration_cast<std::chrono::nanoseconds>(now - lastStart).count());
+		lastStart = now;
+
+		// A late step is run straight away to catch up, too far behind and the time is dropped
+		if(now - due > step)
+		{
+			m_lateSteps.fetch_add(1, std::memory_order_relaxed);
+			if(now - due > step * maxCatchUpSteps)
+			{
+				m_droppedSteps.fetch_add((unsigned long long)((now - due) / step), std::memory_order_relaxed);
+				due = now;
+			}
+		}
+
+		{
+			PROFILE_ZONE("Simulation step");
+
+			if(m_box2Positions.acquire())
+			{
+				m_scene.box2Pos = m_box2Positions.getReadBuffer();
+			}
+			updateScene(m_scene, m_dt);
+
+			const unsigned int delay = m_stepDelay.load(std::memory_order_relaxed);
+			if(delay > 0)
+			{
+				std::this_thread::sleep_for(std::chrono::microseconds(delay));
+			}
+
+			SceneSnapshot &snapshot = m_snapshots.getWriteBuffer();
+			const unsigned long long steps = m_scene.world.getStepCount();
+			takeSceneSnapshot(m_scene, steps * (double)m_dt, steps, snapshot);
+			snapshot.published = profilerNow();
+			if(!m_snapshots.publish())
+			{
+				m_unreadSnapshots.fetch_add(1, std::memory_order_relaxed);
+			}
+		}
+		m_steps.fetch_add(1, std::memory_order_relaxed);
+
+		due += step;
+		std::this_thread::sleep_until(due);
+	}
+}
@@ -0,0 +1,1019 @@
+/*
+	Name:			SoftwareRenderBackend.cpp
+	Project:		OpenGL
+	Description:	Render backend that draws the queue's commands on the CPU into tiles of a framebuffer
+	Doc Version:	1.0
+	Author:			Jonathan Simon Jones
+	Date(D/M/Y):	16-10-2026
+	To do:
+*/
+
+#include "SoftwareRenderBackend.h"
+#include "BatchTransform.h"
+#include "Profiler.h"
+#include "ThreadPool.h"
+
+// Math includes
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/quaternion.hpp>
+#include <glm/gtc/type_ptr.hpp>
+
+// STL includes
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+
+namespace
+{
+	// GL_TRIANGLES, repeated here so the backend does not need the GL headers
+	const unsigned int triangleList = 0x0004;
+
+	// Roughly this many triangles make up one job of the vertex stage
+	const unsigned int batchTriangles = 256;
+
+	// Bits of sub pixel precision in the fixed point screen positions
+	const int subPixelBits = 4;
+	const int subPixelScale = 1 << subPixelBits;
+
+	// A polygon clipped by all six planes of the frustum gains at most one corner per plane
+	const unsigned int maxClipVertices = 9;
+
+	// Position in clip space and the color the vertex shader passes on
+	struct ClipVertex
+	{
+		float x, y, z, w;
+		float color[4];
+	};
+
+	// Distance inside plane p of the clip volume, -w <= x, y, z <= w
+	float clipDistance(const ClipVertex &v, unsigned int p)
+	{
+		switch(p)
+		{
+		case 0: return v.w + v.x;
+		case 1: return v.w - v.x;
+		case 2: return v.w + v.y;
+		case 3: return v.w - v.y;
+		case 4: return v.w + v.z;
+		default: return v.w - v.z;
+		}
+	}
+
+	// Bit per plane the vertex lies outside of
+	unsigned int outcode(const ClipVertex &v)
+	{
+		unsigned int code = 0;
+		for(unsigned int p = 0; p < 6; ++p)
+		{
+			code |= clipDistance(v, p) < 0.0f ? 1u << p : 0u;
+		}
+		return code;
+	}
+
+	ClipVertex lerp(const ClipVertex &a, const ClipVertex &b, float t)
+	{
+		ClipVertex v;
+		v.x = a.x + (b.x - a.x) * t;
+		v.y = a.y + (b.y - a.y) * t;
+		v.z = a.z + (b.z - a.z) * t;
+		v.w = a.w + (b.w - a.w) * t;
+		for(unsigned int c = 0; c < 4; ++c)
+		{
+			v.color[c] = a.color[c] + (b.color[c] - a.color[c]) * t;
+		}
+		return v;
+	}
+
+	// Sutherland-Hodgman against every plane in planes, returns the corners left
+	unsigned int clipPolygon(ClipVertex polygon[maxClipVertices], unsigned int count, unsigned int planes)
+	{
+		ClipVertex clipped[maxClipVertices];
+		for(unsigned int p = 0; p < 6 && count >= 3; ++p)
+		{
+			if(!(planes & (1u << p)))
+			{
+				continue;
+			}
+
+			unsigned int kept = 0;
+			for(unsigned int i = 0; i < count; ++i)
+			{
+				const ClipVertex &a = polygon[i];
+				const ClipVertex &b = polygon[(i + 1) % count];
+				const float da = clipDistance(a, p);
+				const float db = clipDistance(b, p);
+
+				if(da >= 0.0f)
+				{
+					clipped[kept++] = a;
+				}
+				if((da >= 0.0f) != (db >= 0.0f))
+				{
+					clipped[kept++] = lerp(a, b, da / (da - db));
+				}
+			}
+
+			count = kept;
+			std::copy(clipped, clipped + count, polygon);
+		}
+
+		return count;
+	}
+
+	// Packs colors in [0, 1] as RGBA bytes, R lowest
+	unsigned int packColor(const float color[4])
+	{
+		unsigned int packed = 0;
+		for(unsigned int c = 0; c < 4; ++c)
+		{
+			const float clamped = color[c] < 0.0f ? 0.0f : (color[c] > 1.0f ? 1.0f : color[c]);
+			packed |= (unsigned int)(int)(clamped * 255.0f + 0.5f) << (c * 8);
+		}
+		return packed;
+	}
+
+	// Lanes of a quad of pixels starting at quadX that lie in [first, last]
+	unsigned int laneMask(int quadX, int first, int last)
+	{
+		unsigned int mask = 0xF;
+		if(first > quadX)
+		{
+			mask &= 0xFu << (first - quadX);
+		}
+		if(last < quadX + 3)
+		{
+			mask &= 0xFu >> (quadX + 3 - last);
+		}
+		return mask & 0xF;
+	}
+
+	const unsigned int laneCounts[16] = { 0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4 };
+
+	// Edge function of the edge from a to b, positive inside a triangle wound with positive
+	// area. Pixel centres exactly on an edge belong to the triangle only if it is a top or a
+	// left edge, so triangles sharing the edge never both draw them.
+	struct Edge
+	{
+		int stepX;						// Change for one pixel right
+		int stepY;						// Change for one pixel down
+		int value;						// At the centre of the first pixel
+	};
+
+	Edge makeEdge(int ax, int ay, int bx, int by, int pixelX, int pixelY)
+	{
+		const int a = ay - by;
+		const int b = bx - ax;
+		const bool topLeft = a > 0 || (a == 0 && b > 0);
+
+		const long long centreX = (long long)pixelX * subPixelScale + subPixelScale / 2;
+		const long long centreY = (long long)pixelY * subPixelScale + subPixelScale / 2;
+		const long long c = (long long)ax * by - (long long)ay * bx;
+
+		Edge edge;
+		edge.stepX = a * subPixelScale;
+		edge.stepY = b * subPixelScale;
+		edge.value = (int)(a * centreX + b * centreY + c + (topLeft ? 0 : -1));
+		return edge;
+	}
+
+	// The per pixel work for one quad, lanes outside mask are left alone. Same sums in the
+	// same order as the SSE2 version so both draw the same image.
+	unsigned int shadeQuadScalar(const int e0[4], const int e2[4], unsigned int mask, const float depth[3], const float invW[3],
+		const float color[4][3], bool blend, unsigned int *colorRow, float *depthRow)
+	{
+		unsigned int written = 0;
+		for(unsigned int lane = 0; lane < 4; ++lane)
+		{
+			if(!(mask & (1u << lane)))
+			{
+				continue;
+			}
+
+			const float f0 = (float)e0[lane];
+			const float f2 = (float)e2[lane];
+			const float z = depth[0] + depth[1] * f2 + depth[2] * f0;
+			if(!(z < depthRow[lane]))
+			{
+				continue;
+			}
+
+			const float w = 1.0f / (invW[0] + invW[1] * f2 + invW[2] * f0);
+			unsigned int packed = 0;
+			for(unsigned int c = 0; c < 4; ++c)
+			{
+				float value = (color[c][0] + color[c][1] * f2 + color[c][2] * f0) * w;
+				value = value < 0.0f ? 0.0f : (value > 1.0f ? 1.0f : value);
+				if(blend)
+				{
+					const float destination = (float)(int)((colorRow[lane] >> (c * 8)) & 0xFF) * (1.0f / 255.0f);
+					value = value * value + destination * (1.0f - value);
+				}
+				packed |= (unsigned int)(int)(value * 255.0f + 0.5f) << (c * 8);
+			}
+
+			colorRow[lane] = packed;
+			depthRow[lane] = z;
+			++written;
+		}
+
+		return written;
+	}
+
+#if SIMD_HAS_SSE2
+	const unsigned int laneBits[16][4] = {
+		{ 0, 0, 0, 0 }, { ~0u, 0, 0, 0 }, { 0, ~0u, 0, 0 }, { ~0u, ~0u, 0, 0 },
+		{ 0, 0, ~0u, 0 }, { ~0u, 0, ~0u, 0 }, { 0, ~0u, ~0u, 0 }, { ~0u, ~0u, ~0u, 0 },
+		{ 0, 0, 0, ~0u }, { ~0u, 0, 0, ~0u }, { 0, ~0u, 0, ~0u }, { ~0u, ~0u, 0, ~0u },
+		{ 0, 0, ~0u, ~0u }, { ~0u, 0, ~0u, ~0u }, { 0, ~0u, ~0u, ~0u }, { ~0u, ~0u, ~0u, ~0u }
+	};
+
+	unsigned int shadeQuadSSE2(__m128i e0, __m128i e2, unsigned int mask, const float depth[3], const float invW[3],
+		const float color[4][3], bool blend, unsigned int *colorRow, float *depthRow)
+	{
+		const __m128 f0 = _mm_cvtepi32_ps(e0);
+		const __m128 f2 = _mm_cvtepi32_ps(e2);
+
+		const __m128 z = _mm_add_ps(_mm_add_ps(_mm_set1_ps(depth[0]), _mm_mul_ps(_mm_set1_ps(depth[1]), f2)), _mm_mul_ps(_mm_set1_ps(depth[2]), f0));
+		const __m128 oldDepth = _mm_loadu_ps(depthRow);
+		const __m128 pass = _mm_and_ps(_mm_cmplt_ps(z, oldDepth), _mm_loadu_ps((const float*)laneBits[mask]));
+		const unsigned int passMask = (unsigned int)_mm_movemask_ps(pass);
+		if(passMask == 0)
+		{
+			return 0;
+		}
+
+		const __m128 one = _mm_set1_ps(1.0f);
+		const __m128 zero = _mm_setzero_ps();
+		const __m128 iw = _mm_add_ps(_mm_add_ps(_mm_set1_ps(invW[0]), _mm_mul_ps(_mm_set1_ps(invW[1]), f2)), _mm_mul_ps(_mm_set1_ps(invW[2]), f0));
+		const __m128 w = _mm_div_ps(one, iw);
+
+		const __m128i oldColor = _mm_loadu_si128((const __m128i*)colorRow);
+		__m128i packed = _mm_setzero_si128();
+		for(unsigned int c = 0; c < 4; ++c)
+		{
+			__m128 value = _mm_add_ps(_mm_add_ps(_mm_set1_ps(color[c][0]), _mm_mul_ps(_mm_set1_ps(color[c][1]), f2)), _mm_mul_ps(_mm_set1_ps(color[c][2]), f0));
+			value = _mm_min_ps(_mm_max_ps(_mm_mul_ps(value, w), zero), one);
+			if(blend)
+			{
+				const __m128i bytes = _mm_and_si128(_mm_srli_epi32(oldColor, (int)(c * 8)), _mm_set1_epi32(0xFF));
+				const __m128 destination = _mm_mul_ps(_mm_cvtepi32_ps(bytes), _mm_set1_ps(1.0f / 255.0f));
+				value = _mm_add_ps(_mm_mul_ps(value, value), _mm_mul_ps(destination, _mm_sub_ps(one, value)));
+			}
+			const __m128i channel = _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(value, _mm_set1_ps(255.0f)), _mm_set1_ps(0.5f)));
+			packed = _mm_or_si128(packed, _mm_slli_epi32(channel, (int)(c * 8)));
+		}
+
+		const __m128i passBits = _mm_castps_si128(pass);
+		_mm_storeu_si128((__m128i*)colorRow, _mm_or_si128(_mm_and_si128(passBits, packed), _mm_andnot_si128(passBits, oldColor)));
+		_mm_storeu_ps(depthRow, _mm_or_ps(_mm_and_ps(pass, z), _mm_andnot_ps(pass, oldDepth)));
+
+		return laneCounts[passMask];
+	}
+#endif
+
+	// x, y, z and w of vertices [first, first + count) through mvp, written as four runs of
+	// count rounded up to 4. Same sums in the same order at every level.
+	void transformScalar(const glm::mat4 &mvp, const float *vertices, unsigned int first, unsigned int count, float *clip)
+	{
+		const unsigned int stride = (count + 3) & ~3u;
+		for(unsigned int i = 0; i < count; ++i)
+		{
+			const float *v = &vertices[(first + i) * meshVertexFloats];
+			for(unsigned int row = 0; row < 4; ++row)
+			{
+				clip[row * stride + i] = mvp[0][row] * v[0] + mvp[1][row] * v[1] + mvp[2][row] * v[2] + mvp[3][row];
+			}
+		}
+	}
+
+#if SIMD_HAS_SSE2
+	void transformSSE2(const glm::mat4 &mvp, const float *vertices, unsigned int first, unsigned int count, float *clip)
+	{
+		const unsigned int stride = (count + 3) & ~3u;
+		for(unsigned int i = 0; i < count; i += 4)
+		{
+			// Gathered from the interleaved vertices, the last one repeated to fill the register
+			float px[4], py[4], pz[4];
+			for(unsigned int lane = 0; lane < 4; ++lane)
+			{
+				const float *v = &vertices[(first + std::min(i + lane, count - 1)) * meshVertexFloats];
+				px[lane] = v[0];
+				py[lane] = v[1];
+				pz[lane] = v[2];
+			}
+			const __m128 x = _mm_loadu_ps(px);
+			const __m128 y = _mm_loadu_ps(py);
+			const __m128 z = _mm_loadu_ps(pz);
+
+			for(unsigned int row = 0; row < 4; ++row)
+			{
+				__m128 sum = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(mvp[0][row]), x), _mm_mul_ps(_mm_set1_ps(mvp[1][row]), y));
+				sum = _mm_add_ps(_mm_add_ps(sum, _mm_mul_ps(_mm_set1_ps(mvp[2][row]), z)), _mm_set1_ps(mvp[3][row]));
+				_mm_storeu_ps(&clip[row * stride + i], sum);
+			}
+		}
+	}
+#endif
+
+	// The model matrix color3DInstanced.vert builds from an instance
+	glm::mat4 instanceModel(const CubeInstance &instance)
+	{
+		const glm::fquat orientation(instance.orientation[3], instance.orientation[0], instance.orientation[1], instance.orientation[2]);
+		return composeModelMatrix(glm::vec3(instance.position[0], instance.position[1], instance.position[2]), orientation,
+			glm::vec3(instance.scale[0], instance.scale[1], instance.scale[2]));
+	}
+
+	const unsigned int *crcTable()
+	{
+		static unsigned int table[256];
+		static bool built = false;
+		if(!built)
+		{
+			for(unsigned int n = 0; n < 256; ++n)
+			{
+				unsigned int c = n;
+				for(unsigned int k = 0; k < 8; ++k)
+				{
+					c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+				}
+				table[n] = c;
+			}
+			built = true;
+		}
+		return table;
+	}
+
+	void appendBigEndian(std::vector<unsigned char> &out, unsigned int value)
+	{
+		out.push_back((unsigned char)(value >> 24));
+		out.push_back((unsigned char)(value >> 16));
+		out.push_back((unsigned char)(value >> 8));
+		out.push_back((unsigned char)value);
+	}
+
+	// Length, type, data and the CRC of type and data
+	void appendChunk(std::vector<unsigned char> &out, const char type[4], const std::vector<unsigned char> &data)
+	{
+		appendBigEndian(out, (unsigned int)data.size());
+		const size_t start = out.size();
+		out.insert(out.end(), type, type + 4);
+		out.insert(out.end(), data.begin(), data.end());
+
+		const unsigned int *table = crcTable();
+		unsigned int crc = 0xFFFFFFFFu;
+		for(size_t i = start; i < out.size(); ++i)
+		{
+			crc = table[(crc ^ out[i]) & 0xFF] ^ (crc >> 8);
+		}
+		appendBigEndian(out, crc ^ 0xFFFFFFFFu);
+	}
+}
+
+Framebuffer::Framebuffer(unsigned int width, unsigned int height): m_width(width)
+, m_height(height)
+, m_stride((width + softwareTileSize - 1) / softwareTileSize * softwareTileSize)
+, m_color(m_stride * height, 0)
+, m_depth(m_stride * height, 1.0f)
+{
+}
+
+unsigned long long Framebuffer::hash() const
+{
+	unsigned long long hash = 14695981039346656037ull;
+	for(unsigned int y = 0; y < m_height; ++y)
+	{
+		const unsigned char *row = (const unsigned char*)&m_color[y * m_stride];
+		for(unsigned int i = 0; i < m_width * 4; ++i)
+		{
+			hash = (hash ^ row[i]) * 1099511628211ull;
+		}
+	}
+	return hash;
+}
+
+bool Framebuffer::writePng(const char *path) const
+{
+	// Each row is a filter type byte, none, then the pixels
+	const size_t rowBytes = 1 + (size_t)m_width * 4;
+	std::vector<unsigned char> raw(rowBytes * m_height);
+	for(unsigned int y = 0; y < m_height; ++y)
+	{
+		raw[y * rowBytes] = 0;
+		memcpy(&raw[y * rowBytes + 1], &m_color[y * m_stride], (size_t)m_width * 4);
+	}
+
+	std::vector<unsigned char> header;
+	appendBigEndian(header, m_width);
+	appendBigEndian(header, m_height);
+	const unsigned char format[5] = { 8, 6, 0, 0, 0 };		// 8 bits, RGBA, deflate, no filtering, no interlace
+	header.insert(header.end(), format, format + 5);
+
+	// A zlib stream of stored deflate blocks, at most 65535 bytes each, then the Adler-32 of it all
+	std::vector<unsigned char> data;
+	data.reserve(raw.size() + raw.size() / 65535 * 5 + 16);
+	data.push_back(0x78);
+	data.push_back(0x01);
+	size_t offset = 0;
+	do
+	{
+		const unsigned int length = (unsigned int)std::min<size_t>(raw.size() - offset, 65535);
+		data.push_back(offset + length == raw.size() ? 1 : 0);
+		data.push_back((unsigned char)length);
+		data.push_back((unsigned char)(length >> 8));
+		data.push_back((unsigned char)~length);
+		data.push_back((unsigned char)(~length >> 8));
+		data.insert(data.end(), raw.begin() + offset, raw.begin() + offset + length);
+		offset += length;
+	}
+	while(offset < raw.size());
+
+	unsigned int a = 1;
+	unsigned int b = 0;
+	for(size_t i = 0; i < raw.size(); ++i)
+	{
+		a = (a + raw[i]) % 65521;
+		b = (b + a) % 65521;
+	}
+	appendBigEndian(data, (b << 16) | a);
+
+	const unsigned char signature[8] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+	std::vector<unsigned char> file(signature, signature + 8);
+	appendChunk(file, "IHDR", header);
+	appendChunk(file, "IDAT", data);
+	appendChunk(file, "IEND", std::vector<unsigned char>());
+
+	FILE *out = fopen(path, "wb");
+	if(!out)
+	{
+		printf("Could not open %s to write the image to\n", path);
+		return false;
+	}
+
+	const bool written = fwrite(&file[0], 1, file.size(), out) == file.size();
+	return fclose(out) == 0 && written;
+}
+
+SoftwareRenderBackend::SoftwareRenderBackend(unsigned int width, unsigned int height, ThreadPool *pool): m_pool(pool)
+, m_framebuffer(width, height)
+, m_tilesX((width + softwareTileSize - 1) / softwareTileSize)
+, m_tilesY((height + softwareTileSize - 1) / softwareTileSize)
+, m_simdLevel(::getSimdLevel())
+, m_program(SoftwareColor3D)
+, m_vertexArray(0)
+, m_blend(false)
+, m_alpha(1.0f)
+{
+	// White, as main clears the window
+	for(unsigned int c = 0; c < 4; ++c)
+	{
+		m_clearColor[c] = 1.0f;
+	}
+	m_tileFragments.resize(m_tilesX * m_tilesY);
+}
+
+unsigned int SoftwareRenderBackend::createProgram(SoftwareProgram program)
+{
+	m_programs.push_back(program);
+	return (unsigned int)m_programs.size();
+}
+
+unsigned int SoftwareRenderBackend::createVertexArray(const float *vertices, unsigned int vertexCount, const unsigned int *indices, unsigned int indexCount)
+{
+	m_vertexArrays.push_back(VertexArray());
+	VertexArray &vertexArray = m_vertexArrays.back();
+	vertexArray.vertices.assign(vertices, vertices + vertexCount * meshVertexFloats);
+	if(indices)
+	{
+		vertexArray.indices.assign(indices, indices + indexCount);
+	}
+	return (unsigned int)m_vertexArrays.size();
+}
+
+void SoftwareRenderBackend::setVertices(unsigned int vertexArray, const float *vertices, unsigned int vertexCount)
+{
+	m_vertexArrays[vertexArray - 1].vertices.assign(vertices, vertices + vertexCount * meshVertexFloats);
+}
+
+void SoftwareRenderBackend::setInstances(unsigned int vertexArray, const CubeInstance *instances, unsigned int count)
+{
+	m_vertexArrays[vertexArray - 1].instances.assign(instances, instances + count);
+}
+
+void SoftwareRenderBackend::setViewProj(const glm::mat4 &view, const glm::mat4 &proj)
+{
+	m_viewProj = proj * view;
+}
+
+void SoftwareRenderBackend::setClearColor(float r, float g, float b, float a)
+{
+	m_clearColor[0] = r;
+	m_clearColor[1] = g;
+	m_clearColor[2] = b;
+	m_clearColor[3] = a;
+}
+
+void SoftwareRenderBackend::setSimdLevel(SimdLevel level)
+{
+	m_simdLevel = level > ::getSimdLevel() ? ::getSimdLevel() : level;
+}
+
+void SoftwareRenderBackend::applyProgram(unsigned int program)
+{
+	m_program = program > 0 && program <= m_programs.size() ? m_programs[program - 1] : SoftwareColor3D;
+}
+
+void SoftwareRenderBackend::applyVertexArray(unsigned int vertexArray)
+{
+	m_vertexArray = vertexArray;
+}
+
+void SoftwareRenderBackend::applyBlend(bool blend)
+{
+	m_blend = blend;
+}
+
+void SoftwareRenderBackend::applyModel(const float model[16])
+{
+	memcpy(glm::value_ptr(m_model), model, sizeof(float) * 16);
+}
+
+void SoftwareRenderBackend::applyAlpha(float alpha)
+{
+	m_alpha = alpha;
+}
+
+void SoftwareRenderBackend::draw(const RenderCommand &command)
+{
+	// Drawing waits until the whole queue is known so it can be spread over the tiles
+	if(command.primitive != triangleList || m_vertexArray == 0 || m_vertexArray > m_vertexArrays.size())
+	{
+		return;
+	}
+
+	Draw draw;
+	draw.program = m_program;
+	draw.vertexArray = m_vertexArray;
+	draw.blend = m_blend;
+	draw.model = m_model;
+	draw.alpha = m_alpha;
+	draw.drawType = command.drawType;
+	draw.first = command.first;
+	draw.count = command.count;
+	draw.instanceCount = command.drawType == DrawArraysInstanced || command.drawType == DrawElementsInstanced ? command.instanceCount : 1;
+	m_draws.push_back(draw);
+}
+
+void SoftwareRenderBackend::flush()
+{
+	PROFILE_ZONE("Software render");
+
+	m_stats = SoftwareRenderStats();
+	m_stats.draws = (unsigned int)m_draws.size();
+
+	// Big draws are cut by triangles, small instanced ones by instances
+	m_batches.clear();
+	for(unsigned int d = 0; d < m_draws.size(); ++d)
+	{
+		Draw &draw = m_draws[d];
+		const VertexArray &vertexArray = m_vertexArrays[draw.vertexArray - 1];
+		const bool indexed = draw.drawType == DrawElements || draw.drawType == DrawElementsInstanced;
+		const unsigned int available = indexed ? (unsigned int)vertexArray.indices.size() : vertexArray.getVertexCount();
+		draw.count = draw.first >= available ? 0 : std::min(draw.count, available - draw.first);
+		if(draw.program == SoftwareColor3DInstanced)
+		{
+			draw.instanceCount = std::min(draw.instanceCount, (unsigned int)vertexArray.instances.size());
+		}
+
+		const unsigned int triangles = draw.count / 3;
+		if(triangles == 0 || draw.instanceCount == 0)
+		{
+			continue;
+		}
+
+		if(triangles >= batchTriangles)
+		{
+			for(unsigned int instance = 0; instance < draw.instanceCount; ++instance)
+			{
+				for(unsigned int first = 0; first < triangles; first += batchTriangles)
+				{
+					const Batch batch = { d, first, std::min(batchTriangles, triangles - first), instance, instance + 1 };
+					m_batches.push_back(batch);
+				}
+			}
+		}
+		else
+		{
+			const unsigned int instancesPerBatch = batchTriangles / triangles;
+			for(unsigned int instance = 0; instance < draw.instanceCount; instance += instancesPerBatch)
+			{
+				const Batch batch = { d, 0, triangles, instance, std::min(instance + instancesPerBatch, draw.instanceCount) };
+				m_batches.push_back(batch);
+			}
+		}
+	}
+
+	if(m_outputs.size() < m_batches.size())
+	{
+		m_outputs.resize(m_batches.size());
+	}
+
+	{
+		PROFILE_ZONE("Vertex stage");
+		if(m_pool)
+		{
+			m_pool->parallelFor((unsigned int)m_batches.size(), 1, [this](unsigned int begin, unsigned int end)
+			{
+				PROFILE_ZONE("Vertex chunk");
+				for(unsigned int b = begin; b < end; ++b)
+				{
+					runBatch(b);
+				}
+			});
+		}
+		else
+		{
+			for(unsigned int b = 0; b < m_batches.size(); ++b)
+			{
+				runBatch(b);
+			}
+		}
+	}
+
+	for(unsigned int b = 0; b < m_batches.size(); ++b)
+	{
+		const SoftwareRenderStats &stats = m_outputs[b].stats;
+		m_stats.vertices += stats.vertices;
+		m_stats.triangles += stats.triangles;
+		m_stats.clipped += stats.clipped;
+		m_stats.culled += stats.culled;
+	}
+
+	binTriangles();
+
+	{
+		PROFILE_ZONE("Rasterize");
+		const unsigned int tiles = m_tilesX * m_tilesY;
+		if(m_pool)
+		{
+			m_pool->parallelFor(tiles, 1, [this](unsigned int begin, unsigned int end)
+			{
+				PROFILE_ZONE("Raster chunk");
+				for(unsigned int tile = begin; tile < end; ++tile)
+				{
+					rasterizeTile(tile);
+				}
+			});
+		}
+		else
+		{
+			for(unsigned int tile = 0; tile < tiles; ++tile)
+			{
+				rasterizeTile(tile);
+			}
+		}
+
+		for(unsigned int tile = 0; tile < tiles; ++tile)
+		{
+			m_stats.fragments += m_tileFragments[tile];
+		}
+	}
+
+	m_draws.clear();
+}
+
+void SoftwareRenderBackend::runBatch(unsigned int index)
+{
+	const Batch &batch = m_batches[index];
+	const Draw &draw = m_draws[batch.draw];
+	const VertexArray &vertexArray = m_vertexArrays[draw.vertexArray - 1];
+	const bool indexed = draw.drawType == DrawElements || draw.drawType == DrawElementsInstanced;
+	const unsigned int vertexCount = vertexArray.getVertexCount();
+
+	BatchOutput &output = m_outputs[index];
+	output.triangles.clear();
+	output.stats = SoftwareRenderStats();
+
+	// Only the vertices the batch's triangles use are transformed
+	const unsigned int firstCorner = draw.first + batch.first * 3;
+	const unsigned int cornerCount = batch.count * 3;
+	unsigned int lowest = vertexCount;
+	unsigned int highest = 0;
+	for(unsigned int i = 0; i < cornerCount; ++i)
+	{
+		const unsigned int vertex = indexed ? vertexArray.indices[firstCorner + i] : firstCorner + i;
+		if(vertex < vertexCount)
+		{
+			lowest = std::min(lowest, vertex);
+			highest = std::max(highest, vertex);
+		}
+	}
+	if(lowest > highest)
+	{
+		return;
+	}
+
+	const unsigned int used = highest - lowest + 1;
+	const unsigned int stride = (used + 3) & ~3u;
+	output.clip.resize(stride * 4);
+	const float *clipX = &output.clip[0];
+	const float *clipY = clipX + stride;
+	const float *clipZ = clipY + stride;
+	const float *clipW = clipZ + stride;
+
+	const float width = (float)m_framebuffer.getWidth();
+	const float height = (float)m_framebuffer.getHeight();
+
+	for(unsigned int instance = batch.instanceBegin; instance < batch.instanceEnd; ++instance)
+	{
+		const glm::mat4 model = draw.program == SoftwareColor3DInstanced ? instanceModel(vertexArray.instances[instance]) : draw.model;
+		const glm::mat4 mvp = m_viewProj * model;
+
+#if SIMD_HAS_SSE2
+		if(m_simdLevel >= SimdSSE2)
+		{
+			transformSSE2(mvp, &vertexArray.vertices[0], lowest, used, &output.clip[0]);
+		}
+		else
+#endif
+		{
+			transformScalar(mvp, &vertexArray.vertices[0], lowest, used, &output.clip[0]);
+		}
+		output.stats.vertices += used;
+
+		for(unsigned int t = 0; t < batch.count; ++t)
+		{
+			ClipVertex polygon[maxClipVertices];
+			unsigned int outside = 0x3F;
+			unsigned int crossing = 0;
+			bool valid = true;
+			for(unsigned int k = 0; k < 3; ++k)
+			{
+				const unsigned int corner = firstCorner + t * 3 + k;
+				const unsigned int vertex = indexed ? vertexArray.indices[corner] : corner;
+				if(vertex >= vertexCount)
+				{
+					valid = false;
+					break;
+				}
+
+				const unsigned int local = vertex - lowest;
+				ClipVertex &v = polygon[k];
+				v.x = clipX[local];
+				v.y = clipY[local];
+				v.z = clipZ[local];
+				v.w = clipW[local];
+				const float *color = &vertexArray.vertices[vertex * meshVertexFloats + 3];
+				v.color[0] = color[0];
+				v.color[1] = color[1];
+				v.color[2] = color[2];
+				v.color[3] = draw.alpha;
+
+				const unsigned int code = outcode(v);
+				outside &= code;
+				crossing |= code;
+			}
+
+			++output.stats.triangles;
+			if(!valid || outside)
+			{
+				++output.stats.culled;
+				continue;
+			}
+
+			unsigned int corners = 3;
+			if(crossing)
+			{
+				++output.stats.clipped;
+				corners = clipPolygon(polygon, 3, crossing);
+			}
+
+			// Clipping leaves a convex polygon, drawn as a fan
+			for(unsigned int k = 2; k < corners; ++k)
+			{
+				const ClipVertex *v[3] = { &polygon[0], &polygon[k - 1], &polygon[k] };
+
+				Triangle triangle;
+				float invW[3];
+				bool behind = false;
+				for(unsigned int c = 0; c < 3; ++c)
+				{
+					behind |= !(v[c]->w > 0.0f);
+					invW[c] = 1.0f / v[c]->w;
+					triangle.x[c] = (int)std::floor((v[c]->x * invW[c] * 0.5f + 0.5f) * width * subPixelScale + 0.5f);
+					triangle.y[c] = (int)std::floor((0.5f - v[c]->y * invW[c] * 0.5f) * height * subPixelScale + 0.5f);
+				}
+
+				long long area = (long long)(triangle.x[1] - triangle.x[0]) * (triangle.y[2] - triangle.y[0]) -
+					(long long)(triangle.y[1] - triangle.y[0]) * (triangle.x[2] - triangle.x[0]);
+				if(behind || area == 0)
+				{
+					++output.stats.culled;
+					continue;
+				}
+
+				// Nothing is culled by facing, so either winding is drawn
+				if(area < 0)
+				{
+					std::swap(v[1], v[2]);
+					std::swap(invW[1], invW[2]);
+					std::swap(triangle.x[1], triangle.x[2]);
+					std::swap(triangle.y[1], triangle.y[2]);
+					area = -area;
+				}
+
+				// Pixels whose centre the bounds reach
+				const int half = subPixelScale / 2;
+				triangle.minX = std::max(0, (std::min(triangle.x[0], std::min(triangle.x[1], triangle.x[2])) - half + subPixelScale - 1) >> subPixelBits);
+				triangle.minY = std::max(0, (std::min(triangle.y[0], std::min(triangle.y[1], triangle.y[2])) - half + subPixelScale - 1) >> subPixelBits);
+				triangle.maxX = std::min((int)m_framebuffer.getWidth() - 1, (std::max(triangle.x[0], std::max(triangle.x[1], triangle.x[2])) - half) >> subPixelBits);
+				triangle.maxY = std::min((int)m_framebuffer.getHeight() - 1, (std::max(triangle.y[0], std::max(triangle.y[1], triangle.y[2])) - half) >> subPixelBits);
+				if(triangle.minX > triangle.maxX || triangle.minY > triangle.maxY)
+				{
+					++output.stats.culled;
+					continue;
+				}
+
+				// Each attribute as its value at the first corner plus how much it changes per unit
+				// of the edge functions that weight the second and third
+				const float inverseArea = 1.0f / (float)area;
+				const float z[3] = { v[0]->z * invW[0], v[1]->z * invW[1], v[2]->z * invW[2] };
+				triangle.depth[0] = z[0];
+				triangle.depth[1] = (z[1] - z[0]) * inverseArea;
+				triangle.depth[2] = (z[2] - z[0]) * inverseArea;
+				triangle.invW[0] = invW[0];
+				triangle.invW[1] = (invW[1] - invW[0]) * inverseArea;
+				triangle.invW[2] = (invW[2] - invW[0]) * inverseArea;
+				for(unsigned int c = 0; c < 4; ++c)
+				{
+					const float a = v[0]->color[c] * invW[0];
+					triangle.color[c][0] = a;
+					triangle.color[c][1] = (v[1]->color[c] * invW[1] - a) * inverseArea;
+					triangle.color[c][2] = (v[2]->color[c] * invW[2] - a) * inverseArea;
+				}
+				triangle.blend = draw.blend;
+
+				output.triangles.push_back(triangle);
+			}
+		}
+	}
+}
+
+void SoftwareRenderBackend::binTriangles()
+{
+	PROFILE_ZONE("Bin triangles");
+
+	// Counted, then placed, both in issue order so each tile's list keeps it
+	const unsigned int tiles = m_tilesX * m_tilesY;
+	m_binStarts.assign(tiles + 1, 0);
+	for(unsigned int b = 0; b < m_batches.size(); ++b)
+	{
+		const std::vector<Triangle> &triangles = m_outputs[b].triangles;
+		for(unsigned int t = 0; t < triangles.size(); ++t)
+		{
+			const Triangle &triangle = triangles[t];
+			for(int ty = triangle.minY / (int)softwareTileSize; ty <= triangle.maxY / (int)softwareTileSize; ++ty)
+			{
+				for(int tx = triangle.minX / (int)softwareTileSize; tx <= triangle.maxX / (int)softwareTileSize; ++tx)
+				{
+					++m_binStarts[ty * m_tilesX + tx + 1];
+				}
+			}
+		}
+	}
+
+	for(unsigned int tile = 0; tile < tiles; ++tile)
+	{
+		m_binStarts[tile + 1] += m_binStarts[tile];
+	}
+	m_stats.binned = m_binStarts[tiles];
+	m_binned.resize(m_stats.binned);
+
+	std::vector<unsigned int> &next = m_binFill;
+	next.assign(m_binStarts.begin(), m_binStarts.end() - 1);
+	for(unsigned int b = 0; b < m_batches.size(); ++b)
+	{
+		const std::vector<Triangle> &triangles = m_outputs[b].triangles;
+		for(unsigned int t = 0; t < triangles.size(); ++t)
+		{
+			const Triangle &triangle = triangles[t];
+			for(int ty = triangle.minY / (int)softwareTileSize; ty <= triangle.maxY / (int)softwareTileSize; ++ty)
+			{
+				for(int tx = triangle.minX / (int)softwareTileSize; tx <= triangle.maxX / (int)softwareTileSize; ++tx)
+				{
+					m_binned[next[ty * m_tilesX + tx]++] = &triangle;
+				}
+			}
+		}
+	}
+}
+
+void SoftwareRenderBackend::rasterizeTile(unsigned int tile)
+{
+	const int tileX = (int)((tile % m_tilesX) * softwareTileSize);
+	const int tileY = (int)((tile / m_tilesX) * softwareTileSize);
+	const int lastX = std::min(tileX + (int)softwareTileSize, (int)m_framebuffer.getWidth()) - 1;
+	const int lastY = std::min(tileY + (int)softwareTileSize, (int)m_framebuffer.getHeight()) - 1;
+
+	// Clearing here keeps the tile in this thread's cache for its triangles
+	const unsigned int clearColor = packColor(m_clearColor);
+	for(int y = tileY; y <= lastY; ++y)
+	{
+		std::fill(m_framebuffer.getColorRow(y) + tileX, m_framebuffer.getColorRow(y) + tileX + softwareTileSize, clearColor);
+		std::fill(m_framebuffer.getDepthRow(y) + tileX, m_framebuffer.getDepthRow(y) + tileX + softwareTileSize, 1.0f);
+	}
+
+	unsigned long long fragments = 0;
+	for(unsigned int i = m_binStarts[tile]; i < m_binStarts[tile + 1]; ++i)
+	{
+		const Triangle &triangle = *m_binned[i];
+		const int firstX = std::max(triangle.minX, tileX);
+		const int endX = std::min(triangle.maxX, lastX);
+		const int firstY = std::max(triangle.minY, tileY);
+		const int endY = std::min(triangle.maxY, lastY);
+		if(firstX > endX || firstY > endY)
+		{
+			continue;
+		}
+
+		// Quads of pixels start on a multiple of 4, which the tile does as well
+		const int quadX = firstX & ~3;
+		Edge edges[3];
+		for(unsigned int e = 0; e < 3; ++e)
+		{
+			const unsigned int next = (e + 1) % 3;
+			edges[e] = makeEdge(triangle.x[e], triangle.y[e], triangle.x[next], triangle.y[next], quadX, firstY);
+		}
+
+#if SIMD_HAS_SSE2
+		if(m_simdLevel >= SimdSSE2)
+		{
+			__m128i row[3];
+			__m128i quadStep[3];
+			__m128i rowStep[3];
+			for(unsigned int e = 0; e < 3; ++e)
+			{
+				const int s = edges[e].stepX;
+				row[e] = _mm_add_epi32(_mm_set1_epi32(edges[e].value), _mm_set_epi32(3 * s, 2 * s, s, 0));
+				quadStep[e] = _mm_set1_epi32(4 * s);
+				rowStep[e] = _mm_set1_epi32(edges[e].stepY);
+			}
+
+			for(int y = firstY; y <= endY; ++y)
+			{
+				unsigned int *colorRow = m_framebuffer.getColorRow(y);
+				float *depthRow = m_framebuffer.getDepthRow(y);
+				__m128i e0 = row[0];
+				__m128i e1 = row[1];
+				__m128i e2 = row[2];
+				for(int x = quadX; x <= endX; x += 4)
+				{
+					// A lane is inside when no edge function is negative
+					const __m128i any = _mm_or_si128(_mm_or_si128(e0, e1), e2);
+					const unsigned int inside = ~(unsigned int)_mm_movemask_ps(_mm_castsi128_ps(any)) & laneMask(x, firstX, endX);
+					if(inside)
+					{
+						fragments += shadeQuadSSE2(e0, e2, inside, triangle.depth, triangle.invW, triangle.color, triangle.blend, colorRow + x, depthRow + x);
+					}
+
+					e0 = _mm_add_epi32(e0, quadStep[0]);
+					e1 = _mm_add_epi32(e1, quadStep[1]);
+					e2 = _mm_add_epi32(e2, quadStep[2]);
+				}
+
+				row[0] = _mm_add_epi32(row[0], rowStep[0]);
+				row[1] = _mm_add_epi32(row[1], rowStep[1]);
+				row[2] = _mm_add_epi32(row[2], rowStep[2]);
+			}
+			continue;
+		}
+#endif
+
+		for(int y = firstY; y <= endY; ++y)
+		{
+			unsigned int *colorRow = m_framebuffer.getColorRow(y);
+			float *depthRow = m_framebuffer.getDepthRow(y);
+			const int rowOffset = (y - firstY);
+			for(int x = quadX; x <= endX; x += 4)
+			{
+				int e[3][4];
+				unsigned int inside = laneMask(x, firstX, endX);
+				for(unsigned int lane = 0; lane < 4; ++lane)
+				{
+					for(unsigned int k = 0; k < 3; ++k)
+					{
+						e[k][lane] = edges[k].value + edges[k].stepY * rowOffset + edges[k].stepX * (x - quadX + (int)lane);
+						inside &= e[k][lane] < 0 ? ~(1u << lane) : ~0u;
+					}
+				}
+
+				if(inside)
+				{
+					fragments += shadeQuadScalar(e[0], e[2], inside, triangle.depth, triangle.invW, triangle.color, triangle.blend, colorRow + x, depthRow + x);
+				}
+			}
+		}
+	}
+
+	m_tileFragments[tile] = fragments;
+}
@@ -0,0 +1,281 @@
+/*
+	Name:			SweepAndPrune.cpp
+	Project:		OpenGL
+	Description:	Incremental sort and sweep broadphase over AABBs
+	Doc Version:	1.0
+	Author:			Jonathan Simon Jones
+	Date(D/M/Y):	16-10-2026
+	To do:
+*/
+
+#include "SweepAndPrune.h"
+#include "Profiler.h"
+
+// STL includes
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+
+namespace
+{
+	// Inserting more than this many bodies between updates falls back to a full sort
+	const unsigned int maxIncrementalInserts = 16;
+
+	// Another axis has to spread the bodies this much more before we switch to it
+	const float axisSwitchRatio = 1.2f;
+
+	const unsigned int invalidSlot = 0xFFFFFFFF;
+
+	// A NaN would break the endpoint ordering the sorts rely on and a negative radius would
+	// put a max endpoint before its min, so neither gets in. Debug builds stop on them,
+	// otherwise they are zeroed and radii made positive.
+	AABB makeValidBox(const AABB &box)
+	{
+		AABB valid = box;
+		for(unsigned int axis = 0; axis < 3; ++axis)
+		{
+			assert(std::isfinite(box.center_position[axis]) && std::isfinite(box.radius[axis]) && box.radius[axis] >= 0.0f);
+			valid.center_position[axis] = std::isfinite(box.center_position[axis]) ? box.center_position[axis] : 0.0f;
+			valid.radius[axis] = std::isfinite(box.radius[axis]) ? std::abs(box.radius[axis]) : 0.0f;
+		}
+		return valid;
+	}
+}
+
+SweepAndPrune::SweepAndPrune(): m_bodyCount(0)
+, m_axis(0)
+, m_insertedSinceSort(0)
+, m_needsFullSort(false)
+{
+}
+
+unsigned int SweepAndPrune::addBody(const AABB &newBox)
+{
+	const AABB box = makeValidBox(newBox);
+	unsigned int body;
+
+	// Reuse a free handle if there is one
+	if(!m_freeBodies.empty())
+	{
+		body = m_freeBodies.back();
+		m_freeBodies.pop_back();
+		m_boxes[body] = box;
+		m_alive[body] = 1;
+	}
+	else
+	{
+		body = (unsigned int)m_boxes.size();
+		m_boxes.push_back(box);
+		m_alive.push_back(1);
+		m_openSlot.push_back(invalidSlot);
+	}
+
+	// New endpoints go on the end and get sorted in on the next update
+	Endpoint minPoint = { box.center_position[m_axis] - box.radius[m_axis], body << 1 };
+	Endpoint maxPoint = { box.center_position[m_axis] + box.radius[m_axis], (body << 1) | 1 };
+	m_endpoints.push_back(minPoint);
+	m_endpoints.push_back(maxPoint);
+
+	++m_bodyCount;
+	if(++m_insertedSinceSort > maxIncrementalInserts)
+	{
+		m_needsFullSort = true;
+	}
+
+	return body;
+}
+
+void SweepAndPrune::removeBody(unsigned int body)
+{
+	if(body >= m_boxes.size() || !m_alive[body])
+	{
+		return;
+	}
+
+	// Compact the endpoint array, the order of the rest is unchanged
+	std::vector<Endpoint>::iterator out = m_endpoints.begin();
+	for(std::vector<Endpoint>::iterator it = m_endpoints.begin(); it != m_endpoints.end(); it++)
+	{
+		if(((*it).data >> 1) != body)
+		{
+			*out++ = *it;
+		}
+	}
+	m_endpoints.erase(out, m_endpoints.end());
+
+	m_alive[body] = 0;
+	m_freeBodies.push_back(body);
+	--m_bodyCount;
+}
+
+void SweepAndPrune::updateBody(unsigned int body, const AABB &box)
+{
+	m_boxes[body] = makeValidBox(box);
+}
+
+const std::vector<BroadphasePair>& SweepAndPrune::findOverlappingPairs()
+{
+	PROFILE_ZONE("Broadphase");
+
+	chooseSortAxis();
+	refreshEndpoints();
+
+	if(m_needsFullSort)
+	{
+		fullSort();
+	}
+	else
+	{
+		insertionSort();
+	}
+
+	m_insertedSinceSort = 0;
+	m_needsFullSort = false;
+
+	sweep();
+
+	return m_pairs;
+}
+
+bool SweepAndPrune::endpointLess(const Endpoint &a, const Endpoint &b)
+{
+	// Min endpoints go before max endpoints of the same value so touching boxes
+	// are reported, matching testAABBAABB
+	if(a.value != b.value)
+	{
+		return a.value < b.value;
+	}
+
+	return (a.data & 1) < (b.data & 1);
+}
+
+void SweepAndPrune::chooseSortAxis()
+{
+	if(m_bodyCount < 2)
+	{
+		return;
+	}
+
+	// Sort along the axis the centers are most spread out on, fewer intervals overlap there
+	glm::vec3 sum(0.0f, 0.0f, 0.0f);
+	glm::vec3 sumSquared(0.0f, 0.0f, 0.0f);
+	for(unsigned int i = 0; i < m_boxes.size(); ++i)
+	{
+		if(m_alive[i])
+		{
+			const glm::vec3 &c = m_boxes[i].center_position;
+			sum += c;
+			sumSquared += c * c;
+		}
+	}
+
+	const float invCount = 1.0f / (float)m_bodyCount;
+	const glm::vec3 mean = sum * invCount;
+	const glm::vec3 variance = sumSquared * invCount - mean * mean;
+
+	unsigned int best = m_axis;
+	for(unsigned int axis = 0; axis < 3; ++axis)
+	{
+		if(variance[axis] > variance[best] * axisSwitchRatio)
+		{
+			best = axis;
+		}
+	}
+
+	// Endpoints along a new axis are in no useful order
+	if(best != m_axis)
+	{
+		m_axis = best;
+		m_needsFullSort = true;
+	}
+}
+
+void SweepAndPrune::refreshEndpoints()
+{
+	const unsigned int axis = m_axis;
+	for(std::vector<Endpoint>::iterator it = m_endpoints.begin(); it != m_endpoints.end(); it++)
+	{
+		const AABB &box = m_boxes[(*it).data >> 1];
+		if((*it).data & 1)
+		{
+			(*it).value = box.center_position[axis] + box.radius[axis];
+		}
+		else
+		{
+			(*it).value = box.center_position[axis] - box.radius[axis];
+		}
+	}
+}
+
+void SweepAndPrune::insertionSort()
+{
+	const unsigned int count = (unsigned int)m_endpoints.size();
+	for(unsigned int i = 1; i < count; ++i)
+	{
+		const Endpoint key = m_endpoints[i];
+
+		unsigned int j = i;
+		while(j > 0 && endpointLess(key, m_endpoints[j - 1]))
+		{
+			m_endpoints[j] = m_endpoints[j - 1];
+			--j;
+		}
+
+		m_endpoints[j] = key;
+	}
+}
+
+void SweepAndPrune::fullSort()
+{
+	std::sort(m_endpoints.begin(), m_endpoints.end(), endpointLess);
+}
+
+void SweepAndPrune::sweep()
+{
+	m_pairs.clear();
+	m_open.clear();
+
+	const unsigned int axis1 = (m_axis + 1) % 3;
+	const unsigned int axis2 = (m_axis + 2) % 3;
+
+	for(std::vector<Endpoint>::const_iterator it = m_endpoints.begin(); it != m_endpoints.end(); it++)
+	{
+		const unsigned int body = (*it).data >> 1;
+
+		if((*it).data & 1)
+		{
+			// Interval closed, swap it out of the open list. One that never opened is
+			// skipped rather than taking another body out in its place.
+			const unsigned int slot = m_openSlot[body];
+			if(slot == invalidSlot)
+			{
+				continue;
+			}
+
+			const unsigned int last = m_open.back();
+			m_open[slot] = last;
+			m_openSlot[last] = slot;
+			m_open.pop_back();
+			m_openSlot[body] = invalidSlot;
+			continue;
+		}
+
+		// Every open interval overlaps this one on the sort axis, check the other two
+		const AABB &box = m_boxes[body];
+		for(std::vector<unsigned int>::const_iterator other = m_open.begin(); other != m_open.end(); other++)
+		{
+			const AABB &otherBox = m_boxes[*other];
+
+			if(glm::abs(box.center_position[axis1] - otherBox.center_position[axis1]) > (box.radius[axis1] + otherBox.radius[axis1])) continue;
+			if(glm::abs(box.center_position[axis2] - otherBox.center_position[axis2]) > (box.radius[axis2] + otherBox.radius[axis2])) continue;
+
+			BroadphasePair pair;
+			pair.a = std::min(body, *other);
+			pair.b = std::max(body, *other);
+			m_pairs.push_back(pair);
+		}
+
+		m_openSlot[body] = (unsigned int)m_open.size();
+		m_open.push_back(body);
+	}
+}
@@ -0,0 +1,585 @@
+/*
+	Name:			ThreadPool.cpp
+	Project:		OpenGL
+	Description:	Worker threads that run jobs from their own deques and steal from each other's
+	Doc Version:	1.0
+	Author:			Jonathan Simon Jones
+	Date(D/M/Y):	16-10-2026
+	To do:
+*/
+
+#include "ThreadPool.h"
+#include "Profiler.h"
+
+// STL includes
+#include <cstdio>
+
+struct Job
+{
+	ThreadPool::Task task;
+	const ThreadPool::RangeTask *range;		// Set instead of task for part of a parallelFor
+	unsigned int begin;
+	unsigned int end;
+	unsigned int grain;
+	JobCounter *counter;
+	unsigned int owner;						// Worker that queued it, noJobOwner from outside the pool
+	Job *next;								// In a counter's held back list
+};
+
+namespace
+{
+	// Jobs a deque has room for, a thread queueing more than this runs the rest itself
+	const unsigned int dequeCapacity = 4096;
+	// Times a worker looks everywhere for a job before it goes to sleep
+	const unsigned int spinRounds = 64;
+	// Jobs a worker takes from or hands back to the spares at once
+	const unsigned int jobBatch = 32;
+	// Room made up front for jobs on a thread, a frame has rarely had more in flight
+	const unsigned int jobsPerThread = 256;
+
+	const unsigned int noJobOwner = 0xffffffff;
+
+	// Chase-Lev deque with a fixed size. The owner pushes and pops at the bottom, thieves
+	// take from the top, and the two only race for the last job, which a compare and swap
+	// on top settles. Orderings follow Le, Pop, Cohen and Zappa Nardelli, PPoPP 2013.
+	class JobDeque
+	{
+	public:
+		JobDeque(): m_top(0)
+		, m_bottom(0)
+		{
+			for(unsigned int i = 0; i < dequeCapacity; ++i)
+			{
+				m_slots[i].store(0, std::memory_order_relaxed);
+			}
+		}
+
+		// Owner only, false when full
+		bool push(Job *job)
+		{
+			const long long bottom = m_bottom.load(std::memory_order_relaxed);
+			const long long top = m_top.load(std::memory_order_acquire);
+			if(bottom - top >= (long long)dequeCapacity)
+			{
+				return false;
+			}
+
+			m_slots[bottom & (dequeCapacity - 1)].store(job, std::memory_order_relaxed);
+			std::atomic_thread_fence(std::memory_order_release);
+			m_bottom.store(bottom + 1, std::memory_order_relaxed);
+			return true;
+		}
+
+		// Owner only, the job pushed last
+		Job* pop()
+		{
+			const long long bottom = m_bottom.load(std::memory_order_relaxed) - 1;
+			m_bottom.store(bottom, std::memory_order_relaxed);
+			std::atomic_thread_fence(std::memory_order_seq_cst);
+			long long top = m_top.load(std::memory_order_relaxed);
+
+			if(top > bottom)
+			{
+				m_bottom.store(bottom + 1, std::memory_order_relaxed);
+				return 0;
+			}
+
+			Job *job = m_slots[bottom & (dequeCapacity - 1)].load(std::memory_order_relaxed);
+			if(top == bottom)
+			{
+				// Last one, a thief may be taking it too
+				if(!m_top.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+				{
+					job = 0;
+				}
+				m_bottom.store(bottom + 1, std::memory_order_relaxed);
+			}
+
+			return job;
+		}
+
+		// Any thread, the job pushed first. Null when empty or another thread got there first.
+		Job* steal()
+		{
+			long long top = m_top.load(std::memory_order_acquire);
+			std::atomic_thread_fence(std::memory_order_seq_cst);
+			const long long bottom = m_bottom.load(std::memory_order_acquire);
+			if(top >= bottom)
+			{
+				return 0;
+			}
+
+			Job *job = m_slots[top & (dequeCapacity - 1)].load(std::memory_order_relaxed);
+			if(!m_top.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+			{
+				return 0;
+			}
+
+			return job;
+		}
+
+	private:
+		JobDeque(const JobDeque &);
+		JobDeque& operator=(const JobDeque &);
+
+		// Thieves hammer top and the owner bottom, kept on separate cache lines
+		std::atomic<long long> m_top;
+		char m_padding[64];
+		std::atomic<long long> m_bottom;
+		std::atomic<Job*> m_slots[dequeCapacity];
+	};
+
+	unsigned int nextRandom(unsigned int &state)
+	{
+		// Xorshift, only used to spread thieves over the other deques
+		state ^= state << 13;
+		state ^= state >> 17;
+		state ^= state << 5;
+		return state;
+	}
+}
+
+struct ThreadPool::Worker
+{
+	JobDeque deque;
+	std::vector<Job*> freeJobs;				// Finished jobs this thread reuses, never touched by another
+	std::atomic<unsigned long long> jobs;
+	std::atomic<unsigned long long> stolen;
+	std::thread::id id;
+	unsigned int index;
+	unsigned int random;
+};
+
+ThreadPool::ThreadPool(unsigned int threadCount): m_queued(0)
+, m_sleeping(0)
+, m_quit(false)
+, m_jobPool(sizeof(Job), std::alignment_of<Job>::value, jobBatch)
+{
+	if(threadCount == 0)
+	{
+		threadCount = std::thread::hardware_concurrency();
+	}
+	if(threadCount == 0)
+	{
+		threadCount = 1;
+	}
+
+	for(unsigned int i = 0; i < threadCount; ++i)
+	{
+		Worker *worker = new Worker;
+		worker->jobs.store(0);
+		worker->stolen.store(0);
+		worker->index = i;
+		worker->random = 2654435761u * (i + 1);
+		worker->freeJobs.reserve(jobBatch * 2);
+		m_workers.push_back(worker);
+	}
+
+	m_jobPool.reserve(jobsPerThread * threadCount);
+	m_spareJobs.reserve(jobsPerThread * threadCount);
+
+	// The calling thread is worker 0 and does its share whenever it waits
+	m_workers[0]->id = std::this_thread::get_id();
+	for(unsigned int i = 1; i < threadCount; ++i)
+	{
+		m_threads.push_back(std::thread(&ThreadPool::workerLoop, this, i));
+		m_workers[i]->id = m_threads.back().get_id();
+	}
+}
+
+ThreadPool::~ThreadPool()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_quit = true;
+	}
+	m_wake.notify_all();
+
+	for(std::vector<std::thread>::iterator it = m_threads.begin(); it != m_threads.end(); it++)
+	{
+		(*it).join();
+	}
+
+	for(unsigned int i = 0; i < m_workers.size(); ++i)
+	{
+		for(unsigned int j = 0; j < m_workers[i]->freeJobs.size(); ++j)
+		{
+			m_workers[i]->freeJobs[j]->~Job();
+		}
+		delete m_workers[i];
+	}
+	for(unsigned int i = 0; i < m_spareJobs.size(); ++i)
+	{
+		m_spareJobs[i]->~Job();
+	}
+}
+
+void ThreadPool::run(const Task &task, JobCounter *counter, JobCounter *after)
+{
+	Worker *worker = findWorker();
+	Job *job = allocateJob(worker);
+	job->task = task;
+	job->counter = counter;
+	if(counter)
+	{
+		counter->m_pending.fetch_add(1);
+	}
+
+	if(after)
+	{
+		// Held under the lock the last of after's jobs takes to hand these out
+		std::lock_guard<std::mutex> lock(after->m_mutex);
+		if(!after->isDone())
+		{
+			job->next = after->m_waiting;
+			after->m_waiting = job;
+			return;
+		}
+	}
+
+	queue(worker, job);
+}
+
+void ThreadPool::wait(JobCounter &counter)
+{
+	Worker *worker = findWorker();
+	while(!counter.isDone())
+	{
+		Job *job = findJob(worker);
+		if(job)
+		{
+			execute(worker, job);
+		}
+		else
+		{
+			std::this_thread::yield();
+		}
+	}
+
+	// The job that took the count to 0 may still be holding it
+	std::lock_guard<std::mutex> lock(counter.m_mutex);
+}
+
+void ThreadPool::parallelFor(unsigned int count, unsigned int grain, const RangeTask &task)
+{
+	if(count == 0)
+	{
+		return;
+	}
+
+	if(grain == 0)
+	{
+		grain = 1;
+	}
+
+	// Not worth queueing anything for a single chunk
+	if(m_workers.size() == 1 || count <= grain)
+	{
+		task(0, count);
+		return;
+	}
+
+	// The whole range starts on this thread, the halves it queues are what the rest steal
+	Worker *worker = findWorker();
+	JobCounter done;
+	done.m_pending.store(1);
+	Job *job = allocateJob(worker);
+	job->range = &task;
+	job->begin = 0;
+	job->end = count;
+	job->grain = grain;
+	job->counter = &done;
+	job->owner = worker ? worker->index : noJobOwner;
+	execute(worker, job);
+
+	wait(done);
+}
+
+JobStats ThreadPool::getStats() const
+{
+	JobStats stats;
+	for(unsigned int i = 0; i < m_workers.size(); ++i)
+	{
+		stats.jobs += m_workers[i]->jobs.load(std::memory_order_relaxed);
+		stats.stolen += m_workers[i]->stolen.load(std::memory_order_relaxed);
+	}
+
+	return stats;
+}
+
+void ThreadPool::resetStats()
+{
+	for(unsigned int i = 0; i < m_workers.size(); ++i)
+	{
+		m_workers[i]->jobs.store(0, std::memory_order_relaxed);
+		m_workers[i]->stolen.store(0, std::memory_order_relaxed);
+	}
+}
+
+ThreadPool::Worker* ThreadPool::findWorker() const
+{
+	const std::thread::id id = std::this_thread::get_id();
+	for(unsigned int i = 0; i < m_workers.size(); ++i)
+	{
+		if(m_workers[i]->id == id)
+		{
+			return m_workers[i];
+		}
+	}
+
+	return 0;
+}
+
+Job* ThreadPool::allocateJob(Worker *worker)
+{
+	Job *job = 0;
+	if(worker && !worker->freeJobs.empty())
+	{
+		job = worker->freeJobs.back();
+		worker->freeJobs.pop_back();
+	}
+	else
+	{
+		// A worker that has run out takes a batch at once, so it is rarely here
+		std::lock_guard<std::mutex> lock(m_jobMutex);
+		const unsigned int wanted = worker ? jobBatch : 1;
+		for(unsigned int i = 0; i < wanted; ++i)
+		{
+			Job *spare = 0;
+			if(!m_spareJobs.empty())
+			{
+				spare = m_spareJobs.back();
+				m_spareJobs.pop_back();
+			}
+			else
+			{
+				spare = new(m_jobPool.allocate()) Job;
+			}
+
+			if(i + 1 < wanted)
+			{
+				worker->freeJobs.push_back(spare);
+			}
+			else
+			{
+				job = spare;
+			}
+		}
+	}
+
+	job->range = 0;
+	job->begin = 0;
+	job->end = 0;
+	job->grain = 1;
+	job->counter = 0;
+	job->next = 0;
+	return job;
+}
+
+void ThreadPool::queue(Worker *worker, Job *job)
+{
+	job->owner = worker ? worker->index : noJobOwner;
+
+	// Counted first so a sleeping thread never misses it, see workerLoop
+	m_queued.fetch_add(1);
+	if(worker)
+	{
+		if(!worker->deque.push(job))
+		{
+			m_queued.fetch_sub(1);
+			execute(worker, job);
+			return;
+		}
+	}
+	else
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_foreignJobs.push_back(job);
+	}
+
+	if(m_sleeping.load() > 0)
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_wake.notify_one();
+	}
+}
+
+Job* ThreadPool::findJob(Worker *worker)
+{
+	Job *job = worker ? worker->deque.pop() : 0;
+
+	// Start somewhere different each time so thieves do not all pile onto one deque
+	const unsigned int count = (unsigned int)m_workers.size();
+	const unsigned int start = worker ? nextRandom(worker->random) % count : 0;
+	for(unsigned int i = 0; !job && i < count; ++i)
+	{
+		Worker *victim = m_workers[(start + i) % count];
+		if(victim != worker)
+		{
+			job = victim->deque.steal();
+		}
+	}
+
+	// Something is queued that no deque gave up, it may be on the foreign list
+	if(!job && m_queued.load() > 0)
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		if(!m_foreignJobs.empty())
+		{
+			job = m_foreignJobs.back();
+			m_foreignJobs.pop_back();
+		}
+	}
+
+	if(job)
+	{
+		m_queued.fetch_sub(1);
+	}
+
+	return job;
+}
+
+void ThreadPool::execute(Worker *worker, Job *job)
+{
+	if(worker)
+	{
+		worker->jobs.fetch_add(1, std::memory_order_relaxed);
+		if(job->owner != worker->index)
+		{
+			worker->stolen.fetch_add(1, std::memory_order_relaxed);
+		}
+	}
+
+	if(job->range)
+	{
+		// Keep the first half and queue the second until only a chunk is left
+		while(job->end - job->begin > job->grain)
+		{
+			const unsigned int chunks = (job->end - job->begin + job->grain - 1) / job->grain;
+			const unsigned int middle = job->begin + chunks / 2 * job->grain;
+
+			Job *half = allocateJob(worker);
+			half->range = job->range;
+			half->begin = middle;
+			half->end = job->end;
+			half->grain = job->grain;
+			half->counter = job->counter;
+			job->counter->m_pending.fetch_add(1);
+			job->end = middle;
+			queue(worker, half);
+		}
+
+		(*job->range)(job->begin, job->end);
+	}
+	else
+	{
+		job->task();
+	}
+
+	JobCounter *counter = job->counter;
+	releaseJob(worker, job);
+	finish(worker, counter);
+}
+
+void ThreadPool::releaseJob(Worker *worker, Job *job)
+{
+	job->task = Task();
+	if(worker)
+	{
+		worker->freeJobs.push_back(job);
+		if(worker->freeJobs.size() < jobBatch * 2)
+		{
+			return;
+		}
+	}
+
+	// Finished more than it queued, the surplus goes back for whoever runs out
+	std::lock_guard<std::mutex> lock(m_jobMutex);
+	if(worker)
+	{
+		m_spareJobs.insert(m_spareJobs.end(), worker->freeJobs.end() - jobBatch, worker->freeJobs.end());
+		worker->freeJobs.resize(worker->freeJobs.size() - jobBatch);
+	}
+	else
+	{
+		m_spareJobs.push_back(job);
+	}
+}
+
+void ThreadPool::finish(Worker *worker, JobCounter *counter)
+{
+	if(!counter)
+	{
+		return;
+	}
+
+	// Any but the last job can let go without the lock, it never touches the counter again
+	unsigned int pending = counter->m_pending.load();
+	while(pending > 1)
+	{
+		if(counter->m_pending.compare_exchange_weak(pending, pending - 1))
+		{
+			return;
+		}
+	}
+
+	Job *released = 0;
+	{
+		std::lock_guard<std::mutex> lock(counter->m_mutex);
+		if(counter->m_pending.fetch_sub(1) == 1)
+		{
+			released = counter->m_waiting;
+			counter->m_waiting = 0;
+		}
+	}
+
+	while(released)
+	{
+		Job *next = released->next;
+		queue(worker, released);
+		released = next;
+	}
+}
+
+void ThreadPool::workerLoop(unsigned int index)
+{
+	Worker *worker = m_workers[index];
+	unsigned int idleRounds = 0;
+
+	char name[32];
+	snprintf(name, sizeof(name), "Worker %u", index);
+	setProfilerThreadName(name);
+
+	for(;;)
+	{
+		Job *job = findJob(worker);
+		if(job)
+		{
+			execute(worker, job);
+			idleRounds = 0;
+			continue;
+		}
+
+		if(++idleRounds < spinRounds)
+		{
+			std::this_thread::yield();
+			continue;
+		}
+
+		// queue counts a job before it checks for sleepers and this counts a sleeper
+		// before it checks for jobs, so one of the two always sees the other
+		std::unique_lock<std::mutex> lock(m_mutex);
+		m_sleeping.fetch_add(1);
+		while(!m_quit && m_queued.load() == 0)
+		{
+			m_wake.wait(lock);
+		}
+		m_sleeping.fetch_sub(1);
+
+		if(m_quit)
+		{
+			return;
+		}
+		idleRounds = 0;
+	}
+}
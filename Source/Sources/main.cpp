@@ -2,66 +2,107 @@
 	Name:			main.cpp
 	Project:		OpenGL
 	Description:	Contains entry point for OpenGL project
-	Doc Version:	1.6
+	Doc Version:	1.19
 	Author:			Jonathan Simon Jones
 	Date(D/M/Y):	19-01-2014
-	To do:			Error check readTextFromFile
-					Fix min/max values in calculateBoxExtremes
+	To do:
 */
 
-// OpenGL includes
+// OpenGL includes, left out of the headless build which has no window or GL context
+#ifndef HEADLESS
 #include <GL\glew.h>
 #include <SFML/Graphics.hpp>
+#endif
 #include <glm/glm.hpp>						// Math library
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/type_ptr.hpp>				// Converting a matrix object into a float array
 #include <glm/gtc/quaternion.hpp>
 
 // OS include
+#ifdef _WIN32
 #include <Windows.h>
+#endif
 
 // STL includes
-#include <fstream>
 #include <string>
-#include <sstream>
 #include <iostream>
 #include <vector>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+// Project includes
+#include "AABB.h"
+#include "AssetLoader.h"
+#include "Benchmark.h"
+#include "Headless.h"
+#include "Memory.h"
+#include "Mesh.h"
+#include "MeshOptimizer.h"
+#include "Profiler.h"
+#include "RenderQueue.h"
+#include "RenderStats.h"
+#include "Scene.h"
+#include "SimulationThread.h"
+#include "ThreadPool.h"
+#ifndef HEADLESS
+#include "GLRenderBackend.h"
+#include "GpuBuffer.h"
+#include "GpuProfiler.h"
+#include "InstancedCubeRenderer.h"
+#include "ShaderCache.h"
+#endif
+
+#ifndef HEADLESS
+// Prototypes
+void setSharedUniforms(ShaderCache &shaders, unsigned int shader, const glm::mat4 &view, const glm::mat4 &proj);
+#endif
 
-struct AABB
+// Main
+int main(int argc, char *argv[])
 {
-	glm::vec3 center_position;
-	glm::vec3 radius;
-};
+	// Run a headless benchmark instead of the game, e.g. -benchmark broadphase
+	if(argc > 2 && std::string(argv[1]) == "-benchmark")
+	{
+		return runBenchmark(argv[2]);
+	}
 
-struct extremes
-{
-	extremes(): minX(0.0f)
-	, maxX(0.0f)
-	, minY(0.0f)
-	, maxY(0.0f)
-	, minZ(0.0f)
-	, maxZ(0.0f)
-	{}
-
-	float minX;
-	float maxX;
-	float minY;
-	float maxY;
-	float minZ;
-	float maxZ;
-};
+	// Run the frame update without a window, e.g. -headless 10000 5000 for 10000 frames
+	// with 5000 extra bodies, a trace file after them profiles the run
+	if(argc > 2 && std::string(argv[1]) == "-headless")
+	{
+		const unsigned int frames = (unsigned int)strtoul(argv[2], NULL, 10);
+		const unsigned int extraBodies = argc > 3 ? (unsigned int)strtoul(argv[3], NULL, 10) : 0;
+		return runHeadless(frames, extraBodies, argc > 4 ? argv[4] : 0);
+	}
 
-// Prototypes
-std::string readTextFromFile(std::string nameOfFile);
-void checkShaderForErrors(GLuint shader);
-void createShaderProgram(GLuint &shaderProgram_);
-inline glm::fquat AngularVelocityToSpin(glm::fquat orientation, glm::vec3 angularVelocity);
-bool testAABBAABB(const AABB &a, const AABB &b);
-void calculateBoxExtremes(glm::mat4 transformMat, GLfloat newBoxCoords[], extremes &boxExtremes);
+	// Draw the frames on the CPU as well, e.g. -render 1000 5000 frame.png writes the last
+	// of 1000 frames with 5000 extra bodies to frame.png
+	if(argc > 2 && std::string(argv[1]) == "-render")
+	{
+		const unsigned int frames = (unsigned int)strtoul(argv[2], NULL, 10);
+		const unsigned int extraBodies = argc > 3 ? (unsigned int)strtoul(argv[3], NULL, 10) : 0;
+		return runHeadlessRender(frames, extraBodies, argc > 4 ? argv[4] : 0);
+	}
+
+	// Turn an OBJ file into a .mesh file, e.g. -convert Meshes/cube.obj Meshes/cube.mesh
+	if(argc > 3 && std::string(argv[1]) == "-convert")
+	{
+		return convertObjToMesh(argv[2], argv[3]);
+	}
+
+#ifdef HEADLESS
+	// Nothing to draw with in this build
+	printf("Usage: %s -headless <frames> [bodies] [trace.json] | -render <frames> [bodies] [image.png] | -benchmark <name> | -convert <in.obj> <out.mesh>\n", argv[0]);
+	return 1;
+#else
+	// Extra spinning cubes to load the renderer, e.g. -cubes 10000
+	unsigned int extraCubes = 0;
+	if(argc > 2 && std::string(argv[1]) == "-cubes")
+	{
+		extraCubes = (unsigned int)strtoul(argv[2], NULL, 10);
+	}
 
-// Main
-int main()
-{
 	unsigned int windowWidth, windowHeight;
 	windowWidth = 800;
 	windowHeight = 600;
@@ -85,221 +126,54 @@ int main()
 	// Bing the vertex array object
 	glBindVertexArray(vao);
 
-	GLfloat vertices[] = {
-		// First cube
-		-0.5f, -0.5f, -0.5f, 0.0f, 0.0f, 1.0f, 
-		 0.5f, -0.5f, -0.5f, 0.0f, 1.0f, 0.0f, 
-		 0.5f,  0.5f, -0.5f, 1.0f, 0.0f, 0.0f, 
-		 0.5f,  0.5f, -0.5f, 1.0f, 1.0f, 0.0f, 
-		-0.5f,  0.5f, -0.5f, 1.0f, 0.0f, 1.0f, 
-		-0.5f, -0.5f, -0.5f, 0.0f, 1.0f, 1.0f, 
-
-		-0.5f, -0.5f,  0.5f, 0.0f, 0.0f, 1.0f,
-		 0.5f, -0.5f,  0.5f, 0.0f, 1.0f, 0.0f, 
-		 0.5f,  0.5f,  0.5f, 1.0f, 0.0f, 0.0f,
-		 0.5f,  0.5f,  0.5f, 1.0f, 1.0f, 0.0f,
-		-0.5f,  0.5f,  0.5f, 1.0f, 0.0f, 1.0f,
-		-0.5f, -0.5f,  0.5f, 0.0f, 1.0f, 1.0f,
-
-		-0.5f,  0.5f,  0.5f, 0.0f, 0.0f, 1.0f,
-		-0.5f,  0.5f, -0.5f, 0.0f, 1.0f, 0.0f,
-		-0.5f, -0.5f, -0.5f, 1.0f, 0.0f, 0.0f, 
-		-0.5f, -0.5f, -0.5f, 1.0f, 1.0f, 0.0f,
-		-0.5f, -0.5f,  0.5f, 1.0f, 0.0f, 1.0f,
-		-0.5f,  0.5f,  0.5f, 0.0f, 1.0f, 1.0f,
-
-		 0.5f,  0.5f,  0.5f, 0.0f, 0.0f, 1.0f,
-		 0.5f,  0.5f, -0.5f, 0.0f, 1.0f, 0.0f,
-		 0.5f, -0.5f, -0.5f, 1.0f, 0.0f, 0.0f,
-		 0.5f, -0.5f, -0.5f, 1.0f, 1.0f, 0.0f,
-		 0.5f, -0.5f,  0.5f, 1.0f, 0.0f, 1.0f,
-		 0.5f,  0.5f,  0.5f, 0.0f, 1.0f, 1.0f,
-
-		-0.5f, -0.5f, -0.5f, 0.0f, 0.0f, 1.0f,
-		 0.5f, -0.5f, -0.5f, 0.0f, 1.0f, 0.0f,
-		 0.5f, -0.5f,  0.5f, 1.0f, 0.0f, 0.0f,
-		 0.5f, -0.5f,  0.5f, 1.0f, 1.0f, 0.0f,
-		-0.5f, -0.5f,  0.5f, 1.0f, 0.0f, 1.0f,
-		-0.5f, -0.5f, -0.5f, 0.0f, 1.0f, 1.0f,
-
-		-0.5f,  0.5f, -0.5f, 0.0f, 0.0f, 1.0f,
-		 0.5f,  0.5f, -0.5f, 0.0f, 1.0f, 0.0f,
-		 0.5f,  0.5f,  0.5f, 1.0f, 0.0f, 0.0f,
-		 0.5f,  0.5f,  0.5f, 1.0f, 1.0f, 0.0f,
-		-0.5f,  0.5f,  0.5f, 1.0f, 0.0f, 1.0f,
-		-0.5f,  0.5f, -0.5f, 0.0f, 1.0f, 1.0f,
-
-		// Second cube
-		/*-0.5f, -0.5f, -0.5f, 0.3f, 0.3f, 0.3f, 
-		 0.5f, -0.5f, -0.5f, 0.3f, 0.3f, 0.3f, 
-		 0.5f,  0.5f, -0.5f, 0.3f, 0.3f, 0.3f, 
-		 0.5f,  0.5f, -0.5f, 0.3f, 0.3f, 0.3f, 
-		-0.5f,  0.5f, -0.5f, 0.3f, 0.3f, 0.3f, 
-		-0.5f, -0.5f, -0.5f, 0.3f, 0.3f, 0.3f, 
-
-		-0.5f, -0.5f,  0.5f, 0.3f, 0.3f, 0.3f,
-		 0.5f, -0.5f,  0.5f, 0.3f, 0.3f, 0.3f, 
-		 0.5f,  0.5f,  0.5f, 0.3f, 0.3f, 0.3f,
-		 0.5f,  0.5f,  0.5f, 0.3f, 0.3f, 0.3f,
-		-0.5f,  0.5f,  0.5f, 0.3f, 0.3f, 0.3f,
-		-0.5f, -0.5f,  0.5f, 0.3f, 0.3f, 0.3f,
-
-		-0.5f,  0.5f,  0.5f, 0.3f, 0.3f, 0.3f,
-		-0.5f,  0.5f, -0.5f, 0.3f, 0.3f, 0.3f,
-		-0.5f, -0.5f, -0.5f, 0.3f, 0.3f, 0.3f,
-		-0.5f, -0.5f, -0.5f, 0.3f, 0.3f, 0.3f,
-		-0.5f, -0.5f,  0.5f, 0.3f, 0.3f, 0.3f,
-		-0.5f,  0.5f,  0.5f, 0.3f, 0.3f, 0.3f,
-
-		 0.5f,  0.5f,  0.5f, 0.3f, 0.3f, 0.3f,
-		 0.5f,  0.5f, -0.5f, 0.3f, 0.3f, 0.3f,
-		 0.5f, -0.5f, -0.5f, 0.3f, 0.3f, 0.3f,
-		 0.5f, -0.5f, -0.5f, 0.3f, 0.3f, 0.3f,
-		 0.5f, -0.5f,  0.5f, 0.3f, 0.3f, 0.3f,
-		 0.5f,  0.5f,  0.5f, 0.3f, 0.3f, 0.3f,
-
-		-0.5f, -0.5f, -0.5f, 0.3f, 0.3f, 0.3f,
-		 0.5f, -0.5f, -0.5f, 0.3f, 0.3f, 0.3f,
-		 0.5f, -0.5f,  0.5f, 0.3f, 0.3f, 0.3f,
-		 0.5f, -0.5f,  0.5f, 0.3f, 0.3f, 0.3f,
-		-0.5f, -0.5f,  0.5f, 0.3f, 0.3f, 0.3f,
-		-0.5f, -0.5f, -0.5f, 0.3f, 0.3f, 0.3f,
-
-		-0.5f,  0.5f, -0.5f, 0.3f, 0.3f, 0.3f,
-		 0.5f,  0.5f, -0.5f, 0.3f, 0.3f, 0.3f,
-		 0.5f,  0.5f,  0.5f, 0.3f, 0.3f, 0.3f,
-		 0.5f,  0.5f,  0.5f, 0.3f, 0.3f, 0.3f,
-		-0.5f,  0.5f,  0.5f, 0.3f, 0.3f, 0.3f,
-		-0.5f,  0.5f, -0.5f, 0.3f, 0.3f, 0.3f,*/
-
-		// Floor
-		-0.5f, -0.5f, 0.0f, 0.0f, 0.0f, 0.5f, 
-		 0.5f, -0.5f, 0.0f, 0.0f, 0.0f, 0.5f,
-		 0.5f,  0.5f, 0.0f, 0.0f, 0.0f, 0.5f,
-		 0.5f,  0.5f, 0.0f, 0.5f, 0.0f, 0.0f, 
-		-0.5f,  0.5f, 0.0f, 0.5f, 0.0f, 0.0f, 
-		-0.5f, -0.5f, 0.0f, 0.5f, 0.0f, 0.0f, 
-	};
-
-	GLfloat boundingBoxVertices[] = { 
-		// Second cube
-		-0.5f, -0.5f, -0.5f, 0.3f, 0.3f, 0.3f,
-		 0.5f, -0.5f, -0.5f, 0.3f, 0.3f, 0.3f, 
-		 0.5f,  0.5f, -0.5f, 0.3f, 0.3f, 0.3f, 
-		 0.5f,  0.5f, -0.5f, 0.3f, 0.3f, 0.3f, 
-		-0.5f,  0.5f, -0.5f, 0.3f, 0.3f, 0.3f, 
-		-0.5f, -0.5f, -0.5f, 0.3f, 0.3f, 0.3f, 
-
-		-0.5f, -0.5f,  0.5f, 0.3f, 0.3f, 0.3f,
-		 0.5f, -0.5f,  0.5f, 0.3f, 0.3f, 0.3f, 
-		 0.5f,  0.5f,  0.5f, 0.3f, 0.3f, 0.3f,
-		 0.5f,  0.5f,  0.5f, 0.3f, 0.3f, 0.3f,
-		-0.5f,  0.5f,  0.5f, 0.3f, 0.3f, 0.3f,
-		-0.5f, -0.5f,  0.5f, 0.3f, 0.3f, 0.3f,
-
-		-0.5f,  0.5f,  0.5f, 0.3f, 0.3f, 0.3f,
-		-0.5f,  0.5f, -0.5f, 0.3f, 0.3f, 0.3f,
-		-0.5f, -0.5f, -0.5f, 0.3f, 0.3f, 0.3f,
-		-0.5f, -0.5f, -0.5f, 0.3f, 0.3f, 0.3f,
-		-0.5f, -0.5f,  0.5f, 0.3f, 0.3f, 0.3f,
-		-0.5f,  0.5f,  0.5f, 0.3f, 0.3f, 0.3f,
-
-		 0.5f,  0.5f,  0.5f, 0.3f, 0.3f, 0.3f,
-		 0.5f,  0.5f, -0.5f, 0.3f, 0.3f, 0.3f,
-		 0.5f, -0.5f, -0.5f, 0.3f, 0.3f, 0.3f,
-		 0.5f, -0.5f, -0.5f, 0.3f, 0.3f, 0.3f,
-		 0.5f, -0.5f,  0.5f, 0.3f, 0.3f, 0.3f,
-		 0.5f,  0.5f,  0.5f, 0.3f, 0.3f, 0.3f,
-
-		-0.5f, -0.5f, -0.5f, 0.3f, 0.3f, 0.3f,
-		 0.5f, -0.5f, -0.5f, 0.3f, 0.3f, 0.3f,
-		 0.5f, -0.5f,  0.5f, 0.3f, 0.3f, 0.3f,
-		 0.5f, -0.5f,  0.5f, 0.3f, 0.3f, 0.3f,
-		-0.5f, -0.5f,  0.5f, 0.3f, 0.3f, 0.3f,
-		-0.5f, -0.5f, -0.5f, 0.3f, 0.3f, 0.3f,
-
-		-0.5f,  0.5f, -0.5f, 0.3f, 0.3f, 0.3f,
-		 0.5f,  0.5f, -0.5f, 0.3f, 0.3f, 0.3f,
-		 0.5f,  0.5f,  0.5f, 0.3f, 0.3f, 0.3f,
-		 0.5f,  0.5f,  0.5f, 0.3f, 0.3f, 0.3f,
-		-0.5f,  0.5f,  0.5f, 0.3f, 0.3f, 0.3f,
-		-0.5f,  0.5f, -0.5f, 0.3f, 0.3f, 0.3f,
-	};
-
-	GLfloat boundingBoxVertices2[48] = {0.0f};
-
-	// Setup vertex buffer
-	// This is used to store the vert info that is to be passed to the graphics card
-	GLuint vertexBuffer[3];				// Reference to memory where buffer is
-	glGenBuffers(1, vertexBuffer);		// We only want one buffer
-
-	// Make buffer active
-	glBindBuffer(GL_ARRAY_BUFFER, vertexBuffer[0]);	// Make vertexBuffer the active array buffer
-													// Now that it is active we can copy the vertex data to it
-
-	// Copy vertex data to the active array buffer (currently vertexBuffer)
-	glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);		// glBufferData(the array to deal with, size in bytes, pointer to data, usage of vertex data)
-
-	// Make buffer active
-	glBindBuffer(GL_ARRAY_BUFFER, vertexBuffer[1]);	// Make vertexBuffer the active array buffer
-															// Now that it is active we can copy the vertex data to it
-
-	// Copy vertex data to the active array buffer (currently vertexBuffer)
-	glBufferData(GL_ARRAY_BUFFER, sizeof(boundingBoxVertices), boundingBoxVertices, GL_STATIC_DRAW);		// glBufferData(the array to deal with, size in bytes, pointer to data, usage of vertex data)
-
-	// Make buffer active
-	glBindBuffer(GL_ARRAY_BUFFER, vertexBuffer[2]);	// Make vertexBuffer the active array buffer
-													// Now that it is active we can copy the vertex data to it
-
-	// Copy vertex data to the active array buffer (currently vertexBuffer)
-	glBufferData(GL_ARRAY_BUFFER, sizeof(boundingBoxVertices2), boundingBoxVertices2, GL_DYNAMIC_DRAW);		// glBufferData(the array to deal with, size in bytes, pointer to data, usage of vertex data)
-	
-	// Rebind first buffer
-	glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
-
-	GLuint elements[] = {
-		// Bottom
-		0, 2, 1,
-		3, 0, 2,
-
-		// Top
-		4, 6, 5,
-		7, 4, 6,
-
-		// Front
-		0, 5, 1,
-		4, 0, 5,
-
-		// Right
-		1, 6, 2,
-		5, 1, 6,
-
-		// Back
-		2, 7, 3,
-		6, 2, 7,
-
-		// Left 
-		3, 4, 0,
-		7, 3, 4,
-	};
-
-	GLuint ebo;
-	glGenBuffers(1, &ebo);
-	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ebo);
-	glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(elements), elements, GL_STATIC_DRAW);
-	
-	// Create shader program
-	GLuint shaderProgram;
-	createShaderProgram(shaderProgram);
-
-	// Set shader to graphcics pipeline
-	glUseProgram(shaderProgram);
+	// Files are mapped on loader threads, the main loop picks them up between frames
+	AssetLoader assetLoader;
+
+	// The cube is an indexed mesh converted offline, its mapping goes to the driver as it is
+	const unsigned int cubeAsset = assetLoader.request("Meshes/cube.mesh");
+	MeshView cubeMesh;
+	if(!assetLoader.wait(cubeAsset) || !openMeshView(assetLoader.getFile(cubeAsset), cubeMesh))
+	{
+		printf("Could not load Meshes/cube.mesh\n");
+		return 1;
+	}
+
+	// Setup vertex buffers
+	// Geometry that never changes is copied to the graphics card once, here. The index
+	// buffer is bound while vao is, so vao keeps it.
+	GLuint cubeBuffer = createStaticBuffer(GL_ARRAY_BUFFER, cubeMesh.getVertexBytes(), cubeMesh.vertices);
+	GLuint cubeIndexBuffer = createStaticBuffer(GL_ELEMENT_ARRAY_BUFFER, cubeMesh.getIndexBytes(), cubeMesh.indices);
+	const GLsizei cubeIndexCount = (GLsizei)cubeMesh.header->indexCount;
+	assetLoader.release(cubeAsset);
+
+	// Box 1's bounding box corners change every frame, each frame gets its own region
+	// so we never write over corners the GPU has not drawn yet
+	StreamingBuffer boundingBoxStream(GL_ARRAY_BUFFER, 48 * sizeof(GLfloat));
+	printf("Bounding box streaming through %s\n", boundingBoxStream.isPersistent() ? "a persistent mapped buffer" : "buffer orphaning");
+
+	// Triangles over the eight corners calculateBoxExtremes writes. The corners cannot
+	// move, so only the triangles are reordered before upload.
+	GLuint elements[36];
+	memcpy(elements, boundingBoxIndices, sizeof(elements));
+
+	// Shader programs, linked binaries are kept on disk between runs and edited shader
+	// files are picked up while running
+	ShaderCache shaderCache(assetLoader, "ShaderCache");
+	const unsigned int colorShader = shaderCache.load("VertexShaders/color3D.vert", "FragmentShaders/inputColor.frag");
+
+	// Extra cubes, drawn one call per cube or all in one instanced call. I switches between them.
+	const unsigned int instancedShader = shaderCache.load("VertexShaders/color3DInstanced.vert", "FragmentShaders/inputColor.frag");
+
+	const ShaderCacheStats &shaderStats = shaderCache.getStats();
+	printf("Shaders ready in %.2f ms: %u stages compiled, %u programs linked, %u loaded from the binary cache\n",
+		shaderStats.seconds * 1000.0, shaderStats.compiles, shaderStats.links, shaderStats.binaryLoads);
 
 	// Get references to shader vars
-	GLint posAttrib = glGetAttribLocation(shaderProgram, "position"); // Get reference to position in vertex shader
-	GLint colAttrib = glGetAttribLocation(shaderProgram, "color");	  // Get triangle color attribute
+	GLint posAttrib = shaderCache.getAttribLocation(colorShader, "position"); // Get reference to position in vertex shader
+	GLint colAttrib = shaderCache.getAttribLocation(colorShader, "color");	  // Get triangle color attribute
 
-	// Specify the format of the attribute
+	// Specify the format of the attribute, the cubes and floor read the static buffer
+	glBindBuffer(GL_ARRAY_BUFFER, cubeBuffer);
 	glVertexAttribPointer(posAttrib, 3, GL_FLOAT, GL_FALSE, 6*sizeof(float), 0);
 	glVertexAttribPointer(colAttrib, 3, GL_FLOAT, GL_FALSE, 6*sizeof(float), (void*)(3*sizeof(float)));
 
@@ -307,164 +181,275 @@ int main()
 	glEnableVertexAttribArray(posAttrib);
 	glEnableVertexAttribArray(colAttrib);
 
-	// Box 1
-	// 2D rotation
-	glm::mat4 model;
-	glm::fquat orientation(1.0f, 0.0f, 0.0f, 0.0f);
-	glm::vec3 position(0.0f, 0.0f, 0.0f);
+	// The bounding box has its own vertex array object holding the index buffer,
+	// its attributes are pointed at the streamed corners each frame
+	GLuint boundingBoxVao;
+	glGenVertexArrays(1, &boundingBoxVao);
+	glBindVertexArray(boundingBoxVao);
+	optimizeVertexCache(elements, sizeof(elements) / sizeof(elements[0]), 8);
+	GLuint ebo = createStaticBuffer(GL_ELEMENT_ARRAY_BUFFER, sizeof(elements), elements);
+	glEnableVertexAttribArray(posAttrib);
+	glEnableVertexAttribArray(colAttrib);
+	glBindVertexArray(vao);
 
-	const float fps = 200.0f;
-	const float dt = 1 / fps;
-	glm::vec3 velocity(0.1f, 0.0f, 0.0f);
-	glm::vec3 gravity(0.0f, 0.0f, -1.0f);
-	glm::vec3 angularVelocity(0.0f, 0.0f, 0.1f);
+	printf("Static geometry uploaded once: %llu bytes\n", getRenderStats().bytesUploaded);
+	getRenderStats().reset();
 
-	position += glm::vec3(0.0f, 0.0f, 0.0f);
-	model = glm::translate(model, position);
+	// Bodies, broadphase and everything else the simulation needs, shared with the headless build
+	ThreadPool threadPool;
+	Scene scene(&threadPool);
+	addSceneClutter(scene, extraCubes);
+	const float dt = scene.world.getFixedDt();
+	updateScene(scene, 0.0f);
 
-	glm::mat4 ident;
+	// The simulation steps at its own fixed rate on a thread of its own from here on, the
+	// scene is only touched again once it has stopped. Frames draw the two latest snapshots
+	// blended, whatever the refresh rate.
+	SimulationThread simulation(scene);
+	SceneSnapshot snapshot;
+	SceneVisibility visibility;
+	glm::vec3 box2Position = scene.box2Pos;
+	simulation.start();
 
-	AABB BBB1;
+	// The floor and whatever else is placed rather than simulated
+	SceneProps props(&threadPool);
 
-	// Set up uniform attribute 
-	GLint uniModel = glGetUniformLocation(shaderProgram, "model");
-	glUniformMatrix4fv(uniModel, 1, GL_FALSE, glm::value_ptr(model));
+	// Camera, the render queue sorts by distance from it
+	const glm::vec3 cameraPosition(0.0f, -5.0f, 2.0f);
+	const float farPlane = 15.0f;
 
 	// Create view matrix
 	glm::mat4 view = glm::lookAt(			// Looks at specifies XY plane as ground, Z axis is up
-		glm::vec3(0.0f, -5.0f, 2.0f),		// Position
+		cameraPosition,						// Position
 		glm::vec3(0.0f, 0.0f, 0.0f),		// Where to look on the screen, forward vector
 		glm::vec3(0.0f, 0.0f, 1.0f)			// The up axis
 		);
 
-	// Set up uniform for view matrix
-	GLint uniView = glGetUniformLocation(shaderProgram, "view");
-	glUniformMatrix4fv(uniView, 1, GL_FALSE, glm::value_ptr(view));
-
 	// Create projection matrix
-	glm::mat4 proj = glm::perspective(45.0f, (float)windowWidth / (float)windowHeight, 1.0f, 15.0f);		// perspective(vetical fov, aspect ratio, near, far)
-	GLint uniProj = glGetUniformLocation(shaderProgram, "proj");
-	glUniformMatrix4fv(uniProj, 1, GL_FALSE, glm::value_ptr(proj));
+	glm::mat4 proj = glm::perspective(45.0f, (float)windowWidth / (float)windowHeight, 1.0f, farPlane);		// perspective(vetical fov, aspect ratio, near, far)
 
-	// Set up uniform attribute 
-	GLint uniColor = glGetUniformLocation(shaderProgram, "overrideColor");
-	glUniform3f(uniColor, 1.0f, 1.0f, 1.0f);
+	// Uniforms that stay the same all frame, set again whenever a program is rebuilt
+	setSharedUniforms(shaderCache, colorShader, view, proj);
+	setSharedUniforms(shaderCache, instancedShader, view, proj);
+
+	InstancedCubeRenderer cubeRenderer(cubeBuffer, cubeIndexBuffer, cubeIndexCount, shaderCache.getProgram(instancedShader));
+	bool instancedCubes = true;
+	bool culling = true;
+	glBindVertexArray(vao);
 
-	// Set up unifrom alpha
-	GLint uniAlpha = glGetUniformLocation(shaderProgram, "Alpha");
-	glUniform1f(uniAlpha, 1.0f);
+	// Every draw is submitted here and issued in sorted order by the backend
+	RenderQueue renderQueue;
+	GLRenderBackend renderBackend(shaderCache);
 
 	// Box 2
-	glm::vec3 box2Pos(3.0f, 0.0f, 0.5f);
 	float movSpeed = 4.0f;
-	AABB BBB2;
+
+	// Frame totals are printed once a second
+	sf::Clock statsClock;
+	unsigned long long statsBytes = 0;
+	unsigned long long statsDrawCalls = 0;
+	unsigned long long statsStateChanges = 0;
+	unsigned long long statsStateChangesSkipped = 0;
+	unsigned long long statsFrustumCulled = 0;
+	unsigned long long statsOccluded = 0;
+	unsigned int statsFrames = 0;
+	SimulationThreadStats statsSimulation;
+	HeapStats statsHeap = getHeapStats();
+
+	// P starts a capture and writes it out when pressed again, zones cost next to nothing until then
+	const char *traceFile = "profile.json";
+	setProfilerThreadName("Main");
+	GpuProfiler gpuProfiler;
+	printf("P starts and stops profiling into %s, GPU timer queries %s\n", traceFile, gpuProfiler.isAvailable() ? "available" : "not available");
+
+	// Box 1 and box 2 touching, only their boxes overlapping or apart, printed when it changes
+	int collisionState = -1;
 
 	// While window open
 	while (window.isOpen())
 	{
+		// The ring buffers only hold a frame or so, last frame's events go into the capture
+		collectProfile();
+		PROFILE_ZONE("Frame");
+
 		// Set clear colour
 		glClearColor(1.0f, 1.0f, 1.0f, 1.0f);
 		// Clear back buffer
 		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
-		// Box 1
-			//glBindBuffer(GL_ARRAY_BUFFER, vertexBuffer[0]);
-			glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);		// glBufferData(the array to deal with, size in bytes, pointer to data, usage of vertex data)
-
-			// Advance linearly
-			//velocity += gravity * dt;
-			//position += velocity * dt;
-			model = glm::translate(ident, position);
-
-			// Calculate rotation
-			glm::fquat spin = AngularVelocityToSpin(orientation, angularVelocity);
-			orientation = orientation + spin * dt;
-			orientation = glm::normalize(orientation);
-			model = glm::rotate( model, glm::angle(orientation), glm::axis(orientation) );
-			glm::mat4 modelCopy = model;
-		
-			// Upload variables to graphics mem
-			glUniformMatrix4fv(uniModel, 1, GL_FALSE, glm::value_ptr(model));
-			glUniform1f(uniAlpha, 1.0f);
-
-			// Draw cube
-			glDrawArrays(GL_TRIANGLES, 0, 36);
-
-		// Box 2
-			BBB2.center_position = box2Pos;
-			BBB2.radius = glm::vec3(0.5f, 0.5f, 0.5f);
-
-			// Calculate position
-			model = glm::translate(ident, box2Pos);
-
-			// Upload variables to graphics mem
-			glUniformMatrix4fv(uniModel, 1, GL_FALSE, glm::value_ptr(model));
-			glUniform1f(uniAlpha, 1.0f);
-
-			// Draw cube
-			glDrawArrays(GL_TRIANGLES, 0, 36);
-
-		// AABB Box 1
-			//glBindBuffer(GL_ARRAY_BUFFER, vertexBuffer[1]);
-			glBufferData(GL_ARRAY_BUFFER, sizeof(boundingBoxVertices2), boundingBoxVertices2, GL_STATIC_DRAW);	
-			glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(elements), elements, GL_STATIC_DRAW);// glBufferData(the array to deal with, size in bytes, pointer to data, usage of vertex data)
-
-			// Enable alpha blending 
-			glEnable(GL_BLEND);
-			glBlendFunc(GL_SRC_COLOR, GL_ONE_MINUS_SRC_COLOR);
-
-			GLfloat temp[48] = {0.0f};
-			extremes boxExtremes;
-			calculateBoxExtremes(modelCopy, temp, boxExtremes);
-			glBufferSubData(GL_ARRAY_BUFFER, 0, sizeof(temp), temp);
-
-			// Calculate position
-			//model = glm::translate(ident, position);
-			//model = glm::scale(model, glm::vec3(1.5f, 1.5f, 1.5f));
-
-			//glm::vec4 world(1.0f, 1.0f, 1.0f, 1.0f);
-			//world = world * model;
-
-			BBB1.center_position = position;
-			BBB1.radius = glm::vec3(boxExtremes.minX - position.x, boxExtremes.minY - position.y, boxExtremes.minZ - position.z);
-		
-			// Upload variables to graphics mem
-			glUniformMatrix4fv(uniModel, 1, GL_FALSE, glm::value_ptr(ident));
-			glUniform1f(uniAlpha, 0.5f);
-
-			// Draw bounding box
-			//glDrawArrays(GL_TRIANGLES, 0, 36);
-			glDrawElements(GL_TRIANGLES, 36, GL_UNSIGNED_INT, 0);
-
-			// Disable alpha blending
-			glDisable(GL_BLEND);
-
-		// Floor
-			//glBindBuffer(GL_ARRAY_BUFFER, vertexBuffer[0]);
-			glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);		// glBufferData(the array to deal with, size in bytes, pointer to data, usage of vertex data)
-
-			// Calculate position
-			model = glm::translate(ident, glm::vec3(0.0f, 0.0f, -0.5f));
-			model = glm::scale(model, glm::vec3(10.0f, 10.0f, 1.0f));
-		
-			// Upload variables to graphics mem
-			glUniformMatrix4fv(uniModel, 1, GL_FALSE, glm::value_ptr(model));
-			glUniform1f(uniAlpha, 1.0f);
-
-			// Draw bounding box
-			//glDrawArrays(GL_TRIANGLES, 36, 6);
-
-		
-		// Display back buffer
-		window.display();
+		// Never waits, the latest snapshot is taken if there is one and blended with the one
+		// before it for now
+		{
+			PROFILE_ZONE("Interpolate snapshots");
+			simulation.interpolate(snapshot);
+		}
+
+		PROFILE_COUNTER("Broadphase pairs", snapshot.pairCount);
+		PROFILE_COUNTER("Pairs tested", snapshot.pairsTested);
+		PROFILE_COUNTER("Contact manifolds", snapshot.manifolds);
+		PROFILE_COUNTER("Awake bodies", snapshot.awakeBodies);
+
+		// Set by updateScene when the narrowphase finds box 1 and box 2 touching, writing
+		// it out every frame took longer than finding it
+		const int lastCollisionState = collisionState;
+		collisionState = snapshot.colliding ? 2 : snapshot.boxesOverlapAABB ? 1 : 0;
+		if(collisionState != lastCollisionState)
+		{
+			if(snapshot.colliding)
+			{
+				const ContactManifold &contact = snapshot.boxContact;
+				float deepest = 0.0f;
+				for(unsigned int i = 0; i < contact.pointCount; ++i)
+				{
+					deepest = contact.depths[i] > deepest ? contact.depths[i] : deepest;
+				}
+
+				std::cout << "Boxes colliding: " << contact.pointCount << " contact points, depth " << deepest
+					<< ", normal (" << contact.normal.x << ", " << contact.normal.y << ", " << contact.normal.z << ")" << std::endl;
+			}
+			else if(snapshot.boxesOverlapAABB)
+			{
+				std::cout << "No collision, bounding boxes overlap" << std::endl;
+			}
+			else
+			{
+				std::cout << "No collision" << std::endl;
+			}
+		}
 
-		if(testAABBAABB(BBB1, BBB2))
+		// Only what the camera can see is submitted
+		if(culling)
 		{
-			std::cout << "Boxes colliding" << std::endl;
+			cullScene(snapshot, proj * view, cameraPosition, visibility);
 		}
 		else
 		{
-			std::cout << "No collision" << std::endl;
+			showWholeScene(snapshot, visibility);
+		}
+
+		// Files finished loading are only picked up here, between frames
+		assetLoader.update();
+
+		// Pick up edited shaders, a rebuilt program starts with none of its uniforms set
+		if(shaderCache.update())
+		{
+			setSharedUniforms(shaderCache, colorShader, view, proj);
+			setSharedUniforms(shaderCache, instancedShader, view, proj);
+		}
+
+		// Build this frame's draws, the queue decides what order they are issued in
+		const unsigned long long buildStart = isProfiling() ? profilerTicks() : 0;
+		renderQueue.clear();
+
+		// Stream box 1's bounding box corners and point the attributes at where they landed,
+		// the vertex array object keeps them until the command is drawn
+		boundingBoxStream.beginFrame();
+		const GLintptr boundingBoxOffset = boundingBoxStream.write(snapshot.boundingBoxCoords, sizeof(snapshot.boundingBoxCoords));
+		glBindVertexArray(boundingBoxVao);
+		glVertexAttribPointer(posAttrib, 3, GL_FLOAT, GL_FALSE, 6*sizeof(float), (void*)boundingBoxOffset);
+		glVertexAttribPointer(colAttrib, 3, GL_FLOAT, GL_FALSE, 6*sizeof(float), (void*)(boundingBoxOffset + 3*sizeof(float)));
+
+		// Box 1, box 2, the bounding box, the floor and, when not instanced, the extra cubes. Only
+		// the floor comes from the scene graph, the boxes are physics bodies whose world transforms
+		// come straight from the snapshot and the bounding box corners are already in world space.
+		SceneDrawSetup drawSetup;
+		drawSetup.colorProgram = shaderCache.getProgram(colorShader);
+		drawSetup.cubeVertexArray = vao;
+		drawSetup.cubeIndexCount = cubeIndexCount;
+		drawSetup.boundingBoxVertexArray = boundingBoxVao;
+		submitSceneDraws(snapshot, visibility, props, drawSetup, cameraPosition, farPlane, !instancedCubes, renderQueue);
+
+		// Extra cubes, all in one instanced draw issued once they are uploaded
+		if(instancedCubes)
+		{
+			cubeRenderer.setInstances(snapshot.getOrientedBoxes(), visibility.visibleClutter);
+		}
+
+		if(buildStart != 0)
+		{
+			recordProfileZone("Build draws", buildStart, profilerTicks());
+		}
+
+		if(instancedCubes)
+		{
+			PROFILE_ZONE("Upload instances");
+			PROFILE_GPU_ZONE(gpuProfiler, "Upload instances");
+			cubeRenderer.upload();
+			if(cubeRenderer.getInstanceCount() > 0)
+			{
+				renderQueue.submit(cubeRenderer.getCommand(shaderCache.getProgram(instancedShader)), 0.0f);
+			}
+		}
+
+		// Opaque first grouped by state and front to back, then blended back to front
+		{
+			PROFILE_ZONE("Sort draws");
+			renderQueue.sort();
+		}
+		{
+			PROFILE_GPU_ZONE(gpuProfiler, "Draw");
+			renderBackend.execute(renderQueue);
+		}
+
+		// Everything streamed this frame has been drawn from
+		boundingBoxStream.endFrame();
+		cubeRenderer.endFrame();
+
+		// Display back buffer
+		{
+			PROFILE_ZONE("Display");
+			window.display();
+		}
+		gpuProfiler.endFrame();
+
+		PROFILE_COUNTER("Draw calls", getRenderStats().drawCalls);
+		PROFILE_COUNTER("Bytes uploaded", (double)getRenderStats().bytesUploaded);
+		PROFILE_COUNTER("State changes", getRenderStats().stateChanges);
+
+		// Only streamed data should be uploading anything now
+		statsBytes += getRenderStats().bytesUploaded;
+		statsDrawCalls += getRenderStats().drawCalls;
+		statsStateChanges += getRenderStats().stateChanges;
+		statsStateChangesSkipped += getRenderStats().stateChangesSkipped;
+		statsFrustumCulled += culling ? visibility.culler.getStats().frustumCulled : 0;
+		statsOccluded += culling ? visibility.culler.getStats().occluded : 0;
+		++statsFrames;
+		getRenderStats().reset();
+		const float statsSeconds = statsClock.getElapsedTime().asSeconds();
+		if(statsSeconds >= 1.0f)
+		{
+			printf("%s cubes: %.3f ms per frame, %llu draw calls per frame, %llu bytes uploaded per frame\n",
+				instancedCubes ? "Instanced" : "Per object", 1000.0f * statsSeconds / statsFrames, statsDrawCalls / statsFrames, statsBytes / statsFrames);
+			printf("State changes per frame: %llu issued, %llu skipped\n", statsStateChanges / statsFrames, statsStateChangesSkipped / statsFrames);
+			printf("Culling %s: %llu bodies outside the frustum, %llu occluded per frame\n",
+				culling ? (visibility.culler.getOcclusion() ? "frustum + occlusion" : "frustum") : "off", statsFrustumCulled / statsFrames, statsOccluded / statsFrames);
+
+			// The change over the second, latency from a snapshot being published to a frame taking it
+			const SimulationThreadStats simulationStats = simulation.getStats();
+			const unsigned long long taken = simulationStats.snapshotsTaken - statsSimulation.snapshotsTaken;
+			printf("Simulation: %llu steps, %llu late, %llu snapshots unread, %.3f ms average latency, %llu stale frames\n",
+				simulationStats.steps - statsSimulation.steps, simulationStats.lateSteps - statsSimulation.lateSteps,
+				simulationStats.unreadSnapshots - statsSimulation.unreadSnapshots,
+				taken > 0 ? (simulationStats.totalLatency - statsSimulation.totalLatency) / (1e6 * taken) : 0.0,
+				simulationStats.staleFrames - statsSimulation.staleFrames);
+			statsSimulation = simulationStats;
+
+			// Both threads, the steady loop should not be going to the heap at all
+			if(heapCountersEnabled)
+			{
+				const HeapStats heapStats = getHeapStats();
+				printf("Heap: %.1f allocations per frame, %llu bytes\n", (double)(heapStats.allocations - statsHeap.allocations) / statsFrames,
+					heapStats.bytes - statsHeap.bytes);
+				statsHeap = heapStats;
+			}
+			statsClock.restart();
+			statsBytes = 0;
+			statsDrawCalls = 0;
+			statsStateChanges = 0;
+			statsStateChangesSkipped = 0;
+			statsFrustumCulled = 0;
+			statsOccluded = 0;
+			statsFrames = 0;
 		}
 
 		// Handle messages
@@ -484,242 +469,95 @@ int main()
 						window.close();
 					}
 
+					if(windowEvent.key.code == sf::Keyboard::I)
+					{
+						instancedCubes = !instancedCubes;
+					}
+
+					// C turns culling off and on, O just the occlusion test
+					if(windowEvent.key.code == sf::Keyboard::C)
+					{
+						culling = !culling;
+					}
+
+					if(windowEvent.key.code == sf::Keyboard::O)
+					{
+						visibility.culler.setOcclusion(!visibility.culler.getOcclusion());
+					}
+
+					if(windowEvent.key.code == sf::Keyboard::P)
+					{
+						if(!isProfiling())
+						{
+							startProfiling();
+							printf("Profiling, P again to write %s\n", traceFile);
+						}
+						else
+						{
+							stopProfiling();
+							if(writeChromeTrace(traceFile))
+							{
+								printf("Profile written to %s, %llu events dropped\n", traceFile, getProfilerStats().dropped);
+							}
+						}
+					}
+
 					if(windowEvent.key.code == sf::Keyboard::Up)
 					{
-						box2Pos.y += movSpeed * dt;
+						box2Position.y += movSpeed * dt;
+						simulation.setBox2Position(box2Position);
 					}
 
 					if(windowEvent.key.code == sf::Keyboard::Down)
 					{
-						box2Pos.y -= movSpeed * dt;
+						box2Position.y -= movSpeed * dt;
+						simulation.setBox2Position(box2Position);
 					}
 
 					if(windowEvent.key.code == sf::Keyboard::Left)
 					{
-						box2Pos.x -= movSpeed * dt;
+						box2Position.x -= movSpeed * dt;
+						simulation.setBox2Position(box2Position);
 					}
 
 					if(windowEvent.key.code == sf::Keyboard::Right)
 					{
-						box2Pos.x += movSpeed * dt;
+						box2Position.x += movSpeed * dt;
+						simulation.setBox2Position(box2Position);
 					}
 				}
 			}
 		}
 	}
 
-	glDeleteProgram(shaderProgram);
-
-    glDeleteBuffers(2, vertexBuffer);
-
-    glDeleteVertexArrays(1, &vao);
-
-	return 0;
-}
-
-std::string readTextFromFile(std::string nameOfFile)
-{
-	// !Add error checking to see if file open correctly
-	std::ifstream vertexShaderSource(nameOfFile);
-	std::stringstream vertexShaderText;
-	vertexShaderText << vertexShaderSource.rdbuf();
-	return vertexShaderText.str();
-}
-
-void checkShaderForErrors(GLuint shader)
-{
-	GLint status;
-	glGetShaderiv(shader, GL_COMPILE_STATUS, &status);
+	// The step under way is finished before anything it uses goes
+	simulation.stop();
 
-	if(status != GL_TRUE)
+	if(isProfiling())
 	{
-		char buffer[512];
-		glGetShaderInfoLog(shader, 512, NULL, buffer);
-		std::cout << "Failed to compile shader, reasons to follow:" << std::endl;
-		std::cout << buffer << std::endl;
-		std::cin >> buffer;
+		stopProfiling();
+		writeChromeTrace(traceFile);
 	}
-}
-
-void createShaderProgram(GLuint &shaderProgram_)
-{
-	// Get vertex buffer 
-	std::string vertexShaderText = readTextFromFile("VertexShaders/color3D.vert");
-	const char *vertexShaderData = vertexShaderText.c_str();
-
-	// Create vertex shader
-	GLuint vertexShader = glCreateShader(GL_VERTEX_SHADER);
-
-	// Load the data into the shader
-	glShaderSource(vertexShader, 1, &vertexShaderData, NULL);
-
-	// Compile the vertex shader
-	glCompileShader(vertexShader);
 
-	checkShaderForErrors(vertexShader);
+    glDeleteBuffers(1, &cubeBuffer);
+    glDeleteBuffers(1, &cubeIndexBuffer);
+    glDeleteBuffers(1, &ebo);
 
-	// Get fragment buffer
-	std::string fragmentShaderText = readTextFromFile("FragmentShaders/inputColor.frag");
-	const char *fragmentShaderData = fragmentShaderText.c_str();
-
-	// Create fragment shader 
-	GLuint fragmentShader = glCreateShader(GL_FRAGMENT_SHADER);
-	
-	// Load the data into the shader
-	glShaderSource(fragmentShader,1, &fragmentShaderData, NULL);
-
-	// Compile the fragment shader
-	glCompileShader(fragmentShader);
-
-	checkShaderForErrors(fragmentShader);
-
-	// Create shader program 
-	shaderProgram_ = glCreateProgram();
-	glAttachShader(shaderProgram_, vertexShader);
-	glAttachShader(shaderProgram_, fragmentShader);
-
-	// Bing fragment shader output to buffer
-	glBindFragDataLocation(shaderProgram_, 0, "outColor");
-
-	// Finished construction of shader by linking it
-	glLinkProgram(shaderProgram_);
+    glDeleteVertexArrays(1, &vao);
+    glDeleteVertexArrays(1, &boundingBoxVao);
 
-	// Delete the shaders as we do not need them anymore
-	glDeleteShader(fragmentShader);
-    glDeleteShader(vertexShader);
+	return 0;
+#endif
 }
 
-inline glm::fquat AngularVelocityToSpin(glm::fquat orientation, glm::vec3 angularVelocity)
+#ifndef HEADLESS
+void setSharedUniforms(ShaderCache &shaders, unsigned int shader, const glm::mat4 &view, const glm::mat4 &proj)
 {
-	const float x = angularVelocity.x;
-	const float y = angularVelocity.y;
-	const float z = angularVelocity.z;
-
-	return 0.5f * glm::fquat(0, x, y, z) * orientation;
-}
+	glUseProgram(shaders.getProgram(shader));
 
-bool testAABBAABB(const AABB &a, const AABB &b)
-{
-	if(glm::abs(a.center_position.x - b.center_position.x) > (a.radius.x + b.radius.x)) return false;
-	if(glm::abs(a.center_position.y - b.center_position.y) > (a.radius.y + b.radius.y))	return false;
-	if(glm::abs(a.center_position.z - b.center_position.z) > (a.radius.z + b.radius.z)) return false;
-				
-	return true;
+	glUniformMatrix4fv(shaders.getUniformLocation(shader, "view"), 1, GL_FALSE, glm::value_ptr(view));
+	glUniformMatrix4fv(shaders.getUniformLocation(shader, "proj"), 1, GL_FALSE, glm::value_ptr(proj));
+	glUniform3f(shaders.getUniformLocation(shader, "overrideColor"), 1.0f, 1.0f, 1.0f);
+	glUniform1f(shaders.getUniformLocation(shader, "Alpha"), 1.0f);
 }
-
-void calculateBoxExtremes(glm::mat4 transformMat, GLfloat newBoxCoords[], extremes &boxExtremes)
-{
-	std::vector<glm::vec4> v;
-	
-	// Get positions of verts
-	v.push_back(glm::vec4(-0.5f, -0.5f, -0.5f, 1.0f));
-	v.push_back(glm::vec4(-0.5f,  0.5f, -0.5f, 1.0f));
-	v.push_back(glm::vec4( 0.5f, -0.5f, -0.5f, 1.0f));
-	v.push_back(glm::vec4( 0.5f,  0.5f, -0.5f, 1.0f));
-	v.push_back(glm::vec4(-0.5f, -0.5f,  0.5f, 1.0f));
-	v.push_back(glm::vec4(-0.5f,  0.5f,  0.5f, 1.0f));
-	v.push_back(glm::vec4( 0.5f, -0.5f,  0.5f, 1.0f));
-	v.push_back(glm::vec4( 0.5f,  0.5f,  0.5f, 1.0f));
-
-	std::vector<glm::vec4> updateVerts;
-	
-	for(std::vector<glm::vec4>::iterator it = v.begin(); it != v.end(); it++)
-	{
-		updateVerts.push_back((*it) * transformMat);
-	}
-
-	for(std::vector<glm::vec4>::iterator it = updateVerts.begin(); it != updateVerts.end(); it++)
-	{
-		if((*it).x > boxExtremes.minX)
-		{
-			boxExtremes.minX = (*it).x;
-		}
-
-		if((*it).x < boxExtremes.maxX)
-		{
-			boxExtremes.maxX = (*it).x;
-		}
-
-		if((*it).y > boxExtremes.minY)
-		{
-			boxExtremes.minY = (*it).y;
-		}
-
-		if((*it).y < boxExtremes.maxY)
-		{
-			boxExtremes.maxY = (*it).y;
-		}
-
-		if((*it).z > boxExtremes.minZ)
-		{
-			boxExtremes.minZ = (*it).z;
-		}
-
-		if((*it).z < boxExtremes.maxZ)
-		{
-			boxExtremes.maxZ = (*it).z;
-		}
-	}
-
-	/*
-	std::vector<glm::vec3> newBoxCoords;
-	newBoxCoords.push_back(glm::vec3(boxExtremes.minX, boxExtremes.minY, boxExtremes.minZ));
-	newBoxCoords.push_back(glm::vec3(boxExtremes.maxX, boxExtremes.minY, boxExtremes.minZ));
-	newBoxCoords.push_back(glm::vec3(boxExtremes.maxX, boxExtremes.maxY, boxExtremes.minZ));
-	newBoxCoords.push_back(glm::vec3(boxExtremes.minX, boxExtremes.maxY, boxExtremes.minZ));
-
-	newBoxCoords.push_back(glm::vec3(boxExtremes.minX, boxExtremes.minY, boxExtremes.maxZ));
-	newBoxCoords.push_back(glm::vec3(boxExtremes.maxX, boxExtremes.minY, boxExtremes.maxZ));
-	newBoxCoords.push_back(glm::vec3(boxExtremes.maxX, boxExtremes.maxY, boxExtremes.maxZ));
-	newBoxCoords.push_back(glm::vec3(boxExtremes.minX, boxExtremes.maxY, boxExtremes.maxZ));
-	*/
-
-	newBoxCoords[0] = boxExtremes.minX;
-	newBoxCoords[1] = boxExtremes.minY;
-	newBoxCoords[2] = boxExtremes.minZ; 
-	newBoxCoords[3] = 0.3f; 
-	newBoxCoords[4] = 0.3f; 
-	newBoxCoords[5] = 0.3f; 
-	newBoxCoords[6] = boxExtremes.maxX; 
-	newBoxCoords[7] = boxExtremes.minY; 
-	newBoxCoords[8] = boxExtremes.minZ; 
-	newBoxCoords[9] = 0.3f; 
-	newBoxCoords[10] = 0.3f; 
-	newBoxCoords[11] = 0.3f; 
-	newBoxCoords[12] = boxExtremes.maxX; 
-	newBoxCoords[13] = boxExtremes.maxY; 
-	newBoxCoords[14] = boxExtremes.minZ; 
-	newBoxCoords[15] = 0.3f; 
-	newBoxCoords[16] = 0.3f; 
-	newBoxCoords[17] = 0.3f;
-	newBoxCoords[18] = boxExtremes.minX; 
-	newBoxCoords[19] = boxExtremes.maxY; 
-	newBoxCoords[20] = boxExtremes.minZ;
-	newBoxCoords[21] = 0.3f; 
-	newBoxCoords[22] = 0.3f; 
-	newBoxCoords[23] = 0.3f;
-	newBoxCoords[24] = boxExtremes.minX; 
-	newBoxCoords[25] = boxExtremes.minY; 
-	newBoxCoords[26] = boxExtremes.maxZ;
-	newBoxCoords[27] = 0.3f; 
-	newBoxCoords[28] = 0.3f; 
-	newBoxCoords[29] = 0.3f;
-	newBoxCoords[30] = boxExtremes.maxX; 
-	newBoxCoords[31] = boxExtremes.minY; 
-	newBoxCoords[32] = boxExtremes.maxZ;
-	newBoxCoords[33] = 0.3f; 
-	newBoxCoords[34] = 0.3f; 
-	newBoxCoords[35] = 0.3f;
-	newBoxCoords[36] = boxExtremes.maxX; 
-	newBoxCoords[37] = boxExtremes.maxY; 
-	newBoxCoords[38] = boxExtremes.maxZ;
-	newBoxCoords[39] = 0.3f; 
-	newBoxCoords[40] = 0.3f; 
-	newBoxCoords[41] = 0.3f;
-	newBoxCoords[42] = boxExtremes.minX; 
-	newBoxCoords[43] = boxExtremes.maxY; 
-	newBoxCoords[44] = boxExtremes.maxZ;
-	newBoxCoords[45] = 0.3f; 
-	newBoxCoords[46] = 0.3f; 
-	newBoxCoords[47] = 0.3f; 
-}
\ No newline at end of file
+#endif